@@ -1,14 +1,21 @@
 #include "Renderer.h"
+#include "BindlessTextures.h"
 #include "Shader.h"
 #include "mesh.h"
 #include "Texture.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
 #include "Camera.h"
+#include "Profiler.h"
 #include <vector>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <GLFW/glfw3.h>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 // 旋转角度变量
 float rotateX = 0.0f;
@@ -52,16 +59,59 @@ void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
     camera.processMouseMovement(xoffset, yoffset);
 }
 
+// --bindless 模式的片段着色器正文，接在 BindlessMaterialTable::shaderPrelude() 之后；
+// 顶点着色器沿用 glsl/texture.vs
+const char* const kMaterialFS =
+    "in vec3 ourColor;\n"
+    "in vec2 TexCoord;\n"
+    "out vec4 FragColor;\n"
+    "uniform int material;\n"
+    "void main() {\n"
+    "    vec4 base = sampleMaterial(material, 0, TexCoord);\n"
+    "    vec4 decal = sampleMaterial(material, 1, TexCoord);\n"
+    "    FragColor = mix(base, decal, 0.2) * vec4(ourColor, 1.0);\n"
+    "}\n";
+
 // 滚轮回调
 void scroll_callback(GLFWwindow* window, double /*xoffset*/, double yoffset) {
     camera.processMouseScroll(static_cast<float>(yoffset));
 }
 
-int main() {
-    Renderer renderer(800, 600, "Mesh Camera Demo");
-    glfwSetInputMode(renderer.window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-    glfwSetCursorPosCallback(renderer.window(), mouse_callback);
-    glfwSetScrollCallback(renderer.window(), scroll_callback);
+// 用法：mesh_example [--headless 帧数] [--threaded] [--stream | --bindless]
+// 无窗口模式渲染固定帧数到离屏 FBO 后退出，可在 CI 或没有显示器的机器上运行；
+// --threaded 使用独立的渲染线程；
+// --stream 通过 TextureStreamer 加载贴图，先上传粗级别，再按相机距离估算需要的 mip 逐步细化；
+// --bindless 通过 BindlessMaterialTable 采样两张贴图，绘制时只设置材质索引，不支持 bindless 时走纹理数组
+int main(int argc, char** argv) {
+    int headlessFrames = 0;
+    bool threaded = false;
+    bool stream = false;
+    bool bindless = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            headlessFrames = (i + 1 < argc) ? std::atoi(argv[++i]) : 100;
+        } else if (std::strcmp(argv[i], "--threaded") == 0) {
+            threaded = true;
+        } else if (std::strcmp(argv[i], "--stream") == 0) {
+            stream = true;
+        } else if (std::strcmp(argv[i], "--bindless") == 0) {
+            bindless = true;
+        }
+    }
+    // 两种模式互斥，材质表自己管理贴图
+    if (bindless) stream = false;
+
+    std::unique_ptr<Renderer> rendererPtr;
+    if (headlessFrames > 0) {
+        rendererPtr = Renderer::createHeadless(800, 600);
+        if (!rendererPtr) return 1;
+    } else {
+        rendererPtr.reset(new Renderer(800, 600, "Mesh Camera Demo"));
+        glfwSetInputMode(rendererPtr->window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetCursorPosCallback(rendererPtr->window(), mouse_callback);
+        glfwSetScrollCallback(rendererPtr->window(), scroll_callback);
+    }
+    Renderer& renderer = *rendererPtr;
 
     std::vector<Vertex> vertices = {
         // 位置                // 颜色         // 法线         // 纹理坐标
@@ -72,36 +122,120 @@ int main() {
     std::vector<uint32_t> indices = { 0, 1, 2 };
     Mesh mesh(vertices, indices);
 
-    Shader shader("/home/shangyizhou/code/learn-opengl/src/pratice/src/glsl/texture.vs", "/home/shangyizhou/code/learn-opengl/src/pratice/src/glsl/texture.fs");
-    Texture texture("/home/shangyizhou/code/learn-opengl/src/pratice/src/textures/container.jpg", GL_RGB);
-    shader.use();
-    shader.setInt("ourTexture", 0);
+    const char* vertexPath = "/home/shangyizhou/code/learn-opengl/src/pratice/src/glsl/texture.vs";
+    const char* texturePath = "/home/shangyizhou/code/learn-opengl/src/pratice/src/textures/container.jpg";
+    const char* decalPath = "/home/shangyizhou/code/learn-opengl/src/pratice/src/textures/awesomeface.png";
+
+    // --bindless：一个材质，槽 0 为箱子、槽 1 为笑脸
+    BindlessMaterialTable materials;
+    int material = -1;
+    if (bindless) {
+        material = materials.addMaterial({materials.addTexture(texturePath), materials.addTexture(decalPath)});
+        if (!materials.finalize()) return 1;
+        std::cout << "Material table: " << (materials.isBindless() ? "bindless handles" : "texture arrays")
+                  << std::endl;
+    }
 
-    renderer.run([&](){
-        float currentFrame = static_cast<float>(glfwGetTime());
+    std::unique_ptr<Shader> shaderPtr;
+    if (bindless) {
+        std::vector<unsigned char> vertexSource;
+        if (!readFileBytes(vertexPath, vertexSource)) return 1;
+        shaderPtr.reset(new Shader(std::string(vertexSource.begin(), vertexSource.end()),
+                                   materials.shaderPrelude() + kMaterialFS, true));
+        materials.attach(shaderPtr->ID());
+    } else {
+        shaderPtr.reset(new Shader(vertexPath, "/home/shangyizhou/code/learn-opengl/src/pratice/src/glsl/texture.fs"));
+    }
+    Shader& shader = *shaderPtr;
+
+    // 普通模式经 TextureCache 加载，句柄释放后可用 evictUnused() 回收
+    TextureCache textureCache;
+    TextureStreamer streamer;
+    std::shared_ptr<Texture> texture;
+    if (stream) {
+        texture = streamer.load(texturePath);
+    } else if (!bindless) {
+        texture = textureCache.get(texturePath, GL_RGB);
+    }
+    shader.use();
+    if (!bindless) shader.setInt("ourTexture", 0);
+
+    // 模拟：时间、输入和旋转角度，结果是这一帧要用的矩阵
+    struct FrameState {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 model;
+        float distance;   // 相机到三角形的距离和垂直视角（弧度），流式加载据此估算 mip
+        float fovY;
+    };
+    auto simulate = [&](long frame) -> FrameState {
+        float currentFrame = static_cast<float>(renderer.time());
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
-        processInput(renderer.window());
+        if (renderer.window()) {
+            processInput(renderer.window());
+        } else {
+            // 无窗口模式没有输入，按帧号自动旋转，保证每次运行画面一致
+            rotateY = frame * 1.0f;
+        }
+
+        FrameState state;
+        state.view = camera.getViewMatrix();
+        state.projection = camera.getProjectionMatrix(static_cast<float>(renderer.width()) / renderer.height());
+        state.model = glm::mat4(1.0f);
+        state.model = glm::rotate(state.model, glm::radians(rotateX), glm::vec3(1.0f, 0.0f, 0.0f));
+        state.model = glm::rotate(state.model, glm::radians(rotateY), glm::vec3(0.0f, 1.0f, 0.0f));
+        state.distance = glm::length(camera.getPosition());
+        state.fovY = glm::radians(camera.getFov());
+        return state;
+    };
 
-        texture.bind(0);
+    // 提交：只读取 FrameState，多线程模式下在渲染线程上执行
+    const GLint modelLoc = glGetUniformLocation(shader.ID(), "transform");
+    auto draw = [&](const FrameState& state) {
+        if (bindless) {
+            materials.beginFrame();
+            materials.bind();
+            materials.use(material);
+        } else {
+            if (stream) {
+                // 三角形宽 1 个单位，UV 也跨 0..1
+                streamer.requestForView(texture, state.distance, 1.0f, state.fovY, renderer.height());
+                streamer.update();
+            }
+            texture->bind(0);
+        }
         shader.use();
+        if (bindless) shader.setInt("material", material);
+        shader.setMat4("view", state.view);
+        shader.setMat4("projection", state.projection);
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(state.model));
 
-        glm::mat4 view = camera.getViewMatrix();
-        glm::mat4 projection = camera.getProjectionMatrix(800.0f/600.0f);
-
-        shader.setMat4("view", view);
-        shader.setMat4("projection", projection);
-
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::rotate(model, glm::radians(rotateX), glm::vec3(1.0f, 0.0f, 0.0f));
-        model = glm::rotate(model, glm::radians(rotateY), glm::vec3(0.0f, 1.0f, 0.0f));
-
-        GLuint modelLoc = glGetUniformLocation(shader.ID(), "transform");
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
+        PROFILE_SCOPE("mesh");
         mesh.draw();
-    });
+    };
 
+    if (threaded) {
+        // 主线程模拟下一帧的同时，渲染线程提交上一帧
+        renderer.runThreaded([&](RenderCommandList& list) {
+            const FrameState state = simulate(list.frame());
+            list.add([&draw, state]() { draw(state); });
+        }, headlessFrames);
+    } else {
+        renderer.run([&]() { draw(simulate(renderer.frameIndex())); }, headlessFrames);
+    }
+
+    if (renderer.isHeadless()) {
+        std::cout << "Rendered " << renderer.frameIndex() << " headless frames in " << renderer.time() << " s"
+                  << std::endl;
+    }
+    if (stream && texture) {
+        const TextureStreamer::Stats stats = streamer.stats();
+        std::cout << "Streamed texture: " << texture->width() << "x" << texture->height() << ", "
+                  << texture->droppedLevels() << " levels dropped, " << stats.residentBytes << " bytes resident"
+                  << std::endl;
+    }
+    Profiler::get().print(std::cout);
     return 0;
 }
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "mesh.h"
+#include "ColorSpace.h"
+#include "GLStateCache.h"
 
 // 窗口设置
 const unsigned int SCR_WIDTH = 1200;
@@ -56,6 +58,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -83,7 +86,9 @@ int main()
     }
 
     // 启用深度测试
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::get().enable(GL_DEPTH_TEST);
+    // sRGB 默认帧缓冲：着色器在线性空间计算光照，写入时由硬件编码为 sRGB
+    GLStateCache::get().enable(GL_FRAMEBUFFER_SRGB);
 
     // 创建投光物着色器
     Shader lightCastersShader(
@@ -370,7 +375,9 @@ int main()
         }
 
         // 清除缓冲
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        // 颜色常量按 sRGB 挑选，参与计算前转换到线性空间
+        const glm::vec3 clearColor = srgbToLinear(glm::vec3(0.1f, 0.1f, 0.1f));
+        glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 激活投光物着色器
@@ -378,7 +385,7 @@ int main()
         
         // 设置通用参数
         lightCastersShader.setVec3("viewPos", camera.getPosition());
-        lightCastersShader.setVec3("objectColor", glm::vec3(1.0f, 0.5f, 0.31f));
+        lightCastersShader.setVec3("objectColor", srgbToLinear(glm::vec3(1.0f, 0.5f, 0.31f)));
         lightCastersShader.setFloat("materialShininess", 32.0f);
         lightCastersShader.setInt("lightType", currentLightType);
 
@@ -445,7 +452,7 @@ int main()
             model = glm::mat4(1.0f);
             model = glm::translate(model, pointLightPos);
             model = glm::scale(model, glm::vec3(0.2f));
-            lightShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
+            lightShader.setVec3("lightColor", srgbToLinear(glm::vec3(1.0f, 1.0f, 1.0f)));
             lightShader.setMat4("model", model);
             cubeMesh.draw();
         }
@@ -455,7 +462,7 @@ int main()
             model = glm::mat4(1.0f);
             model = glm::translate(model, spotLightPos);
             model = glm::scale(model, glm::vec3(0.2f));
-            lightShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 0.0f));
+            lightShader.setVec3("lightColor", srgbToLinear(glm::vec3(1.0f, 1.0f, 0.0f)));
             lightShader.setMat4("model", model);
             cubeMesh.draw();
         }
@@ -8,6 +8,8 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "mesh.h"
+#include "ColorSpace.h"
+#include "GLStateCache.h"
 
 // 窗口设置
 const unsigned int SCR_WIDTH = 800;
@@ -39,6 +41,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -65,7 +68,9 @@ int main()
     }
 
     // 启用深度测试
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::get().enable(GL_DEPTH_TEST);
+    // sRGB 默认帧缓冲：着色器在线性空间计算光照，写入时由硬件编码为 sRGB
+    GLStateCache::get().enable(GL_FRAMEBUFFER_SRGB);
 
     // 创建着色器
     // 光照着色器
@@ -237,13 +242,15 @@ int main()
         processInput(window);
 
         // 清除缓冲
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+        // 颜色常量按 sRGB 挑选，参与计算前转换到线性空间
+        const glm::vec3 clearColor = srgbToLinear(glm::vec3(0.2f, 0.3f, 0.3f));
+        glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 激活光照着色器
         lightingShader.use();
-        lightingShader.setVec3("objectColor", glm::vec3(1.0f, 0.5f, 0.31f));  // 珊瑚红色
-        lightingShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));    // 白色光源
+        lightingShader.setVec3("objectColor", srgbToLinear(glm::vec3(1.0f, 0.5f, 0.31f)));  // 珊瑚红色
+        lightingShader.setVec3("lightColor", srgbToLinear(glm::vec3(1.0f, 1.0f, 1.0f)));    // 白色光源
         lightingShader.setVec3("lightPos", lightPos);
         lightingShader.setVec3("viewPos", camera.getPosition());
 
@@ -8,6 +8,12 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "mesh.h"
+#include "ColorSpace.h"
+#include "GLStateCache.h"
+#include "Image.h"
+#include "Texture.h"
+#include "TextureArray.h"
+#include "ProceduralTexture.h"
 
 
 // 窗口设置
@@ -45,90 +51,6 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 
-// 创建木箱纹理
-unsigned int createWoodenBoxTexture()
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    
-    // 设置纹理参数
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    // 创建简单的木箱纹理数据
-    const int width = 256, height = 256;
-    unsigned char* data = new unsigned char[width * height * 3];
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int index = (y * width + x) * 3;
-            
-            // 创建木纹效果
-            float noise = (sin(x * 0.1f) + cos(y * 0.1f)) * 0.5f + 0.5f;
-            float wood = sin(x * 0.05f + y * 0.02f) * 0.3f + 0.7f;
-            
-            // 木箱颜色：棕色系
-            data[index] = (unsigned char)(139 + noise * 50);     // R
-            data[index + 1] = (unsigned char)(69 + wood * 30);   // G
-            data[index + 2] = (unsigned char)(19 + noise * 20);  // B
-        }
-    }
-    
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    
-    delete[] data;
-    return textureID;
-}
-
-// 创建镜面光贴图
-unsigned int createSpecularMap()
-{
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    
-    // 设置纹理参数
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    // 创建镜面光贴图数据
-    const int width = 256, height = 256;
-    unsigned char* data = new unsigned char[width * height * 3];
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int index = (y * width + x) * 3;
-            
-            // 创建镜面光贴图：木头部分黑色（不反光），边框部分白色（反光）
-            float border = 0.1f;
-            float xNorm = (float)x / width;
-            float yNorm = (float)y / height;
-            
-            // 边框区域（金属部分）
-            bool isBorder = (xNorm < border || xNorm > 1.0f - border || 
-                           yNorm < border || yNorm > 1.0f - border);
-            
-            unsigned char intensity = isBorder ? 255 : 50;  // 边框白色，内部黑色
-            
-            data[index] = intensity;     // R
-            data[index + 1] = intensity; // G
-            data[index + 2] = intensity; // B
-        }
-    }
-    
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-    
-    delete[] data;
-    return textureID;
-}
-
 
 int main()
 {
@@ -137,6 +59,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -164,7 +87,9 @@ int main()
     }
 
     // 启用深度测试
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::get().enable(GL_DEPTH_TEST);
+    // sRGB 默认帧缓冲：着色器在线性空间计算光照，写入时由硬件编码为 sRGB
+    GLStateCache::get().enable(GL_FRAMEBUFFER_SRGB);
 
     // 创建光照贴图着色器
     Shader lightingMapsShader(
@@ -207,14 +132,16 @@ int main()
         "uniform float shininess;\n"
         "\n"
         "// 材质贴图\n"
-        "uniform sampler2D diffuseMap;\n"
-        "uniform sampler2D specularMap;\n"
+        "uniform sampler2DArray colorMaps;\n"   // sRGB 存储，采样得到线性颜色
+        "uniform sampler2DArray dataMaps;\n"
+        "uniform int diffuseLayer;\n"
+        "uniform int specularLayer;\n"
         "\n"
         "void main()\n"
         "{\n"
         "    // 从贴图获取材质属性\n"
-        "    vec3 diffuseColor = vec3(texture(diffuseMap, TexCoords));\n"
-        "    vec3 specularColor = vec3(texture(specularMap, TexCoords));\n"
+        "    vec3 diffuseColor = vec3(texture(colorMaps, vec3(TexCoords, diffuseLayer)));\n"
+        "    vec3 specularColor = vec3(texture(dataMaps, vec3(TexCoords, specularLayer)));\n"
         "\n"
         "    // 环境光照\n"
         "    vec3 ambient = ambientStrength * lightColor * diffuseColor;\n"
@@ -269,9 +196,23 @@ int main()
     );
 
     // 创建程序化纹理
-    // 漫反射纹理：木箱纹理
-    unsigned int diffuseMap = createWoodenBoxTexture();
-    unsigned int specularMap = createSpecularMap();
+    // 采样状态由共享的 sampler 对象提供：三线性过滤 + 4x 各向异性
+    TextureParams mapParams;
+    mapParams.sampler = SamplerDesc::trilinear(GL_REPEAT, 4.0f);
+    // 木纹和边框遮罩由程序化生成（多线程 + SIMD），结果按参数哈希缓存在磁盘上
+    WoodParams woodParams;
+    BorderMaskParams specularParams;
+    // 同一个纹理数组只能有一种内部格式，颜色贴图 (sRGB) 和数据贴图 (线性) 分成两个数组
+    TextureParams dataParams = mapParams;
+    dataParams.role = TextureRole::Data;
+    TextureArrayBuilder colorBuilder(mapParams);
+    TextureArrayBuilder dataBuilder(dataParams);
+    const int diffuseLayer = colorBuilder.addLayer(loadOrGenerate("wooden_box", woodParams.hash(),
+        [&]() { return generateWoodImage(woodParams); }));
+    const int specularLayer = dataBuilder.addLayer(loadOrGenerate("wooden_box_specular", specularParams.hash(),
+        [&]() { return generateBorderMaskImage(specularParams); }));
+    std::unique_ptr<TextureArray> colorMaps = colorBuilder.build();
+    std::unique_ptr<TextureArray> dataMaps = dataBuilder.build();
     
     std::cout << "纹理加载完成！" << std::endl;
 
@@ -375,14 +316,16 @@ int main()
         }
 
         // 清除缓冲
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        // 颜色常量按 sRGB 挑选，参与计算前转换到线性空间
+        const glm::vec3 clearColor = srgbToLinear(glm::vec3(0.1f, 0.1f, 0.1f));
+        glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 激活光照贴图着色器
         lightingMapsShader.use();
         
         // 设置光照参数
-        lightingMapsShader.setVec3("lightColor", lightColor);
+        lightingMapsShader.setVec3("lightColor", srgbToLinear(lightColor));
         lightingMapsShader.setVec3("lightPos", lightPos);
         lightingMapsShader.setVec3("viewPos", camera.getPosition());
         lightingMapsShader.setFloat("ambientStrength", ambientStrength);
@@ -391,13 +334,12 @@ int main()
         lightingMapsShader.setFloat("shininess", shininess);
 
         // 绑定纹理
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        lightingMapsShader.setInt("diffuseMap", 0);
-        
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMap);
-        lightingMapsShader.setInt("specularMap", 1);
+        colorMaps->bind(0);
+        dataMaps->bind(1);
+        lightingMapsShader.setInt("colorMaps", 0);
+        lightingMapsShader.setInt("dataMaps", 1);
+        lightingMapsShader.setInt("diffuseLayer", diffuseLayer);
+        lightingMapsShader.setInt("specularLayer", specularLayer);
 
         // 设置变换矩阵
         glm::mat4 projection = camera.getProjectionMatrix((float)SCR_WIDTH / (float)SCR_HEIGHT);
@@ -413,7 +355,7 @@ int main()
 
         // 激活光源着色器
         lightShader.use();
-        lightShader.setVec3("lightColor", lightColor);
+        lightShader.setVec3("lightColor", srgbToLinear(lightColor));
         lightShader.setMat4("projection", projection);
         lightShader.setMat4("view", view);
 
@@ -429,9 +371,7 @@ int main()
         glfwPollEvents();
     }
 
-    // 清理资源
-    glDeleteTextures(1, &diffuseMap);
-    glDeleteTextures(1, &specularMap);
+    // 清理资源（纹理由 Texture 析构释放）
     glfwTerminate();
     return 0;
 }
@@ -8,6 +8,13 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "mesh.h"
+#include "ColorSpace.h"
+#include "GLStateCache.h"
+#include "Profiler.h"
+#include "Frustum.h"
+#include "RenderQueue.h"
+#include "ShadowMaps.h"
+#include "HdrPipeline.h"
 
 // 窗口设置
 const unsigned int SCR_WIDTH = 1200;
@@ -45,6 +52,9 @@ glm::vec3 spotLightDir(0.0f, -1.0f, 0.0f);
 float cutOff = glm::cos(glm::radians(12.5f));
 float outerCutOff = glm::cos(glm::radians(17.5f));
 
+// 阴影：点光源和聚光阴影贴图的远平面，衰减到这里已经很暗
+const float SHADOW_RADIUS = 20.0f;
+
 // 光源移动
 bool lightMoving = true;
 float lightSpeed = 0.5f;
@@ -63,6 +73,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -90,7 +101,9 @@ int main()
     }
 
     // 启用深度测试
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::get().enable(GL_DEPTH_TEST);
+    // sRGB 默认帧缓冲：着色器在线性空间计算光照，写入时由硬件编码为 sRGB
+    GLStateCache::get().enable(GL_FRAMEBUFFER_SRGB);
 
     // 创建多光源着色器
     Shader multipleLightsShader(
@@ -116,8 +129,8 @@ int main()
         "    TexCoords = aTexCoord;\n"
         "    gl_Position = projection * view * vec4(FragPos, 1.0);\n"
         "}\n",
-        // 片段着色器 - 多光源系统
-        "#version 330 core\n"
+        // 片段着色器 - 多光源系统，带阴影
+        std::string("#version 330 core\n") + ShadowMaps::shaderSource() +
         "out vec4 FragColor;\n"
         "\n"
         "in vec3 FragPos;\n"
@@ -172,30 +185,38 @@ int main()
         "};\n"
         "uniform SpotLight spotLight;\n"
         "\n"
+        "// 阴影图块序号，-1 表示没有阴影\n"
+        "uniform int pointShadowIndices[4];\n"
+        "uniform int spotShadowIndex;\n"
+        "\n"
         "// 函数声明\n"
-        "vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);\n"
-        "vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);\n"
-        "vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);\n"
+        "vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow);\n"
+        "vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);\n"
+        "vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);\n"
         "\n"
         "void main()\n"
         "{\n"
         "    vec3 norm = normalize(Normal);\n"
         "    vec3 viewDir = normalize(viewPos - FragPos);\n"
+        "    // 查阴影的位置沿法线偏移一点，避免表面自阴影\n"
+        "    vec3 shadowPos = FragPos + norm * 0.03;\n"
         "\n"
         "    // 第一阶段：平行光\n"
-        "    vec3 result = CalcDirLight(dirLight, norm, viewDir);\n"
+        "    vec3 result = CalcDirLight(dirLight, norm, viewDir, directionalShadow(shadowPos));\n"
         "\n"
         "    // 第二阶段：点光源\n"
-        "    for(int i = 0; i < 4; i++)\n"
-        "        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);\n"
+        "    for(int i = 0; i < 4; i++) {\n"
+        "        float shadow = pointShadow(pointShadowIndices[i], shadowPos, pointLights[i].position);\n"
+        "        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, shadow);\n"
+        "    }\n"
         "\n"
         "    // 第三阶段：聚光\n"
-        "    result += CalcSpotLight(spotLight, norm, FragPos, viewDir);\n"
+        "    result += CalcSpotLight(spotLight, norm, FragPos, viewDir, spotShadow(spotShadowIndex, shadowPos));\n"
         "\n"
         "    FragColor = vec4(result * objectColor, 1.0);\n"
         "}\n"
         "\n"
-        "vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)\n"
+        "vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float shadow)\n"
         "{\n"
         "    vec3 lightDir = normalize(-light.direction);\n"
         "    float diff = max(dot(normal, lightDir), 0.0);\n"
@@ -203,13 +224,13 @@ int main()
         "    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);\n"
         "    \n"
         "    vec3 ambient = light.ambient * material.ambient;\n"
-        "    vec3 diffuse = light.diffuse * diff * material.diffuse;\n"
-        "    vec3 specular = light.specular * spec * material.specular;\n"
+        "    vec3 diffuse = light.diffuse * diff * material.diffuse * shadow;\n"
+        "    vec3 specular = light.specular * spec * material.specular * shadow;\n"
         "    \n"
         "    return (ambient + diffuse + specular);\n"
         "}\n"
         "\n"
-        "vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)\n"
+        "vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow)\n"
         "{\n"
         "    vec3 lightDir = normalize(light.position - fragPos);\n"
         "    float diff = max(dot(normal, lightDir), 0.0);\n"
@@ -220,8 +241,8 @@ int main()
         "    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * distance * distance);\n"
         "    \n"
         "    vec3 ambient = light.ambient * material.ambient;\n"
-        "    vec3 diffuse = light.diffuse * diff * material.diffuse;\n"
-        "    vec3 specular = light.specular * spec * material.specular;\n"
+        "    vec3 diffuse = light.diffuse * diff * material.diffuse * shadow;\n"
+        "    vec3 specular = light.specular * spec * material.specular * shadow;\n"
         "    \n"
         "    ambient *= attenuation;\n"
         "    diffuse *= attenuation;\n"
@@ -230,7 +251,7 @@ int main()
         "    return (ambient + diffuse + specular);\n"
         "}\n"
         "\n"
-        "vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)\n"
+        "vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow)\n"
         "{\n"
         "    vec3 lightDir = normalize(light.position - fragPos);\n"
         "    float diff = max(dot(normal, lightDir), 0.0);\n"
@@ -245,8 +266,8 @@ int main()
         "    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);\n"
         "    \n"
         "    vec3 ambient = light.ambient * material.ambient;\n"
-        "    vec3 diffuse = light.diffuse * diff * material.diffuse;\n"
-        "    vec3 specular = light.specular * spec * material.specular;\n"
+        "    vec3 diffuse = light.diffuse * diff * material.diffuse * shadow;\n"
+        "    vec3 specular = light.specular * spec * material.specular * shadow;\n"
         "    \n"
         "    ambient *= attenuation * intensity;\n"
         "    diffuse *= attenuation * intensity;\n"
@@ -368,11 +389,122 @@ int main()
     std::cout << "- 1个平行光 (太阳光)" << std::endl;
     std::cout << "- 4个点光源 (彩色灯泡)" << std::endl;
     std::cout << "- 1个聚光 (手电筒)" << std::endl;
+    std::cout << "- 以上光源都投射阴影" << std::endl;
     std::cout << "=================" << std::endl;
 
+    // 渲染队列：立方体和灯都以排序键提交，执行时跳过重复的程序、材质和 VAO 绑定
+    glm::mat4 projection(1.0f), view(1.0f);
+    const glm::vec3 cubePositions[] = {
+        glm::vec3( 0.0f, 0.0f,  0.0f),  // 主立方体
+        glm::vec3(-2.0f, 0.0f,  0.0f),  // 左侧立方体
+        glm::vec3( 2.0f, 0.0f,  0.0f),  // 右侧立方体
+        glm::vec3( 0.0f, 0.0f, -2.0f)   // 后方立方体
+    };
+    // 地面：压扁的立方体，顶面在立方体底部的高度，用来接收阴影
+    const glm::mat4 floorModel = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.75f, 0.0f)),
+                                            glm::vec3(20.0f, 0.5f, 20.0f));
+    RenderQueue queue;
+
+    // 阴影：平行光用级联阴影，点光源和聚光在图集里。场景几何是静态的，光源注册为静态，
+    // 只在移动后重画；每帧最多重画 13 个图块（两个点光源加聚光），其余推迟到之后的帧
+    const DirectionalLight sun = DirectionalLight();
+    ShadowMaps shadows;
+    if (!shadows.init())
+    {
+        glfwTerminate();
+        return -1;
+    }
+    shadows.setTileBudget(13);
+    int pointShadowIds[NR_POINT_LIGHTS];
+    for (int i = 0; i < NR_POINT_LIGHTS; i++) {
+        PointLight light;
+        light.position = pointLightPositions[i];
+        light.radius = SHADOW_RADIUS;
+        pointShadowIds[i] = shadows.addPointLight(light);
+    }
+    SpotLight spotShadowLight;
+    spotShadowLight.position = spotLightPos;
+    spotShadowLight.direction = spotLightDir;
+    spotShadowLight.radius = SHADOW_RADIUS;
+    spotShadowLight.outerCos = outerCutOff;
+    const int spotShadowId = shadows.addSpotLight(spotShadowLight);
+
+    // 四个点光源、平行光和聚光叠加后会超过 1，先渲染到 HDR 目标再做色调映射。
+    // 不支持时退回直接渲染到默认帧缓冲
+    HdrPipeline hdr;
+    const bool useHdr = hdr.init();
+
+    // 灯光等逐帧参数在程序每帧第一次使用时设置
+    queue.setProgramSetup(&multipleLightsShader, [&](Shader& shader) {
+        PROFILE_SCOPE("lights");
+        shader.setVec3("viewPos", camera.getPosition());
+
+        // 设置平行光
+        shader.setVec3("dirLight.direction", sun.direction);
+        shader.setVec3("dirLight.ambient", glm::vec3(0.05f, 0.05f, 0.05f));
+        shader.setVec3("dirLight.diffuse", glm::vec3(0.4f, 0.4f, 0.4f));
+        shader.setVec3("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
+
+        // 设置点光源
+        for (int i = 0; i < NR_POINT_LIGHTS; i++) {
+            std::string prefix = "pointLights[" + std::to_string(i) + "].";
+            shader.setVec3(prefix + "position", pointLightPositions[i]);
+            shader.setVec3(prefix + "ambient", srgbToLinear(pointLightColors[i]) * 0.1f);
+            shader.setVec3(prefix + "diffuse", srgbToLinear(pointLightColors[i]) * 0.8f);
+            shader.setVec3(prefix + "specular", srgbToLinear(pointLightColors[i]));
+            shader.setFloat(prefix + "constant", 1.0f);
+            shader.setFloat(prefix + "linear", 0.09f);
+            shader.setFloat(prefix + "quadratic", 0.032f);
+        }
+
+        // 设置聚光
+        shader.setVec3("spotLight.position", spotLightPos);
+        shader.setVec3("spotLight.direction", spotLightDir);
+        shader.setVec3("spotLight.ambient", glm::vec3(0.0f, 0.0f, 0.0f));
+        shader.setVec3("spotLight.diffuse", glm::vec3(1.0f, 1.0f, 1.0f));
+        shader.setVec3("spotLight.specular", glm::vec3(1.0f, 1.0f, 1.0f));
+        shader.setFloat("spotLight.cutOff", cutOff);
+        shader.setFloat("spotLight.outerCutOff", outerCutOff);
+        shader.setFloat("spotLight.constant", 1.0f);
+        shader.setFloat("spotLight.linear", 0.09f);
+        shader.setFloat("spotLight.quadratic", 0.032f);
+
+        // 阴影贴图占用 1~3 号纹理单元
+        shadows.bind(shader, 1);
+        for (int i = 0; i < NR_POINT_LIGHTS; i++) {
+            shader.setInt("pointShadowIndices[" + std::to_string(i) + "]", shadows.shadowIndex(pointShadowIds[i]));
+        }
+        shader.setInt("spotShadowIndex", shadows.shadowIndex(spotShadowId));
+
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", view);
+    });
+    queue.setProgramSetup(&lightShader, [&](Shader& shader) {
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", view);
+    });
+
+    RenderMaterial cubeMaterial;
+    cubeMaterial.shader = &multipleLightsShader;
+    cubeMaterial.apply = [](Shader& shader) {
+        shader.setVec3("objectColor", srgbToLinear(glm::vec3(1.0f, 0.5f, 0.31f)));
+        shader.setVec3("material.ambient", glm::vec3(0.1f, 0.1f, 0.1f));
+        shader.setVec3("material.diffuse", glm::vec3(0.7f, 0.7f, 0.7f));
+        shader.setVec3("material.specular", glm::vec3(1.0f, 1.0f, 1.0f));
+        shader.setFloat("material.shininess", 32.0f);
+    };
+    const uint16_t cubeMaterialId = queue.addMaterial(cubeMaterial);
+
+    RenderMaterial lampMaterial;
+    lampMaterial.shader = &lightShader;
+    lampMaterial.colorUniform = "lightColor";
+    const uint16_t lampMaterialId = queue.addMaterial(lampMaterial);
+
     // 渲染循环
     while (!glfwWindowShouldClose(window))
     {
+        Profiler::get().beginFrame();
+
         // 计算时间
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
@@ -397,115 +529,125 @@ int main()
             spotLightPos.x = 2.0f * cos(time * lightSpeed * 0.7f);
             spotLightPos.z = 2.0f * sin(time * lightSpeed * 0.7f);
         }
+        // 参数没变时阴影直接复用缓存
+        for (int i = 0; i < NR_POINT_LIGHTS; i++) {
+            PointLight light;
+            light.position = pointLightPositions[i];
+            light.radius = SHADOW_RADIUS;
+            shadows.setPointLight(pointShadowIds[i], light);
+        }
+        spotShadowLight.position = spotLightPos;
+        spotShadowLight.outerCos = outerCutOff;
+        shadows.setSpotLight(spotShadowId, spotShadowLight);
 
         // 清除缓冲
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // 激活多光源着色器
-        multipleLightsShader.use();
-        
-        // 设置通用参数
-        multipleLightsShader.setVec3("viewPos", camera.getPosition());
-        multipleLightsShader.setVec3("objectColor", glm::vec3(1.0f, 0.5f, 0.31f));
-
-        // 设置材质
-        multipleLightsShader.setVec3("material.ambient", glm::vec3(0.1f, 0.1f, 0.1f));
-        multipleLightsShader.setVec3("material.diffuse", glm::vec3(0.7f, 0.7f, 0.7f));
-        multipleLightsShader.setVec3("material.specular", glm::vec3(1.0f, 1.0f, 1.0f));
-        multipleLightsShader.setFloat("material.shininess", 32.0f);
-
-        // 设置平行光
-        multipleLightsShader.setVec3("dirLight.direction", glm::vec3(-0.2f, -1.0f, -0.3f));
-        multipleLightsShader.setVec3("dirLight.ambient", glm::vec3(0.05f, 0.05f, 0.05f));
-        multipleLightsShader.setVec3("dirLight.diffuse", glm::vec3(0.4f, 0.4f, 0.4f));
-        multipleLightsShader.setVec3("dirLight.specular", glm::vec3(0.5f, 0.5f, 0.5f));
+        // 颜色常量按 sRGB 挑选，参与计算前转换到线性空间
+        const glm::vec3 clearColor = srgbToLinear(glm::vec3(0.1f, 0.1f, 0.1f));
+        int framebufferWidth = 0, framebufferHeight = 0;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        if (useHdr && hdr.resize(framebufferWidth, framebufferHeight)) {
+            hdr.begin(clearColor);
+        } else {
+            glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
 
-        // 设置点光源
-        for (int i = 0; i < NR_POINT_LIGHTS; i++) {
-            std::string prefix = "pointLights[" + std::to_string(i) + "].";
-            multipleLightsShader.setVec3(prefix + "position", pointLightPositions[i]);
-            multipleLightsShader.setVec3(prefix + "ambient", pointLightColors[i] * 0.1f);
-            multipleLightsShader.setVec3(prefix + "diffuse", pointLightColors[i] * 0.8f);
-            multipleLightsShader.setVec3(prefix + "specular", pointLightColors[i]);
-            multipleLightsShader.setFloat(prefix + "constant", 1.0f);
-            multipleLightsShader.setFloat(prefix + "linear", 0.09f);
-            multipleLightsShader.setFloat(prefix + "quadratic", 0.032f);
+        projection = camera.getProjectionMatrix((float)SCR_WIDTH / (float)SCR_HEIGHT);
+        view = camera.getViewMatrix();
+        const glm::vec3 cameraPos = camera.getPosition();
+        const Frustum frustum = Frustum::fromMatrix(projection * view);
+
+        // 阴影投射物：立方体和地面，灯泡不投射阴影，否则会挡住自己的光
+        {
+            PROFILE_SCOPE("shadows");
+            shadows.update(view, projection, 0.1f, 100.0f, sun, [&](const glm::mat4&) {
+                for (int i = 0; i < 4; i++) {
+                    shadows.setModel(glm::translate(glm::mat4(1.0f), cubePositions[i]));
+                    cubeMesh.draw();
+                }
+                shadows.setModel(floorModel);
+                cubeMesh.draw();
+            });
         }
 
-        // 设置聚光
-        multipleLightsShader.setVec3("spotLight.position", spotLightPos);
-        multipleLightsShader.setVec3("spotLight.direction", spotLightDir);
-        multipleLightsShader.setVec3("spotLight.ambient", glm::vec3(0.0f, 0.0f, 0.0f));
-        multipleLightsShader.setVec3("spotLight.diffuse", glm::vec3(1.0f, 1.0f, 1.0f));
-        multipleLightsShader.setVec3("spotLight.specular", glm::vec3(1.0f, 1.0f, 1.0f));
-        multipleLightsShader.setFloat("spotLight.cutOff", cutOff);
-        multipleLightsShader.setFloat("spotLight.outerCutOff", outerCutOff);
-        multipleLightsShader.setFloat("spotLight.constant", 1.0f);
-        multipleLightsShader.setFloat("spotLight.linear", 0.09f);
-        multipleLightsShader.setFloat("spotLight.quadratic", 0.032f);
-
-        // 设置变换矩阵
-        glm::mat4 projection = camera.getProjectionMatrix((float)SCR_WIDTH / (float)SCR_HEIGHT);
-        glm::mat4 view = camera.getViewMatrix();
-        multipleLightsShader.setMat4("projection", projection);
-        multipleLightsShader.setMat4("view", view);
-
-        // 绘制多个立方体
-        glm::mat4 model = glm::mat4(1.0f);
-        
-        // 主立方体
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
-        multipleLightsShader.setMat4("model", model);
-        cubeMesh.draw();
-
-        // 左侧立方体
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-2.0f, 0.0f, 0.0f));
-        multipleLightsShader.setMat4("model", model);
-        cubeMesh.draw();
-
-        // 右侧立方体
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(2.0f, 0.0f, 0.0f));
-        multipleLightsShader.setMat4("model", model);
-        cubeMesh.draw();
-
-        // 后方立方体
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, 0.0f, -2.0f));
-        multipleLightsShader.setMat4("model", model);
-        cubeMesh.draw();
-
-        // 激活光源着色器
-        lightShader.use();
-        lightShader.setMat4("projection", projection);
-        lightShader.setMat4("view", view);
-
-        // 绘制点光源
-        for (int i = 0; i < NR_POINT_LIGHTS; i++) {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, pointLightPositions[i]);
-            model = glm::scale(model, glm::vec3(0.2f));
-            lightShader.setVec3("lightColor", pointLightColors[i]);
-            lightShader.setMat4("model", model);
-            cubeMesh.draw();
+        // 提交绘制命令：立方体和灯共用一个网格，排序后每个程序只切换一次。
+        // 单位立方体的包围球半径为 sqrt(3)/2，视锥外的物体不提交
+        {
+            PROFILE_SCOPE("submit");
+            queue.clear();
+            for (int i = 0; i < 4; i++) {
+                if (!frustum.intersectsSphere(cubePositions[i], 0.8660254f)) continue;
+                DrawCommand command;
+                command.material = cubeMaterialId;
+                command.mesh = &cubeMesh;
+                command.model = glm::translate(glm::mat4(1.0f), cubePositions[i]);
+                command.depth = glm::length(cubePositions[i] - cameraPos);
+                queue.submit(command);
+            }
+            {
+                DrawCommand command;
+                command.material = cubeMaterialId;
+                command.mesh = &cubeMesh;
+                command.model = floorModel;
+                command.depth = glm::length(glm::vec3(floorModel[3]) - cameraPos);
+                queue.submit(command);
+            }
+            // 点光源和聚光的灯泡
+            for (int i = 0; i <= NR_POINT_LIGHTS; i++) {
+                const glm::vec3 position = i < NR_POINT_LIGHTS ? pointLightPositions[i] : spotLightPos;
+                if (!frustum.intersectsSphere(position, 0.2f * 0.8660254f)) continue;
+                DrawCommand command;
+                command.material = lampMaterialId;
+                command.mesh = &cubeMesh;
+                command.model = glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(0.2f));
+                command.color = srgbToLinear(i < NR_POINT_LIGHTS ? pointLightColors[i] : glm::vec3(1.0f));
+                command.depth = glm::length(position - cameraPos);
+                queue.submit(command);
+            }
+        }
+        {
+            PROFILE_SCOPE("draw");
+            queue.execute();
+        }
+        if (useHdr) {
+            PROFILE_SCOPE("post");
+            hdr.end(0);
         }
 
-        // 绘制聚光光源
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, spotLightPos);
-        model = glm::scale(model, glm::vec3(0.2f));
-        lightShader.setVec3("lightColor", glm::vec3(1.0f, 1.0f, 1.0f));
-        lightShader.setMat4("model", model);
-        cubeMesh.draw();
+        Profiler::get().endFrame();
 
         // 交换缓冲并检查事件
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    // 每帧耗时统计，trace 可在 chrome://tracing 中打开
+    const RenderQueue::Stats& queueStats = queue.stats();
+    std::cout << "RenderQueue: " << queueStats.draws << " draws, " << queueStats.programChanges
+              << " program changes, " << queueStats.meshBinds << " VAO binds per frame" << std::endl;
+    const GLStateCache::Stats& glStats = GLStateCache::get().stats();
+    std::cout << "GLStateCache: program " << glStats.program.issued << " issued / " << glStats.program.skipped
+              << " skipped, VAO " << glStats.vertexArray.issued << " / " << glStats.vertexArray.skipped
+              << ", texture " << glStats.texture.issued << " / " << glStats.texture.skipped << std::endl;
+    const ShadowMaps::Stats& shadowStats = shadows.stats();
+    std::cout << "ShadowMaps: " << shadowStats.tilesUsed << " atlas tiles, last frame " << shadowStats.tilesRendered
+              << " tiles rendered, " << shadowStats.lightsUpdated << " lights updated / " << shadowStats.lightsCached
+              << " cached / " << shadowStats.lightsDeferred << " deferred" << std::endl;
+    if (useHdr) {
+        const RenderTargetPool::Stats& poolStats = hdr.pool().stats();
+        std::cout << "HdrPipeline: exposure " << hdr.stats().exposure << ", " << hdr.stats().bloomLevels
+                  << " bloom levels, " << poolStats.targets << " pooled targets (" << poolStats.bytes / 1024
+                  << " KB), " << poolStats.created << " created / " << poolStats.reused << " reused" << std::endl;
+        const FrameGraph::Stats& graphStats = hdr.graph().stats();
+        std::cout << "FrameGraph: " << graphStats.passes << " passes (" << graphStats.culledPasses << " culled), "
+                  << graphStats.textures << " transient textures in " << graphStats.targets << " targets" << std::endl;
+        std::cout << hdr.graph().dump();
+    }
+    Profiler::get().print(std::cout);
+    Profiler::get().writeChromeTrace("multiple_lights_trace.json");
+
     // 清理资源
+    Profiler::get().releaseGpuResources();
     glfwTerminate();
     return 0;
 }
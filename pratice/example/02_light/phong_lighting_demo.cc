@@ -8,6 +8,8 @@
 #include "Shader.h"
 #include "Camera.h"
 #include "mesh.h"
+#include "ColorSpace.h"
+#include "GLStateCache.h"
 
 // 窗口设置
 const unsigned int SCR_WIDTH = 1200;
@@ -52,6 +54,7 @@ int main()
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -79,7 +82,9 @@ int main()
     }
 
     // 启用深度测试
-    glEnable(GL_DEPTH_TEST);
+    GLStateCache::get().enable(GL_DEPTH_TEST);
+    // sRGB 默认帧缓冲：着色器在线性空间计算光照，写入时由硬件编码为 sRGB
+    GLStateCache::get().enable(GL_FRAMEBUFFER_SRGB);
 
     // 创建Phong光照着色器
     Shader phongShader(
@@ -276,15 +281,17 @@ int main()
         }
 
         // 清除缓冲
-        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        // 颜色常量按 sRGB 挑选，参与计算前转换到线性空间
+        const glm::vec3 clearColor = srgbToLinear(glm::vec3(0.1f, 0.1f, 0.1f));
+        glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // 激活Phong着色器
         phongShader.use();
         
         // 设置光照参数
-        phongShader.setVec3("objectColor", objectColor);
-        phongShader.setVec3("lightColor", lightColor);
+        phongShader.setVec3("objectColor", srgbToLinear(objectColor));
+        phongShader.setVec3("lightColor", srgbToLinear(lightColor));
         phongShader.setVec3("lightPos", lightPos);
         phongShader.setVec3("viewPos", camera.getPosition());
         phongShader.setFloat("ambientStrength", ambientStrength);
@@ -306,7 +313,7 @@ int main()
 
         // 激活光源着色器
         lightShader.use();
-        lightShader.setVec3("lightColor", lightColor);
+        lightShader.setVec3("lightColor", srgbToLinear(lightColor));
         lightShader.setMat4("projection", projection);
         lightShader.setMat4("view", view);
 
@@ -0,0 +1,178 @@
+#include "Frustum.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// 任务系统扩展性测试：对 N 个物体做变换更新（逐帧动画 + 模型矩阵）和视锥剔除，
+// 线程数从 1 增加到硬件线程数，比较每帧耗时。剔除依赖变换计数器，统计结果由主线程专属任务汇总
+
+namespace {
+
+struct Objects {
+    std::vector<glm::vec3> basePosition;
+    std::vector<glm::vec3> axis;
+    std::vector<float> speed;
+    std::vector<float> radius;
+    std::vector<glm::mat4> model;
+    std::vector<glm::vec4> sphere;   // 世界空间包围球 xyz + 半径
+    std::vector<unsigned char> visible;
+};
+
+float random01(unsigned& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+void initObjects(Objects& objects, size_t count) {
+    unsigned state = 12345u;
+    objects.basePosition.resize(count);
+    objects.axis.resize(count);
+    objects.speed.resize(count);
+    objects.radius.resize(count);
+    objects.model.resize(count);
+    objects.sphere.resize(count);
+    objects.visible.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        objects.basePosition[i] = glm::vec3(random01(state) * 400.0f - 200.0f, random01(state) * 40.0f - 20.0f,
+                                            random01(state) * 400.0f - 200.0f);
+        objects.axis[i] = glm::normalize(glm::vec3(random01(state) - 0.5f, 1.0f, random01(state) - 0.5f));
+        objects.speed[i] = 0.5f + random01(state) * 2.0f;
+        objects.radius[i] = 0.5f + random01(state);
+    }
+}
+
+void updateTransforms(Objects& objects, float time, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        const float angle = time * objects.speed[i];
+        glm::vec3 position = objects.basePosition[i];
+        position.y += std::sin(angle) * 2.0f;
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+        model = glm::rotate(model, angle, objects.axis[i]);
+        model = glm::scale(model, glm::vec3(objects.radius[i]));
+        objects.model[i] = model;
+        objects.sphere[i] = glm::vec4(position, objects.radius[i] * 1.7320508f);
+    }
+}
+
+size_t cullSpheres(Objects& objects, const Frustum& frustum, size_t begin, size_t end) {
+    size_t visibleCount = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const glm::vec4& s = objects.sphere[i];
+        const bool inside = frustum.intersectsSphere(glm::vec3(s), s.w);
+        objects.visible[i] = inside ? 1 : 0;
+        visibleCount += inside ? 1 : 0;
+    }
+    return visibleCount;
+}
+
+struct Timing {
+    double transformMs = 0.0;
+    double cullMs = 0.0;
+    double frameMs = 0.0;
+    size_t visible = 0;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+Timing runBenchmark(unsigned threads, Objects& objects, int iterations) {
+    JobSystem jobs(threads - 1);
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+    Timing total;
+    // 第 0 次为预热，不计时
+    for (int iteration = 0; iteration <= iterations; ++iteration) {
+        const float time = iteration * 0.016f;
+        const glm::mat4 view = glm::lookAt(glm::vec3(std::cos(time) * 50.0f, 30.0f, std::sin(time) * 50.0f),
+                                           glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const Frustum frustum = Frustum::fromMatrix(projection * view);
+        const size_t count = objects.model.size();
+
+        // 分阶段计时：变换和剔除各自阻塞等待
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        jobs.parallelFor(count, [&objects, time](size_t begin, size_t end) {
+            updateTransforms(objects, time, begin, end);
+        });
+        const double transformMs = elapsedMs(start);
+        start = std::chrono::steady_clock::now();
+        std::atomic<size_t> visible(0);
+        jobs.parallelFor(count, [&objects, &frustum, &visible](size_t begin, size_t end) {
+            visible.fetch_add(cullSpheres(objects, frustum, begin, end), std::memory_order_relaxed);
+        });
+        const double cullMs = elapsedMs(start);
+
+        // 整帧用依赖串起来：剔除等变换完成，汇总只在主线程执行
+        start = std::chrono::steady_clock::now();
+        JobCounter transformDone, cullDone, frameDone;
+        std::atomic<size_t> frameVisible(0);
+        size_t reported = 0;
+        jobs.parallelFor(count, [&objects, time](size_t begin, size_t end) {
+            updateTransforms(objects, time, begin, end);
+        }, transformDone);
+        jobs.parallelFor(count, [&objects, &frustum, &frameVisible](size_t begin, size_t end) {
+            frameVisible.fetch_add(cullSpheres(objects, frustum, begin, end), std::memory_order_relaxed);
+        }, cullDone, 0, &transformDone);
+        jobs.runOnMainThread([&reported, &frameVisible]() { reported = frameVisible.load(); }, &frameDone, &cullDone);
+        jobs.wait(frameDone);
+        jobs.wait(cullDone);
+        jobs.wait(transformDone);
+        const double frameMs = elapsedMs(start);
+
+        if (reported != visible.load()) {
+            std::cerr << "visible count mismatch: " << reported << " vs " << visible.load() << std::endl;
+        }
+        if (iteration == 0) continue;
+        total.transformMs += transformMs;
+        total.cullMs += cullMs;
+        total.frameMs += frameMs;
+        total.visible = reported;
+    }
+    total.transformMs /= iterations;
+    total.cullMs /= iterations;
+    total.frameMs /= iterations;
+    return total;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t objectCount = 1000000;
+    int iterations = 20;
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--objects") == 0) objectCount = std::strtoul(argv[i + 1], nullptr, 10);
+        else if (std::strcmp(argv[i], "--iterations") == 0) iterations = std::max(1, std::atoi(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--threads") == 0) maxThreads = std::max(1, std::atoi(argv[i + 1]));
+    }
+
+    Objects objects;
+    initObjects(objects, objectCount);
+    std::cout << objectCount << " objects, " << iterations << " iterations, ms per frame\n";
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "transform" << std::setw(10) << "cull"
+              << std::setw(10) << "frame" << std::setw(10) << "speedup" << std::setw(10) << "visible" << "\n";
+
+    // 1, 2, 4 ... 直到 maxThreads
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    double baseline = 0.0;
+    for (unsigned threads : threadCounts) {
+        const Timing t = runBenchmark(threads, objects, iterations);
+        if (threads == 1) baseline = t.frameMs;
+        std::cout << std::fixed << std::setprecision(2) << std::setw(8) << threads << std::setw(12) << t.transformMs
+                  << std::setw(10) << t.cullMs << std::setw(10) << t.frameMs << std::setw(9) << baseline / t.frameMs
+                  << "x" << std::setw(10) << t.visible << "\n";
+    }
+    return 0;
+}
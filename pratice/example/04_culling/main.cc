@@ -0,0 +1,119 @@
+#include "Frustum.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// 视锥剔除测试：100k 到 10M 个包围球/包围盒，比较标量、SIMD 单线程、SIMD 多线程的耗时，
+// 并检查三者结果一致
+
+namespace {
+
+float random01(unsigned& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+glm::vec3 randomPosition(unsigned& state) {
+    return glm::vec3(random01(state) * 1000.0f - 500.0f, random01(state) * 100.0f - 50.0f,
+                     random01(state) * 1000.0f - 500.0f);
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 重复 iterations 次取平均，返回毫秒
+template <typename F>
+double measure(int iterations, F func) {
+    func();
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) func();
+    return elapsedMs(start) / iterations;
+}
+
+size_t countMismatches(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b) {
+    size_t mismatches = 0;
+    for (size_t i = 0; i < a.size(); ++i) mismatches += a[i] != b[i] ? 1 : 0;
+    return mismatches;
+}
+
+void printRow(const char* kind, size_t count, double scalarMs, double simdMs, double parallelMs, size_t visible,
+              size_t mismatches) {
+    std::cout << std::setw(6) << kind << std::setw(10) << count << std::fixed << std::setprecision(3)
+              << std::setw(10) << scalarMs << std::setw(10) << simdMs << std::setw(10) << parallelMs
+              << std::setprecision(1) << std::setw(8) << scalarMs / simdMs << "x" << std::setw(7)
+              << simdMs / parallelMs << "x" << std::setw(10) << visible << std::setw(6) << mismatches << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t maxObjects = 10000000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--max") == 0) maxObjects = std::strtoul(argv[i + 1], nullptr, 10);
+    }
+
+    JobSystem& jobs = JobSystem::get();
+    const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+    const glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(100.0f, 0.0f, 100.0f),
+                                       glm::vec3(0.0f, 1.0f, 0.0f));
+    const Frustum frustum = Frustum::fromMatrix(projection * view);
+
+    std::cout << "SIMD path: " << FrustumCuller::simdPath() << " (" << FrustumCuller::simdWidth()
+              << " objects per test), " << jobs.threadCount() << " threads, ms per pass\n";
+    std::cout << std::setw(6) << "kind" << std::setw(10) << "objects" << std::setw(10) << "scalar"
+              << std::setw(10) << "simd" << std::setw(10) << "parallel" << std::setw(9) << "simd"
+              << std::setw(8) << "mt" << std::setw(10) << "visible" << std::setw(6) << "diff" << "\n";
+
+    for (size_t count = 100000; count <= maxObjects; count *= 10) {
+        // 大数组重复次数少一些，每组总共处理约 2000 万个物体
+        const int iterations = static_cast<int>(std::max<size_t>(3, 20000000 / count));
+        unsigned state = 2024u;
+
+        SphereSoA spheres;
+        spheres.resize(count);
+        for (size_t i = 0; i < count; ++i) spheres.set(i, randomPosition(state), 0.5f + random01(state) * 4.0f);
+        std::vector<uint8_t> reference(count), simd(count), parallel(count);
+        size_t visible = 0;
+        const double sphereScalar = measure(iterations, [&]() {
+            visible = FrustumCuller::cullSpheresScalar(frustum, spheres, 0, count, reference.data());
+        });
+        const double sphereSimd = measure(iterations, [&]() {
+            FrustumCuller::cullSpheres(frustum, spheres, 0, count, simd.data());
+        });
+        const double sphereParallel = measure(iterations, [&]() {
+            FrustumCuller::cullSpheres(frustum, spheres, parallel.data(), jobs);
+        });
+        printRow("sphere", count, sphereScalar, sphereSimd, sphereParallel, visible,
+                 countMismatches(reference, simd) + countMismatches(reference, parallel));
+        spheres = SphereSoA();
+
+        AABBSoA boxes;
+        boxes.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const glm::vec3 center = randomPosition(state);
+            const glm::vec3 extent(0.5f + random01(state) * 3.0f, 0.5f + random01(state) * 3.0f,
+                                   0.5f + random01(state) * 3.0f);
+            boxes.set(i, center - extent, center + extent);
+        }
+        const double boxScalar = measure(iterations, [&]() {
+            visible = FrustumCuller::cullAABBsScalar(frustum, boxes, 0, count, reference.data());
+        });
+        const double boxSimd = measure(iterations, [&]() {
+            FrustumCuller::cullAABBs(frustum, boxes, 0, count, simd.data());
+        });
+        const double boxParallel = measure(iterations, [&]() {
+            FrustumCuller::cullAABBs(frustum, boxes, parallel.data(), jobs);
+        });
+        printRow("aabb", count, boxScalar, boxSimd, boxParallel, visible,
+                 countMismatches(reference, simd) + countMismatches(reference, parallel));
+    }
+    return 0;
+}
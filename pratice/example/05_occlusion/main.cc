@@ -0,0 +1,320 @@
+#include "Renderer.h"
+#include "Shader.h"
+#include "mesh.h"
+#include "Camera.h"
+#include "Frustum.h"
+#include "GLStateCache.h"
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+#include "Profiler.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <GLFW/glfw3.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// 遮挡剔除示例：迷宫一样的房间网格，墙后面放满小物体。
+// 1 只做视锥剔除，2 Hi-Z 遮挡剔除，3 遮挡查询 + 条件渲染；WASD + 鼠标移动相机
+// 用法：occlusion_example [--headless 帧数] [--mode frustum|hiz|query]
+
+enum class CullMode { Frustum, HiZ, Query };
+
+const int kGridSize = 16;          // 房间数 kGridSize x kGridSize
+const float kRoomSize = 12.0f;
+const float kWallHeight = 4.0f;
+const int kObjectsPerRoom = 60;
+
+Camera camera(glm::vec3(kRoomSize * 0.5f, 1.7f, kRoomSize * 0.5f));
+CullMode cullMode = CullMode::HiZ;
+float lastX = 400.0f, lastY = 300.0f;
+bool firstMouse = true;
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+void mouse_callback(GLFWwindow* /*window*/, double xposIn, double yposIn) {
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+    if (firstMouse) {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    camera.processMouseMovement(xpos - lastX, lastY - ypos);
+    lastX = xpos;
+    lastY = ypos;
+}
+
+void key_callback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/) {
+    if (action != GLFW_PRESS) return;
+    if (key == GLFW_KEY_ESCAPE) glfwSetWindowShouldClose(window, true);
+    if (key == GLFW_KEY_1) cullMode = CullMode::Frustum;
+    if (key == GLFW_KEY_2) cullMode = CullMode::HiZ;
+    if (key == GLFW_KEY_3) cullMode = CullMode::Query;
+}
+
+const char* modeName(CullMode mode) {
+    switch (mode) {
+    case CullMode::Frustum: return "frustum";
+    case CullMode::HiZ: return "hiz";
+    case CullMode::Query: return "query";
+    }
+    return "";
+}
+
+// 法线朝外的单位立方体 [-0.5, 0.5]
+void makeCube(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    const glm::vec3 normals[6] = {glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+                                  glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)};
+    for (int face = 0; face < 6; ++face) {
+        const glm::vec3 n = normals[face];
+        const glm::vec3 u = face < 2 ? glm::vec3(0, 1, 0) : (face < 4 ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0));
+        const glm::vec3 v = glm::cross(n, u);
+        const uint32_t base = static_cast<uint32_t>(vertices.size());
+        for (int i = 0; i < 4; ++i) {
+            const float su = (i == 1 || i == 2) ? 0.5f : -0.5f;
+            const float sv = i >= 2 ? 0.5f : -0.5f;
+            Vertex vertex;
+            vertex.position = n * 0.5f + u * su + v * sv;
+            vertex.color = glm::vec3(1.0f);
+            vertex.normal = n;
+            vertex.texcoord = glm::vec2(su + 0.5f, sv + 0.5f);
+            vertices.push_back(vertex);
+        }
+        const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+        for (int i = 0; i < 6; ++i) indices.push_back(base + quad[i]);
+    }
+}
+
+struct Box {
+    glm::vec3 center;
+    glm::vec3 extent;
+    glm::vec3 color;
+};
+
+float random01(unsigned& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+// 房间之间的墙随机留门，墙是遮挡体，每个房间放若干小物体
+void buildScene(std::vector<Box>& walls, std::vector<Box>& objects) {
+    unsigned state = 7u;
+    const float thickness = 0.3f;
+    const float span = kGridSize * kRoomSize;
+    Box floor;
+    floor.center = glm::vec3(span * 0.5f, -0.05f, span * 0.5f);
+    floor.extent = glm::vec3(span * 0.5f, 0.05f, span * 0.5f);
+    floor.color = glm::vec3(0.3f);
+    walls.push_back(floor);
+    for (int line = 0; line <= kGridSize; ++line) {
+        for (int cell = 0; cell < kGridSize; ++cell) {
+            for (int axis = 0; axis < 2; ++axis) {
+                const bool border = line == 0 || line == kGridSize;
+                const bool door = !border && random01(state) < 0.35f;
+                const float along = (cell + 0.5f) * kRoomSize;
+                const float across = line * kRoomSize;
+                // 有门的墙拆成两段，中间留 2 个单位宽的口
+                const int pieces = door ? 2 : 1;
+                for (int piece = 0; piece < pieces; ++piece) {
+                    const float length = door ? (kRoomSize - 2.0f) * 0.5f : kRoomSize;
+                    const float offset = door ? (piece == 0 ? -1.0f - length * 0.5f : 1.0f + length * 0.5f) : 0.0f;
+                    Box wall;
+                    wall.center = axis == 0 ? glm::vec3(along + offset, kWallHeight * 0.5f, across)
+                                            : glm::vec3(across, kWallHeight * 0.5f, along + offset);
+                    wall.extent = axis == 0 ? glm::vec3(length * 0.5f, kWallHeight * 0.5f, thickness)
+                                            : glm::vec3(thickness, kWallHeight * 0.5f, length * 0.5f);
+                    wall.color = glm::vec3(0.7f, 0.65f, 0.6f);
+                    walls.push_back(wall);
+                }
+            }
+        }
+    }
+    for (int z = 0; z < kGridSize; ++z) {
+        for (int x = 0; x < kGridSize; ++x) {
+            for (int i = 0; i < kObjectsPerRoom; ++i) {
+                Box object;
+                const float size = 0.2f + random01(state) * 0.4f;
+                object.center = glm::vec3((x + 0.1f + random01(state) * 0.8f) * kRoomSize, size + random01(state) * 2.0f,
+                                          (z + 0.1f + random01(state) * 0.8f) * kRoomSize);
+                object.extent = glm::vec3(size);
+                object.color = glm::vec3(0.2f + random01(state) * 0.8f, 0.2f + random01(state) * 0.8f,
+                                         0.2f + random01(state) * 0.8f);
+                objects.push_back(object);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    int headlessFrames = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            headlessFrames = (i + 1 < argc) ? std::atoi(argv[++i]) : 300;
+        } else if (std::strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "frustum") == 0) cullMode = CullMode::Frustum;
+            else if (std::strcmp(mode, "query") == 0) cullMode = CullMode::Query;
+            else cullMode = CullMode::HiZ;
+        }
+    }
+
+    std::unique_ptr<Renderer> rendererPtr;
+    if (headlessFrames > 0) {
+        rendererPtr = Renderer::createHeadless(1280, 720);
+        if (!rendererPtr) return 1;
+    } else {
+        rendererPtr.reset(new Renderer(1280, 720, "Occlusion Culling Demo"));
+        glfwSetInputMode(rendererPtr->window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetCursorPosCallback(rendererPtr->window(), mouse_callback);
+        glfwSetKeyCallback(rendererPtr->window(), key_callback);
+    }
+    Renderer& renderer = *rendererPtr;
+
+    const char* vertexShaderSource =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "layout (location = 2) in vec3 aNormal;\n"
+        "uniform mat4 viewProjection;\n"
+        "uniform mat4 model;\n"
+        "out vec3 Normal;\n"
+        "void main() {\n"
+        "    Normal = mat3(model) * aNormal;\n"
+        "    gl_Position = viewProjection * model * vec4(aPos, 1.0);\n"
+        "}\n";
+    const char* fragmentShaderSource =
+        "#version 330 core\n"
+        "in vec3 Normal;\n"
+        "uniform vec3 color;\n"
+        "out vec4 FragColor;\n"
+        "void main() {\n"
+        "    float diffuse = max(dot(normalize(Normal), normalize(vec3(0.4, 1.0, 0.3))), 0.0);\n"
+        "    FragColor = vec4(color * (0.25 + 0.75 * diffuse), 1.0);\n"
+        "}\n";
+    Shader shader(vertexShaderSource, fragmentShaderSource, true);
+    const GLint viewProjectionLoc = glGetUniformLocation(shader.ID(), "viewProjection");
+    const GLint modelLoc = glGetUniformLocation(shader.ID(), "model");
+    const GLint colorLoc = glGetUniformLocation(shader.ID(), "color");
+    std::vector<Vertex> cubeVertices;
+    std::vector<uint32_t> cubeIndices;
+    makeCube(cubeVertices, cubeIndices);
+    Mesh cube(cubeVertices, cubeIndices);
+
+    std::vector<Box> walls, objects;
+    buildScene(walls, objects);
+    AABBSoA objectBounds;
+    objectBounds.resize(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+        objectBounds.set(i, objects[i].center - objects[i].extent, objects[i].center + objects[i].extent);
+    }
+    std::vector<uint8_t> inFrustum(objects.size());
+
+    HiZCuller hiz;
+    OcclusionQueryCuller queries;
+    if (!hiz.init() && cullMode == CullMode::HiZ) cullMode = CullMode::Query;
+    if (!queries.init() && cullMode == CullMode::Query) cullMode = CullMode::Frustum;
+    GLStateCache::get().enable(GL_DEPTH_TEST);
+
+    auto drawBox = [&](const Box& box) {
+        const glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), box.center), box.extent * 2.0f);
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+        glUniform3fv(colorLoc, 1, glm::value_ptr(box.color));
+        cube.drawBound();
+    };
+
+    size_t framesInWindow = 0, frustumVisibleSum = 0, drawnSum = 0;
+    CullMode lastMode = cullMode;
+    renderer.run([&]() {
+        float currentFrame = static_cast<float>(renderer.time());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        int width = renderer.width(), height = renderer.height();
+        glm::mat4 view;
+        if (renderer.window()) {
+            camera.processKeyboard(renderer.window(), deltaTime);
+            glfwGetFramebufferSize(renderer.window(), &width, &height);
+            view = camera.getViewMatrix();
+        } else {
+            // 无窗口模式沿第一排房间来回走，视线穿过门洞
+            const float t = renderer.frameIndex() * 0.01f;
+            const glm::vec3 eye(kRoomSize * (0.5f + (kGridSize - 1) * 0.5f * (1.0f - std::cos(t))), 1.7f,
+                                kRoomSize * 0.5f);
+            view = glm::lookAt(eye, eye + glm::vec3(std::cos(t * 3.0f), 0.0f, std::sin(t * 3.0f)),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        if (width <= 0 || height <= 0) return;
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), static_cast<float>(width) / height,
+                                                      0.1f, 300.0f);
+        const glm::mat4 viewProjection = projection * view;
+        const glm::vec3 cameraPos = glm::vec3(glm::inverse(view)[3]);
+        if (cullMode != lastMode) {
+            // 切换模式时丢弃旧结果，避免用过期的可见性
+            hiz.reset();
+            lastMode = cullMode;
+        }
+
+        size_t frustumVisible = 0;
+        {
+            PROFILE_SCOPE("cull");
+            if (cullMode == CullMode::HiZ) hiz.fetchResults();
+            frustumVisible = FrustumCuller::cullAABBs(Frustum::fromMatrix(viewProjection), objectBounds,
+                                                      inFrustum.data(), JobSystem::get());
+        }
+
+        size_t drawn = 0;
+        {
+            PROFILE_SCOPE("draw");
+            shader.use();
+            glUniformMatrix4fv(viewProjectionLoc, 1, GL_FALSE, glm::value_ptr(viewProjection));
+            cube.bind();
+            // 墙先画，作为遮挡体
+            for (const Box& wall : walls) drawBox(wall);
+
+            if (cullMode == CullMode::Query) {
+                queries.beginTests(viewProjection, cameraPos, objects.size());
+                for (size_t i = 0; i < objects.size(); ++i) {
+                    if (inFrustum[i]) queries.testBounds(i, objects[i].center, objects[i].extent);
+                }
+                queries.endTests();
+                shader.use();
+                cube.bind();
+            }
+            for (size_t i = 0; i < objects.size(); ++i) {
+                if (!inFrustum[i]) continue;
+                if (cullMode == CullMode::HiZ && !hiz.isVisible(i)) continue;
+                if (cullMode == CullMode::Query) queries.beginConditional(i);
+                drawBox(objects[i]);
+                if (cullMode == CullMode::Query) queries.endConditional();
+                ++drawn;
+            }
+        }
+
+        if (cullMode == CullMode::HiZ) {
+            PROFILE_SCOPE("hiz");
+            hiz.build(renderer.framebuffer(), width, height, viewProjection);
+            hiz.test(objectBounds);
+        }
+
+        ++framesInWindow;
+        frustumVisibleSum += frustumVisible;
+        drawnSum += drawn;
+        if (framesInWindow == 120) {
+            std::cout << "[" << modeName(cullMode) << "] objects " << objects.size() << ", in frustum "
+                      << frustumVisibleSum / framesInWindow << ", drawn " << drawnSum / framesInWindow;
+            if (cullMode == CullMode::HiZ) {
+                std::cout << ", occluded " << hiz.stats().occluded << ", latency " << hiz.stats().latency
+                          << " frames";
+            }
+            std::cout << std::endl;
+            framesInWindow = frustumVisibleSum = drawnSum = 0;
+        }
+    }, headlessFrames);
+
+    Profiler::get().print(std::cout);
+    return 0;
+}
@@ -0,0 +1,568 @@
+#include "Renderer.h"
+#include "Shader.h"
+#include "mesh.h"
+#include "Camera.h"
+#include "ClusteredLights.h"
+#include "ColorSpace.h"
+#include "DeferredRenderer.h"
+#include "FrameCapture.h"
+#include "GLStateCache.h"
+#include "HdrPipeline.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// 多光源示例：柱子阵列上方飘着几千个点光源，外加一个跟随相机的手电筒聚光。
+// 1 前向着色（每个片段遍历所有光源），2 延迟着色，3 分簇前向着色（只遍历所在簇的光源）；
+// +/- 光源数量翻倍/减半，F 开关手电筒，T 切换 ACES/Reinhard 色调映射，B 开关泛光
+// 用法：deferred_example [--headless 帧数] [--mode forward|deferred|clustered] [--lights 数量] [--no-hdr]
+//                        [--size 宽x高] [--capture 输出路径 (.png/.qoi 为图片序列，.y4m 为视频)]
+
+enum class ShadingMode { Forward, Deferred, Clustered };
+
+const int kGridSize = 24;         // 柱子 kGridSize x kGridSize
+const float kSpacing = 4.0f;
+const int kMaxLights = 16384;
+const size_t kMarkerCount = 64;   // 只给前几个光源画灯泡
+const float kNear = 0.1f;
+const float kFar = 300.0f;
+
+Camera camera(glm::vec3(kGridSize * kSpacing * 0.5f, 6.0f, kGridSize * kSpacing + 10.0f));
+ShadingMode shadingMode = ShadingMode::Deferred;
+int lightCount = 2048;
+bool flashlight = true;
+HdrPipeline* hdrPipeline = nullptr;
+const float kBloomIntensity = 0.05f;
+float lastX = 400.0f, lastY = 300.0f;
+bool firstMouse = true;
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+void mouse_callback(GLFWwindow* /*window*/, double xposIn, double yposIn) {
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+    if (firstMouse) {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    camera.processMouseMovement(xpos - lastX, lastY - ypos);
+    lastX = xpos;
+    lastY = ypos;
+}
+
+void key_callback(GLFWwindow* window, int key, int /*scancode*/, int action, int /*mods*/) {
+    if (action != GLFW_PRESS) return;
+    if (key == GLFW_KEY_ESCAPE) glfwSetWindowShouldClose(window, true);
+    if (key == GLFW_KEY_1) shadingMode = ShadingMode::Forward;
+    if (key == GLFW_KEY_2) shadingMode = ShadingMode::Deferred;
+    if (key == GLFW_KEY_3) shadingMode = ShadingMode::Clustered;
+    if (key == GLFW_KEY_EQUAL || key == GLFW_KEY_KP_ADD) lightCount = std::min(lightCount * 2, kMaxLights);
+    if (key == GLFW_KEY_MINUS || key == GLFW_KEY_KP_SUBTRACT) lightCount = std::max(lightCount / 2, 1);
+    if (key == GLFW_KEY_F) flashlight = !flashlight;
+    if (hdrPipeline && key == GLFW_KEY_T) {
+        const bool aces = hdrPipeline->toneMapper() == HdrPipeline::ToneMapper::Aces;
+        hdrPipeline->setToneMapper(aces ? HdrPipeline::ToneMapper::Reinhard : HdrPipeline::ToneMapper::Aces);
+    }
+    if (hdrPipeline && key == GLFW_KEY_B) {
+        hdrPipeline->setBloomIntensity(hdrPipeline->bloomIntensity() > 0.0f ? 0.0f : kBloomIntensity);
+    }
+}
+
+// 法线朝外的单位立方体 [-0.5, 0.5]
+void makeCube(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    const glm::vec3 normals[6] = {glm::vec3(1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0),
+                                  glm::vec3(0, -1, 0), glm::vec3(0, 0, 1), glm::vec3(0, 0, -1)};
+    for (int face = 0; face < 6; ++face) {
+        const glm::vec3 n = normals[face];
+        const glm::vec3 u = face < 2 ? glm::vec3(0, 1, 0) : (face < 4 ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0));
+        const glm::vec3 v = glm::cross(n, u);
+        const uint32_t base = static_cast<uint32_t>(vertices.size());
+        for (int i = 0; i < 4; ++i) {
+            const float su = (i == 1 || i == 2) ? 0.5f : -0.5f;
+            const float sv = i >= 2 ? 0.5f : -0.5f;
+            Vertex vertex;
+            vertex.position = n * 0.5f + u * su + v * sv;
+            vertex.color = glm::vec3(1.0f);
+            vertex.normal = n;
+            vertex.texcoord = glm::vec2(su + 0.5f, sv + 0.5f);
+            vertices.push_back(vertex);
+        }
+        const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+        for (int i = 0; i < 6; ++i) indices.push_back(base + quad[i]);
+    }
+}
+
+float random01(unsigned& state) {
+    state = state * 1664525u + 1013904223u;
+    return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+struct Object {
+    glm::mat4 model;
+    glm::vec3 albedo;  // 线性
+    float specular;
+    float shininess;
+};
+
+// 光源围绕各自的锚点转圈
+struct LightAnchor {
+    glm::vec3 center;
+    float orbit;
+    float speed;
+    float phase;
+};
+
+void buildScene(std::vector<Object>& objects) {
+    unsigned state = 11u;
+    const float span = kGridSize * kSpacing;
+    Object ground;
+    ground.model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(span * 0.5f, -0.05f, span * 0.5f)),
+                              glm::vec3(span + 8.0f, 0.1f, span + 8.0f));
+    ground.albedo = srgbToLinear(glm::vec3(0.6f));
+    ground.specular = 0.2f;
+    ground.shininess = 16.0f;
+    objects.push_back(ground);
+    for (int z = 0; z < kGridSize; ++z) {
+        for (int x = 0; x < kGridSize; ++x) {
+            const float height = 1.0f + random01(state) * 4.0f;
+            Object pillar;
+            pillar.model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3((x + 0.5f) * kSpacing, height * 0.5f,
+                                                                               (z + 0.5f) * kSpacing)),
+                                      glm::vec3(1.2f, height, 1.2f));
+            pillar.albedo = srgbToLinear(glm::vec3(0.5f + random01(state) * 0.5f, 0.5f + random01(state) * 0.5f,
+                                                   0.5f + random01(state) * 0.5f));
+            pillar.specular = 0.5f;
+            pillar.shininess = 32.0f;
+            objects.push_back(pillar);
+        }
+    }
+}
+
+// 饱和度较高的随机颜色
+glm::vec3 randomColor(unsigned& state) {
+    const float hue = random01(state) * 6.0f;
+    const glm::vec3 rgb(std::abs(hue - 3.0f) - 1.0f, 2.0f - std::abs(hue - 2.0f), 2.0f - std::abs(hue - 4.0f));
+    return glm::clamp(rgb, 0.0f, 1.0f);
+}
+
+void buildLights(std::vector<LightAnchor>& anchors, std::vector<PointLight>& lights) {
+    unsigned state = 23u;
+    const float span = kGridSize * kSpacing;
+    anchors.resize(kMaxLights);
+    lights.resize(kMaxLights);
+    for (int i = 0; i < kMaxLights; ++i) {
+        anchors[i].center = glm::vec3(random01(state) * span, 0.4f + random01(state) * 2.5f, random01(state) * span);
+        anchors[i].orbit = 0.5f + random01(state) * 2.0f;
+        anchors[i].speed = 0.3f + random01(state) * 1.2f;
+        anchors[i].phase = random01(state) * 6.2831853f;
+        lights[i].color = srgbToLinear(randomColor(state));
+        lights[i].radius = 3.0f + random01(state) * 3.0f;
+        lights[i].intensity = 3.0f + random01(state) * 5.0f;
+    }
+}
+
+const char* modeName(ShadingMode mode) {
+    switch (mode) {
+    case ShadingMode::Forward: return "forward";
+    case ShadingMode::Deferred: return "deferred";
+    case ShadingMode::Clustered: return "clustered";
+    }
+    return "";
+}
+
+int main(int argc, char** argv) {
+    int headlessFrames = 0;
+    bool useHdr = true;
+    int windowWidth = 1280, windowHeight = 720;
+    const char* capturePath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--headless") == 0) {
+            headlessFrames = (i + 1 < argc) ? std::atoi(argv[++i]) : 300;
+        } else if (std::strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            const char* mode = argv[++i];
+            if (std::strcmp(mode, "forward") == 0) shadingMode = ShadingMode::Forward;
+            else if (std::strcmp(mode, "clustered") == 0) shadingMode = ShadingMode::Clustered;
+            else shadingMode = ShadingMode::Deferred;
+        } else if (std::strcmp(argv[i], "--lights") == 0 && i + 1 < argc) {
+            lightCount = std::max(1, std::min(std::atoi(argv[++i]), kMaxLights));
+        } else if (std::strcmp(argv[i], "--no-hdr") == 0) {
+            useHdr = false;
+        } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            int w = 0, h = 0;
+            if (std::sscanf(argv[++i], "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+                windowWidth = w;
+                windowHeight = h;
+            }
+        } else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+            capturePath = argv[++i];
+        }
+    }
+
+    std::unique_ptr<Renderer> rendererPtr;
+    if (headlessFrames > 0) {
+        rendererPtr = Renderer::createHeadless(windowWidth, windowHeight);
+        if (!rendererPtr) return 1;
+    } else {
+        rendererPtr.reset(new Renderer(windowWidth, windowHeight, "Deferred Shading Demo"));
+        glfwSetInputMode(rendererPtr->window(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        glfwSetCursorPosCallback(rendererPtr->window(), mouse_callback);
+        glfwSetKeyCallback(rendererPtr->window(), key_callback);
+    }
+    Renderer& renderer = *rendererPtr;
+
+    // 几千个光源叠加很容易超过 1，渲染到 HDR 目标再做色调映射
+    HdrPipeline hdr;
+    if (useHdr && hdr.init()) {
+        hdr.setBloomIntensity(kBloomIntensity);
+        renderer.setHdr(&hdr);
+        hdrPipeline = &hdr;
+    }
+
+    DeferredRenderer deferred;
+    if (!deferred.init()) {
+        std::cerr << "Deferred shading unavailable, falling back to forward" << std::endl;
+        shadingMode = ShadingMode::Forward;
+    }
+    deferred.setBackgroundColor(srgbToLinear(glm::vec3(0.2f, 0.3f, 0.3f)));
+    ClusteredLights clusters;
+    if (!clusters.init() && shadingMode == ShadingMode::Clustered) shadingMode = ShadingMode::Forward;
+
+    // 前向着色：光源放在纹理缓冲里，每个片段遍历全部光源，衰减和延迟路径一致。
+    // 定义 CLUSTERED 时改为只遍历片段所在簇的光源
+    const char* forwardVS =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "layout (location = 2) in vec3 aNormal;\n"
+        "uniform mat4 view;\n"
+        "uniform mat4 projection;\n"
+        "uniform mat4 model;\n"
+        "out vec3 FragPos;\n"
+        "out vec3 Normal;\n"
+        "out float ViewDepth;\n"
+        "void main() {\n"
+        "    FragPos = vec3(model * vec4(aPos, 1.0));\n"
+        "    Normal = mat3(transpose(inverse(model))) * aNormal;\n"
+        "    vec4 viewPos = view * vec4(FragPos, 1.0);\n"
+        "    ViewDepth = -viewPos.z;\n"
+        "    gl_Position = projection * viewPos;\n"
+        "}\n";
+    const char* forwardFS =
+        "in vec3 FragPos;\n"
+        "in vec3 Normal;\n"
+        "in float ViewDepth;\n"
+        "#ifndef CLUSTERED\n"
+        "uniform samplerBuffer lights;\n"
+        "uniform int lightCount;\n"
+        "#endif\n"
+        "uniform vec3 viewPos;\n"
+        "uniform vec3 albedo;\n"
+        "uniform float specular;\n"
+        "uniform float shininess;\n"
+        "uniform vec3 sunDirection;\n"
+        "uniform vec3 sunColor;\n"
+        "uniform vec3 ambient;\n"
+        "uniform vec4 spotPositionRadius;\n"
+        "uniform vec4 spotColorOuter;\n"
+        "uniform vec4 spotDirectionInner;\n"
+        "out vec4 FragColor;\n"
+        "vec3 shade(vec3 normal, vec3 viewDir, vec3 lightDir, vec3 radiance) {\n"
+        "    float diff = max(dot(normal, lightDir), 0.0);\n"
+        "    float spec = pow(max(dot(normal, normalize(lightDir + viewDir)), 0.0), shininess);\n"
+        "    return radiance * (diff * albedo + spec * specular);\n"
+        "}\n"
+        "float attenuate(float distance, float radius) {\n"
+        "    float ratio = distance / radius;\n"
+        "    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);\n"
+        "    return window * window / (1.0 + distance * distance);\n"
+        "}\n"
+        "void main() {\n"
+        "    vec3 normal = normalize(Normal);\n"
+        "    vec3 viewDir = normalize(viewPos - FragPos);\n"
+        "    vec3 color = ambient * albedo + shade(normal, viewDir, normalize(-sunDirection), sunColor);\n"
+        "#ifdef CLUSTERED\n"
+        "    uvec2 range = clusterLightRange(ViewDepth);\n"
+        "    for (uint i = range.x; i < range.x + range.y; ++i) {\n"
+        "        vec4 positionRadius;\n"
+        "        vec3 lightColor;\n"
+        "        clusterLight(i, positionRadius, lightColor);\n"
+        "#else\n"
+        "    for (int i = 0; i < lightCount; ++i) {\n"
+        "        vec4 positionRadius = texelFetch(lights, i * 2);\n"
+        "        vec3 lightColor = texelFetch(lights, i * 2 + 1).rgb;\n"
+        "#endif\n"
+        "        vec3 toLight = positionRadius.xyz - FragPos;\n"
+        "        float distance = length(toLight);\n"
+        "        if (distance >= positionRadius.w) continue;\n"
+        "        vec3 radiance = lightColor * attenuate(distance, positionRadius.w);\n"
+        "        color += shade(normal, viewDir, toLight / max(distance, 1e-4), radiance);\n"
+        "    }\n"
+        "    vec3 toSpot = spotPositionRadius.xyz - FragPos;\n"
+        "    float spotDistance = length(toSpot);\n"
+        "    if (spotColorOuter.w >= -1.0 && spotDistance < spotPositionRadius.w) {\n"
+        "        vec3 lightDir = toSpot / max(spotDistance, 1e-4);\n"
+        "        float theta = dot(-lightDir, normalize(spotDirectionInner.xyz));\n"
+        "        float cone = clamp((theta - spotColorOuter.w) / max(spotDirectionInner.w - spotColorOuter.w, 1e-4),\n"
+        "                           0.0, 1.0);\n"
+        "        color += shade(normal, viewDir, lightDir,\n"
+        "                       spotColorOuter.rgb * attenuate(spotDistance, spotPositionRadius.w) * cone);\n"
+        "    }\n"
+        "    FragColor = vec4(color, 1.0);\n"
+        "}\n";
+    Shader forwardShader(forwardVS, std::string("#version 330 core\n") + forwardFS, true);
+    Shader clusteredShader(forwardVS,
+                           "#version 330 core\n#define CLUSTERED\n" + ClusteredLights::shaderSource() + forwardFS,
+                           true);
+    forwardShader.use();
+    forwardShader.setInt("lights", 0);
+
+    GLuint lightBuffer = 0, lightTexture = 0;
+    glGenBuffers(1, &lightBuffer);
+    glGenTextures(1, &lightTexture);
+    GLStateCache::get().bindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, kMaxLights * 2 * sizeof(glm::vec4), nullptr, GL_STREAM_DRAW);
+    GLStateCache::get().bindTexture(GL_TEXTURE_BUFFER, lightTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, lightBuffer);
+
+    // 灯泡在延迟结果之上前向绘制，依赖 resolve 拷贝过来的深度
+    const char* markerVS =
+        "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "uniform mat4 viewProjection;\n"
+        "uniform mat4 model;\n"
+        "void main() {\n"
+        "    gl_Position = viewProjection * model * vec4(aPos, 1.0);\n"
+        "}\n";
+    const char* markerFS =
+        "#version 330 core\n"
+        "uniform vec3 color;\n"
+        "out vec4 FragColor;\n"
+        "void main() {\n"
+        "    FragColor = vec4(color, 1.0);\n"
+        "}\n";
+    Shader markerShader(markerVS, markerFS, true);
+    const GLint markerModelLoc = glGetUniformLocation(markerShader.ID(), "model");
+    const GLint markerColorLoc = glGetUniformLocation(markerShader.ID(), "color");
+
+    std::vector<Vertex> cubeVertices;
+    std::vector<uint32_t> cubeIndices;
+    makeCube(cubeVertices, cubeIndices);
+    Mesh cube(cubeVertices, cubeIndices);
+
+    std::vector<Object> objects;
+    buildScene(objects);
+    std::vector<LightAnchor> anchors;
+    std::vector<PointLight> allLights, pointLights;
+    buildLights(anchors, allLights);
+    std::vector<SpotLight> spotLights;
+    std::vector<glm::vec4> lightTexels;
+    DirectionalLight sun;
+    sun.color = glm::vec3(0.05f);
+    sun.ambient = glm::vec3(0.02f);
+    GLStateCache::get().enable(GL_DEPTH_TEST);
+
+    // 录制：读回和编码都是异步的，GL 线程只提交 glReadPixels
+    FrameCapture capture;
+    if (capturePath) {
+        FrameCapture::Format format;
+        int captureWidth = renderer.width(), captureHeight = renderer.height();
+        if (renderer.window()) glfwGetFramebufferSize(renderer.window(), &captureWidth, &captureHeight);
+        if (!FrameCapture::formatFromPath(capturePath, format)) {
+            std::cerr << "Unknown capture format: " << capturePath << std::endl;
+        } else if (capture.start(capturePath, format, captureWidth, captureHeight)) {
+            renderer.setCapture(&capture);
+        }
+    }
+    const std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+
+    size_t framesInWindow = 0;
+    ShadingMode lastMode = shadingMode;
+    renderer.run([&]() {
+        float currentFrame = static_cast<float>(renderer.time());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        int width = renderer.width(), height = renderer.height();
+        glm::mat4 view;
+        if (renderer.window()) {
+            camera.processKeyboard(renderer.window(), deltaTime);
+            glfwGetFramebufferSize(renderer.window(), &width, &height);
+            view = camera.getViewMatrix();
+        } else {
+            // 无窗口模式绕场地中心转圈
+            const float t = renderer.frameIndex() * 0.01f;
+            const glm::vec3 center(kGridSize * kSpacing * 0.5f, 0.0f, kGridSize * kSpacing * 0.5f);
+            const glm::vec3 eye = center + glm::vec3(std::cos(t) * 40.0f, 12.0f, std::sin(t) * 40.0f);
+            view = glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+        }
+        if (width <= 0 || height <= 0) return;
+        if (shadingMode == ShadingMode::Deferred && (!deferred.isReady() || !deferred.resize(width, height))) {
+            shadingMode = ShadingMode::Forward;
+        }
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), static_cast<float>(width) / height,
+                                                      kNear, kFar);
+        const glm::mat4 viewProjection = projection * view;
+        const glm::mat4 inverseView = glm::inverse(view);
+        const glm::vec3 cameraPos = glm::vec3(inverseView[3]);
+
+        {
+            PROFILE_SCOPE("animate");
+            pointLights.resize(lightCount);
+            for (int i = 0; i < lightCount; ++i) {
+                const LightAnchor& anchor = anchors[i];
+                const float angle = anchor.phase + currentFrame * anchor.speed;
+                pointLights[i] = allLights[i];
+                pointLights[i].position =
+                    anchor.center + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * anchor.orbit;
+            }
+            spotLights.clear();
+            if (flashlight) {
+                SpotLight spot;
+                spot.position = cameraPos;
+                spot.direction = -glm::vec3(inverseView[2]);
+                spot.radius = 40.0f;
+                spot.intensity = 60.0f;
+                spotLights.push_back(spot);
+            }
+        }
+
+        if (shadingMode == ShadingMode::Deferred) {
+            {
+                PROFILE_SCOPE("gbuffer");
+                deferred.beginGeometryPass(view, projection);
+                cube.bind();
+                for (const Object& object : objects) {
+                    deferred.setObject(object.model, object.albedo, object.specular, object.shininess);
+                    cube.drawBound();
+                }
+                deferred.endGeometryPass();
+            }
+            {
+                PROFILE_SCOPE("lighting");
+                deferred.lightingPass(sun, pointLights, spotLights);
+            }
+            PROFILE_SCOPE("resolve");
+            deferred.resolve(renderer.framebuffer());
+        } else {
+            const bool clustered = shadingMode == ShadingMode::Clustered;
+            if (clustered) {
+                PROFILE_SCOPE("clusters");
+                clusters.update(view, projection, kNear, kFar, pointLights, JobSystem::get());
+            } else {
+                lightTexels.resize(pointLights.size() * 2);
+                for (size_t i = 0; i < pointLights.size(); ++i) {
+                    lightTexels[i * 2] = glm::vec4(pointLights[i].position, pointLights[i].radius);
+                    lightTexels[i * 2 + 1] = glm::vec4(pointLights[i].color * pointLights[i].intensity, 0.0f);
+                }
+                GLStateCache::get().bindBuffer(GL_TEXTURE_BUFFER, lightBuffer);
+                glBufferSubData(GL_TEXTURE_BUFFER, 0, lightTexels.size() * sizeof(glm::vec4), lightTexels.data());
+            }
+
+            PROFILE_SCOPE(clustered ? "clustered" : "forward");
+            Shader& shader = clustered ? clusteredShader : forwardShader;
+            const GLuint program = shader.ID();
+            shader.use();
+            if (clustered) {
+                clusters.bind(shader, glm::vec2(static_cast<float>(width), static_cast<float>(height)), 1);
+            } else {
+                shader.setInt("lightCount", lightCount);
+                GLStateCache::get().bindSampler(0, 0);
+                GLStateCache::get().bindTextureUnit(0, GL_TEXTURE_BUFFER, lightTexture);
+            }
+            shader.setMat4("view", view);
+            shader.setMat4("projection", projection);
+            shader.setVec3("viewPos", cameraPos);
+            shader.setVec3("sunDirection", sun.direction);
+            shader.setVec3("sunColor", sun.color);
+            shader.setVec3("ambient", sun.ambient);
+            glm::vec4 spotPositionRadius(0.0f), spotColorOuter(0.0f, 0.0f, 0.0f, -2.0f), spotDirectionInner(0.0f);
+            if (!spotLights.empty()) {
+                const SpotLight& spot = spotLights[0];
+                spotPositionRadius = glm::vec4(spot.position, spot.radius);
+                spotColorOuter = glm::vec4(spot.color * spot.intensity, spot.outerCos);
+                spotDirectionInner = glm::vec4(spot.direction, spot.innerCos);
+            }
+            glUniform4fv(glGetUniformLocation(program, "spotPositionRadius"), 1, glm::value_ptr(spotPositionRadius));
+            glUniform4fv(glGetUniformLocation(program, "spotColorOuter"), 1, glm::value_ptr(spotColorOuter));
+            glUniform4fv(glGetUniformLocation(program, "spotDirectionInner"), 1, glm::value_ptr(spotDirectionInner));
+            const GLint modelLoc = glGetUniformLocation(program, "model");
+            const GLint albedoLoc = glGetUniformLocation(program, "albedo");
+            const GLint specularLoc = glGetUniformLocation(program, "specular");
+            const GLint shininessLoc = glGetUniformLocation(program, "shininess");
+            cube.bind();
+            for (const Object& object : objects) {
+                glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(object.model));
+                glUniform3fv(albedoLoc, 1, glm::value_ptr(object.albedo));
+                glUniform1f(specularLoc, object.specular);
+                glUniform1f(shininessLoc, object.shininess);
+                cube.drawBound();
+            }
+        }
+
+        {
+            PROFILE_SCOPE("markers");
+            markerShader.use();
+            markerShader.setMat4("viewProjection", viewProjection);
+            cube.bind();
+            const size_t markers = std::min(kMarkerCount, pointLights.size());
+            for (size_t i = 0; i < markers; ++i) {
+                const glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), pointLights[i].position),
+                                                   glm::vec3(0.15f));
+                glUniformMatrix4fv(markerModelLoc, 1, GL_FALSE, glm::value_ptr(model));
+                glUniform3fv(markerColorLoc, 1, glm::value_ptr(pointLights[i].color));
+                cube.drawBound();
+            }
+        }
+
+        if (shadingMode != lastMode) {
+            framesInWindow = 0;
+            lastMode = shadingMode;
+        }
+        if (++framesInWindow == 120) {
+            std::cout << "[" << modeName(shadingMode) << "] " << objects.size() << " objects, " << lightCount
+                      << " point lights";
+            if (shadingMode == ShadingMode::Deferred) {
+                std::cout << ", " << deferred.stats().visibleLights << " light volumes drawn";
+            } else if (shadingMode == ShadingMode::Clustered) {
+                const ClusteredLights::Stats& clusterStats = clusters.stats();
+                std::cout << ", " << clusterStats.visibleLights << " in view, "
+                          << clusterStats.indices / ClusteredLights::kClusterCount << " per cluster avg, "
+                          << clusterStats.maxPerCluster << " max";
+            }
+            if (hdrPipeline) {
+                std::cout << ", exposure " << hdr.stats().exposure << " (avg luminance "
+                          << hdr.stats().averageLuminance << ")";
+            }
+            std::cout << std::endl;
+            framesInWindow = 0;
+        }
+    }, headlessFrames);
+
+    if (capture.isCapturing()) {
+        renderer.setCapture(nullptr);
+        capture.stop();
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+        const FrameCapture::Stats captureStats = capture.stats();
+        std::cout << "FrameCapture: " << captureStats.written << "/" << captureStats.captured << " frames written ("
+                  << captureStats.bytes / (1024 * 1024) << " MB) in " << seconds << " s, "
+                  << captureStats.written / seconds << " fps, " << captureStats.readbackStalls
+                  << " readback stalls, " << captureStats.encoderStalls << " encoder stalls" << std::endl;
+    }
+    Profiler::get().print(std::cout);
+    GLStateCache::get().deleteTexture(lightTexture);
+    GLStateCache::get().deleteBuffer(lightBuffer);
+    return 0;
+}
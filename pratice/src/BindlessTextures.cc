@@ -0,0 +1,252 @@
+#include "BindlessTextures.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+BindlessMaterialTable::BindlessMaterialTable(const TextureParams& params, bool preferBindless)
+    : m_params(params),
+      m_bindless(preferBindless && GLCaps::get().supportsBindlessTextures()) {}
+
+BindlessMaterialTable::~BindlessMaterialTable() {
+    for (size_t i = 0; i < m_textures.size(); ++i) makeNonResident(m_textures[i]);
+    if (m_ubo) GLStateCache::get().deleteBuffer(m_ubo);
+}
+
+int BindlessMaterialTable::addTexture(const Image& image) {
+    if (m_finalized) {
+        std::cerr << "BindlessMaterialTable: cannot add textures after finalize()" << std::endl;
+        return -1;
+    }
+    if (image.empty()) return -1;
+    Entry entry;
+    entry.image = image;
+    m_textures.push_back(std::move(entry));
+    return static_cast<int>(m_textures.size()) - 1;
+}
+
+int BindlessMaterialTable::addTexture(const std::string& path) {
+    Image image;
+    std::string error;
+    if (!loadImage(path, image, m_params.flip, Texture::channelsForFormat(m_params.format), &error)) {
+        std::cerr << "Failed to load texture: " << path << " (" << error << ")" << std::endl;
+        return -1;
+    }
+    return addTexture(image);
+}
+
+int BindlessMaterialTable::addMaterial(std::initializer_list<int> textures) {
+    if (m_finalized) {
+        std::cerr << "BindlessMaterialTable: cannot add materials after finalize()" << std::endl;
+        return -1;
+    }
+    Material material;
+    std::fill(material.textures, material.textures + kMaxSlots, -1);
+    int slot = 0;
+    for (std::initializer_list<int>::const_iterator it = textures.begin(); it != textures.end() && slot < kMaxSlots; ++it) {
+        material.textures[slot++] = (*it >= 0 && *it < textureCount()) ? *it : -1;
+    }
+    m_materials.push_back(material);
+    return static_cast<int>(m_materials.size()) - 1;
+}
+
+bool BindlessMaterialTable::finalize() {
+    if (m_finalized) return true;
+
+    if (m_bindless) {
+        for (size_t i = 0; i < m_textures.size(); ++i) {
+            Entry& entry = m_textures[i];
+            entry.texture.reset(new Texture(entry.image, m_params));
+            entry.handle = entry.texture->bindlessHandle();
+            entry.bytes = entry.texture->memoryBytes();
+            if (entry.handle == 0) {
+                std::cerr << "BindlessMaterialTable: handle creation failed, falling back to texture arrays" << std::endl;
+                m_bindless = false;
+                break;
+            }
+        }
+        if (!m_bindless) {
+            for (size_t i = 0; i < m_textures.size(); ++i) {
+                m_textures[i].texture.reset();
+                m_textures[i].handle = 0;
+            }
+        }
+    }
+
+    if (!m_bindless) {
+        // 按 (尺寸, 通道, 像素类型) 分组，每组一个纹理数组
+        std::vector<TextureArrayBuilder> builders;
+        std::vector<const Image*> keys;
+        for (size_t i = 0; i < m_textures.size(); ++i) {
+            Entry& entry = m_textures[i];
+            size_t group = 0;
+            while (group < keys.size() &&
+                   (keys[group]->width != entry.image.width || keys[group]->height != entry.image.height ||
+                    keys[group]->channels != entry.image.channels || keys[group]->type != entry.image.type)) {
+                ++group;
+            }
+            if (group == keys.size()) {
+                if (keys.size() == static_cast<size_t>(kMaxArrays)) {
+                    std::cerr << "BindlessMaterialTable: more than " << kMaxArrays
+                              << " distinct texture sizes; resize or atlas them for the array fallback" << std::endl;
+                    return false;
+                }
+                keys.push_back(&entry.image);
+                builders.push_back(TextureArrayBuilder(m_params));
+            }
+            entry.array = static_cast<int>(group);
+            entry.layer = builders[group].addLayer(entry.image);
+        }
+        m_arrays.clear();
+        for (size_t i = 0; i < builders.size(); ++i) m_arrays.push_back(builders[i].build());
+    }
+
+    // std140：每个槽位一个 uvec4，bindless 时 xy 为句柄，回退时 x=数组 y=层，w=1 表示有效
+    GLint maxBlockSize = 0;
+    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize);
+    const size_t materialBytes = kMaxSlots * 4 * sizeof(GLuint);
+    if (m_materials.size() * materialBytes > static_cast<size_t>(maxBlockSize)) {
+        std::cerr << "BindlessMaterialTable: " << m_materials.size() << " materials exceed the "
+                  << maxBlockSize << " byte uniform block limit" << std::endl;
+        return false;
+    }
+    std::vector<GLuint> table(std::max<size_t>(1, m_materials.size()) * kMaxSlots * 4, 0);
+    for (size_t m = 0; m < m_materials.size(); ++m) {
+        for (int slot = 0; slot < kMaxSlots; ++slot) {
+            const int index = m_materials[m].textures[slot];
+            if (index < 0) continue;
+            const Entry& entry = m_textures[index];
+            GLuint* dst = &table[(m * kMaxSlots + slot) * 4];
+            if (m_bindless) {
+                dst[0] = static_cast<GLuint>(entry.handle & 0xFFFFFFFFu);
+                dst[1] = static_cast<GLuint>(entry.handle >> 32);
+            } else {
+                dst[0] = static_cast<GLuint>(entry.array);
+                dst[1] = static_cast<GLuint>(entry.layer);
+            }
+            dst[3] = 1;
+        }
+    }
+    glGenBuffers(1, &m_ubo);
+    GLStateCache::get().bindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, table.size() * sizeof(GLuint), table.data(), GL_STATIC_DRAW);
+    GLStateCache::get().bindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // CPU 端像素已上传，不再保留
+    for (size_t i = 0; i < m_textures.size(); ++i) m_textures[i].image = Image();
+    m_finalized = true;
+    return true;
+}
+
+std::string BindlessMaterialTable::shaderPrelude() const {
+    std::ostringstream ss;
+    if (m_bindless) {
+        ss << "#version 400 core\n"
+              "#extension GL_ARB_bindless_texture : require\n";
+    } else {
+        ss << "#version 330 core\n";
+    }
+    ss << "struct MaterialEntry { uvec4 maps[" << kMaxSlots << "]; };\n"
+       << "layout(std140) uniform MaterialTable { MaterialEntry materials["
+       << std::max(1, materialCount()) << "]; };\n";
+    if (m_bindless) {
+        ss << "vec4 sampleMaterial(int material, int slot, vec2 uv) {\n"
+              "    uvec4 e = materials[material].maps[slot];\n"
+              "    return texture(sampler2D(e.xy), uv);\n"
+              "}\n";
+    } else {
+        // GLSL 3.30 的采样器数组只能用常量下标，逐个分支展开
+        const int arrays = std::max<int>(1, static_cast<int>(m_arrays.size()));
+        ss << "uniform sampler2DArray materialArrays[" << arrays << "];\n"
+           << "vec4 sampleMaterial(int material, int slot, vec2 uv) {\n"
+              "    uvec4 e = materials[material].maps[slot];\n"
+              "    vec3 coord = vec3(uv, float(e.y));\n";
+        for (int i = 1; i < arrays; ++i) {
+            ss << "    if (e.x == " << i << "u) return texture(materialArrays[" << i << "], coord);\n";
+        }
+        ss << "    return texture(materialArrays[0], coord);\n"
+              "}\n";
+    }
+    return ss.str();
+}
+
+void BindlessMaterialTable::attach(GLuint program) const {
+    const GLuint block = glGetUniformBlockIndex(program, "MaterialTable");
+    if (block != GL_INVALID_INDEX) glUniformBlockBinding(program, block, m_uniformBinding);
+    if (m_bindless) return;
+    // 会切换当前程序
+    GLStateCache::get().useProgram(program);
+    for (size_t i = 0; i < m_arrays.size(); ++i) {
+        std::ostringstream name;
+        name << "materialArrays[" << i << "]";
+        const GLint location = glGetUniformLocation(program, name.str().c_str());
+        if (location >= 0) glUniform1i(location, static_cast<GLint>(m_firstUnit + i));
+    }
+}
+
+void BindlessMaterialTable::bind() const {
+    GLStateCache::get().bindBufferBase(GL_UNIFORM_BUFFER, m_uniformBinding, m_ubo);
+    for (size_t i = 0; i < m_arrays.size(); ++i) {
+        if (m_arrays[i]) m_arrays[i]->bind(m_firstUnit + static_cast<GLuint>(i));
+    }
+}
+
+void BindlessMaterialTable::beginFrame() {
+    ++m_frame;
+    enforceBudget();
+}
+
+void BindlessMaterialTable::use(int material) {
+    if (!m_bindless || material < 0 || material >= materialCount()) return;
+    bool added = false;
+    for (int slot = 0; slot < kMaxSlots; ++slot) {
+        const int index = m_materials[material].textures[slot];
+        if (index < 0) continue;
+        Entry& entry = m_textures[index];
+        entry.lastUsed = m_frame;
+        if (!entry.resident) {
+            makeResident(entry);
+            added = true;
+        }
+    }
+    if (added) enforceBudget();
+}
+
+void BindlessMaterialTable::makeResident(Entry& entry) {
+#ifdef GL_ARB_bindless_texture
+    if (entry.handle == 0 || entry.resident) return;
+    glMakeTextureHandleResidentARB(entry.handle);
+    entry.resident = true;
+    m_residentBytes += entry.bytes;
+#else
+    (void)entry;
+#endif
+}
+
+void BindlessMaterialTable::makeNonResident(Entry& entry) {
+#ifdef GL_ARB_bindless_texture
+    if (entry.handle == 0 || !entry.resident) return;
+    glMakeTextureHandleNonResidentARB(entry.handle);
+    entry.resident = false;
+    m_residentBytes -= entry.bytes;
+#else
+    (void)entry;
+#endif
+}
+
+// 超出预算时按最近使用时间换出，仍可能被在途帧引用的句柄保持驻留，
+// 因此当前帧实际用到的贴图总量超过预算时会暂时超支
+void BindlessMaterialTable::enforceBudget() {
+    if (m_budget == 0 || m_residentBytes <= m_budget) return;
+    std::vector<Entry*> candidates;
+    for (size_t i = 0; i < m_textures.size(); ++i) {
+        Entry& entry = m_textures[i];
+        if (entry.resident && entry.lastUsed + kFramesInFlight <= m_frame) candidates.push_back(&entry);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const Entry* a, const Entry* b) { return a->lastUsed < b->lastUsed; });
+    for (size_t i = 0; i < candidates.size() && m_residentBytes > m_budget; ++i) {
+        makeNonResident(*candidates[i]);
+    }
+}
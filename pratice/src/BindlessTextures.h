@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "Image.h"
+#include "Texture.h"
+#include "TextureArray.h"
+
+// 材质贴图表
+// 每个材质最多 kMaxSlots 张贴图，表本身放在一个 std140 UBO 里，绘制时只需设置材质索引，
+// 着色器通过 sampleMaterial(material, slot, uv) 采样，绘制循环里不再有任何纹理绑定。
+//
+// 两种后端：
+//  - ARB_bindless_texture：UBO 里存 64 位纹理句柄，句柄按预算驻留/换出；
+//  - 回退（如 Mesa llvmpipe）：按尺寸分组打包成若干 GL_TEXTURE_2D_ARRAY，UBO 里存 (数组, 层)。
+class BindlessMaterialTable {
+public:
+    static const int kMaxSlots = 4;
+    static const int kMaxArrays = 4;       // 回退模式下最多的尺寸分组数
+    static const int kFramesInFlight = 2;  // 最近这么多帧用过的句柄不会被换出
+
+    explicit BindlessMaterialTable(const TextureParams& params = TextureParams(), bool preferBindless = true);
+    ~BindlessMaterialTable();
+    BindlessMaterialTable(const BindlessMaterialTable&) = delete;
+    BindlessMaterialTable& operator=(const BindlessMaterialTable&) = delete;
+
+    bool isBindless() const { return m_bindless; }
+
+    // 返回贴图索引，失败返回 -1；必须在 finalize 之前调用
+    int addTexture(const Image& image);
+    int addTexture(const std::string& path);
+    // 按槽位顺序给出贴图索引（-1 表示空槽），返回材质索引
+    int addMaterial(std::initializer_list<int> textures);
+    int materialCount() const { return static_cast<int>(m_materials.size()); }
+    int textureCount() const { return static_cast<int>(m_textures.size()); }
+
+    // 创建 GL 资源并上传材质表
+    bool finalize();
+
+    // 着色器前缀：#version、扩展声明、材质表 UBO 和 sampleMaterial()，拼在片段着色器正文之前
+    std::string shaderPrelude() const;
+    // 链接后调用一次：设置 uniform block 绑定点和回退模式的采样器单元
+    void attach(GLuint program) const;
+    // 每帧一次：绑定 UBO（回退模式还绑定纹理数组），并按预算换出长期未用的句柄
+    void bind() const;
+    void beginFrame();
+    // 绘制前调用，保证该材质的句柄已驻留
+    void use(int material);
+
+    // 驻留预算（字节），0 表示不限
+    void setResidentBudget(size_t bytes) { m_budget = bytes; }
+    size_t residentBytes() const { return m_residentBytes; }
+
+    GLuint uniformBinding() const { return m_uniformBinding; }
+    void setUniformBinding(GLuint binding) { m_uniformBinding = binding; }
+    GLuint firstTextureUnit() const { return m_firstUnit; }
+    void setFirstTextureUnit(GLuint unit) { m_firstUnit = unit; }
+
+private:
+    struct Entry {
+        Image image;                       // finalize 后释放
+        std::unique_ptr<Texture> texture;  // 仅 bindless 模式
+        GLuint64 handle = 0;
+        size_t bytes = 0;                  // Texture::memoryBytes() 估算
+        bool resident = false;
+        uint64_t lastUsed = 0;
+        int array = 0;
+        int layer = 0;
+    };
+    struct Material { int textures[kMaxSlots]; };
+
+    void makeResident(Entry& entry);
+    void makeNonResident(Entry& entry);
+    void enforceBudget();
+
+    TextureParams m_params;
+    bool m_bindless = false;
+    bool m_finalized = false;
+    std::vector<Entry> m_textures;
+    std::vector<Material> m_materials;
+    std::vector<std::unique_ptr<TextureArray>> m_arrays;
+    GLuint m_ubo = 0;
+    GLuint m_uniformBinding = 0;
+    GLuint m_firstUnit = 0;
+    size_t m_budget = 0;
+    size_t m_residentBytes = 0;
+    uint64_t m_frame = 0;
+};
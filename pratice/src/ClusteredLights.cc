@@ -0,0 +1,228 @@
+#include "ClusteredLights.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#include "JobSystem.h"
+#include "Shader.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+
+// 切片 k 的深度范围是 near * (far/near)^(k/Z) 到 near * (far/near)^((k+1)/Z)，
+// 着色器里 slice = log(depth) * scale + bias
+const char* kClusterGLSL =
+    "uniform usamplerBuffer clusterGrid;\n"
+    "uniform usamplerBuffer clusterIndices;\n"
+    "uniform samplerBuffer clusterLights;\n"
+    "uniform vec2 clusterScreenSize;\n"
+    "uniform vec2 clusterDepthParams;\n"
+    "uvec2 clusterLightRange(float viewDepth) {\n"
+    "    ivec3 cell;\n"
+    "    cell.xy = ivec2(gl_FragCoord.xy / clusterScreenSize * vec2(CLUSTERS_X, CLUSTERS_Y));\n"
+    "    cell.z = int(floor(log(max(viewDepth, 1e-4)) * clusterDepthParams.x + clusterDepthParams.y));\n"
+    "    cell = clamp(cell, ivec3(0), ivec3(CLUSTERS_X - 1, CLUSTERS_Y - 1, CLUSTERS_Z - 1));\n"
+    "    return texelFetch(clusterGrid, (cell.z * CLUSTERS_Y + cell.y) * CLUSTERS_X + cell.x).xy;\n"
+    "}\n"
+    "void clusterLight(uint i, out vec4 positionRadius, out vec3 color) {\n"
+    "    int light = int(texelFetch(clusterIndices, int(i)).r);\n"
+    "    positionRadius = texelFetch(clusterLights, light * 2);\n"
+    "    color = texelFetch(clusterLights, light * 2 + 1).rgb;\n"
+    "}\n";
+
+// 球心到包围盒的最近距离不超过半径
+bool sphereIntersectsBox(const glm::vec3& center, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    const glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+    const glm::vec3 offset = closest - center;
+    return glm::dot(offset, offset) <= radius * radius;
+}
+
+int tileOf(float ndc, int tiles) {
+    return std::max(0, std::min(tiles - 1, static_cast<int>(std::floor((ndc * 0.5f + 0.5f) * tiles))));
+}
+
+} // namespace
+
+ClusteredLights::ClusteredLights()
+    : m_boundsProjection(0.0f),
+      m_clusterMin(kClusterCount),
+      m_clusterMax(kClusterCount),
+      m_sliceRanges(kClustersZ),
+      m_clusterLights(kClusterCount),
+      m_gridData(kClusterCount * 2) {}
+
+ClusteredLights::~ClusteredLights() {
+    for (int i = 0; i < 3; ++i) {
+        GLStateCache::get().deleteTexture(m_textures[i]);
+        GLStateCache::get().deleteBuffer(m_buffers[i]);
+    }
+}
+
+bool ClusteredLights::init() {
+    if (m_ready) return true;
+    if (!GLCaps::get().versionAtLeast(3, 3)) {
+        std::cerr << "ClusteredLights: requires OpenGL 3.3" << std::endl;
+        return false;
+    }
+    const GLenum formats[3] = {GL_RG32UI, GL_R32UI, GL_RGBA32F};
+    glGenBuffers(3, m_buffers);
+    glGenTextures(3, m_textures);
+    for (int i = 0; i < 3; ++i) {
+        GLStateCache::get().bindBuffer(GL_TEXTURE_BUFFER, m_buffers[i]);
+        glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+        GLStateCache::get().bindTexture(GL_TEXTURE_BUFFER, m_textures[i]);
+        glTexBuffer(GL_TEXTURE_BUFFER, formats[i], m_buffers[i]);
+    }
+    m_ready = true;
+    return true;
+}
+
+std::string ClusteredLights::shaderSource() {
+    return "#define CLUSTERS_X " + std::to_string(kClustersX) + "\n#define CLUSTERS_Y " +
+           std::to_string(kClustersY) + "\n#define CLUSTERS_Z " + std::to_string(kClustersZ) + "\n" +
+           kClusterGLSL;
+}
+
+int ClusteredLights::sliceOf(float depth) const {
+    const float slice = std::log(depth / m_near) / std::log(m_far / m_near) * kClustersZ;
+    return std::max(0, std::min(kClustersZ - 1, static_cast<int>(std::floor(slice))));
+}
+
+void ClusteredLights::buildClusterBounds(const glm::mat4& projection, float zNear, float zFar) {
+    if (projection == m_boundsProjection && zNear == m_near && zFar == m_far) return;
+    m_boundsProjection = projection;
+    m_near = zNear;
+    m_far = zFar;
+    // 观察空间里 x = ndc.x * depth / P[0][0]，y 同理，相机朝 -z
+    for (int z = 0; z < kClustersZ; ++z) {
+        const float depths[2] = {zNear * std::pow(zFar / zNear, static_cast<float>(z) / kClustersZ),
+                                 zNear * std::pow(zFar / zNear, static_cast<float>(z + 1) / kClustersZ)};
+        for (int y = 0; y < kClustersY; ++y) {
+            const float ndcY[2] = {-1.0f + 2.0f * y / kClustersY, -1.0f + 2.0f * (y + 1) / kClustersY};
+            for (int x = 0; x < kClustersX; ++x) {
+                const float ndcX[2] = {-1.0f + 2.0f * x / kClustersX, -1.0f + 2.0f * (x + 1) / kClustersX};
+                glm::vec3 boxMin(1e30f), boxMax(-1e30f);
+                for (int corner = 0; corner < 8; ++corner) {
+                    const float depth = depths[corner & 1];
+                    const glm::vec3 p(ndcX[(corner >> 1) & 1] * depth / projection[0][0],
+                                      ndcY[(corner >> 2) & 1] * depth / projection[1][1], -depth);
+                    boxMin = glm::min(boxMin, p);
+                    boxMax = glm::max(boxMax, p);
+                }
+                const int cluster = (z * kClustersY + y) * kClustersX + x;
+                m_clusterMin[cluster] = boxMin;
+                m_clusterMax[cluster] = boxMax;
+            }
+        }
+    }
+}
+
+void ClusteredLights::update(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+                             const std::vector<PointLight>& lights, JobSystem& jobs) {
+    if (!m_ready) return;
+    buildClusterBounds(projection, zNear, zFar);
+
+    // 每个光源保守地算出覆盖的簇范围：深度范围直接换算切片，x/depth 在球的包围盒上
+    // 只在四个角取到极值，换算到 NDC 得到格子范围。视锥外的光源在这里就被丢掉
+    m_ranges.clear();
+    for (std::vector<uint32_t>& slice : m_sliceRanges) slice.clear();
+    for (size_t i = 0; i < lights.size(); ++i) {
+        const glm::vec3 center = glm::vec3(view * glm::vec4(lights[i].position, 1.0f));
+        const float radius = lights[i].radius;
+        const float depth = -center.z;
+        if (depth + radius < zNear || depth - radius > zFar) continue;
+        const float depthMin = std::max(depth - radius, zNear);
+        const float depthMax = std::min(depth + radius, zFar);
+        const float xs[4] = {(center.x - radius) / depthMin, (center.x - radius) / depthMax,
+                             (center.x + radius) / depthMin, (center.x + radius) / depthMax};
+        const float ys[4] = {(center.y - radius) / depthMin, (center.y - radius) / depthMax,
+                             (center.y + radius) / depthMin, (center.y + radius) / depthMax};
+        const float ndcMinX = *std::min_element(xs, xs + 4) * projection[0][0];
+        const float ndcMaxX = *std::max_element(xs, xs + 4) * projection[0][0];
+        const float ndcMinY = *std::min_element(ys, ys + 4) * projection[1][1];
+        const float ndcMaxY = *std::max_element(ys, ys + 4) * projection[1][1];
+        if (ndcMaxX < -1.0f || ndcMinX > 1.0f || ndcMaxY < -1.0f || ndcMinY > 1.0f) continue;
+
+        LightRange range;
+        range.light = static_cast<uint32_t>(i);
+        range.x0 = tileOf(ndcMinX, kClustersX);
+        range.x1 = tileOf(ndcMaxX, kClustersX);
+        range.y0 = tileOf(ndcMinY, kClustersY);
+        range.y1 = tileOf(ndcMaxY, kClustersY);
+        range.z0 = sliceOf(depthMin);
+        range.z1 = sliceOf(depthMax);
+        range.center = center;
+        range.radius = radius;
+        const uint32_t rangeIndex = static_cast<uint32_t>(m_ranges.size());
+        m_ranges.push_back(range);
+        for (int z = range.z0; z <= range.z1; ++z) m_sliceRanges[z].push_back(rangeIndex);
+    }
+
+    // 每个任务处理一个深度切片，只写自己切片里的簇
+    jobs.parallelFor(kClustersZ, [this](size_t begin, size_t end) {
+        for (size_t slice = begin; slice < end; ++slice) assignSlice(static_cast<int>(slice));
+    }, 1);
+
+    // 压缩成连续的序号列表
+    m_indexData.clear();
+    m_stats.maxPerCluster = 0;
+    for (int cluster = 0; cluster < kClusterCount; ++cluster) {
+        const std::vector<uint32_t>& clusterLights = m_clusterLights[cluster];
+        m_gridData[cluster * 2] = static_cast<uint32_t>(m_indexData.size());
+        m_gridData[cluster * 2 + 1] = static_cast<uint32_t>(clusterLights.size());
+        m_indexData.insert(m_indexData.end(), clusterLights.begin(), clusterLights.end());
+        m_stats.maxPerCluster = std::max(m_stats.maxPerCluster, clusterLights.size());
+    }
+    m_lightData.resize(lights.size() * 2);
+    for (size_t i = 0; i < lights.size(); ++i) {
+        m_lightData[i * 2] = glm::vec4(lights[i].position, lights[i].radius);
+        m_lightData[i * 2 + 1] = glm::vec4(lights[i].color * lights[i].intensity, 0.0f);
+    }
+    m_stats.lights = lights.size();
+    m_stats.visibleLights = m_ranges.size();
+    m_stats.indices = m_indexData.size();
+
+    // 每帧重新分配，不用等 GPU 读完上一帧的数据；空缓冲的纹理缓冲无法读取，至少留一个元素
+    if (m_indexData.empty()) m_indexData.push_back(0);
+    if (m_lightData.empty()) m_lightData.resize(2, glm::vec4(0.0f));
+    GLStateCache& cache = GLStateCache::get();
+    cache.bindBuffer(GL_TEXTURE_BUFFER, m_buffers[0]);
+    glBufferData(GL_TEXTURE_BUFFER, m_gridData.size() * sizeof(uint32_t), m_gridData.data(), GL_STREAM_DRAW);
+    cache.bindBuffer(GL_TEXTURE_BUFFER, m_buffers[1]);
+    glBufferData(GL_TEXTURE_BUFFER, m_indexData.size() * sizeof(uint32_t), m_indexData.data(), GL_STREAM_DRAW);
+    cache.bindBuffer(GL_TEXTURE_BUFFER, m_buffers[2]);
+    glBufferData(GL_TEXTURE_BUFFER, m_lightData.size() * sizeof(glm::vec4), m_lightData.data(), GL_STREAM_DRAW);
+}
+
+void ClusteredLights::assignSlice(int slice) {
+    for (int cluster = slice * kClustersX * kClustersY; cluster < (slice + 1) * kClustersX * kClustersY; ++cluster) {
+        m_clusterLights[cluster].clear();
+    }
+    for (uint32_t rangeIndex : m_sliceRanges[slice]) {
+        const LightRange& range = m_ranges[rangeIndex];
+        for (int y = range.y0; y <= range.y1; ++y) {
+            for (int x = range.x0; x <= range.x1; ++x) {
+                const int cluster = (slice * kClustersY + y) * kClustersX + x;
+                if (sphereIntersectsBox(range.center, range.radius, m_clusterMin[cluster], m_clusterMax[cluster])) {
+                    m_clusterLights[cluster].push_back(range.light);
+                }
+            }
+        }
+    }
+}
+
+void ClusteredLights::bind(Shader& shader, const glm::vec2& screenSize, GLuint firstUnit) const {
+    static const char* const kSamplers[3] = {"clusterGrid", "clusterIndices", "clusterLights"};
+    if (m_near <= 0.0f) return;
+    GLStateCache& cache = GLStateCache::get();
+    for (GLuint i = 0; i < 3; ++i) {
+        cache.bindSampler(firstUnit + i, 0);
+        cache.bindTextureUnit(firstUnit + i, GL_TEXTURE_BUFFER, m_textures[i]);
+        shader.setInt(kSamplers[i], static_cast<int>(firstUnit + i));
+    }
+    const float logRatio = std::log(m_far / m_near);
+    const glm::vec2 depthParams(kClustersZ / logRatio, -kClustersZ * std::log(m_near) / logRatio);
+    glUniform2fv(glGetUniformLocation(shader.ID(), "clusterScreenSize"), 1, glm::value_ptr(screenSize));
+    glUniform2fv(glGetUniformLocation(shader.ID(), "clusterDepthParams"), 1, glm::value_ptr(depthParams));
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "Lights.h"
+
+class JobSystem;
+class Shader;
+
+// 分簇前向着色 (clustered forward+)
+// 视锥按屏幕 16x9 个格子、深度方向 24 个指数分布的切片划成 3456 个簇，每帧在 CPU 上把点光源
+// 分配到它的包围球碰到的簇里：先按深度切片分桶，再按切片并行逐簇做球与簇包围盒的相交测试。
+// 结果以纹理缓冲上传：每个簇的 (起点, 数量)、光源序号列表、光源参数。
+// 片段着色器根据自己所在的簇只遍历相关的光源，仍然是前向着色，MSAA 和透明物体照常可用。
+// 用法：
+//   Shader shader(vs, "#version 330 core\n" + ClusteredLights::shaderSource() + fs, true);
+//   clusters.update(view, projection, near, far, lights, JobSystem::get());   // 每帧
+//   shader.use(); clusters.bind(shader, screenSize, 1);
+// 片段着色器中：
+//   uvec2 range = clusterLightRange(viewDepth);
+//   for (uint i = range.x; i < range.x + range.y; ++i) { clusterLight(i, positionRadius, color); ... }
+// 光源位置为世界坐标，color 已乘以强度
+class ClusteredLights {
+public:
+    static const int kClustersX = 16;
+    static const int kClustersY = 9;
+    static const int kClustersZ = 24;
+    static const int kClusterCount = kClustersX * kClustersY * kClustersZ;
+
+    struct Stats {
+        size_t lights = 0;         // 提交的光源数
+        size_t visibleLights = 0;  // 与视锥相交的
+        size_t indices = 0;        // 所有簇的光源序号总数
+        size_t maxPerCluster = 0;
+    };
+
+    ClusteredLights();
+    ~ClusteredLights();
+    ClusteredLights(const ClusteredLights&) = delete;
+    ClusteredLights& operator=(const ClusteredLights&) = delete;
+
+    // 创建纹理缓冲，需要 GL 3.3 上下文
+    bool init();
+    bool isReady() const { return m_ready; }
+
+    // 重新分配光源并上传。projection 需要是对称的透视投影，zNear/zFar 与它一致
+    void update(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+                const std::vector<PointLight>& lights, JobSystem& jobs);
+    // 把三个纹理缓冲绑定到 firstUnit 起的三个纹理单元并设置 uniform，shader 需要是当前程序
+    void bind(Shader& shader, const glm::vec2& screenSize, GLuint firstUnit = 0) const;
+
+    // 片段着色器用的声明和函数，拼在 #version 之后
+    static std::string shaderSource();
+
+    const Stats& stats() const { return m_stats; }
+
+private:
+    // 一个光源覆盖的簇范围（闭区间）和观察空间包围球
+    struct LightRange {
+        uint32_t light;
+        int x0, x1, y0, y1, z0, z1;
+        glm::vec3 center;
+        float radius;
+    };
+
+    void buildClusterBounds(const glm::mat4& projection, float zNear, float zFar);
+    int sliceOf(float depth) const;
+    void assignSlice(int slice);
+
+    bool m_ready = false;
+    GLuint m_buffers[3] = {0, 0, 0};   // 簇、序号、光源
+    GLuint m_textures[3] = {0, 0, 0};
+
+    // 簇包围盒只和投影有关，投影不变时复用
+    glm::mat4 m_boundsProjection;
+    float m_near = 0.0f;
+    float m_far = 0.0f;
+    std::vector<glm::vec3> m_clusterMin;
+    std::vector<glm::vec3> m_clusterMax;
+
+    std::vector<LightRange> m_ranges;
+    std::vector<std::vector<uint32_t> > m_sliceRanges;    // 每个深度切片涉及的 m_ranges 下标
+    std::vector<std::vector<uint32_t> > m_clusterLights;  // 每个簇的光源序号
+    std::vector<uint32_t> m_gridData;
+    std::vector<uint32_t> m_indexData;
+    std::vector<glm::vec4> m_lightData;
+    Stats m_stats;
+};
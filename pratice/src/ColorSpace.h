@@ -0,0 +1,23 @@
+#pragma once
+#include <cmath>
+#include <glm/glm.hpp>
+
+// sRGB <-> 线性空间转换（IEC 61966-2-1 分段曲线）
+// 开启 GL_FRAMEBUFFER_SRGB 后着色器输出的是线性值，界面里按 sRGB 挑选的颜色常量
+// （清屏色、物体颜色、灯光颜色）需要先转换到线性空间再参与光照计算。
+
+inline float srgbToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+inline float linearToSrgb(float c) {
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+inline glm::vec3 srgbToLinear(const glm::vec3& c) {
+    return glm::vec3(srgbToLinear(c.x), srgbToLinear(c.y), srgbToLinear(c.z));
+}
+
+inline glm::vec3 linearToSrgb(const glm::vec3& c) {
+    return glm::vec3(linearToSrgb(c.x), linearToSrgb(c.y), linearToSrgb(c.z));
+}
@@ -0,0 +1,496 @@
+#include "DeferredRenderer.h"
+#include "FullscreenPass.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#include "Shader.h"
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+
+const char* kGeometryVS =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 2) in vec3 aNormal;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "uniform mat3 normalMatrix;\n"
+    "out vec3 viewNormal;\n"
+    "void main() {\n"
+    "    viewNormal = normalMatrix * aNormal;\n"
+    "    gl_Position = projection * view * model * vec4(aPos, 1.0);\n"
+    "}\n";
+
+const char* kGeometryFS =
+    "#version 330 core\n"
+    "in vec3 viewNormal;\n"
+    "uniform vec3 albedo;\n"
+    "uniform float specular;\n"
+    "uniform float shininess;\n"
+    "layout (location = 0) out vec4 gNormal;\n"
+    "layout (location = 1) out vec4 gAlbedo;\n"
+    "void main() {\n"
+    "    gNormal = vec4(normalize(viewNormal), shininess);\n"
+    "    gAlbedo = vec4(albedo, specular);\n"
+    "}\n";
+
+// 光照 pass 共用：从 G-buffer 读出当前像素的表面，Blinn-Phong
+const char* kSurfaceGLSL =
+    "uniform sampler2D gNormal;\n"
+    "uniform sampler2D gAlbedo;\n"
+    "uniform sampler2D gDepth;\n"
+    "uniform mat4 inverseProjection;\n"
+    "uniform vec2 screenSize;\n"
+    "struct Surface {\n"
+    "    vec3 position;\n"
+    "    vec3 normal;\n"
+    "    vec3 albedo;\n"
+    "    float specular;\n"
+    "    float shininess;\n"
+    "};\n"
+    "bool loadSurface(out Surface surface) {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    float depth = texelFetch(gDepth, p, 0).r;\n"
+    "    if (depth >= 1.0) return false;\n"
+    "    vec4 ndc = vec4(gl_FragCoord.xy / screenSize * 2.0 - 1.0, depth * 2.0 - 1.0, 1.0);\n"
+    "    vec4 position = inverseProjection * ndc;\n"
+    "    vec4 normal = texelFetch(gNormal, p, 0);\n"
+    "    vec4 albedo = texelFetch(gAlbedo, p, 0);\n"
+    "    surface.position = position.xyz / position.w;\n"
+    "    surface.normal = normalize(normal.xyz);\n"
+    "    surface.shininess = normal.w;\n"
+    "    surface.albedo = albedo.rgb;\n"
+    "    surface.specular = albedo.a;\n"
+    "    return true;\n"
+    "}\n"
+    "vec3 shade(Surface surface, vec3 lightDir, vec3 radiance) {\n"
+    "    float diff = max(dot(surface.normal, lightDir), 0.0);\n"
+    "    vec3 halfway = normalize(lightDir + normalize(-surface.position));\n"
+    "    float spec = pow(max(dot(surface.normal, halfway), 0.0), surface.shininess);\n"
+    "    return radiance * (diff * surface.albedo + spec * surface.specular);\n"
+    "}\n";
+
+const char* kDirectionalFS =
+    "uniform vec3 lightDirection;\n"
+    "uniform vec3 lightColor;\n"
+    "uniform vec3 ambient;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    Surface surface;\n"
+    "    if (!loadSurface(surface)) discard;\n"
+    "    vec3 color = ambient * surface.albedo + shade(surface, normalize(-lightDirection), lightColor);\n"
+    "    FragColor = vec4(color, 1.0);\n"
+    "}\n";
+
+// 光源参数按实例传入，位置和方向在顶点着色器里转到观察空间
+const char* kVolumeVS =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "layout (location = 1) in vec4 aPositionRadius;\n"
+    "layout (location = 2) in vec4 aColorOuter;\n"
+    "layout (location = 3) in vec4 aDirectionInner;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "flat out vec4 lightPosition;\n"
+    "flat out vec4 lightColor;\n"
+    "flat out vec4 lightDirection;\n"
+    "void main() {\n"
+    "    lightPosition = vec4((view * vec4(aPositionRadius.xyz, 1.0)).xyz, aPositionRadius.w);\n"
+    "    lightColor = aColorOuter;\n"
+    "    lightDirection = vec4(mat3(view) * aDirectionInner.xyz, aDirectionInner.w);\n"
+    "    gl_Position = projection * view * vec4(aPositionRadius.xyz + aPos * aPositionRadius.w, 1.0);\n"
+    "}\n";
+
+// 衰减在 radius 处平滑降到 0，光照体之外的像素不会被漏算。
+// 外锥角小于 -1 表示点光源
+const char* kVolumeFS =
+    "flat in vec4 lightPosition;\n"
+    "flat in vec4 lightColor;\n"
+    "flat in vec4 lightDirection;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    Surface surface;\n"
+    "    if (!loadSurface(surface)) discard;\n"
+    "    vec3 toLight = lightPosition.xyz - surface.position;\n"
+    "    float distance = length(toLight);\n"
+    "    if (distance >= lightPosition.w) discard;\n"
+    "    vec3 lightDir = toLight / max(distance, 1e-4);\n"
+    "    float ratio = distance / lightPosition.w;\n"
+    "    float window = clamp(1.0 - ratio * ratio * ratio * ratio, 0.0, 1.0);\n"
+    "    float attenuation = window * window / (1.0 + distance * distance);\n"
+    "    if (lightColor.w >= -1.0) {\n"
+    "        float theta = dot(-lightDir, normalize(lightDirection.xyz));\n"
+    "        attenuation *= clamp((theta - lightColor.w) / max(lightDirection.w - lightColor.w, 1e-4), 0.0, 1.0);\n"
+    "    }\n"
+    "    FragColor = vec4(shade(surface, lightDir, lightColor.rgb * attenuation), 0.0);\n"
+    "}\n";
+
+const char* kResolveFS =
+    "#version 330 core\n"
+    "uniform sampler2D lightTexture;\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    FragColor = vec4(texelFetch(lightTexture, ivec2(gl_FragCoord.xy), 0).rgb, 1.0);\n"
+    "}\n";
+
+// 光照体球的经纬分段
+const int kSlices = 16;
+const int kStacks = 8;
+
+GLuint createTexture(GLenum internalFormat, int width, int height, GLenum format, GLenum type) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    GLStateCache::get().bindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+} // namespace
+
+DeferredRenderer::DeferredRenderer() : m_view(1.0f), m_projection(1.0f), m_background(0.0f) {}
+
+DeferredRenderer::~DeferredRenderer() {
+    release();
+    GLStateCache& cache = GLStateCache::get();
+    cache.deleteVertexArray(m_emptyVao);
+    cache.deleteVertexArray(m_volumeVao);
+    cache.deleteBuffer(m_volumeVbo);
+    cache.deleteBuffer(m_volumeEbo);
+    cache.deleteBuffer(m_instanceVbo);
+}
+
+bool DeferredRenderer::init() {
+    if (m_ready) return true;
+    if (!GLCaps::get().versionAtLeast(3, 3)) {
+        std::cerr << "DeferredRenderer: requires OpenGL 3.3" << std::endl;
+        return false;
+    }
+    const std::string header = std::string("#version 330 core\n") + kSurfaceGLSL;
+    m_geometryShader.reset(new Shader(kGeometryVS, kGeometryFS, true));
+    m_directionalShader.reset(new Shader(kFullscreenVS, header + kDirectionalFS, true));
+    m_volumeShader.reset(new Shader(kVolumeVS, header + kVolumeFS, true));
+    m_resolveShader.reset(new Shader(kFullscreenVS, kResolveFS, true));
+    if (!m_geometryShader->isValid() || !m_directionalShader->isValid() || !m_volumeShader->isValid() ||
+        !m_resolveShader->isValid()) {
+        std::cerr << "DeferredRenderer: shader compilation failed" << std::endl;
+        m_geometryShader.reset();
+        m_directionalShader.reset();
+        m_volumeShader.reset();
+        m_resolveShader.reset();
+        return false;
+    }
+    const GLuint geometry = m_geometryShader->ID();
+    m_modelLocation = glGetUniformLocation(geometry, "model");
+    m_normalMatrixLocation = glGetUniformLocation(geometry, "normalMatrix");
+    m_albedoLocation = glGetUniformLocation(geometry, "albedo");
+    m_specularLocation = glGetUniformLocation(geometry, "specular");
+    m_shininessLocation = glGetUniformLocation(geometry, "shininess");
+    Shader* lightingShaders[] = {m_directionalShader.get(), m_volumeShader.get()};
+    for (Shader* shader : lightingShaders) {
+        shader->use();
+        shader->setInt("gNormal", 0);
+        shader->setInt("gAlbedo", 1);
+        shader->setInt("gDepth", 2);
+    }
+    m_resolveShader->use();
+    m_resolveShader->setInt("lightTexture", 0);
+
+    glGenVertexArrays(1, &m_emptyVao);
+    createLightVolume();
+    m_ready = true;
+    return true;
+}
+
+void DeferredRenderer::createLightVolume() {
+    // 经纬球的三角面在球面内侧，放大到外切，保证整个光照范围都被覆盖
+    const float pi = 3.14159265f;
+    const float scale = 1.01f / (std::cos(pi / kSlices) * std::cos(pi / (2 * kStacks)));
+    std::vector<glm::vec3> positions;
+    for (int stack = 0; stack <= kStacks; ++stack) {
+        const float phi = pi * stack / kStacks;
+        for (int slice = 0; slice <= kSlices; ++slice) {
+            const float theta = 2.0f * pi * slice / kSlices;
+            positions.push_back(glm::vec3(std::sin(phi) * std::cos(theta), std::cos(phi),
+                                          std::sin(phi) * std::sin(theta)) * scale);
+        }
+    }
+    // 从外面看逆时针
+    std::vector<uint16_t> indices;
+    for (int stack = 0; stack < kStacks; ++stack) {
+        for (int slice = 0; slice < kSlices; ++slice) {
+            const uint16_t a = static_cast<uint16_t>(stack * (kSlices + 1) + slice);
+            const uint16_t b = static_cast<uint16_t>(a + kSlices + 1);
+            const uint16_t quad[6] = {a, static_cast<uint16_t>(b + 1), b,
+                                      a, static_cast<uint16_t>(a + 1), static_cast<uint16_t>(b + 1)};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    m_volumeIndexCount = static_cast<GLsizei>(indices.size());
+
+    GLStateCache& cache = GLStateCache::get();
+    glGenVertexArrays(1, &m_volumeVao);
+    glGenBuffers(1, &m_volumeVbo);
+    glGenBuffers(1, &m_volumeEbo);
+    glGenBuffers(1, &m_instanceVbo);
+    cache.bindVertexArray(m_volumeVao);
+    cache.bindBuffer(GL_ARRAY_BUFFER, m_volumeVbo);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+    cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_volumeEbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t), indices.data(), GL_STATIC_DRAW);
+
+    cache.bindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    for (GLuint i = 0; i < 3; ++i) {
+        glEnableVertexAttribArray(1 + i);
+        glVertexAttribPointer(1 + i, 4, GL_FLOAT, GL_FALSE, sizeof(LightInstance),
+                              reinterpret_cast<const void*>(i * sizeof(glm::vec4)));
+        glVertexAttribDivisor(1 + i, 1);
+    }
+    cache.bindVertexArray(0);
+}
+
+void DeferredRenderer::release() {
+    GLStateCache& cache = GLStateCache::get();
+    cache.deleteFramebuffer(m_gbuffer);
+    cache.deleteTexture(m_normalTexture);
+    cache.deleteTexture(m_albedoTexture);
+    cache.deleteTexture(m_depthTexture);
+    cache.deleteFramebuffer(m_lightFbo);
+    cache.deleteTexture(m_lightTexture);
+    if (m_lightDepth) glDeleteRenderbuffers(1, &m_lightDepth);
+    m_gbuffer = m_normalTexture = m_albedoTexture = m_depthTexture = 0;
+    m_lightFbo = m_lightTexture = m_lightDepth = 0;
+    m_width = m_height = 0;
+}
+
+bool DeferredRenderer::resize(int width, int height) {
+    if (!m_ready || width <= 0 || height <= 0) return false;
+    if (width == m_width && height == m_height) return true;
+    release();
+    GLStateCache& cache = GLStateCache::get();
+
+    m_normalTexture = createTexture(GL_RGBA16F, width, height, GL_RGBA, GL_HALF_FLOAT);
+    m_albedoTexture = createTexture(GL_SRGB8_ALPHA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE);
+    m_depthTexture = createTexture(GL_DEPTH24_STENCIL8, width, height, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glGenFramebuffers(1, &m_gbuffer);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_gbuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_normalTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_albedoTexture, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+    const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+    const bool gbufferComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    m_lightTexture = createTexture(GL_RGBA16F, width, height, GL_RGBA, GL_HALF_FLOAT);
+    glGenRenderbuffers(1, &m_lightDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_lightDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glGenFramebuffers(1, &m_lightFbo);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_lightFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_lightTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_lightDepth);
+    const bool lightComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    cache.bindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!gbufferComplete || !lightComplete) {
+        std::cerr << "DeferredRenderer: incomplete framebuffer for " << width << "x" << height << std::endl;
+        release();
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void DeferredRenderer::beginGeometryPass(const glm::mat4& view, const glm::mat4& projection) {
+    if (!m_gbuffer) return;
+    GLStateCache& cache = GLStateCache::get();
+    m_view = view;
+    m_projection = projection;
+
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_gbuffer);
+    glViewport(0, 0, m_width, m_height);
+    // 反照率纹理是 sRGB 格式，写入时需要硬件编码
+    m_srgbWasEnabled = glIsEnabled(GL_FRAMEBUFFER_SRGB) == GL_TRUE;
+    cache.enable(GL_FRAMEBUFFER_SRGB);
+    cache.enable(GL_DEPTH_TEST);
+    cache.depthMask(true);
+    const GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    const GLfloat one = 1.0f;
+    glClearBufferfv(GL_COLOR, 0, zero);
+    glClearBufferfv(GL_COLOR, 1, zero);
+    glClearBufferfv(GL_DEPTH, 0, &one);
+
+    m_geometryShader->use();
+    m_geometryShader->setMat4("view", view);
+    m_geometryShader->setMat4("projection", projection);
+}
+
+void DeferredRenderer::setObject(const glm::mat4& model, const glm::vec3& albedo, float specular, float shininess) {
+    const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(m_view * model)));
+    glUniformMatrix4fv(m_modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+    glUniformMatrix3fv(m_normalMatrixLocation, 1, GL_FALSE, glm::value_ptr(normalMatrix));
+    glUniform3fv(m_albedoLocation, 1, glm::value_ptr(albedo));
+    glUniform1f(m_specularLocation, specular);
+    glUniform1f(m_shininessLocation, shininess);
+}
+
+void DeferredRenderer::endGeometryPass() {
+    GLStateCache::get().setEnabled(GL_FRAMEBUFFER_SRGB, m_srgbWasEnabled);
+}
+
+void DeferredRenderer::bindGBufferTextures() {
+    GLStateCache& cache = GLStateCache::get();
+    for (GLuint unit = 0; unit < 3; ++unit) cache.bindSampler(unit, 0);
+    cache.bindTextureUnit(0, GL_TEXTURE_2D, m_normalTexture);
+    cache.bindTextureUnit(1, GL_TEXTURE_2D, m_albedoTexture);
+    cache.bindTextureUnit(2, GL_TEXTURE_2D, m_depthTexture);
+}
+
+void DeferredRenderer::lightingPass(const DirectionalLight& sun, const std::vector<PointLight>& pointLights,
+                                    const std::vector<SpotLight>& spotLights) {
+    if (!m_gbuffer) return;
+    GLStateCache& cache = GLStateCache::get();
+    const bool depthTest = glIsEnabled(GL_DEPTH_TEST) == GL_TRUE;
+    const bool blend = glIsEnabled(GL_BLEND) == GL_TRUE;
+    const bool cullFace = glIsEnabled(GL_CULL_FACE) == GL_TRUE;
+    const bool depthClamp = glIsEnabled(GL_DEPTH_CLAMP) == GL_TRUE;
+    GLint blendSrc = GL_ONE, blendDst = GL_ZERO, cullMode = GL_BACK, depthFunc = GL_LESS;
+    GLboolean depthMask = GL_TRUE;
+    glGetIntegerv(GL_BLEND_SRC_RGB, &blendSrc);
+    glGetIntegerv(GL_BLEND_DST_RGB, &blendDst);
+    glGetIntegerv(GL_CULL_FACE_MODE, &cullMode);
+    glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+
+    // 光照体的深度测试用 G-buffer 深度的拷贝，着色器同时在采样原深度纹理，不能挂在同一个 FBO 上
+    cache.bindFramebuffer(GL_READ_FRAMEBUFFER, m_gbuffer);
+    cache.bindFramebuffer(GL_DRAW_FRAMEBUFFER, m_lightFbo);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_lightFbo);
+    glViewport(0, 0, m_width, m_height);
+    const GLfloat background[4] = {m_background.x, m_background.y, m_background.z, 1.0f};
+    glClearBufferfv(GL_COLOR, 0, background);
+    bindGBufferTextures();
+
+    const glm::mat4 inverseProjection = glm::inverse(m_projection);
+    const glm::vec2 screenSize(static_cast<float>(m_width), static_cast<float>(m_height));
+
+    // 平行光和环境光：全屏，直接覆盖有表面的像素
+    cache.disable(GL_DEPTH_TEST);
+    cache.disable(GL_BLEND);
+    cache.disable(GL_CULL_FACE);
+    cache.bindVertexArray(m_emptyVao);
+    m_directionalShader->use();
+    m_directionalShader->setMat4("inverseProjection", inverseProjection);
+    glUniform2fv(glGetUniformLocation(m_directionalShader->ID(), "screenSize"), 1, glm::value_ptr(screenSize));
+    m_directionalShader->setVec3("lightDirection", glm::mat3(m_view) * sun.direction);
+    m_directionalShader->setVec3("lightColor", sun.color);
+    m_directionalShader->setVec3("ambient", sun.ambient);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // 视锥剔除光照体，剩下的一次实例化绘制
+    const size_t lightCount = pointLights.size() + spotLights.size();
+    m_lightBounds.resize(lightCount);
+    for (size_t i = 0; i < pointLights.size(); ++i) {
+        m_lightBounds.set(i, pointLights[i].position, pointLights[i].radius);
+    }
+    for (size_t i = 0; i < spotLights.size(); ++i) {
+        m_lightBounds.set(pointLights.size() + i, spotLights[i].position, spotLights[i].radius);
+    }
+    m_lightVisible.resize(lightCount);
+    FrustumCuller::cullSpheres(Frustum::fromMatrix(m_projection * m_view), m_lightBounds, 0, lightCount,
+                               m_lightVisible.data());
+    m_instances.clear();
+    for (size_t i = 0; i < pointLights.size(); ++i) {
+        if (!m_lightVisible[i]) continue;
+        const PointLight& light = pointLights[i];
+        LightInstance instance;
+        instance.positionRadius = glm::vec4(light.position, light.radius);
+        instance.colorOuter = glm::vec4(light.color * light.intensity, -2.0f);
+        instance.directionInner = glm::vec4(0.0f, -1.0f, 0.0f, 1.0f);
+        m_instances.push_back(instance);
+    }
+    for (size_t i = 0; i < spotLights.size(); ++i) {
+        if (!m_lightVisible[pointLights.size() + i]) continue;
+        const SpotLight& light = spotLights[i];
+        LightInstance instance;
+        instance.positionRadius = glm::vec4(light.position, light.radius);
+        instance.colorOuter = glm::vec4(light.color * light.intensity, light.outerCos);
+        instance.directionInner = glm::vec4(light.direction, light.innerCos);
+        m_instances.push_back(instance);
+    }
+    m_stats.pointLights = pointLights.size();
+    m_stats.spotLights = spotLights.size();
+    m_stats.visibleLights = m_instances.size();
+
+    if (!m_instances.empty()) {
+        // 只画背面：相机在光照体内部也能覆盖到；GEQUAL 剔除球背面前方没有表面的像素。
+        // 深度钳制避免远平面把球的背面裁掉
+        cache.enable(GL_DEPTH_TEST);
+        cache.depthFunc(GL_GEQUAL);
+        cache.depthMask(false);
+        cache.enable(GL_CULL_FACE);
+        cache.cullFace(GL_FRONT);
+        cache.enable(GL_BLEND);
+        cache.blendFunc(GL_ONE, GL_ONE);
+        cache.enable(GL_DEPTH_CLAMP);
+
+        cache.bindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+        glBufferData(GL_ARRAY_BUFFER, m_instances.size() * sizeof(LightInstance), m_instances.data(),
+                     GL_STREAM_DRAW);
+        m_volumeShader->use();
+        m_volumeShader->setMat4("view", m_view);
+        m_volumeShader->setMat4("projection", m_projection);
+        m_volumeShader->setMat4("inverseProjection", inverseProjection);
+        glUniform2fv(glGetUniformLocation(m_volumeShader->ID(), "screenSize"), 1, glm::value_ptr(screenSize));
+        cache.bindVertexArray(m_volumeVao);
+        glDrawElementsInstanced(GL_TRIANGLES, m_volumeIndexCount, GL_UNSIGNED_SHORT, nullptr,
+                                static_cast<GLsizei>(m_instances.size()));
+
+        // 固定状态恢复为进入时的值
+        cache.setEnabled(GL_DEPTH_CLAMP, depthClamp);
+        cache.blendFunc(static_cast<GLenum>(blendSrc), static_cast<GLenum>(blendDst));
+        cache.cullFace(static_cast<GLenum>(cullMode));
+        cache.depthMask(depthMask == GL_TRUE);
+        cache.depthFunc(static_cast<GLenum>(depthFunc));
+    }
+    cache.setEnabled(GL_DEPTH_TEST, depthTest);
+    cache.setEnabled(GL_BLEND, blend);
+    cache.setEnabled(GL_CULL_FACE, cullFace);
+}
+
+void DeferredRenderer::resolve(GLuint framebuffer) {
+    if (!m_lightFbo) return;
+    GLStateCache& cache = GLStateCache::get();
+    const bool depthTest = glIsEnabled(GL_DEPTH_TEST) == GL_TRUE;
+    const bool blend = glIsEnabled(GL_BLEND) == GL_TRUE;
+
+    cache.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, m_width, m_height);
+    cache.disable(GL_DEPTH_TEST);
+    cache.disable(GL_BLEND);
+    cache.bindVertexArray(m_emptyVao);
+    m_resolveShader->use();
+    cache.bindSampler(0, 0);
+    cache.bindTextureUnit(0, GL_TEXTURE_2D, m_lightTexture);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // 深度一并拷过去，后续前向绘制的物体能和场景正确遮挡
+    cache.bindFramebuffer(GL_READ_FRAMEBUFFER, m_lightFbo);
+    cache.bindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+    glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    cache.setEnabled(GL_DEPTH_TEST, depthTest);
+    cache.setEnabled(GL_BLEND, blend);
+}
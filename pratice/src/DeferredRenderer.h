@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+#include "Lights.h"
+
+class Shader;
+
+// 延迟着色
+// 几何 pass 把法线/高光指数 (RGBA16F)、反照率/高光强度 (SRGB8_ALPHA8) 和深度写入 G-buffer，
+// 光照 pass 只对被光照覆盖的像素计算：平行光和环境光是一次全屏 pass，点光源和聚光
+// 用包围球实例化绘制，只画背面并用 GEQUAL 和场景深度比较，球后面没有表面的像素被深度测试剔除，
+// 结果叠加到 RGBA16F 累积缓冲。光照开销随被照亮的像素数增长，而不是物体数 × 光源数。
+// 光照在观察空间计算，位置由深度和投影矩阵的逆重建。
+// 用法（每帧）：
+//   deferred.resize(w, h);
+//   deferred.beginGeometryPass(view, projection);
+//   for (...) { deferred.setObject(model, albedo, specular, shininess); mesh.draw(); }
+//   deferred.endGeometryPass();
+//   deferred.lightingPass(sun, pointLights, spotLights);
+//   deferred.resolve(renderer.framebuffer());  // 之后仍可以在目标上前向绘制灯泡、透明物体等
+class DeferredRenderer {
+public:
+    struct Stats {
+        size_t pointLights = 0;    // 提交的光源数
+        size_t spotLights = 0;
+        size_t visibleLights = 0;  // 通过视锥剔除、实际绘制光照体的
+    };
+
+    DeferredRenderer();
+    ~DeferredRenderer();
+    DeferredRenderer(const DeferredRenderer&) = delete;
+    DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+    // 编译着色器、创建光照体网格，需要 GL 3.3 上下文；失败时返回 false
+    bool init();
+    bool isReady() const { return m_ready; }
+    // 尺寸变化时重建 G-buffer，相同尺寸直接返回
+    bool resize(int width, int height);
+
+    // 绑定 G-buffer 并清空，切换到内置的几何着色器。物体网格需要 Mesh::getLayout() 的顶点布局
+    void beginGeometryPass(const glm::mat4& view, const glm::mat4& projection);
+    // 设置下一个物体的模型矩阵和材质，albedo 为线性颜色
+    void setObject(const glm::mat4& model, const glm::vec3& albedo, float specular, float shininess);
+    void endGeometryPass();
+    // 使用自己的几何着色器时，片段着色器按 location 0/1 输出上面两张纹理的内容，法线在观察空间
+    Shader& geometryShader() { return *m_geometryShader; }
+
+    // 累积光照。没有被物体覆盖的像素保留背景色 (线性)
+    void lightingPass(const DirectionalLight& sun, const std::vector<PointLight>& pointLights,
+                      const std::vector<SpotLight>& spotLights);
+    // 把累积结果写到 framebuffer 并拷贝深度，目标深度格式需要是 DEPTH24_STENCIL8。
+    // 这里不做色调映射：输出到 8 位帧缓冲时截断，输出到 HdrPipeline 的场景目标时保留超过 1 的亮度
+    void resolve(GLuint framebuffer);
+
+    void setBackgroundColor(const glm::vec3& color) { m_background = color; }
+    GLuint normalTexture() const { return m_normalTexture; }
+    GLuint albedoTexture() const { return m_albedoTexture; }
+    GLuint depthTexture() const { return m_depthTexture; }
+    GLuint lightTexture() const { return m_lightTexture; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    // 每个光源三个 vec4：位置+半径、颜色×强度+外锥角、方向+内锥角
+    struct LightInstance {
+        glm::vec4 positionRadius;
+        glm::vec4 colorOuter;
+        glm::vec4 directionInner;
+    };
+
+    void release();
+    void createLightVolume();
+    void bindGBufferTextures();
+
+    bool m_ready = false;
+    int m_width = 0;
+    int m_height = 0;
+    glm::mat4 m_view;
+    glm::mat4 m_projection;
+    glm::vec3 m_background;
+    bool m_srgbWasEnabled = false;
+
+    std::unique_ptr<Shader> m_geometryShader;
+    std::unique_ptr<Shader> m_directionalShader;
+    std::unique_ptr<Shader> m_volumeShader;
+    std::unique_ptr<Shader> m_resolveShader;
+    GLint m_modelLocation = -1;
+    GLint m_normalMatrixLocation = -1;
+    GLint m_albedoLocation = -1;
+    GLint m_specularLocation = -1;
+    GLint m_shininessLocation = -1;
+
+    GLuint m_gbuffer = 0;
+    GLuint m_normalTexture = 0;
+    GLuint m_albedoTexture = 0;
+    GLuint m_depthTexture = 0;
+    GLuint m_lightFbo = 0;       // 累积缓冲
+    GLuint m_lightTexture = 0;
+    GLuint m_lightDepth = 0;     // G-buffer 深度的拷贝，光照体拿它做深度测试，同时着色器采样原深度
+
+    GLuint m_emptyVao = 0;
+    GLuint m_volumeVao = 0;
+    GLuint m_volumeVbo = 0;
+    GLuint m_volumeEbo = 0;
+    GLuint m_instanceVbo = 0;
+    GLsizei m_volumeIndexCount = 0;
+
+    SphereSoA m_lightBounds;
+    std::vector<uint8_t> m_lightVisible;
+    std::vector<LightInstance> m_instances;
+    Stats m_stats;
+};
@@ -0,0 +1,382 @@
+#include "FrameCapture.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// 强制等待读回时的超时，1 秒
+const GLuint64 kWaitTimeout = 1000000000ull;
+
+void appendBytes(void* context, void* data, int size) {
+    std::vector<unsigned char>& out = *static_cast<std::vector<unsigned char>*>(context);
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+// 输入是 GL 的自下而上行序，输出都是自上而下
+void encodePNG(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& out) {
+    std::vector<unsigned char> rgb(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        const unsigned char* src = rgba + static_cast<size_t>(height - 1 - y) * width * 4;
+        unsigned char* dst = rgb.data() + static_cast<size_t>(y) * width * 3;
+        for (int x = 0; x < width; ++x, src += 4, dst += 3) {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+        }
+    }
+    out.clear();
+    stbi_write_png_to_func(appendBytes, &out, width, height, 3, rgb.data(), width * 3);
+}
+
+void putBigEndian32(std::vector<unsigned char>& out, uint32_t value) {
+    out.push_back(static_cast<unsigned char>(value >> 24));
+    out.push_back(static_cast<unsigned char>(value >> 16));
+    out.push_back(static_cast<unsigned char>(value >> 8));
+    out.push_back(static_cast<unsigned char>(value));
+}
+
+} // namespace
+
+// QOI 规范 (qoiformat.org)，3 通道，alpha 恒为 255。
+// 索引表和解码器一样按 RGBA 保存、初始全 0，空槽位的 alpha 为 0，不会和任何像素匹配
+void FrameCapture::encodeQOI(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& out) {
+    out.clear();
+    out.reserve(static_cast<size_t>(width) * height * 4 + 22);
+    const unsigned char magic[4] = {'q', 'o', 'i', 'f'};
+    out.insert(out.end(), magic, magic + 4);
+    putBigEndian32(out, static_cast<uint32_t>(width));
+    putBigEndian32(out, static_cast<uint32_t>(height));
+    out.push_back(3);   // channels
+    out.push_back(0);   // sRGB
+
+    unsigned char index[64][4] = {};
+    unsigned char prev[4] = {0, 0, 0, 255};
+    int run = 0;
+    for (int y = height - 1; y >= 0; --y) {
+        const unsigned char* px = rgba + static_cast<size_t>(y) * width * 4;
+        for (int x = 0; x < width; ++x, px += 4) {
+            if (px[0] == prev[0] && px[1] == prev[1] && px[2] == prev[2]) {
+                if (++run == 62) {
+                    out.push_back(static_cast<unsigned char>(0xc0 | (run - 1)));
+                    run = 0;
+                }
+                continue;
+            }
+            if (run > 0) {
+                out.push_back(static_cast<unsigned char>(0xc0 | (run - 1)));
+                run = 0;
+            }
+            const int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) % 64;
+            if (index[hash][0] == px[0] && index[hash][1] == px[1] && index[hash][2] == px[2] &&
+                index[hash][3] == 255) {
+                out.push_back(static_cast<unsigned char>(hash));
+            } else {
+                std::memcpy(index[hash], px, 3);
+                index[hash][3] = 255;
+                const int dr = static_cast<signed char>(px[0] - prev[0]);
+                const int dg = static_cast<signed char>(px[1] - prev[1]);
+                const int db = static_cast<signed char>(px[2] - prev[2]);
+                const int drg = dr - dg, dbg = db - dg;
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                    out.push_back(static_cast<unsigned char>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+                } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                    out.push_back(static_cast<unsigned char>(0x80 | (dg + 32)));
+                    out.push_back(static_cast<unsigned char>((drg + 8) << 4 | (dbg + 8)));
+                } else {
+                    out.push_back(0xfe);
+                    out.insert(out.end(), px, px + 3);
+                }
+            }
+            std::memcpy(prev, px, 3);
+        }
+    }
+    if (run > 0) out.push_back(static_cast<unsigned char>(0xc0 | (run - 1)));
+    const unsigned char end[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    out.insert(out.end(), end, end + 8);
+}
+
+// Y4M 的一帧：BT.601 全范围 (JPEG) YCbCr，色度取 2x2 平均
+void FrameCapture::encodeY4M(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& out) {
+    static const char kFrameHeader[] = "FRAME\n";
+    const int chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+    const size_t lumaSize = static_cast<size_t>(width) * height;
+    const size_t chromaSize = static_cast<size_t>(chromaWidth) * chromaHeight;
+    out.resize(sizeof(kFrameHeader) - 1 + lumaSize + chromaSize * 2);
+    std::memcpy(out.data(), kFrameHeader, sizeof(kFrameHeader) - 1);
+    unsigned char* luma = out.data() + sizeof(kFrameHeader) - 1;
+    unsigned char* cb = luma + lumaSize;
+    unsigned char* cr = cb + chromaSize;
+
+    const auto pixel = [&](int x, int y) {
+        return rgba + (static_cast<size_t>(height - 1 - std::min(y, height - 1)) * width + std::min(x, width - 1)) * 4;
+    };
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const unsigned char* p = pixel(x, y);
+            *luma++ = static_cast<unsigned char>((19595 * p[0] + 38470 * p[1] + 7471 * p[2] + 32768) >> 16);
+        }
+    }
+    const int bias = (128 << 16) + 32768;
+    for (int y = 0; y < chromaHeight; ++y) {
+        for (int x = 0; x < chromaWidth; ++x) {
+            int r = 0, g = 0, b = 0;
+            for (int i = 0; i < 4; ++i) {
+                const unsigned char* p = pixel(x * 2 + (i & 1), y * 2 + (i >> 1));
+                r += p[0];
+                g += p[1];
+                b += p[2];
+            }
+            // 四个样本之和，系数再除以 4。纯蓝/纯红的 Cb/Cr 舍入后是 256，先夹到 [0, 255]
+            const int u = (-11059 * r - 21709 * g + 32768 * b + 4 * bias) >> 18;
+            const int v = (32768 * r - 27439 * g - 5329 * b + 4 * bias) >> 18;
+            *cb++ = static_cast<unsigned char>(std::max(0, std::min(255, u)));
+            *cr++ = static_cast<unsigned char>(std::max(0, std::min(255, v)));
+        }
+    }
+}
+
+FrameCapture::~FrameCapture() {
+    stop();
+}
+
+bool FrameCapture::formatFromPath(const std::string& path, Format& format) {
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos) return false;
+    std::string extension = path.substr(dot + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (extension == "png") format = Format::PNG;
+    else if (extension == "qoi") format = Format::QOI;
+    else if (extension == "y4m") format = Format::Y4M;
+    else return false;
+    return true;
+}
+
+bool FrameCapture::start(const std::string& path, Format format, int width, int height, int fps, JobSystem& jobs) {
+    if (m_capturing) stop();
+    if (!GLCaps::get().versionAtLeast(3, 3)) {
+        std::cerr << "FrameCapture: requires OpenGL 3.3" << std::endl;
+        return false;
+    }
+    if (width <= 0 || height <= 0 || fps <= 0) {
+        std::cerr << "FrameCapture: invalid size " << width << "x" << height << " @ " << fps << std::endl;
+        return false;
+    }
+    m_format = format;
+    m_path = path;
+    // 图片序列的路径没有编号占位符时在扩展名前补上
+    if (format != Format::Y4M && path.find('%') == std::string::npos) {
+        const size_t dot = path.find_last_of('.');
+        const size_t split = dot == std::string::npos ? path.size() : dot;
+        m_path = path.substr(0, split) + "_%05d" + path.substr(split);
+    }
+    if (format == Format::Y4M) {
+        m_video.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_video) {
+            std::cerr << "FrameCapture: cannot open " << path << std::endl;
+            return false;
+        }
+        m_video << "YUV4MPEG2 W" << width << " H" << height << " F" << fps << ":1 Ip A1:1 C420jpeg\n";
+    }
+
+    m_width = width;
+    m_height = height;
+    m_jobs = &jobs;
+    GLStateCache& cache = GLStateCache::get();
+    for (Slot& slot : m_slots) {
+        glGenBuffers(1, &slot.buffer);
+        cache.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(width) * height * 4, nullptr, GL_STREAM_READ);
+    }
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_oldest = m_inFlight = 0;
+    m_nextIndex = 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 每个线程各编码一帧，另外为 PBO 环里的帧留出余量
+    m_maxFrames = jobs.threadCount() + kSlots;
+    m_nextWrite = 0;
+    m_stats = Stats();
+    m_capturing = true;
+    return true;
+}
+
+void FrameCapture::capture(GLuint framebuffer) {
+    if (!m_capturing) return;
+    poll();
+    // 环满时只能等最早的读回完成
+    if (m_inFlight == kSlots) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_stats.readbackStalls;
+        }
+        collect(true);
+    }
+
+    Slot& slot = m_slots[(m_oldest + m_inFlight) % kSlots];
+    GLStateCache& cache = GLStateCache::get();
+    cache.bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // 无窗口模式没有 SwapBuffers，主动提交，之后轮询 fence 才会就绪
+    glFlush();
+    slot.index = m_nextIndex++;
+    ++m_inFlight;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.captured;
+}
+
+void FrameCapture::poll() {
+    while (m_inFlight > 0 && collect(false)) {
+    }
+}
+
+bool FrameCapture::collect(bool wait) {
+    Slot& slot = m_slots[m_oldest];
+    const GLenum status =
+        glClientWaitSync(slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? kWaitTimeout : 0);
+    if (!wait && status == GL_TIMEOUT_EXPIRED) return false;
+    if (status == GL_WAIT_FAILED) std::cerr << "FrameCapture: fence wait failed" << std::endl;
+
+    Frame* frame = acquireFrame();
+    frame->index = slot.index;
+    frame->pixels.resize(static_cast<size_t>(m_width) * m_height * 4);
+    GLStateCache& cache = GLStateCache::get();
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frame->pixels.size(), GL_MAP_READ_BIT);
+    if (data) {
+        std::memcpy(frame->pixels.data(), data, frame->pixels.size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        std::memset(frame->pixels.data(), 0, frame->pixels.size());
+    }
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+    m_oldest = (m_oldest + 1) % kSlots;
+    --m_inFlight;
+
+    m_jobs->run([this, frame]() {
+        encode(*frame);
+        finish(frame);
+    }, &m_counter);
+    return true;
+}
+
+FrameCapture::Frame* FrameCapture::acquireFrame() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_freeFrames.empty() && m_frames.size() < m_maxFrames) {
+            m_frames.emplace_back(new Frame());
+            m_freeFrames.push_back(m_frames.back().get());
+        }
+        if (!m_freeFrames.empty()) {
+            Frame* frame = m_freeFrames.back();
+            m_freeFrames.pop_back();
+            return frame;
+        }
+        ++m_stats.encoderStalls;
+    }
+    // 编码跟不上：等手上的帧全部写完，等待期间 GL 线程也参与编码
+    m_jobs->wait(m_counter);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Frame* frame = m_freeFrames.back();
+    m_freeFrames.pop_back();
+    return frame;
+}
+
+void FrameCapture::encode(Frame& frame) const {
+    switch (m_format) {
+        case Format::PNG: encodePNG(frame.pixels.data(), m_width, m_height, frame.encoded); break;
+        case Format::QOI: encodeQOI(frame.pixels.data(), m_width, m_height, frame.encoded); break;
+        case Format::Y4M: encodeY4M(frame.pixels.data(), m_width, m_height, frame.encoded); break;
+    }
+}
+
+std::string FrameCapture::framePath(long index) const {
+    char buffer[1024];
+    std::snprintf(buffer, sizeof(buffer), m_path.c_str(), static_cast<int>(index));
+    return buffer;
+}
+
+void FrameCapture::finish(Frame* frame) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_encoded[frame->index] = frame;
+    }
+    for (;;) {
+        std::unique_lock<std::mutex> writer(m_writeMutex, std::try_to_lock);
+        if (!writer.owns_lock()) return;
+        for (;;) {
+            Frame* next = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::map<long, Frame*>::iterator it = m_encoded.find(m_nextWrite);
+                if (it == m_encoded.end()) break;
+                next = it->second;
+                m_encoded.erase(it);
+            }
+            bool ok;
+            if (m_format == Format::Y4M) {
+                m_video.write(reinterpret_cast<const char*>(next->encoded.data()), next->encoded.size());
+                ok = static_cast<bool>(m_video);
+            } else {
+                std::ofstream file(framePath(next->index), std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(next->encoded.data()), next->encoded.size());
+                ok = static_cast<bool>(file);
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (ok) {
+                ++m_stats.written;
+                m_stats.bytes += next->encoded.size();
+            } else {
+                ++m_stats.failed;
+            }
+            ++m_nextWrite;
+            m_freeFrames.push_back(next);
+        }
+        writer.unlock();
+        // 放开写锁之后可能有别的线程刚放进下一帧、又没抢到写锁，再检查一次
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_encoded.find(m_nextWrite) == m_encoded.end()) return;
+    }
+}
+
+bool FrameCapture::stop() {
+    if (!m_capturing) return true;
+    while (m_inFlight > 0) collect(true);
+    m_jobs->wait(m_counter);
+    if (m_video.is_open()) m_video.close();
+    releaseGpuResources();
+    m_capturing = false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stats.failed > 0) std::cerr << "FrameCapture: " << m_stats.failed << " frames failed to write" << std::endl;
+    m_frames.clear();
+    m_freeFrames.clear();
+    m_encoded.clear();
+    return m_stats.failed == 0;
+}
+
+void FrameCapture::releaseGpuResources() {
+    for (Slot& slot : m_slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        GLStateCache::get().deleteBuffer(slot.buffer);
+        slot = Slot();
+    }
+}
+
+FrameCapture::Stats FrameCapture::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "JobSystem.h"
+
+// 异步帧捕获：截图序列或 Y4M 视频
+// capture 把帧缓冲 glReadPixels 到 PBO 环里的下一个槽位并插入 fence，立即返回；
+// 几帧后 fence 就绪再映射拷出，交给 JobSystem 的工作线程编码，GL 线程不等 GPU 也不做编码。
+// 编码完成的顺序不定，写出按帧序号排队，图片编号和视频帧顺序与 capture 调用顺序一致。
+//   PNG：stb_image_write，压缩慢，适合少量截图和金图比对；
+//   QOI：无损，编码比 PNG 快一个数量级，适合整段录制；
+//   Y4M：原始 YUV 4:2:0 (C420jpeg, BT.601 全范围)，写入单个文件，ffmpeg 可直接读取。
+// 图片按 RGB 写出，丢弃帧缓冲的 alpha。
+// 用法：
+//   FrameCapture capture;
+//   capture.start("frames/frame_%05d.qoi", FrameCapture::Format::QOI, w, h);
+//   每帧交换缓冲前：capture.capture(framebuffer);
+//   capture.stop();
+// Renderer::setCapture 可以把 capture 放进 Renderer::run
+class FrameCapture {
+public:
+    enum class Format { PNG, QOI, Y4M };
+
+    struct Stats {
+        size_t captured = 0;        // 提交读回的帧数
+        size_t written = 0;         // 编码并写出的帧数
+        size_t failed = 0;          // 写文件失败的帧数
+        size_t readbackStalls = 0;  // PBO 环满、不得不等 GPU 的次数
+        size_t encoderStalls = 0;   // 编码跟不上、等工作线程的次数
+        uint64_t bytes = 0;         // 写出的字节数
+    };
+
+    FrameCapture() = default;
+    ~FrameCapture();
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // PNG/QOI 的 path 是 printf 风格的模式（如 "shot_%04d.png"，参数为 int 帧序号），没有占位符时自动补上；Y4M 是单个文件。
+    // 捕获 width x height 的左下区域，录制中帧缓冲尺寸变化不会改变输出尺寸
+    bool start(const std::string& path, Format format, int width, int height, int fps = 60,
+               JobSystem& jobs = JobSystem::get());
+    // 读回 framebuffer 的当前内容，0 为默认帧缓冲（读后缓冲）。需在交换缓冲前调用
+    void capture(GLuint framebuffer);
+    // 把已就绪的读回交给编码线程，不阻塞。capture 内部会调用，停止录制前的空闲帧也可以手动调用
+    void poll();
+    // 等待所有读回和编码完成并关闭输出，有帧写入失败时返回 false
+    bool stop();
+
+    bool isCapturing() const { return m_capturing; }
+    // 由扩展名推断格式：.png / .qoi / .y4m，不认识时返回 false
+    static bool formatFromPath(const std::string& path, Format& format);
+    // 线程安全的快照
+    Stats stats() const;
+
+    // 编码一帧，输入为 RGBA、行序自下而上（glReadPixels 的布局），工作线程调用，也便于单独测试
+    static void encodeQOI(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& out);
+    static void encodeY4M(const unsigned char* rgba, int width, int height, std::vector<unsigned char>& out);
+
+private:
+    static const int kSlots = 4;
+
+    struct Slot {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        long index = 0;
+    };
+    struct Frame {
+        long index = 0;
+        std::vector<unsigned char> pixels;   // RGBA，行序自下而上
+        std::vector<unsigned char> encoded;
+    };
+
+    // 取回最早的读回并提交编码；wait 为 false 且尚未就绪时返回 false
+    bool collect(bool wait);
+    Frame* acquireFrame();
+    void encode(Frame& frame) const;
+    void finish(Frame* frame);
+    std::string framePath(long index) const;
+    void releaseGpuResources();
+
+    bool m_capturing = false;
+    Format m_format = Format::PNG;
+    std::string m_path;
+    int m_width = 0;
+    int m_height = 0;
+    JobSystem* m_jobs = nullptr;
+    JobCounter m_counter;
+
+    Slot m_slots[kSlots];
+    int m_oldest = 0;     // 最早提交、尚未取回的槽位
+    int m_inFlight = 0;
+    long m_nextIndex = 0;
+
+    // 以下由编码线程和 GL 线程共享，m_mutex 保护
+    mutable std::mutex m_mutex;
+    // 持有者负责按序写出，其它编码线程把结果放进 m_encoded 后直接返回
+    std::mutex m_writeMutex;
+    std::vector<std::unique_ptr<Frame> > m_frames;
+    std::vector<Frame*> m_freeFrames;
+    size_t m_maxFrames = 0;
+    std::map<long, Frame*> m_encoded;   // 编码完成、等待按序写出的帧
+    long m_nextWrite = 0;
+    std::ofstream m_video;
+    Stats m_stats;
+};
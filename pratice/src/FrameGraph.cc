@@ -0,0 +1,311 @@
+#include "FrameGraph.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <sstream>
+
+namespace {
+
+void addUnique(std::vector<int>& values, int value) {
+    if (std::find(values.begin(), values.end(), value) == values.end()) values.push_back(value);
+}
+
+} // namespace
+
+int FrameGraph::PassBuilder::read(int resource) {
+    if (!m_graph.validResource(resource)) {
+        std::cerr << "FrameGraph: pass '" << m_graph.m_passes[m_pass].name << "' reads an invalid resource"
+                  << std::endl;
+        m_graph.m_valid = false;
+        return -1;
+    }
+    addUnique(m_graph.m_passes[m_pass].reads, resource);
+    addUnique(m_graph.m_resources[resource].readers, m_pass);
+    return resource;
+}
+
+int FrameGraph::PassBuilder::write(int resource) {
+    if (!m_graph.validResource(resource)) {
+        std::cerr << "FrameGraph: pass '" << m_graph.m_passes[m_pass].name << "' writes an invalid resource"
+                  << std::endl;
+        m_graph.m_valid = false;
+        return -1;
+    }
+    const Resource& current = m_graph.m_resources[resource];
+    const Texture& texture = m_graph.m_textures[current.texture];
+    // 旧版本已经被别的 pass 改写过，再写它会让版本分叉
+    if (current.version != texture.latestVersion) {
+        std::cerr << "FrameGraph: pass '" << m_graph.m_passes[m_pass].name << "' writes stale version "
+                  << current.version << " of '" << texture.name << "'" << std::endl;
+        m_graph.m_valid = false;
+        return -1;
+    }
+    // 已有内容的版本按读-改-写处理（叠加混合等），依赖上一个写者，也让它不被剔除
+    if (current.writer >= 0) read(resource);
+    const int next = m_graph.addResource(current.texture, current.version + 1);
+    m_graph.m_resources[next].writer = m_pass;
+    m_graph.m_resources[next].previous = resource;
+    m_graph.m_passes[m_pass].writes.push_back(next);
+    return next;
+}
+
+void FrameGraph::PassBuilder::sideEffect() {
+    m_graph.m_passes[m_pass].sideEffect = true;
+}
+
+void FrameGraph::reset() {
+    m_textures.clear();
+    m_resources.clear();
+    m_passes.clear();
+    m_order.clear();
+    m_compiled = false;
+    m_valid = true;
+    m_stats = Stats();
+}
+
+bool FrameGraph::validResource(int resource) const {
+    return resource >= 0 && resource < static_cast<int>(m_resources.size());
+}
+
+int FrameGraph::addResource(int texture, int version) {
+    Resource resource;
+    resource.texture = texture;
+    resource.version = version;
+    m_textures[texture].latestVersion = version;
+    m_resources.push_back(resource);
+    return static_cast<int>(m_resources.size()) - 1;
+}
+
+int FrameGraph::createTexture(const std::string& name, const TextureDesc& desc) {
+    Texture texture;
+    texture.name = name;
+    texture.desc = desc;
+    m_textures.push_back(texture);
+    return addResource(static_cast<int>(m_textures.size()) - 1, 0);
+}
+
+int FrameGraph::importTarget(const std::string& name, const RenderTarget& target) {
+    Texture texture;
+    texture.name = name;
+    texture.desc = TextureDesc(target.width, target.height, target.format);
+    texture.imported = true;
+    texture.external = target;
+    m_textures.push_back(texture);
+    return addResource(static_cast<int>(m_textures.size()) - 1, 0);
+}
+
+int FrameGraph::addPass(const std::string& name, const Setup& setup, const Execute& execute) {
+    Pass pass;
+    pass.name = name;
+    pass.execute = execute;
+    m_passes.push_back(pass);
+    const int index = static_cast<int>(m_passes.size()) - 1;
+    PassBuilder builder(*this, index);
+    setup(builder);
+    m_compiled = false;
+    return index;
+}
+
+bool FrameGraph::compile() {
+    m_order.clear();
+    m_compiled = false;
+    if (!m_valid) return false;
+    cull();
+    // 临时纹理的第一个版本没有写者，读它拿到的是池里上一次用剩的内容
+    for (const Pass& pass : m_passes) {
+        if (pass.culled) continue;
+        for (int read : pass.reads) {
+            const Resource& resource = m_resources[read];
+            const Texture& texture = m_textures[resource.texture];
+            if (resource.writer < 0 && !texture.imported) {
+                std::cerr << "FrameGraph: pass '" << pass.name << "' reads '" << texture.name
+                          << "' before it is written" << std::endl;
+                return false;
+            }
+        }
+    }
+    if (!sortPasses()) return false;
+    computeLifetimes();
+    m_stats.passes = m_passes.size();
+    m_stats.culledPasses = m_passes.size() - m_order.size();
+    m_compiled = true;
+    return true;
+}
+
+void FrameGraph::cull() {
+    // 引用计数：pass 被它写出的、仍有人读的资源数，资源被未剔除的读者数。
+    // 导入资源和副作用 pass 额外持有一个引用，永远不会归零
+    for (Pass& pass : m_passes) {
+        pass.culled = false;
+        pass.refCount = static_cast<int>(pass.writes.size());
+        bool output = pass.sideEffect;
+        for (int write : pass.writes) output = output || m_textures[m_resources[write].texture].imported;
+        if (output) ++pass.refCount;
+    }
+    std::vector<int> unused;
+    for (size_t i = 0; i < m_resources.size(); ++i) {
+        Resource& resource = m_resources[i];
+        resource.refCount = static_cast<int>(resource.readers.size());
+        if (resource.refCount == 0 && resource.writer >= 0) unused.push_back(static_cast<int>(i));
+    }
+
+    std::vector<int> culled;
+    for (size_t i = 0; i < m_passes.size(); ++i) {
+        if (m_passes[i].refCount == 0) culled.push_back(static_cast<int>(i));
+    }
+    while (!culled.empty() || !unused.empty()) {
+        if (!unused.empty()) {
+            const int writer = m_resources[unused.back()].writer;
+            unused.pop_back();
+            if (--m_passes[writer].refCount == 0) culled.push_back(writer);
+            continue;
+        }
+        Pass& pass = m_passes[culled.back()];
+        culled.pop_back();
+        pass.culled = true;
+        for (int read : pass.reads) {
+            Resource& resource = m_resources[read];
+            if (--resource.refCount == 0 && resource.writer >= 0) unused.push_back(read);
+        }
+    }
+}
+
+bool FrameGraph::sortPasses() {
+    // 依赖：写者在读者之前；同一纹理的读者在写它下一个版本的 pass 之前（会覆盖同一块显存）
+    std::vector<std::vector<int> > edges(m_passes.size());
+    std::vector<int> inDegree(m_passes.size(), 0);
+    const auto addEdge = [&](int from, int to) {
+        if (from == to || m_passes[from].culled || m_passes[to].culled) return;
+        edges[from].push_back(to);
+        ++inDegree[to];
+    };
+    for (size_t i = 0; i < m_passes.size(); ++i) {
+        const Pass& pass = m_passes[i];
+        for (int read : pass.reads) {
+            if (m_resources[read].writer >= 0) addEdge(m_resources[read].writer, static_cast<int>(i));
+        }
+        for (int write : pass.writes) {
+            const Resource& previous = m_resources[m_resources[write].previous];
+            for (int reader : previous.readers) addEdge(reader, static_cast<int>(i));
+        }
+    }
+
+    // 就绪的 pass 中优先执行声明早的，没有依赖时保持原顺序
+    std::priority_queue<int, std::vector<int>, std::greater<int> > ready;
+    size_t live = 0;
+    for (size_t i = 0; i < m_passes.size(); ++i) {
+        if (m_passes[i].culled) continue;
+        ++live;
+        if (inDegree[i] == 0) ready.push(static_cast<int>(i));
+    }
+    while (!ready.empty()) {
+        const int pass = ready.top();
+        ready.pop();
+        m_order.push_back(pass);
+        for (int next : edges[pass]) {
+            if (--inDegree[next] == 0) ready.push(next);
+        }
+    }
+    if (m_order.size() != live) {
+        std::cerr << "FrameGraph: dependency cycle among passes" << std::endl;
+        m_order.clear();
+        return false;
+    }
+    return true;
+}
+
+void FrameGraph::computeLifetimes() {
+    for (Texture& texture : m_textures) texture.firstPass = texture.lastPass = -1;
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        const Pass& pass = m_passes[m_order[i]];
+        for (int side = 0; side < 2; ++side) {
+            const std::vector<int>& resources = side == 0 ? pass.reads : pass.writes;
+            for (int resource : resources) {
+                Texture& texture = m_textures[m_resources[resource].texture];
+                if (texture.firstPass < 0) texture.firstPass = static_cast<int>(i);
+                texture.lastPass = static_cast<int>(i);
+            }
+        }
+    }
+    m_stats.textures = 0;
+    for (const Texture& texture : m_textures) {
+        if (!texture.imported && texture.firstPass >= 0) ++m_stats.textures;
+    }
+}
+
+void FrameGraph::execute() {
+    if (!m_compiled) return;
+    std::vector<const RenderTarget*> used;
+    bool failed = false;
+    for (size_t i = 0; i < m_order.size() && !failed; ++i) {
+        const int index = static_cast<int>(i);
+        for (Texture& texture : m_textures) {
+            if (texture.imported || texture.firstPass != index) continue;
+            texture.pooled = m_pool.acquire(texture.desc.width, texture.desc.height, texture.desc.format);
+            if (!texture.pooled) {
+                std::cerr << "FrameGraph: cannot allocate '" << texture.name << "'" << std::endl;
+                failed = true;
+                break;
+            }
+            if (std::find(used.begin(), used.end(), texture.pooled) == used.end()) used.push_back(texture.pooled);
+        }
+        if (!failed) {
+            Pass& pass = m_passes[m_order[i]];
+            PROFILE_SCOPE(pass.name.c_str());
+            pass.execute(*this);
+        }
+        for (Texture& texture : m_textures) {
+            if (texture.pooled && (failed || texture.lastPass == index)) {
+                m_pool.release(texture.pooled);
+                texture.pooled = nullptr;
+            }
+        }
+    }
+    m_stats.targets = used.size();
+    m_stats.bytes = 0;
+    for (const RenderTarget* target : used) {
+        m_stats.bytes += RenderTargetPool::bytesPerPixel(target->format) * target->width * target->height;
+    }
+}
+
+const RenderTarget& FrameGraph::target(int resource) const {
+    static const RenderTarget kNone;
+    if (!validResource(resource)) return kNone;
+    const Texture& texture = m_textures[m_resources[resource].texture];
+    if (texture.imported) return texture.external;
+    return texture.pooled ? *texture.pooled : kNone;
+}
+
+const FrameGraph::TextureDesc& FrameGraph::desc(int resource) const {
+    static const TextureDesc kNone;
+    if (!validResource(resource)) return kNone;
+    return m_textures[m_resources[resource].texture].desc;
+}
+
+std::string FrameGraph::dump() const {
+    std::ostringstream out;
+    const auto names = [&](const std::vector<int>& resources) {
+        std::string result;
+        for (int resource : resources) {
+            if (!result.empty()) result += ", ";
+            result += m_textures[m_resources[resource].texture].name + "#" +
+                      std::to_string(m_resources[resource].version);
+        }
+        return result;
+    };
+    for (int index : m_order) {
+        const Pass& pass = m_passes[index];
+        out << pass.name << ": " << names(pass.reads) << " -> " << names(pass.writes) << "\n";
+    }
+    for (const Pass& pass : m_passes) {
+        if (pass.culled) out << pass.name << ": culled\n";
+    }
+    for (const Texture& texture : m_textures) {
+        if (texture.imported || texture.firstPass < 0) continue;
+        out << texture.name << " " << texture.desc.width << "x" << texture.desc.height << " live [" << texture.firstPass
+            << ", " << texture.lastPass << "]\n";
+    }
+    return out.str();
+}
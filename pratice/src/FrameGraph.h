@@ -0,0 +1,139 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "RenderTargetPool.h"
+
+// 帧图
+// 每帧先声明 pass 和它们读写的纹理，compile 再统一处理：
+//   剔除：从输出（导入的资源、标记了副作用的 pass）反推，结果没人用的 pass 不执行；
+//   排序：按读写依赖拓扑排序，没有依赖关系的 pass 保持声明顺序；
+//   生命周期：每张临时纹理在第一个用到它的 pass 前从 RenderTargetPool 借出，最后一个用到它的 pass 后归还，
+//             之后尺寸和格式相同的纹理直接复用同一个目标，显存占用取决于同时存活的纹理而不是纹理总数。
+// 资源句柄带版本：write 返回新句柄，之后的读者应使用新句柄，据此确定 pass 之间的先后。
+// 用法（每帧）：
+//   graph.reset();
+//   int output = graph.importTarget("backbuffer", backbuffer);
+//   int blur = graph.createTexture("blur", {w / 2, h / 2, GL_RGBA16F});
+//   graph.addPass("blur", [&](FrameGraph::PassBuilder& pass) {
+//       pass.read(scene);
+//       blur = pass.write(blur);
+//   }, [=](FrameGraph& graph) { ... 绑定 graph.target(blur).framebuffer 绘制 ... });
+//   if (graph.compile()) graph.execute();
+//   pool.endFrame();
+// 每个资源是单层纹理 + FBO，不支持 MRT；GL 3.3 不能让不同格式共享显存，只在尺寸和格式相同的纹理间复用
+class FrameGraph {
+public:
+    struct TextureDesc {
+        int width = 0;
+        int height = 0;
+        GLenum format = GL_RGBA8;
+
+        TextureDesc() = default;
+        TextureDesc(int w, int h, GLenum f) : width(w), height(h), format(f) {}
+    };
+
+    struct Stats {
+        size_t passes = 0;        // 声明的 pass 数
+        size_t culledPasses = 0;  // 被剔除的 pass 数
+        size_t textures = 0;      // 实际用到的临时纹理数
+        size_t targets = 0;       // 它们占用的不同池目标数，小于 textures 说明有复用
+        size_t bytes = 0;         // 这些池目标的显存
+    };
+
+    // 在 addPass 的 setup 回调里声明 pass 的读写
+    class PassBuilder {
+    public:
+        int read(int resource);
+        // 返回资源的新版本，之后的 pass 应读写返回的句柄
+        int write(int resource);
+        // pass 有图外可见的效果（读回、写外部对象），即使不输出到图里的资源也不剔除
+        void sideEffect();
+
+    private:
+        friend class FrameGraph;
+        PassBuilder(FrameGraph& graph, int pass) : m_graph(graph), m_pass(pass) {}
+        FrameGraph& m_graph;
+        int m_pass;
+    };
+
+    typedef std::function<void(PassBuilder&)> Setup;
+    typedef std::function<void(FrameGraph&)> Execute;
+
+    explicit FrameGraph(RenderTargetPool& pool) : m_pool(pool) {}
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    // 清空上一帧声明的 pass 和资源，容器容量保留
+    void reset();
+
+    // 临时纹理，执行时从池中借出，内容在第一次写入前未定义
+    int createTexture(const std::string& name, const TextureDesc& desc);
+    // 图外部的目标（场景缓冲、默认帧缓冲等），不归池管理；写入它的 pass 不会被剔除
+    int importTarget(const std::string& name, const RenderTarget& target);
+
+    // setup 在 addPass 内立即调用；execute 在 execute() 时按排序后的顺序调用
+    int addPass(const std::string& name, const Setup& setup, const Execute& execute);
+
+    // 剔除、排序并计算生命周期。句柄无效、资源在写入前被读或依赖成环时返回 false
+    bool compile();
+    // 按编译结果执行，每个 pass 有自己的 Profiler 作用域
+    void execute();
+
+    // 只在 pass 执行期间有效。同一纹理的各个版本对应同一个目标，execute 回调可以用 write 之前的句柄
+    const RenderTarget& target(int resource) const;
+    GLuint texture(int resource) const { return target(resource).texture; }
+    GLuint framebuffer(int resource) const { return target(resource).framebuffer; }
+    const TextureDesc& desc(int resource) const;
+
+    const Stats& stats() const { return m_stats; }
+    // 编译后的执行顺序，每行一个 pass 及其读写的资源，调试用
+    std::string dump() const;
+
+private:
+    // 同一张纹理的所有版本共用一个 Texture
+    struct Texture {
+        std::string name;
+        TextureDesc desc;
+        bool imported = false;
+        RenderTarget external;
+        RenderTarget* pooled = nullptr;
+        int firstPass = -1;   // 编译后执行顺序中的下标
+        int lastPass = -1;
+        int latestVersion = 0;
+    };
+    struct Resource {
+        int texture = 0;
+        int version = 0;
+        int writer = -1;
+        int previous = -1;   // 同一纹理的上一个版本
+        std::vector<int> readers;
+        int refCount = 0;
+    };
+    struct Pass {
+        std::string name;
+        Execute execute;
+        std::vector<int> reads;
+        std::vector<int> writes;
+        bool sideEffect = false;
+        int refCount = 0;
+        bool culled = false;
+    };
+
+    bool validResource(int resource) const;
+    int addResource(int texture, int version);
+    void cull();
+    bool sortPasses();
+    void computeLifetimes();
+
+    RenderTargetPool& m_pool;
+    std::vector<Texture> m_textures;
+    std::vector<Resource> m_resources;
+    std::vector<Pass> m_passes;
+    std::vector<int> m_order;   // 未被剔除的 pass，按执行顺序
+    bool m_compiled = false;
+    bool m_valid = true;        // 声明阶段出错后 compile 直接失败
+    Stats m_stats;
+};
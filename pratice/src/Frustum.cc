@@ -0,0 +1,287 @@
+#include "Frustum.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define FRUSTUM_SSE 1
+#endif
+
+namespace {
+
+#if defined(FRUSTUM_AVX) || defined(FRUSTUM_SSE)
+const uint8_t kBitCount[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+// movemask 的 4 位展开成 4 个字节的 0/1 写入 visible，x86 为小端
+inline size_t storeMask4(int mask, uint8_t* out) {
+    const uint32_t m = static_cast<uint32_t>(mask);
+    const uint32_t bytes = (m & 1u) | ((m & 2u) << 7) | ((m & 4u) << 14) | ((m & 8u) << 21);
+    std::memcpy(out, &bytes, 4);
+    return kBitCount[mask & 0xF];
+}
+#endif
+
+// 平面参数按分量广播后的形式，AABB 测试另外需要法线的绝对值
+struct PlaneSet {
+    float a[Frustum::PlaneCount], b[Frustum::PlaneCount], c[Frustum::PlaneCount], d[Frustum::PlaneCount];
+    float absA[Frustum::PlaneCount], absB[Frustum::PlaneCount], absC[Frustum::PlaneCount];
+
+    explicit PlaneSet(const Frustum& frustum) {
+        for (int p = 0; p < Frustum::PlaneCount; ++p) {
+            a[p] = frustum.planes[p].x;
+            b[p] = frustum.planes[p].y;
+            c[p] = frustum.planes[p].z;
+            d[p] = frustum.planes[p].w;
+            absA[p] = std::fabs(a[p]);
+            absB[p] = std::fabs(b[p]);
+            absC[p] = std::fabs(c[p]);
+        }
+    }
+};
+
+// 区间按 8 对齐切分，除最后一段外不会落到标量尾部
+size_t cullGrain(size_t count, const JobSystem& jobs, size_t grain) {
+    if (grain == 0) grain = std::max<size_t>(4096, count / (jobs.threadCount() * 4));
+    return (grain + 7) & ~static_cast<size_t>(7);
+}
+
+} // namespace
+
+Frustum Frustum::fromMatrix(const glm::mat4& m) {
+    // glm 按列存储，m[col][row]；第 i 行与第 4 行相加/相减得到左右、下上、近远平面
+    Frustum frustum;
+    const glm::vec4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+    for (int i = 0; i < 3; ++i) {
+        const glm::vec4 row(m[0][i], m[1][i], m[2][i], m[3][i]);
+        frustum.planes[2 * i] = w + row;
+        frustum.planes[2 * i + 1] = w - row;
+    }
+    for (int p = 0; p < PlaneCount; ++p) {
+        const float length = glm::length(glm::vec3(frustum.planes[p]));
+        if (length > 0.0f) frustum.planes[p] /= length;
+    }
+    return frustum;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (int p = 0; p < PlaneCount; ++p) {
+        const glm::vec4& plane = planes[p];
+        if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) return false;
+    }
+    return true;
+}
+
+bool Frustum::intersectsAABB(const glm::vec3& minCorner, const glm::vec3& maxCorner) const {
+    const glm::vec3 center = (minCorner + maxCorner) * 0.5f;
+    const glm::vec3 extent = (maxCorner - minCorner) * 0.5f;
+    for (int p = 0; p < PlaneCount; ++p) {
+        const glm::vec4& plane = planes[p];
+        const float d = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        const float r = std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y + std::fabs(plane.z) * extent.z;
+        if (d + r < 0.0f) return false;
+    }
+    return true;
+}
+
+void SphereSoA::resize(size_t count) {
+    x.resize(count);
+    y.resize(count);
+    z.resize(count);
+    radius.resize(count);
+}
+
+void SphereSoA::set(size_t i, const glm::vec3& center, float r) {
+    x[i] = center.x;
+    y[i] = center.y;
+    z[i] = center.z;
+    radius[i] = r;
+}
+
+void AABBSoA::resize(size_t count) {
+    centerX.resize(count);
+    centerY.resize(count);
+    centerZ.resize(count);
+    extentX.resize(count);
+    extentY.resize(count);
+    extentZ.resize(count);
+}
+
+void AABBSoA::set(size_t i, const glm::vec3& minCorner, const glm::vec3& maxCorner) {
+    centerX[i] = (minCorner.x + maxCorner.x) * 0.5f;
+    centerY[i] = (minCorner.y + maxCorner.y) * 0.5f;
+    centerZ[i] = (minCorner.z + maxCorner.z) * 0.5f;
+    extentX[i] = (maxCorner.x - minCorner.x) * 0.5f;
+    extentY[i] = (maxCorner.y - minCorner.y) * 0.5f;
+    extentZ[i] = (maxCorner.z - minCorner.z) * 0.5f;
+}
+
+size_t FrustumCuller::cullSpheresScalar(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end,
+                                        uint8_t* visible) {
+    const PlaneSet planes(frustum);
+    size_t count = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const float negRadius = -spheres.radius[i];
+        bool inside = true;
+        for (int p = 0; p < Frustum::PlaneCount; ++p) {
+            const float d = planes.a[p] * spheres.x[i] + planes.b[p] * spheres.y[i] + planes.c[p] * spheres.z[i] + planes.d[p];
+            inside = inside && d >= negRadius;
+        }
+        visible[i] = inside ? 1 : 0;
+        count += inside ? 1 : 0;
+    }
+    return count;
+}
+
+size_t FrustumCuller::cullAABBsScalar(const Frustum& frustum, const AABBSoA& boxes, size_t begin, size_t end,
+                                      uint8_t* visible) {
+    const PlaneSet planes(frustum);
+    size_t count = 0;
+    for (size_t i = begin; i < end; ++i) {
+        bool inside = true;
+        for (int p = 0; p < Frustum::PlaneCount; ++p) {
+            const float d = planes.a[p] * boxes.centerX[i] + planes.b[p] * boxes.centerY[i] + planes.c[p] * boxes.centerZ[i] + planes.d[p];
+            const float r = planes.absA[p] * boxes.extentX[i] + planes.absB[p] * boxes.extentY[i] + planes.absC[p] * boxes.extentZ[i];
+            inside = inside && d + r >= 0.0f;
+        }
+        visible[i] = inside ? 1 : 0;
+        count += inside ? 1 : 0;
+    }
+    return count;
+}
+
+// SIMD 版本与标量版本的运算顺序相同（先乘后加，不用 FMA），只有编译器把标量版本收缩成 FMA 时边界上的物体才可能不同
+size_t FrustumCuller::cullSpheres(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end,
+                                  uint8_t* visible) {
+    size_t i = begin;
+    size_t count = 0;
+#if defined(FRUSTUM_AVX)
+    const PlaneSet planes(frustum);
+    for (; i + 8 <= end; i += 8) {
+        const __m256 x = _mm256_loadu_ps(&spheres.x[i]);
+        const __m256 y = _mm256_loadu_ps(&spheres.y[i]);
+        const __m256 z = _mm256_loadu_ps(&spheres.z[i]);
+        const __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(&spheres.radius[i]));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < Frustum::PlaneCount; ++p) {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.a[p]), x), _mm256_mul_ps(_mm256_set1_ps(planes.b[p]), y));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes.c[p]), z));
+            d = _mm256_add_ps(d, _mm256_set1_ps(planes.d[p]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, negRadius, _CMP_GE_OQ));
+        }
+        const int mask = _mm256_movemask_ps(inside);
+        count += storeMask4(mask & 0xF, visible + i);
+        count += storeMask4(mask >> 4, visible + i + 4);
+    }
+#elif defined(FRUSTUM_SSE)
+    const PlaneSet planes(frustum);
+    for (; i + 4 <= end; i += 4) {
+        const __m128 x = _mm_loadu_ps(&spheres.x[i]);
+        const __m128 y = _mm_loadu_ps(&spheres.y[i]);
+        const __m128 z = _mm_loadu_ps(&spheres.z[i]);
+        const __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+        __m128 inside = _mm_cmpeq_ps(x, x);
+        for (int p = 0; p < Frustum::PlaneCount; ++p) {
+            __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.a[p]), x), _mm_mul_ps(_mm_set1_ps(planes.b[p]), y));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes.c[p]), z));
+            d = _mm_add_ps(d, _mm_set1_ps(planes.d[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negRadius));
+        }
+        count += storeMask4(_mm_movemask_ps(inside), visible + i);
+    }
+#endif
+    return count + cullSpheresScalar(frustum, spheres, i, end, visible);
+}
+
+size_t FrustumCuller::cullAABBs(const Frustum& frustum, const AABBSoA& boxes, size_t begin, size_t end,
+                                uint8_t* visible) {
+    size_t i = begin;
+    size_t count = 0;
+#if defined(FRUSTUM_AVX)
+    const PlaneSet planes(frustum);
+    for (; i + 8 <= end; i += 8) {
+        const __m256 cx = _mm256_loadu_ps(&boxes.centerX[i]);
+        const __m256 cy = _mm256_loadu_ps(&boxes.centerY[i]);
+        const __m256 cz = _mm256_loadu_ps(&boxes.centerZ[i]);
+        const __m256 ex = _mm256_loadu_ps(&boxes.extentX[i]);
+        const __m256 ey = _mm256_loadu_ps(&boxes.extentY[i]);
+        const __m256 ez = _mm256_loadu_ps(&boxes.extentZ[i]);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < Frustum::PlaneCount; ++p) {
+            __m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.a[p]), cx), _mm256_mul_ps(_mm256_set1_ps(planes.b[p]), cy));
+            d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(planes.c[p]), cz));
+            d = _mm256_add_ps(d, _mm256_set1_ps(planes.d[p]));
+            __m256 r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(planes.absA[p]), ex), _mm256_mul_ps(_mm256_set1_ps(planes.absB[p]), ey));
+            r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_set1_ps(planes.absC[p]), ez));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        const int mask = _mm256_movemask_ps(inside);
+        count += storeMask4(mask & 0xF, visible + i);
+        count += storeMask4(mask >> 4, visible + i + 4);
+    }
+#elif defined(FRUSTUM_SSE)
+    const PlaneSet planes(frustum);
+    for (; i + 4 <= end; i += 4) {
+        const __m128 cx = _mm_loadu_ps(&boxes.centerX[i]);
+        const __m128 cy = _mm_loadu_ps(&boxes.centerY[i]);
+        const __m128 cz = _mm_loadu_ps(&boxes.centerZ[i]);
+        const __m128 ex = _mm_loadu_ps(&boxes.extentX[i]);
+        const __m128 ey = _mm_loadu_ps(&boxes.extentY[i]);
+        const __m128 ez = _mm_loadu_ps(&boxes.extentZ[i]);
+        __m128 inside = _mm_cmpeq_ps(cx, cx);
+        for (int p = 0; p < Frustum::PlaneCount; ++p) {
+            __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.a[p]), cx), _mm_mul_ps(_mm_set1_ps(planes.b[p]), cy));
+            d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(planes.c[p]), cz));
+            d = _mm_add_ps(d, _mm_set1_ps(planes.d[p]));
+            __m128 r = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.absA[p]), ex), _mm_mul_ps(_mm_set1_ps(planes.absB[p]), ey));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(planes.absC[p]), ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+        }
+        count += storeMask4(_mm_movemask_ps(inside), visible + i);
+    }
+#endif
+    return count + cullAABBsScalar(frustum, boxes, i, end, visible);
+}
+
+size_t FrustumCuller::cullSpheres(const Frustum& frustum, const SphereSoA& spheres, uint8_t* visible,
+                                  JobSystem& jobs, size_t grain) {
+    std::atomic<size_t> count(0);
+    jobs.parallelFor(spheres.size(), [&](size_t begin, size_t end) {
+        count.fetch_add(cullSpheres(frustum, spheres, begin, end, visible), std::memory_order_relaxed);
+    }, cullGrain(spheres.size(), jobs, grain));
+    return count.load();
+}
+
+size_t FrustumCuller::cullAABBs(const Frustum& frustum, const AABBSoA& boxes, uint8_t* visible,
+                                JobSystem& jobs, size_t grain) {
+    std::atomic<size_t> count(0);
+    jobs.parallelFor(boxes.size(), [&](size_t begin, size_t end) {
+        count.fetch_add(cullAABBs(frustum, boxes, begin, end, visible), std::memory_order_relaxed);
+    }, cullGrain(boxes.size(), jobs, grain));
+    return count.load();
+}
+
+const char* FrustumCuller::simdPath() {
+#if defined(FRUSTUM_AVX)
+    return "AVX";
+#elif defined(FRUSTUM_SSE)
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
+
+int FrustumCuller::simdWidth() {
+#if defined(FRUSTUM_AVX)
+    return 8;
+#elif defined(FRUSTUM_SSE)
+    return 4;
+#else
+    return 1;
+#endif
+}
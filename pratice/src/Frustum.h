@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+class JobSystem;
+
+// 视锥体：六个平面 (a, b, c, d)，法线朝内并归一化，点 p 在平面内侧当 dot(n, p) + d >= 0
+struct Frustum {
+    enum Plane { Left = 0, Right, Bottom, Top, Near, Far, PlaneCount };
+    glm::vec4 planes[PlaneCount];
+
+    // 从 projection * view 提取 (Gribb-Hartmann)，平面在世界空间；
+    // 传入 projection * view * model 则得到模型空间的平面
+    static Frustum fromMatrix(const glm::mat4& viewProjection);
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+    bool intersectsAABB(const glm::vec3& minCorner, const glm::vec3& maxCorner) const;
+};
+
+// 按分量分开存放的包围球，便于一次加载 4/8 个物体
+struct SphereSoA {
+    std::vector<float> x, y, z, radius;
+
+    size_t size() const { return x.size(); }
+    void resize(size_t count);
+    void set(size_t i, const glm::vec3& center, float r);
+};
+
+// 包围盒以中心和半边长存放，平面测试只需要 dot(n, c) + dot(|n|, e)
+struct AABBSoA {
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    size_t size() const { return centerX.size(); }
+    void resize(size_t count);
+    void set(size_t i, const glm::vec3& minCorner, const glm::vec3& maxCorner);
+};
+
+// 批量视锥剔除：visible[i] 写 1（与视锥相交）或 0，返回可见数量。
+// 编译器开启 AVX 时每次测试 8 个物体，否则用 SSE 每次 4 个，都没有时退回标量。
+// 结果是保守的：与视锥角落外侧相交的少量物体也会判为可见，与 Frustum::intersects* 一致
+class FrustumCuller {
+public:
+    // 只处理 [begin, end)
+    static size_t cullSpheres(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end,
+                              uint8_t* visible);
+    static size_t cullAABBs(const Frustum& frustum, const AABBSoA& boxes, size_t begin, size_t end,
+                            uint8_t* visible);
+
+    // 用 JobSystem 把整个数组切成区间并行剔除，阻塞到完成
+    static size_t cullSpheres(const Frustum& frustum, const SphereSoA& spheres, uint8_t* visible,
+                              JobSystem& jobs, size_t grain = 0);
+    static size_t cullAABBs(const Frustum& frustum, const AABBSoA& boxes, uint8_t* visible,
+                            JobSystem& jobs, size_t grain = 0);
+
+    // 标量参考实现，用于尾部和对比测试
+    static size_t cullSpheresScalar(const Frustum& frustum, const SphereSoA& spheres, size_t begin, size_t end,
+                                    uint8_t* visible);
+    static size_t cullAABBsScalar(const Frustum& frustum, const AABBSoA& boxes, size_t begin, size_t end,
+                                  uint8_t* visible);
+
+    // 编译进来的指令集："AVX"、"SSE" 或 "scalar"
+    static const char* simdPath();
+    // 每条指令测试的物体数
+    static int simdWidth();
+};
@@ -0,0 +1,27 @@
+#include "FullscreenPass.h"
+#include "GLStateCache.h"
+
+const char* const kFullscreenVS =
+    "#version 330 core\n"
+    "out vec2 uv;\n"
+    "void main() {\n"
+    "    vec2 p = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+    "    uv = p;\n"
+    "    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);\n"
+    "}\n";
+
+const GLenum PassStateScope::kCapabilities[PassStateScope::kCount] = {GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE,
+                                                                      GL_SCISSOR_TEST};
+
+PassStateScope::PassStateScope() {
+    glGetIntegerv(GL_VIEWPORT, m_viewport);
+    for (int i = 0; i < kCount; ++i) {
+        m_enabled[i] = glIsEnabled(kCapabilities[i]) == GL_TRUE;
+        GLStateCache::get().disable(kCapabilities[i]);
+    }
+}
+
+PassStateScope::~PassStateScope() {
+    for (int i = 0; i < kCount; ++i) GLStateCache::get().setEnabled(kCapabilities[i], m_enabled[i]);
+    glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+}
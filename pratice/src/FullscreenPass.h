@@ -0,0 +1,23 @@
+#pragma once
+#include <glad/glad.h>
+
+// 全屏 pass 的公共部分，DeferredRenderer、HiZCuller、HdrPipeline 等内部使用
+
+// 不需要顶点缓冲的全屏三角形：绑定任意 VAO 后 glDrawArrays(GL_TRIANGLES, 0, 3)。
+// 输出 uv ([0, 1])，片元着色器不需要时可以不声明
+extern const char* const kFullscreenVS;
+
+// 全屏 pass 关闭深度测试、混合、剔除和裁剪，析构时按进入时的状态恢复，视口一并恢复
+class PassStateScope {
+public:
+    PassStateScope();
+    ~PassStateScope();
+    PassStateScope(const PassStateScope&) = delete;
+    PassStateScope& operator=(const PassStateScope&) = delete;
+
+private:
+    static const int kCount = 4;
+    static const GLenum kCapabilities[kCount];
+    GLint m_viewport[4];
+    bool m_enabled[kCount];
+};
@@ -0,0 +1,61 @@
+#include "GLCaps.h"
+#include "TextureContainer.h"
+
+const GLCaps& GLCaps::get() {
+    static GLCaps caps;
+    return caps;
+}
+
+GLCaps::GLCaps() {
+    glGetIntegerv(GL_MAJOR_VERSION, &m_major);
+    glGetIntegerv(GL_MINOR_VERSION, &m_minor);
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const GLubyte* name = glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i));
+        if (name) m_extensions.insert(reinterpret_cast<const char*>(name));
+    }
+}
+
+bool GLCaps::supportsCompressedFormat(GLenum internalFormat) const {
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            return hasExtension("GL_EXT_texture_compression_s3tc");
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            return hasExtension("GL_EXT_texture_compression_s3tc") &&
+                   (hasExtension("GL_EXT_texture_sRGB") || hasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_SIGNED_RG_RGTC2:
+            return versionAtLeast(3, 0);
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+            return versionAtLeast(4, 2) || hasExtension("GL_ARB_texture_compression_bptc");
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+            return versionAtLeast(4, 3) || hasExtension("GL_ARB_ES3_compatibility");
+        default:
+            return false;
+    }
+}
+
+bool GLCaps::supportsBindlessTextures() const {
+#ifdef GL_ARB_bindless_texture
+    return versionAtLeast(4, 0) && hasExtension("GL_ARB_bindless_texture");
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <string>
+#include <unordered_set>
+#include <glad/glad.h>
+
+// 当前 GL 上下文的能力查询，第一次调用时读取扩展列表并缓存
+// 必须在创建上下文并初始化 GLAD 之后、在 GL 线程上调用
+class GLCaps {
+public:
+    static const GLCaps& get();
+
+    bool hasExtension(const std::string& name) const { return m_extensions.count(name) != 0; }
+    bool versionAtLeast(int major, int minor) const {
+        return m_major > major || (m_major == major && m_minor >= minor);
+    }
+    int majorVersion() const { return m_major; }
+    int minorVersion() const { return m_minor; }
+
+    // 压缩纹理格式支持
+    bool supportsCompressedFormat(GLenum internalFormat) const;
+    // ARB_bindless_texture：需要 GL 4.0 以及 GLAD 生成了该扩展的入口
+    bool supportsBindlessTextures() const;
+
+private:
+    GLCaps();
+    int m_major = 0;
+    int m_minor = 0;
+    std::unordered_set<std::string> m_extensions;
+};
@@ -0,0 +1,266 @@
+#include "GLStateCache.h"
+
+namespace {
+// 缓存值未知，下一次调用一定会进入驱动
+const GLuint kUnknown = 0xFFFFFFFFu;
+} // namespace
+
+GLStateCache& GLStateCache::get() {
+    static GLStateCache cache;
+    return cache;
+}
+
+GLStateCache::GLStateCache() {
+    invalidate();
+}
+
+void GLStateCache::invalidate() {
+    m_program = kUnknown;
+    m_vertexArray = kUnknown;
+    for (int i = 0; i < kBufferTargets; ++i) m_buffers[i] = kUnknown;
+    m_drawFramebuffer = kUnknown;
+    m_readFramebuffer = kUnknown;
+    m_activeUnit = kUnknown;
+    for (int unit = 0; unit < kMaxTextureUnits; ++unit) {
+        for (int i = 0; i < kTextureTargets; ++i) m_textures[unit][i] = kUnknown;
+        m_samplers[unit] = kUnknown;
+    }
+    for (int i = 0; i < kCapabilities; ++i) m_capabilities[i] = kUnknown;
+    m_blendSrc = m_blendDst = kUnknown;
+    m_depthFunc = kUnknown;
+    m_depthMask = kUnknown;
+    m_cullFace = kUnknown;
+}
+
+int GLStateCache::bufferSlot(GLenum target) {
+    switch (target) {
+    case GL_ARRAY_BUFFER: return 0;
+    case GL_ELEMENT_ARRAY_BUFFER: return 1;
+    case GL_UNIFORM_BUFFER: return 2;
+    case GL_PIXEL_PACK_BUFFER: return 3;
+    case GL_PIXEL_UNPACK_BUFFER: return 4;
+    case GL_TEXTURE_BUFFER: return 5;
+#ifdef GL_SHADER_STORAGE_BUFFER
+    case GL_SHADER_STORAGE_BUFFER: return 6;
+#endif
+#ifdef GL_DRAW_INDIRECT_BUFFER
+    case GL_DRAW_INDIRECT_BUFFER: return 7;
+#endif
+    default: return -1;
+    }
+}
+
+int GLStateCache::textureSlot(GLenum target) {
+    switch (target) {
+    case GL_TEXTURE_2D: return 0;
+    case GL_TEXTURE_2D_ARRAY: return 1;
+    case GL_TEXTURE_CUBE_MAP: return 2;
+    case GL_TEXTURE_3D: return 3;
+    case GL_TEXTURE_BUFFER: return 4;
+    case GL_TEXTURE_2D_MULTISAMPLE: return 5;
+    default: return -1;
+    }
+}
+
+int GLStateCache::capabilitySlot(GLenum capability) {
+    switch (capability) {
+    case GL_BLEND: return 0;
+    case GL_DEPTH_TEST: return 1;
+    case GL_CULL_FACE: return 2;
+    case GL_FRAMEBUFFER_SRGB: return 3;
+    case GL_SCISSOR_TEST: return 4;
+    case GL_STENCIL_TEST: return 5;
+    case GL_MULTISAMPLE: return 6;
+    case GL_TEXTURE_CUBE_MAP_SEAMLESS: return 7;
+    default: return -1;
+    }
+}
+
+bool GLStateCache::update(GLuint& cached, GLuint value, Counter& counter) {
+    if (cached == value) {
+        ++counter.skipped;
+        return false;
+    }
+    cached = value;
+    ++counter.issued;
+    return true;
+}
+
+void GLStateCache::useProgram(GLuint program) {
+    if (update(m_program, program, m_stats.program)) glUseProgram(program);
+}
+
+void GLStateCache::bindVertexArray(GLuint vao) {
+    if (update(m_vertexArray, vao, m_stats.vertexArray)) {
+        glBindVertexArray(vao);
+        // ELEMENT_ARRAY_BUFFER 绑定属于 VAO 状态，切换 VAO 后不再可信
+        m_buffers[bufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = kUnknown;
+    }
+}
+
+void GLStateCache::bindBuffer(GLenum target, GLuint buffer) {
+    const int slot = bufferSlot(target);
+    if (slot < 0) {
+        ++m_stats.buffer.issued;
+        glBindBuffer(target, buffer);
+        return;
+    }
+    if (update(m_buffers[slot], buffer, m_stats.buffer)) glBindBuffer(target, buffer);
+}
+
+void GLStateCache::bindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    ++m_stats.buffer.issued;
+    glBindBufferBase(target, index, buffer);
+    const int slot = bufferSlot(target);
+    if (slot >= 0) m_buffers[slot] = buffer;
+}
+
+void GLStateCache::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    if (target == GL_FRAMEBUFFER) {
+        if (m_drawFramebuffer == framebuffer && m_readFramebuffer == framebuffer) {
+            ++m_stats.framebuffer.skipped;
+            return;
+        }
+        m_drawFramebuffer = m_readFramebuffer = framebuffer;
+        ++m_stats.framebuffer.issued;
+        glBindFramebuffer(target, framebuffer);
+    } else if (target == GL_DRAW_FRAMEBUFFER) {
+        if (update(m_drawFramebuffer, framebuffer, m_stats.framebuffer)) glBindFramebuffer(target, framebuffer);
+    } else if (target == GL_READ_FRAMEBUFFER) {
+        if (update(m_readFramebuffer, framebuffer, m_stats.framebuffer)) glBindFramebuffer(target, framebuffer);
+    }
+}
+
+GLuint GLStateCache::drawFramebuffer() {
+    if (m_drawFramebuffer == kUnknown) {
+        GLint binding = 0;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &binding);
+        m_drawFramebuffer = static_cast<GLuint>(binding);
+    }
+    return m_drawFramebuffer;
+}
+
+GLuint GLStateCache::readFramebuffer() {
+    if (m_readFramebuffer == kUnknown) {
+        GLint binding = 0;
+        glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &binding);
+        m_readFramebuffer = static_cast<GLuint>(binding);
+    }
+    return m_readFramebuffer;
+}
+
+void GLStateCache::activeTexture(GLuint unit) {
+    if (update(m_activeUnit, unit, m_stats.activeTexture)) glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLStateCache::bindTexture(GLenum target, GLuint texture) {
+    // 不知道当前活动单元时无法判断改的是哪个单元，先切到单元 0；调用方上传数据时不关心单元
+    if (m_activeUnit == kUnknown) activeTexture(0);
+    const int slot = textureSlot(target);
+    if (slot < 0 || m_activeUnit >= static_cast<GLuint>(kMaxTextureUnits)) {
+        ++m_stats.texture.issued;
+        glBindTexture(target, texture);
+        return;
+    }
+    if (update(m_textures[m_activeUnit][slot], texture, m_stats.texture)) glBindTexture(target, texture);
+}
+
+void GLStateCache::bindTextureUnit(GLuint unit, GLenum target, GLuint texture) {
+    const int slot = textureSlot(target);
+    if (slot >= 0 && unit < static_cast<GLuint>(kMaxTextureUnits) && m_textures[unit][slot] == texture) {
+        ++m_stats.texture.skipped;
+        return;
+    }
+    activeTexture(unit);
+    bindTexture(target, texture);
+}
+
+void GLStateCache::bindSampler(GLuint unit, GLuint sampler) {
+    if (unit >= static_cast<GLuint>(kMaxTextureUnits)) {
+        ++m_stats.sampler.issued;
+        glBindSampler(unit, sampler);
+        return;
+    }
+    if (update(m_samplers[unit], sampler, m_stats.sampler)) glBindSampler(unit, sampler);
+}
+
+void GLStateCache::setEnabled(GLenum capability, bool enabled) {
+    const int slot = capabilitySlot(capability);
+    if (slot >= 0 && !update(m_capabilities[slot], enabled ? 1u : 0u, m_stats.capability)) return;
+    if (slot < 0) ++m_stats.capability.issued;
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+}
+
+void GLStateCache::blendFunc(GLenum src, GLenum dst) {
+    if (m_blendSrc == src && m_blendDst == dst) {
+        ++m_stats.fixedState.skipped;
+        return;
+    }
+    m_blendSrc = src;
+    m_blendDst = dst;
+    ++m_stats.fixedState.issued;
+    glBlendFunc(src, dst);
+}
+
+void GLStateCache::depthFunc(GLenum func) {
+    if (update(m_depthFunc, func, m_stats.fixedState)) glDepthFunc(func);
+}
+
+void GLStateCache::depthMask(bool write) {
+    if (update(m_depthMask, write ? 1u : 0u, m_stats.fixedState)) glDepthMask(write ? GL_TRUE : GL_FALSE);
+}
+
+void GLStateCache::cullFace(GLenum mode) {
+    if (update(m_cullFace, mode, m_stats.fixedState)) glCullFace(mode);
+}
+
+// 删除仍在使用的程序时 GL 会推迟到解绑后才真正释放，缓存值改为未知即可；
+// 其他对象删除后，当前上下文里的绑定都回到 0
+void GLStateCache::deleteProgram(GLuint program) {
+    if (program == 0) return;
+    glDeleteProgram(program);
+    if (m_program == program) m_program = kUnknown;
+}
+
+void GLStateCache::deleteVertexArray(GLuint vao) {
+    if (vao == 0) return;
+    glDeleteVertexArrays(1, &vao);
+    if (m_vertexArray == vao) {
+        m_vertexArray = 0;
+        m_buffers[bufferSlot(GL_ELEMENT_ARRAY_BUFFER)] = kUnknown;
+    }
+}
+
+void GLStateCache::deleteBuffer(GLuint buffer) {
+    if (buffer == 0) return;
+    glDeleteBuffers(1, &buffer);
+    for (int i = 0; i < kBufferTargets; ++i) {
+        if (m_buffers[i] == buffer) m_buffers[i] = 0;
+    }
+}
+
+void GLStateCache::deleteFramebuffer(GLuint framebuffer) {
+    if (framebuffer == 0) return;
+    glDeleteFramebuffers(1, &framebuffer);
+    if (m_drawFramebuffer == framebuffer) m_drawFramebuffer = 0;
+    if (m_readFramebuffer == framebuffer) m_readFramebuffer = 0;
+}
+
+void GLStateCache::deleteTexture(GLuint texture) {
+    if (texture == 0) return;
+    glDeleteTextures(1, &texture);
+    for (int unit = 0; unit < kMaxTextureUnits; ++unit) {
+        for (int i = 0; i < kTextureTargets; ++i) {
+            if (m_textures[unit][i] == texture) m_textures[unit][i] = 0;
+        }
+    }
+}
+
+void GLStateCache::deleteSampler(GLuint sampler) {
+    if (sampler == 0) return;
+    glDeleteSamplers(1, &sampler);
+    for (int unit = 0; unit < kMaxTextureUnits; ++unit) {
+        if (m_samplers[unit] == sampler) m_samplers[unit] = 0;
+    }
+}
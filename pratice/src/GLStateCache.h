@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <glad/glad.h>
+
+// GL 状态缓存：记录当前绑定的程序、VAO、缓冲、帧缓冲、各纹理单元的纹理和采样器，
+// 以及混合/深度/面剔除等开关，与当前值相同的调用直接跳过，不进入驱动。
+// opengl_utils 的封装类都通过它绑定；绕过它直接调用 GL 修改了这些状态时，需要调用 invalidate()。
+// 缓存对应单个上下文，只能在 GL 线程上使用。删除对象请走 delete* 接口，
+// 否则名字被复用后缓存会误以为新对象已经绑定。
+class GLStateCache {
+public:
+    static const int kMaxTextureUnits = 32;
+
+    struct Counter {
+        size_t issued = 0;   // 真正调用了 GL
+        size_t skipped = 0;  // 与缓存相同而跳过
+    };
+    struct Stats {
+        Counter program;
+        Counter vertexArray;
+        Counter buffer;
+        Counter framebuffer;
+        Counter activeTexture;
+        Counter texture;
+        Counter sampler;
+        Counter capability;  // glEnable/glDisable
+        Counter fixedState;  // 混合函数、深度函数、深度写入、剔除面
+    };
+
+    static GLStateCache& get();
+
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vao);
+    // 支持 ARRAY/ELEMENT_ARRAY/UNIFORM/PIXEL_PACK/PIXEL_UNPACK/TEXTURE/SHADER_STORAGE 等目标，其他目标直接转发
+    void bindBuffer(GLenum target, GLuint buffer);
+    // 带下标的绑定点不缓存，总是调用 GL，同时更新通用绑定点的缓存
+    void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+    // 当前绑定的绘制/读取帧缓冲，缓存未知时向 GL 查询并记下
+    GLuint drawFramebuffer();
+    GLuint readFramebuffer();
+
+    void activeTexture(GLuint unit);
+    // 绑定到当前活动单元，用于上传数据
+    void bindTexture(GLenum target, GLuint texture);
+    // 绑定到指定单元，已经绑定时连 glActiveTexture 也省掉
+    void bindTextureUnit(GLuint unit, GLenum target, GLuint texture);
+    void bindSampler(GLuint unit, GLuint sampler);
+
+    void enable(GLenum capability) { setEnabled(capability, true); }
+    void disable(GLenum capability) { setEnabled(capability, false); }
+    void setEnabled(GLenum capability, bool enabled);
+    void blendFunc(GLenum src, GLenum dst);
+    void depthFunc(GLenum func);
+    void depthMask(bool write);
+    void cullFace(GLenum mode);
+
+    // 删除对象并清除缓存里对它的引用
+    void deleteProgram(GLuint program);
+    void deleteVertexArray(GLuint vao);
+    void deleteBuffer(GLuint buffer);
+    void deleteFramebuffer(GLuint framebuffer);
+    void deleteTexture(GLuint texture);
+    void deleteSampler(GLuint sampler);
+
+    // 忘掉所有缓存值，下一次调用一定会进入驱动（新建上下文或外部代码直接改了状态之后）
+    void invalidate();
+
+    const Stats& stats() const { return m_stats; }
+    void resetStats() { m_stats = Stats(); }
+
+    GLStateCache(const GLStateCache&) = delete;
+    GLStateCache& operator=(const GLStateCache&) = delete;
+
+private:
+    GLStateCache();
+
+    enum { kBufferTargets = 8, kTextureTargets = 6, kCapabilities = 8 };
+    static int bufferSlot(GLenum target);
+    static int textureSlot(GLenum target);
+    static int capabilitySlot(GLenum capability);
+    static bool update(GLuint& cached, GLuint value, Counter& counter);
+
+    GLuint m_program;
+    GLuint m_vertexArray;
+    GLuint m_buffers[kBufferTargets];
+    GLuint m_drawFramebuffer;
+    GLuint m_readFramebuffer;
+    GLuint m_activeUnit;
+    GLuint m_textures[kMaxTextureUnits][kTextureTargets];
+    GLuint m_samplers[kMaxTextureUnits];
+    GLuint m_capabilities[kCapabilities];  // 0/1，未知为 kUnknown
+    GLuint m_blendSrc;
+    GLuint m_blendDst;
+    GLuint m_depthFunc;
+    GLuint m_depthMask;
+    GLuint m_cullFace;
+    Stats m_stats;
+};
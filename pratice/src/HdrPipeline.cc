@@ -0,0 +1,479 @@
+#include "HdrPipeline.h"
+#include "FullscreenPass.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#include "Shader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// 13 点降采样：中心 2x2 盒子权重 0.5，四周四个重叠的 2x2 盒子各 0.125。
+// 第一级同时做软阈值，并限制极亮像素，避免单个高光像素在泛光里闪烁
+const char* kDownsampleFS =
+    "#version 330 core\n"
+    "uniform sampler2D source;\n"
+    "uniform vec2 sourceTexel;\n"
+    "uniform int prefilter;\n"
+    "uniform vec4 threshold;\n"
+    "in vec2 uv;\n"
+    "out vec4 FragColor;\n"
+    "vec3 tap(float x, float y) {\n"
+    "    return texture(source, uv + vec2(x, y) * sourceTexel).rgb;\n"
+    "}\n"
+    "void main() {\n"
+    "    vec3 color = tap(0.0, 0.0) * 0.125;\n"
+    "    color += (tap(-2.0, 2.0) + tap(2.0, 2.0) + tap(-2.0, -2.0) + tap(2.0, -2.0)) * 0.03125;\n"
+    "    color += (tap(0.0, 2.0) + tap(-2.0, 0.0) + tap(2.0, 0.0) + tap(0.0, -2.0)) * 0.0625;\n"
+    "    color += (tap(-1.0, 1.0) + tap(1.0, 1.0) + tap(-1.0, -1.0) + tap(1.0, -1.0)) * 0.125;\n"
+    "    if (prefilter != 0) {\n"
+    "        color = min(color, vec3(threshold.x * 64.0));\n"
+    "        float brightness = max(color.r, max(color.g, color.b));\n"
+    "        float soft = clamp(brightness - threshold.y, 0.0, threshold.z);\n"
+    "        soft = soft * soft * threshold.w;\n"
+    "        color *= max(soft, brightness - threshold.x) / max(brightness, 1e-4);\n"
+    "    }\n"
+    "    FragColor = vec4(color, 1.0);\n"
+    "}\n";
+
+// 3x3 tent 上采样，叠加到上一级
+const char* kUpsampleFS =
+    "#version 330 core\n"
+    "uniform sampler2D source;\n"
+    "uniform vec2 sourceTexel;\n"
+    "in vec2 uv;\n"
+    "out vec4 FragColor;\n"
+    "vec3 tap(float x, float y) {\n"
+    "    return texture(source, uv + vec2(x, y) * sourceTexel).rgb;\n"
+    "}\n"
+    "void main() {\n"
+    "    vec3 color = tap(0.0, 0.0) * 4.0;\n"
+    "    color += (tap(-1.0, 0.0) + tap(1.0, 0.0) + tap(0.0, -1.0) + tap(0.0, 1.0)) * 2.0;\n"
+    "    color += tap(-1.0, -1.0) + tap(1.0, -1.0) + tap(-1.0, 1.0) + tap(1.0, 1.0);\n"
+    "    FragColor = vec4(color / 16.0, 1.0);\n"
+    "}\n";
+
+// 亮度图：每个像素对应场景 8x8 的块，4 个双线性样本覆盖其中 16 个像素
+const char* kLuminanceFS =
+    "#version 330 core\n"
+    "uniform sampler2D scene;\n"
+    "uniform vec2 sceneTexel;\n"
+    "in vec2 uv;\n"
+    "out vec4 FragColor;\n"
+    "float luminance(vec2 offset) {\n"
+    "    return dot(texture(scene, uv + offset * sceneTexel).rgb, vec3(0.2126, 0.7152, 0.0722));\n"
+    "}\n"
+    "void main() {\n"
+    "    float l = luminance(vec2(-2.0, -2.0)) + luminance(vec2(2.0, -2.0)) +\n"
+    "              luminance(vec2(-2.0, 2.0)) + luminance(vec2(2.0, 2.0));\n"
+    "    FragColor = vec4(l * 0.25, 0.0, 0.0, 1.0);\n"
+    "}\n";
+
+// 亮度图的每个像素画一个点，x 坐标落在自己的 log2 亮度桶上，加法混合计数。
+// 桶 0 是比范围下限还暗的像素
+const char* kHistogramVS =
+    "uniform sampler2D luminance;\n"
+    "uniform vec2 logRange;\n"
+    "void main() {\n"
+    "    ivec2 size = textureSize(luminance, 0);\n"
+    "    float l = texelFetch(luminance, ivec2(gl_VertexID % size.x, gl_VertexID / size.x), 0).r;\n"
+    "    float t = (log2(max(l, 1e-10)) - logRange.x) * logRange.y;\n"
+    "    float bin = t < 0.0 ? 0.0 : 1.0 + min(floor(t * float(HISTOGRAM_BINS - 1)), float(HISTOGRAM_BINS - 2));\n"
+    "    gl_Position = vec4((bin + 0.5) / float(HISTOGRAM_BINS) * 2.0 - 1.0, 0.0, 0.0, 1.0);\n"
+    "}\n";
+
+const char* kHistogramFS =
+    "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    FragColor = vec4(1.0);\n"
+    "}\n";
+
+// ACES 用 Narkowicz 的拟合；Reinhard 作用在亮度上（白点 4.0），不改变色相
+const char* kToneMapFS =
+    "#version 330 core\n"
+    "uniform sampler2D scene;\n"
+    "uniform sampler2D bloom;\n"
+    "uniform float bloomIntensity;\n"
+    "uniform float exposure;\n"
+    "uniform int toneMapper;\n"
+    "uniform int encodeSrgb;\n"
+    "in vec2 uv;\n"
+    "out vec4 FragColor;\n"
+    "vec3 aces(vec3 x) {\n"
+    "    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);\n"
+    "}\n"
+    "vec3 reinhard(vec3 x) {\n"
+    "    float l = dot(x, vec3(0.2126, 0.7152, 0.0722));\n"
+    "    float mapped = l * (1.0 + l / 16.0) / (1.0 + l);\n"
+    "    return clamp(x * (mapped / max(l, 1e-5)), 0.0, 1.0);\n"
+    "}\n"
+    "void main() {\n"
+    "    vec3 color = texture(scene, uv).rgb;\n"
+    "    if (bloomIntensity > 0.0) color += texture(bloom, uv).rgb * bloomIntensity;\n"
+    "    color *= exposure;\n"
+    "    color = toneMapper == 0 ? aces(color) : reinhard(color);\n"
+    "    if (encodeSrgb != 0) {\n"
+    "        color = mix(color * 12.92, 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055, step(0.0031308, color));\n"
+    "    }\n"
+    "    FragColor = vec4(color, 1.0);\n"
+    "}\n";
+
+// 测光时忽略最暗的 50% 和最亮的 5%，避免大片阴影或天空里的光源主导曝光
+const float kLowPercentile = 0.5f;
+const float kHighPercentile = 0.95f;
+// 曝光后的中灰
+const float kMiddleGrey = 0.18f;
+const float kMinExposure = 1.0f / 64.0f;
+const float kMaxExposure = 64.0f;
+
+void drawFullscreen(const RenderTarget& target) {
+    GLStateCache::get().bindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glViewport(0, 0, target.width, target.height);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+} // namespace
+
+HdrPipeline::HdrPipeline() : m_graph(m_pool), m_histogram(kHistogramBins, 0.0f) {}
+
+HdrPipeline::~HdrPipeline() {
+    release();
+    for (Readback& readback : m_readbacks) {
+        if (readback.fence) glDeleteSync(readback.fence);
+        GLStateCache::get().deleteBuffer(readback.buffer);
+    }
+    GLStateCache::get().deleteVertexArray(m_emptyVao);
+}
+
+bool HdrPipeline::init() {
+    if (m_ready) return true;
+    if (!GLCaps::get().versionAtLeast(3, 3)) {
+        std::cerr << "HdrPipeline: requires OpenGL 3.3" << std::endl;
+        return false;
+    }
+    const std::string histogramVS = "#version 330 core\n#define HISTOGRAM_BINS " + std::to_string(kHistogramBins) +
+                                    "\n" + kHistogramVS;
+    m_downsampleShader.reset(new Shader(kFullscreenVS, kDownsampleFS, true));
+    m_upsampleShader.reset(new Shader(kFullscreenVS, kUpsampleFS, true));
+    m_luminanceShader.reset(new Shader(kFullscreenVS, kLuminanceFS, true));
+    m_histogramShader.reset(new Shader(histogramVS, kHistogramFS, true));
+    m_toneMapShader.reset(new Shader(kFullscreenVS, kToneMapFS, true));
+    if (!m_downsampleShader->isValid() || !m_upsampleShader->isValid() || !m_luminanceShader->isValid() ||
+        !m_histogramShader->isValid() || !m_toneMapShader->isValid()) {
+        std::cerr << "HdrPipeline: shader compilation failed" << std::endl;
+        m_downsampleShader.reset();
+        m_upsampleShader.reset();
+        m_luminanceShader.reset();
+        m_histogramShader.reset();
+        m_toneMapShader.reset();
+        return false;
+    }
+    m_downsampleShader->use();
+    m_downsampleShader->setInt("source", 0);
+    m_upsampleShader->use();
+    m_upsampleShader->setInt("source", 0);
+    m_luminanceShader->use();
+    m_luminanceShader->setInt("scene", 0);
+    m_histogramShader->use();
+    m_histogramShader->setInt("luminance", 0);
+    m_toneMapShader->use();
+    m_toneMapShader->setInt("scene", 0);
+    m_toneMapShader->setInt("bloom", 1);
+
+    glGenVertexArrays(1, &m_emptyVao);
+    for (Readback& readback : m_readbacks) glGenBuffers(1, &readback.buffer);
+    m_ready = true;
+    return true;
+}
+
+void HdrPipeline::release() {
+    GLStateCache::get().deleteFramebuffer(m_sceneFbo);
+    GLStateCache::get().deleteTexture(m_sceneTexture);
+    if (m_sceneDepth) glDeleteRenderbuffers(1, &m_sceneDepth);
+    m_sceneFbo = m_sceneTexture = m_sceneDepth = 0;
+    m_width = m_height = 0;
+}
+
+bool HdrPipeline::resize(int width, int height) {
+    if (!m_ready || width <= 0 || height <= 0) return false;
+    if (width == m_width && height == m_height) return true;
+    release();
+    GLStateCache& cache = GLStateCache::get();
+
+    glGenTextures(1, &m_sceneTexture);
+    cache.bindTexture(GL_TEXTURE_2D, m_sceneTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+    // 泛光降采样依赖双线性过滤
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // 深度和 Renderer 的离屏目标一样是 DEPTH24_STENCIL8，DeferredRenderer::resolve 可以直接拷贝深度
+    glGenRenderbuffers(1, &m_sceneDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_sceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &m_sceneFbo);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_sceneFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_sceneTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_sceneDepth);
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    cache.bindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cerr << "HdrPipeline: incomplete framebuffer for " << width << "x" << height << std::endl;
+        release();
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    return true;
+}
+
+void HdrPipeline::setBloomThreshold(float threshold, float knee) {
+    m_bloomThreshold = std::max(threshold, 0.0f);
+    m_bloomKnee = std::max(knee, 1e-4f);
+}
+
+void HdrPipeline::begin(const glm::vec3& clearColor) {
+    if (!m_sceneFbo) return;
+    GLStateCache::get().bindFramebuffer(GL_FRAMEBUFFER, m_sceneFbo);
+    glViewport(0, 0, m_width, m_height);
+    glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+}
+
+void HdrPipeline::end(GLuint framebuffer, bool srgbTarget) {
+    if (!m_ready || !m_sceneFbo) return;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const float dt = m_lastEnd == std::chrono::steady_clock::time_point()
+                         ? 0.0f
+                         : std::min(std::chrono::duration<float>(now - m_lastEnd).count(), 0.25f);
+    m_lastEnd = now;
+
+    GLStateCache& cache = GLStateCache::get();
+    {
+        PassStateScope scope;
+        cache.bindVertexArray(m_emptyVao);
+        cache.bindSampler(0, 0);
+        cache.bindSampler(1, 0);
+
+        // 先用几帧前的直方图更新曝光，泛光阈值按曝光后的亮度计算
+        if (m_autoExposure) {
+            collectHistogram();
+            if (m_hasExposure) {
+                const float blend = 1.0f - std::exp(-dt * m_adaptationRate);
+                const float logExposure = std::log2(m_exposure);
+                m_exposure = std::exp2(logExposure + (std::log2(m_targetExposure) - logExposure) * blend);
+            }
+        }
+        m_stats.exposure = m_exposure;
+
+        // 每帧重新声明整条后处理链。泛光强度为 0 时色调映射不读泛光，泛光的各个 pass 由帧图剔除
+        m_graph.reset();
+        RenderTarget sceneTarget;
+        sceneTarget.texture = m_sceneTexture;
+        sceneTarget.framebuffer = m_sceneFbo;
+        sceneTarget.width = m_width;
+        sceneTarget.height = m_height;
+        sceneTarget.format = GL_RGBA16F;
+        RenderTarget outputTarget;
+        outputTarget.framebuffer = framebuffer;
+        outputTarget.width = m_width;
+        outputTarget.height = m_height;
+        const int scene = m_graph.importTarget("hdr scene", sceneTarget);
+        int output = m_graph.importTarget("hdr output", outputTarget);
+        int levelCount = 0;
+        const int bloom = addBloomPasses(scene, levelCount);
+        if (m_autoExposure) addHistogramPasses(scene);
+
+        const bool useBloom = bloom >= 0 && m_bloomIntensity > 0.0f;
+        m_graph.addPass("tone map", [&](FrameGraph::PassBuilder& pass) {
+            pass.read(scene);
+            if (useBloom) pass.read(bloom);
+            output = pass.write(output);
+        }, [=](FrameGraph& graph) {
+            m_toneMapShader->use();
+            const GLuint program = m_toneMapShader->ID();
+            glUniform1f(glGetUniformLocation(program, "bloomIntensity"), useBloom ? m_bloomIntensity : 0.0f);
+            glUniform1f(glGetUniformLocation(program, "exposure"), m_exposure);
+            glUniform1i(glGetUniformLocation(program, "toneMapper"), m_toneMapper == ToneMapper::Aces ? 0 : 1);
+            glUniform1i(glGetUniformLocation(program, "encodeSrgb"), srgbTarget ? 0 : 1);
+            GLStateCache::get().bindTextureUnit(0, GL_TEXTURE_2D, graph.texture(scene));
+            GLStateCache::get().bindTextureUnit(1, GL_TEXTURE_2D, graph.texture(useBloom ? bloom : scene));
+            drawFullscreen(graph.target(output));
+        });
+        if (m_graph.compile()) m_graph.execute();
+        m_stats.bloomLevels = useBloom ? levelCount : 0;
+    }
+    m_pool.endFrame();
+}
+
+int HdrPipeline::addBloomPasses(int scene, int& levelCount) {
+    int levels[kMaxBloomLevels];
+    levelCount = 0;
+    for (int w = m_width / 2, h = m_height / 2; levelCount < kMaxBloomLevels && w >= 2 && h >= 2; w /= 2, h /= 2) {
+        levels[levelCount++] = m_graph.createTexture("bloom", FrameGraph::TextureDesc(w, h, GL_R11F_G11F_B10F));
+    }
+    if (levelCount == 0) return -1;
+
+    for (int i = 0; i < levelCount; ++i) {
+        const int source = i == 0 ? scene : levels[i - 1];
+        const int destination = levels[i];
+        m_graph.addPass("bloom downsample", [&](FrameGraph::PassBuilder& pass) {
+            pass.read(source);
+            levels[i] = pass.write(levels[i]);
+        }, [=](FrameGraph& graph) {
+            const float threshold = m_bloomThreshold / m_exposure;
+            const float knee = m_bloomKnee / m_exposure;
+            const RenderTarget& sourceTarget = graph.target(source);
+            m_downsampleShader->use();
+            const GLuint program = m_downsampleShader->ID();
+            glUniform4f(glGetUniformLocation(program, "threshold"), threshold, threshold - knee, 2.0f * knee,
+                        0.25f / knee);
+            glUniform1i(glGetUniformLocation(program, "prefilter"), i == 0 ? 1 : 0);
+            glUniform2f(glGetUniformLocation(program, "sourceTexel"), 1.0f / sourceTarget.width,
+                        1.0f / sourceTarget.height);
+            GLStateCache::get().bindTextureUnit(0, GL_TEXTURE_2D, sourceTarget.texture);
+            drawFullscreen(graph.target(destination));
+        });
+    }
+
+    // 从最小一级开始，每级上采样后叠加到上一级，最后第 0 级是完整的泛光
+    for (int i = levelCount - 2; i >= 0; --i) {
+        const int source = levels[i + 1];
+        const int destination = levels[i];
+        m_graph.addPass("bloom upsample", [&](FrameGraph::PassBuilder& pass) {
+            pass.read(source);
+            levels[i] = pass.write(levels[i]);
+        }, [=](FrameGraph& graph) {
+            GLStateCache& cache = GLStateCache::get();
+            const RenderTarget& sourceTarget = graph.target(source);
+            m_upsampleShader->use();
+            glUniform2f(glGetUniformLocation(m_upsampleShader->ID(), "sourceTexel"), 1.0f / sourceTarget.width,
+                        1.0f / sourceTarget.height);
+            cache.bindTextureUnit(0, GL_TEXTURE_2D, sourceTarget.texture);
+            cache.enable(GL_BLEND);
+            cache.blendFunc(GL_ONE, GL_ONE);
+            drawFullscreen(graph.target(destination));
+            cache.blendFunc(GL_ONE, GL_ZERO);
+            cache.disable(GL_BLEND);
+        });
+    }
+    return levels[0];
+}
+
+void HdrPipeline::addHistogramPasses(int scene) {
+    const int width = std::max(1, (m_width + 7) / 8);
+    const int height = std::max(1, (m_height + 7) / 8);
+    int luminance = m_graph.createTexture("luminance", FrameGraph::TextureDesc(width, height, GL_R16F));
+    const int histogram = m_graph.createTexture("histogram", FrameGraph::TextureDesc(kHistogramBins, 1, GL_R32F));
+
+    const int luminanceTarget = luminance;
+    m_graph.addPass("luminance", [&](FrameGraph::PassBuilder& pass) {
+        pass.read(scene);
+        luminance = pass.write(luminance);
+    }, [=](FrameGraph& graph) {
+        const RenderTarget& sceneTarget = graph.target(scene);
+        m_luminanceShader->use();
+        glUniform2f(glGetUniformLocation(m_luminanceShader->ID(), "sceneTexel"), 1.0f / sceneTarget.width,
+                    1.0f / sceneTarget.height);
+        GLStateCache::get().bindTextureUnit(0, GL_TEXTURE_2D, sceneTarget.texture);
+        drawFullscreen(graph.target(luminanceTarget));
+    });
+
+    // 直方图只通过 PBO 读回给 CPU，图里没有读者，标记为副作用避免被剔除
+    m_graph.addPass("histogram", [&](FrameGraph::PassBuilder& pass) {
+        pass.read(luminance);
+        pass.write(histogram);
+        pass.sideEffect();
+    }, [=](FrameGraph& graph) {
+        GLStateCache& cache = GLStateCache::get();
+        const RenderTarget& histogramTarget = graph.target(histogram);
+        cache.bindFramebuffer(GL_FRAMEBUFFER, histogramTarget.framebuffer);
+        glViewport(0, 0, kHistogramBins, 1);
+        const GLfloat zero[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+        glClearBufferfv(GL_COLOR, 0, zero);
+        m_histogramShader->use();
+        glUniform2f(glGetUniformLocation(m_histogramShader->ID(), "logRange"), m_minLogLuminance,
+                    1.0f / (m_maxLogLuminance - m_minLogLuminance));
+        cache.bindTextureUnit(0, GL_TEXTURE_2D, graph.texture(luminanceTarget));
+        cache.enable(GL_BLEND);
+        cache.blendFunc(GL_ONE, GL_ONE);
+        glDrawArrays(GL_POINTS, 0, width * height);
+        cache.blendFunc(GL_ONE, GL_ZERO);
+        cache.disable(GL_BLEND);
+        queueHistogramReadback();
+    });
+}
+
+void HdrPipeline::queueHistogramReadback() {
+    // 读到 PBO，几帧后 fence 就绪再映射，不等 GPU
+    Readback& readback = m_readbacks[m_nextSlot];
+    m_nextSlot = (m_nextSlot + 1) % kReadbackSlots;
+    if (readback.fence) glDeleteSync(readback.fence);
+    GLStateCache& cache = GLStateCache::get();
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, kHistogramBins * sizeof(float), nullptr, GL_STREAM_READ);
+    glReadPixels(0, 0, kHistogramBins, 1, GL_RED, GL_FLOAT, nullptr);
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void HdrPipeline::collectHistogram() {
+    // 下一个要写的槽位就是最早提交的那次读回；到现在还没完成说明 GPU 落后太多，丢弃
+    Readback& readback = m_readbacks[m_nextSlot];
+    if (!readback.fence) return;
+    const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+    glDeleteSync(readback.fence);
+    readback.fence = nullptr;
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        ++m_stats.histogramDropped;
+        return;
+    }
+    GLStateCache& cache = GLStateCache::get();
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, kHistogramBins * sizeof(float), GL_MAP_READ_BIT);
+    if (data) {
+        std::memcpy(m_histogram.data(), data, kHistogramBins * sizeof(float));
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!data) return;
+    ++m_stats.histogramReadbacks;
+    updateExposure(m_histogram.data());
+}
+
+void HdrPipeline::updateExposure(const float* histogram) {
+    // 桶 0 是全黑像素，不参与测光
+    float total = 0.0f;
+    for (int bin = 1; bin < kHistogramBins; ++bin) total += histogram[bin];
+    if (total <= 0.0f) return;
+
+    // 只统计累计数落在 [low, high] 之间的部分，取 log2 亮度的加权平均
+    const float low = total * kLowPercentile;
+    const float high = total * kHighPercentile;
+    const float binWidth = (m_maxLogLuminance - m_minLogLuminance) / (kHistogramBins - 1);
+    float cumulative = 0.0f, weightedLog = 0.0f, weight = 0.0f;
+    for (int bin = 1; bin < kHistogramBins; ++bin) {
+        const float count = histogram[bin];
+        const float taken = std::min(cumulative + count, high) - std::max(cumulative, low);
+        if (taken > 0.0f) {
+            weightedLog += taken * (m_minLogLuminance + (bin - 0.5f) * binWidth);
+            weight += taken;
+        }
+        cumulative += count;
+    }
+    if (weight <= 0.0f) return;
+
+    m_stats.averageLuminance = std::exp2(weightedLog / weight);
+    const float key = kMiddleGrey * std::exp2(m_exposureCompensation);
+    m_targetExposure = std::max(kMinExposure, std::min(key / m_stats.averageLuminance, kMaxExposure));
+    // 第一次测光直接采用，不从默认值慢慢过渡
+    if (!m_hasExposure) {
+        m_exposure = m_targetExposure;
+        m_hasExposure = true;
+    }
+}
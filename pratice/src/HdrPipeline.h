@@ -0,0 +1,138 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "FrameGraph.h"
+#include "RenderTargetPool.h"
+
+class Shader;
+
+// HDR 渲染管线
+// 场景渲染到 RGBA16F 目标，亮度不再在 1.0 截断；end() 里依次做：
+//   泛光：超过阈值的部分逐级降采样到 1/2 ... 1/64 分辨率（13 点滤波），再逐级 3x3 tent 上采样叠加回来；
+//   测光：1/8 分辨率的亮度图按 log2 亮度画成 256 个桶的直方图（点绘制 + 加法混合），
+//         PBO 异步读回，CPU 取 50%~95% 分位之间的平均亮度，曝光随时间向目标值平滑过渡；
+//   色调映射：场景 + 泛光乘以曝光后做 ACES 或 Reinhard 映射，写到输出帧缓冲。
+// 这些 pass 每帧声明到 FrameGraph 里，中间目标按生命周期从 RenderTargetPool 借用和归还，第二帧起不再分配显存；
+// 泛光强度为 0 时泛光链整条被剔除。
+// 用法（每帧）：
+//   hdr.resize(w, h);
+//   hdr.begin(clearColor);          // 之后照常绘制，帧缓冲是 hdr.sceneFramebuffer()
+//   ...
+//   hdr.end(renderer.framebuffer());
+// Renderer::setHdr 可以把这些放进 Renderer::run 里
+class HdrPipeline {
+public:
+    enum class ToneMapper { Aces, Reinhard };
+
+    static const int kMaxBloomLevels = 6;
+    static const int kHistogramBins = 256;
+
+    struct Stats {
+        float averageLuminance = 0.0f;  // 最近一次读回的直方图平均亮度
+        float exposure = 1.0f;          // 当前使用的曝光
+        int bloomLevels = 0;
+        size_t histogramReadbacks = 0;  // 累计完成的读回
+        size_t histogramDropped = 0;    // 结果太旧被丢弃的读回
+    };
+
+    HdrPipeline();
+    ~HdrPipeline();
+    HdrPipeline(const HdrPipeline&) = delete;
+    HdrPipeline& operator=(const HdrPipeline&) = delete;
+
+    // 编译着色器，需要 GL 3.3 上下文；失败时返回 false
+    bool init();
+    bool isReady() const { return m_ready; }
+    // 尺寸变化时重建场景目标，相同尺寸直接返回
+    bool resize(int width, int height);
+
+    // 绑定场景目标 (RGBA16F + DEPTH24_STENCIL8) 并用线性颜色清空
+    void begin(const glm::vec3& clearColor);
+    // 泛光、测光和色调映射，结果写到 framebuffer。srgbTarget 为 false 时着色器自己做 sRGB 编码，
+    // 否则依赖 GL_FRAMEBUFFER_SRGB
+    void end(GLuint framebuffer, bool srgbTarget = true);
+
+    GLuint sceneFramebuffer() const { return m_sceneFbo; }
+    GLuint sceneTexture() const { return m_sceneTexture; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    void setToneMapper(ToneMapper toneMapper) { m_toneMapper = toneMapper; }
+    ToneMapper toneMapper() const { return m_toneMapper; }
+    // 泛光叠加强度，0 时跳过整个泛光链
+    void setBloomIntensity(float intensity) { m_bloomIntensity = intensity; }
+    float bloomIntensity() const { return m_bloomIntensity; }
+    // 亮度超过 threshold 的部分进入泛光，knee 为阈值附近的软过渡宽度
+    void setBloomThreshold(float threshold, float knee = 0.5f);
+    // 关闭自动曝光时使用 setExposure 的固定值
+    void setAutoExposure(bool enabled) { m_autoExposure = enabled; }
+    bool autoExposure() const { return m_autoExposure; }
+    void setExposure(float exposure) { m_exposure = exposure; }
+    // 自动曝光的补偿 (EV) 和每秒向目标曝光靠近的速率
+    void setExposureCompensation(float ev) { m_exposureCompensation = ev; }
+    void setAdaptationRate(float rate) { m_adaptationRate = rate; }
+
+    // 中间目标来自这个池，其它后处理 pass 可以共用
+    RenderTargetPool& pool() { return m_pool; }
+    // 最近一帧的后处理帧图，可以查看剔除和复用情况
+    const FrameGraph& graph() const { return m_graph; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Readback {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+    };
+
+    void release();
+    // 返回泛光结果的句柄，没有可用级别时返回 -1
+    int addBloomPasses(int scene, int& levelCount);
+    void addHistogramPasses(int scene);
+    void queueHistogramReadback();
+    void collectHistogram();
+    void updateExposure(const float* histogram);
+
+    bool m_ready = false;
+    int m_width = 0;
+    int m_height = 0;
+
+    std::unique_ptr<Shader> m_downsampleShader;
+    std::unique_ptr<Shader> m_upsampleShader;
+    std::unique_ptr<Shader> m_luminanceShader;
+    std::unique_ptr<Shader> m_histogramShader;
+    std::unique_ptr<Shader> m_toneMapShader;
+
+    GLuint m_sceneFbo = 0;
+    GLuint m_sceneTexture = 0;
+    GLuint m_sceneDepth = 0;
+    GLuint m_emptyVao = 0;
+    RenderTargetPool m_pool;
+    FrameGraph m_graph;
+
+    ToneMapper m_toneMapper = ToneMapper::Aces;
+    float m_bloomIntensity = 0.05f;
+    float m_bloomThreshold = 1.0f;
+    float m_bloomKnee = 0.5f;
+
+    // 直方图覆盖的 log2 亮度范围，桶 0 留给接近全黑的像素
+    float m_minLogLuminance = -10.0f;
+    float m_maxLogLuminance = 6.0f;
+    static const int kReadbackSlots = 3;
+    Readback m_readbacks[kReadbackSlots];
+    int m_nextSlot = 0;
+    std::vector<float> m_histogram;
+
+    bool m_autoExposure = true;
+    bool m_hasExposure = false;
+    float m_exposure = 1.0f;
+    float m_targetExposure = 1.0f;
+    float m_exposureCompensation = 0.0f;
+    float m_adaptationRate = 1.5f;
+    std::chrono::steady_clock::time_point m_lastEnd;
+    Stats m_stats;
+};
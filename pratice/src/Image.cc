@@ -0,0 +1,120 @@
+#include "Image.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+size_t Image::bytesPerChannel() const {
+    switch (type) {
+        case PixelType::UInt16:  return 2;
+        case PixelType::Float32: return 4;
+        default:                 return 1;
+    }
+}
+
+void Image::flipVertically() {
+    const size_t stride = rowBytes();
+    if (stride == 0 || height < 2) return;
+    std::vector<unsigned char> tmp(stride);
+    unsigned char* top = pixels.data();
+    unsigned char* bottom = pixels.data() + stride * (height - 1);
+    while (top < bottom) {
+        std::memcpy(tmp.data(), top, stride);
+        std::memcpy(top, bottom, stride);
+        std::memcpy(bottom, tmp.data(), stride);
+        top += stride;
+        bottom -= stride;
+    }
+}
+
+ImageFormat detectImageFormat(const unsigned char* data, size_t size) {
+    if (size >= 8 && std::memcmp(data, "\x89PNG\r\n\x1a\n", 8) == 0) return ImageFormat::PNG;
+    if (size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) return ImageFormat::JPEG;
+    if (size >= 2 && data[0] == 'B' && data[1] == 'M') return ImageFormat::BMP;
+    if (size >= 6 && (std::memcmp(data, "GIF87a", 6) == 0 || std::memcmp(data, "GIF89a", 6) == 0)) return ImageFormat::GIF;
+    if (size >= 4 && std::memcmp(data, "8BPS", 4) == 0) return ImageFormat::PSD;
+    if (size >= 2 && data[0] == '#' && data[1] == '?') return ImageFormat::HDR;
+    if (size >= 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6')) return ImageFormat::PNM;
+    // TGA 没有魔数，只能根据头部字段粗略判断
+    if (size >= 18 && (data[2] == 1 || data[2] == 2 || data[2] == 3 ||
+                       data[2] == 9 || data[2] == 10 || data[2] == 11)) return ImageFormat::TGA;
+    return ImageFormat::Unknown;
+}
+
+bool decodeImage(const unsigned char* data, size_t size, Image& out,
+                 bool flip, int desiredChannels, std::string* error) {
+    out = Image();
+    const int len = static_cast<int>(size);
+    int width = 0, height = 0, fileChannels = 0;
+    void* decoded = nullptr;
+    PixelType type = PixelType::UInt8;
+
+    if (stbi_is_hdr_from_memory(data, len)) {
+        decoded = stbi_loadf_from_memory(data, len, &width, &height, &fileChannels, desiredChannels);
+        type = PixelType::Float32;
+    } else if (stbi_is_16_bit_from_memory(data, len)) {
+        decoded = stbi_load_16_from_memory(data, len, &width, &height, &fileChannels, desiredChannels);
+        type = PixelType::UInt16;
+    } else {
+        decoded = stbi_load_from_memory(data, len, &width, &height, &fileChannels, desiredChannels);
+    }
+    if (!decoded) {
+        if (error) *error = stbi_failure_reason() ? stbi_failure_reason() : "unknown error";
+        return false;
+    }
+
+    out.width = width;
+    out.height = height;
+    out.channels = desiredChannels ? desiredChannels : fileChannels;
+    out.type = type;
+    out.format = detectImageFormat(data, size);
+    const unsigned char* bytes = static_cast<const unsigned char*>(decoded);
+    out.pixels.assign(bytes, bytes + out.rowBytes() * height);
+    stbi_image_free(decoded);
+
+    if (flip) out.flipVertically();
+    return true;
+}
+
+bool readFileBytes(const std::string& path, std::vector<unsigned char>& bytes) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    std::streamsize size = file.tellg();
+    if (size < 0) return false;
+    bytes.resize(static_cast<size_t>(size));
+    file.seekg(0, std::ios::beg);
+    return size == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(bytes.data()), size));
+}
+
+bool loadImage(const std::string& path, Image& out, bool flip, int desiredChannels, std::string* error) {
+    std::vector<unsigned char> bytes;
+    if (!readFileBytes(path, bytes)) {
+        if (error) *error = "cannot open file";
+        out = Image();
+        return false;
+    }
+    return decodeImage(bytes.data(), bytes.size(), out, flip, desiredChannels, error);
+}
+
+std::vector<Image> loadImagesParallel(const std::vector<std::string>& paths,
+                                      bool flip, int desiredChannels, unsigned threadCount) {
+    std::vector<Image> images(paths.size());
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(paths.size()));
+
+    // 每个线程领取下一个未处理的下标，结果写入各自的槽位，无需加锁
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < paths.size(); i = next++) {
+            loadImage(paths[i], images[i], flip, desiredChannels);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+    return images;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// CPU 端图像解码层
+// stb_image 的 stbi_set_flip_vertically_on_load 是进程级全局状态，多线程解码时会互相干扰。
+// 这里从不修改该全局状态，翻转改为解码后逐行交换，因此可以在任意线程并发调用。
+
+enum class PixelType {
+    UInt8,
+    UInt16,
+    Float32   // HDR (.hdr) 图像
+};
+
+enum class ImageFormat {
+    Unknown,
+    PNG,
+    JPEG,
+    BMP,
+    TGA,
+    GIF,
+    PSD,
+    HDR,
+    PNM
+};
+
+struct Image {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    PixelType type = PixelType::UInt8;
+    ImageFormat format = ImageFormat::Unknown;
+    std::vector<unsigned char> pixels;
+
+    bool empty() const { return pixels.empty(); }
+    size_t bytesPerChannel() const;
+    size_t bytesPerPixel() const { return bytesPerChannel() * channels; }
+    size_t rowBytes() const { return bytesPerPixel() * width; }
+    // 逐行交换实现的垂直翻转，不依赖 stb 的全局状态
+    void flipVertically();
+};
+
+// 根据文件头魔数判断容器格式
+ImageFormat detectImageFormat(const unsigned char* data, size_t size);
+
+// 从内存解码，desiredChannels 为 0 表示保留原始通道数
+// 16 位 PNG/PNM 解码为 UInt16，.hdr 解码为 Float32，其余为 UInt8
+bool decodeImage(const unsigned char* data, size_t size, Image& out,
+                 bool flip = true, int desiredChannels = 0, std::string* error = nullptr);
+bool loadImage(const std::string& path, Image& out,
+               bool flip = true, int desiredChannels = 0, std::string* error = nullptr);
+bool readFileBytes(const std::string& path, std::vector<unsigned char>& bytes);
+
+// 在多个工作线程上并行解码，返回结果与 paths 一一对应（失败的项为空图像）
+// threadCount 为 0 时使用 std::thread::hardware_concurrency()
+std::vector<Image> loadImagesParallel(const std::vector<std::string>& paths,
+                                      bool flip = true, int desiredChannels = 0,
+                                      unsigned threadCount = 0);
@@ -0,0 +1,236 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace {
+// 当前线程所属的 JobSystem 及其队列下标，主线程和外部线程不设置
+thread_local const JobSystem* t_owner = nullptr;
+thread_local unsigned t_index = 0;
+} // namespace
+
+JobSystem& JobSystem::get() {
+    static JobSystem system(std::max(1u, std::thread::hardware_concurrency()) - 1);
+    return system;
+}
+
+JobSystem::JobSystem(unsigned workerCount)
+    : m_mainThread(std::this_thread::get_id()), m_queued(0), m_sleeping(0), m_nextQueue(0),
+      m_executed(0), m_stolen(0), m_mainExecuted(0) {
+    for (unsigned i = 0; i <= workerCount; ++i) m_queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    for (unsigned i = 1; i <= workerCount; ++i) {
+        m_workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) worker.join();
+}
+
+unsigned JobSystem::currentIndex() const {
+    if (t_owner == this) return t_index;
+    if (isMainThread()) return 0;
+    // 外部线程没有自己的队列
+    return static_cast<unsigned>(m_queues.size());
+}
+
+void JobSystem::run(Job job, JobCounter* counter, JobCounter* dependency) {
+    submit(std::move(job), counter, dependency, false);
+}
+
+void JobSystem::runOnMainThread(Job job, JobCounter* counter, JobCounter* dependency) {
+    submit(std::move(job), counter, dependency, true);
+}
+
+void JobSystem::submit(Job job, JobCounter* counter, JobCounter* dependency, bool mainThread) {
+    if (counter) counter->m_value.fetch_add(1, std::memory_order_relaxed);
+    if (dependency) {
+        // 与 finish() 在同一把锁下检查，依赖恰好归零时不会漏掉
+        std::lock_guard<std::mutex> lock(dependency->m_mutex);
+        if (dependency->m_value.load(std::memory_order_acquire) > 0) {
+            JobCounter::Waiting waiting;
+            waiting.job = std::move(job);
+            waiting.counter = counter;
+            waiting.mainThread = mainThread;
+            dependency->m_waiting.push_back(std::move(waiting));
+            return;
+        }
+    }
+    Task task;
+    task.job = std::move(job);
+    task.counter = counter;
+    enqueue(std::move(task), mainThread);
+}
+
+void JobSystem::enqueue(Task task, bool mainThread) {
+    if (mainThread) {
+        std::lock_guard<std::mutex> lock(m_mainQueue.mutex);
+        m_mainQueue.tasks.push_back(std::move(task));
+        return;
+    }
+    unsigned index = currentIndex();
+    if (index >= m_queues.size()) index = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+    {
+        Queue& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    // 与 workerLoop 中 m_sleeping 和 m_queued 的先后顺序配合，两边至少有一边能看到对方，不会丢失唤醒
+    m_queued.fetch_add(1);
+    if (m_sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wake.notify_one();
+    }
+}
+
+bool JobSystem::popLocal(unsigned self, Task& task) {
+    if (self >= m_queues.size()) return false;
+    Queue& queue = *m_queues[self];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    m_queued.fetch_sub(1);
+    return true;
+}
+
+bool JobSystem::steal(unsigned self, Task& task) {
+    const unsigned count = static_cast<unsigned>(m_queues.size());
+    for (unsigned i = 1; i <= count; ++i) {
+        const unsigned victim = (self + i) % count;
+        if (victim == self) continue;
+        Queue& queue = *m_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        m_queued.fetch_sub(1);
+        m_stolen.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+bool JobSystem::popMainThread(Task& task) {
+    std::lock_guard<std::mutex> lock(m_mainQueue.mutex);
+    if (m_mainQueue.tasks.empty()) return false;
+    task = std::move(m_mainQueue.tasks.front());
+    m_mainQueue.tasks.pop_front();
+    return true;
+}
+
+bool JobSystem::tryRunOne(unsigned self, bool allowMainThread) {
+    Task task;
+    if (allowMainThread && popMainThread(task)) {
+        m_mainExecuted.fetch_add(1, std::memory_order_relaxed);
+        execute(task);
+        return true;
+    }
+    if (popLocal(self, task) || steal(self, task)) {
+        execute(task);
+        return true;
+    }
+    return false;
+}
+
+void JobSystem::execute(Task& task) {
+    task.job();
+    // 尽早释放捕获的资源，计数器归零后等待方可能立即销毁它们
+    task.job = nullptr;
+    m_executed.fetch_add(1, std::memory_order_relaxed);
+    finish(task.counter);
+}
+
+void JobSystem::finish(JobCounter* counter) {
+    if (!counter) return;
+    std::vector<JobCounter::Waiting> ready;
+    {
+        // 在锁内归零：wait() 返回前会再取一次这把锁，保证这里不再访问计数器后它才能被销毁
+        std::lock_guard<std::mutex> lock(counter->m_mutex);
+        if (counter->m_value.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        ready.swap(counter->m_waiting);
+    }
+    for (JobCounter::Waiting& waiting : ready) {
+        Task task;
+        task.job = std::move(waiting.job);
+        task.counter = waiting.counter;
+        enqueue(std::move(task), waiting.mainThread);
+    }
+}
+
+void JobSystem::parallelFor(size_t count, RangeJob body, JobCounter& counter, size_t grain,
+                            JobCounter* dependency) {
+    if (count == 0) return;
+    if (grain == 0) grain = std::max<size_t>(1, count / (threadCount() * 4));
+    std::shared_ptr<RangeJob> shared = std::make_shared<RangeJob>(std::move(body));
+    for (size_t begin = 0; begin < count; begin += grain) {
+        const size_t end = std::min(count, begin + grain);
+        run([shared, begin, end]() { (*shared)(begin, end); }, &counter, dependency);
+    }
+}
+
+void JobSystem::parallelFor(size_t count, const RangeJob& body, size_t grain) {
+    if (count == 0) return;
+    if (grain == 0) grain = std::max<size_t>(1, count / (threadCount() * 4));
+    if (count <= grain || m_workers.empty()) {
+        body(0, count);
+        return;
+    }
+    // 调用方会等到全部完成，按引用捕获即可
+    JobCounter counter;
+    for (size_t begin = 0; begin < count; begin += grain) {
+        const size_t end = std::min(count, begin + grain);
+        run([&body, begin, end]() { body(begin, end); }, &counter);
+    }
+    wait(counter);
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    const unsigned self = currentIndex();
+    const bool mainThread = isMainThread();
+    while (!counter.done()) {
+        if (!tryRunOne(self, mainThread)) std::this_thread::yield();
+    }
+    std::lock_guard<std::mutex> lock(counter.m_mutex);
+}
+
+size_t JobSystem::pumpMainThread() {
+    size_t executed = 0;
+    Task task;
+    while (popMainThread(task)) {
+        m_mainExecuted.fetch_add(1, std::memory_order_relaxed);
+        execute(task);
+        ++executed;
+    }
+    return executed;
+}
+
+void JobSystem::workerLoop(unsigned index) {
+    t_owner = this;
+    t_index = index;
+    for (;;) {
+        if (tryRunOne(index, false)) continue;
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleeping.fetch_add(1);
+        m_wake.wait(lock, [this]() { return m_stop || m_queued.load() > 0; });
+        m_sleeping.fetch_sub(1);
+        if (m_stop) return;
+    }
+}
+
+JobSystem::Stats JobSystem::stats() const {
+    Stats s;
+    s.executed = m_executed.load(std::memory_order_relaxed);
+    s.stolen = m_stolen.load(std::memory_order_relaxed);
+    s.mainThread = m_mainExecuted.load(std::memory_order_relaxed);
+    return s;
+}
+
+void JobSystem::resetStats() {
+    m_executed.store(0);
+    m_stolen.store(0);
+    m_mainExecuted.store(0);
+}
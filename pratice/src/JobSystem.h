@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 任务计数器：每提交一个关联的任务加一，任务完成减一，归零表示这批任务全部完成。
+// 也可以作为其他任务的依赖：依赖它的任务在它归零后才进入队列。
+// 计数器销毁前必须经过 JobSystem::wait()，done() 只用于轮询
+class JobCounter {
+public:
+    JobCounter() : m_value(0) {}
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool done() const { return m_value.load(std::memory_order_acquire) == 0; }
+    int value() const { return m_value.load(std::memory_order_acquire); }
+
+private:
+    friend class JobSystem;
+    struct Waiting {
+        std::function<void()> job;
+        JobCounter* counter;
+        bool mainThread;
+    };
+    std::atomic<int> m_value;
+    std::mutex m_mutex;
+    // 等待本计数器归零的任务
+    std::vector<Waiting> m_waiting;
+};
+
+// 工作窃取任务系统
+// 每个线程一个双端队列：自己从尾部取（后进先出，缓存更热），空闲线程从别人的头部偷（先进先出，偷到的通常是大块工作）。
+// 创建 JobSystem 的线程视为主线程，wait() 时也参与执行任务；
+// runOnMainThread 提交的任务只在主线程的 wait()/pumpMainThread() 里执行，用于只能在 GL 线程调用的工作。
+// 任务不能抛出异常
+class JobSystem {
+public:
+    using Job = std::function<void()>;
+    // 处理 [begin, end) 区间
+    using RangeJob = std::function<void(size_t begin, size_t end)>;
+
+    struct Stats {
+        size_t executed = 0;   // 执行的任务数
+        size_t stolen = 0;     // 其中从其他线程偷来的
+        size_t mainThread = 0; // 主线程专属任务
+    };
+
+    // 全局实例，工作线程数为硬件线程数减一（主线程也参与执行）
+    static JobSystem& get();
+
+    // workerCount 为 0 时不创建工作线程，所有任务都在主线程的 wait() 中执行
+    explicit JobSystem(unsigned workerCount);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // 提交任务。counter 非空时计入该计数器；dependency 非空时等它归零后任务才开始执行
+    void run(Job job, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+    // 只在主线程执行的任务
+    void runOnMainThread(Job job, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+    // 把 [0, count) 切成不超过 grain 的区间并行处理，grain 为 0 时按线程数自动选择。
+    // 异步版本完成后 counter 归零，body 会被复制保存
+    void parallelFor(size_t count, RangeJob body, JobCounter& counter, size_t grain = 0,
+                     JobCounter* dependency = nullptr);
+    // 阻塞版本，调用线程参与执行
+    void parallelFor(size_t count, const RangeJob& body, size_t grain = 0);
+
+    // 等待计数器归零，期间执行队列中的任务（主线程还会执行主线程专属任务）
+    void wait(JobCounter& counter);
+    // 主线程每帧调用，执行已经就绪的主线程专属任务，返回执行的个数
+    size_t pumpMainThread();
+
+    // 包括主线程在内的线程数
+    unsigned threadCount() const { return static_cast<unsigned>(m_queues.size()); }
+    bool isMainThread() const { return std::this_thread::get_id() == m_mainThread; }
+    Stats stats() const;
+    void resetStats();
+
+private:
+    struct Task {
+        Job job;
+        JobCounter* counter = nullptr;
+    };
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void submit(Job job, JobCounter* counter, JobCounter* dependency, bool mainThread);
+    void enqueue(Task task, bool mainThread);
+    bool tryRunOne(unsigned self, bool allowMainThread);
+    bool popLocal(unsigned self, Task& task);
+    bool steal(unsigned self, Task& task);
+    bool popMainThread(Task& task);
+    void execute(Task& task);
+    void finish(JobCounter* counter);
+    void workerLoop(unsigned index);
+    unsigned currentIndex() const;
+
+    std::thread::id m_mainThread;
+    // 下标 0 是主线程，1..N 是工作线程
+    std::vector<std::unique_ptr<Queue> > m_queues;
+    std::vector<std::thread> m_workers;
+    Queue m_mainQueue;
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_queued;    // 可被工作线程取走的任务数
+    std::atomic<int> m_sleeping;
+    std::atomic<unsigned> m_nextQueue;
+    bool m_stop = false;
+
+    std::atomic<size_t> m_executed;
+    std::atomic<size_t> m_stolen;
+    std::atomic<size_t> m_mainExecuted;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// 光源描述，DeferredRenderer、ClusteredLights 和 ShadowMaps 共用
+
+// 点光源：radius 处光照衰减到 0，超出半径的像素不参与计算
+struct PointLight {
+    glm::vec3 position = glm::vec3(0.0f);
+    float radius = 5.0f;
+    glm::vec3 color = glm::vec3(1.0f);  // 线性空间
+    float intensity = 1.0f;
+};
+
+// 聚光：衰减同点光源，再乘以内外锥角之间的平滑过渡
+struct SpotLight {
+    glm::vec3 position = glm::vec3(0.0f);
+    float radius = 10.0f;
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    float innerCos = 0.976f;  // cos(12.5°)
+    glm::vec3 color = glm::vec3(1.0f);
+    float outerCos = 0.954f;  // cos(17.5°)
+    float intensity = 1.0f;
+};
+
+struct DirectionalLight {
+    glm::vec3 direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    glm::vec3 color = glm::vec3(0.4f);
+    glm::vec3 ambient = glm::vec3(0.05f);
+};
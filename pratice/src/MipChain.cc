@@ -0,0 +1,242 @@
+#include "MipChain.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+struct SRGBTables {
+    float toLinear[256];
+    SRGBTables() {
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+    }
+};
+const SRGBTables& srgbTables() {
+    static SRGBTables tables;
+    return tables;
+}
+
+float linearToSRGB(float c) {
+    c = std::min(1.0f, std::max(0.0f, c));
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// alpha 通道 (4 通道图像的最后一个，或 2 通道的第二个) 不做伽马转换
+bool isAlphaChannel(int channel, int channels) {
+    return (channels == 4 && channel == 3) || (channels == 2 && channel == 1);
+}
+
+std::vector<float> toLinearFloat(const Image& src, bool srgb) {
+    const size_t count = size_t(src.width) * src.height * src.channels;
+    std::vector<float> out(count);
+    const float* lut = srgbTables().toLinear;
+    for (size_t i = 0; i < count; ++i) {
+        const int channel = static_cast<int>(i % src.channels);
+        switch (src.type) {
+            case PixelType::UInt8: {
+                unsigned char v = src.pixels[i];
+                out[i] = (srgb && !isAlphaChannel(channel, src.channels)) ? lut[v] : v / 255.0f;
+                break;
+            }
+            case PixelType::UInt16: {
+                uint16_t v;
+                std::memcpy(&v, &src.pixels[i * 2], 2);
+                out[i] = v / 65535.0f;
+                break;
+            }
+            case PixelType::Float32:
+                std::memcpy(&out[i], &src.pixels[i * 4], 4);
+                break;
+        }
+    }
+    return out;
+}
+
+void fromLinearFloat(const std::vector<float>& in, Image& dst, bool srgb) {
+    const size_t count = in.size();
+    dst.pixels.resize(count * dst.bytesPerChannel());
+    for (size_t i = 0; i < count; ++i) {
+        const int channel = static_cast<int>(i % dst.channels);
+        float v = in[i];
+        switch (dst.type) {
+            case PixelType::UInt8: {
+                if (srgb && !isAlphaChannel(channel, dst.channels)) v = linearToSRGB(v);
+                v = std::min(1.0f, std::max(0.0f, v));
+                dst.pixels[i] = static_cast<unsigned char>(v * 255.0f + 0.5f);
+                break;
+            }
+            case PixelType::UInt16: {
+                v = std::min(1.0f, std::max(0.0f, v));
+                uint16_t q = static_cast<uint16_t>(v * 65535.0f + 0.5f);
+                std::memcpy(&dst.pixels[i * 2], &q, 2);
+                break;
+            }
+            case PixelType::Float32:
+                v = std::max(0.0f, v);
+                std::memcpy(&dst.pixels[i * 4], &v, 4);
+                break;
+        }
+    }
+}
+
+double besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+// 参数与 NVTT 默认值一致：宽度 3，alpha 4
+float kaiserWeight(float t) {
+    const float width = 3.0f, alpha = 4.0f;
+    if (std::fabs(t) >= width) return 0.0f;
+    const float pi = 3.14159265358979f;
+    float sinc = t == 0.0f ? 1.0f : std::sin(pi * t) / (pi * t);
+    float r = t / width;
+    float window = float(besselI0(alpha * std::sqrt(1.0 - r * r)) / besselI0(alpha));
+    return sinc * window;
+}
+
+// 一维重采样权重表：每个目标像素对应一段源像素区间
+struct Kernel {
+    std::vector<int> first;     // 每个目标像素的第一个源像素（可能越界，使用时夹取）
+    std::vector<int> taps;
+    std::vector<float> weights; // dst * taps
+};
+
+Kernel buildKernel(int srcSize, int dstSize, MipFilter filter) {
+    Kernel k;
+    const float scale = float(srcSize) / float(dstSize);
+    const float support = filter == MipFilter::Box ? 0.5f * scale : 3.0f * scale;
+    const int taps = static_cast<int>(std::ceil(support * 2.0f)) + 1;
+    k.first.resize(dstSize);
+    k.taps.assign(dstSize, taps);
+    k.weights.assign(size_t(dstSize) * taps, 0.0f);
+    for (int d = 0; d < dstSize; ++d) {
+        const float center = (d + 0.5f) * scale;   // 源像素坐标 (像素中心在 i + 0.5)
+        const int first = static_cast<int>(std::floor(center - support));
+        k.first[d] = first;
+        float sum = 0.0f;
+        for (int t = 0; t < taps; ++t) {
+            const float x = (first + t + 0.5f - center) / scale;
+            float w;
+            if (filter == MipFilter::Box) {
+                // 按覆盖面积计算，奇数尺寸时边缘像素只贡献一部分
+                const float lo = std::max(float(first + t), center - support);
+                const float hi = std::min(float(first + t + 1), center + support);
+                w = std::max(0.0f, hi - lo);
+            } else {
+                w = kaiserWeight(x);
+            }
+            k.weights[size_t(d) * taps + t] = w;
+            sum += w;
+        }
+        if (sum != 0.0f) {
+            for (int t = 0; t < taps; ++t) k.weights[size_t(d) * taps + t] /= sum;
+        }
+    }
+    return k;
+}
+
+template <typename Fn>
+void parallelRows(int rows, unsigned threadCount, Fn fn) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(std::max(1, rows / 16)));
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int y = next++; y < rows; y = next++) fn(y);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+}
+
+Image downsample(const Image& src, MipFilter filter, bool srgb, unsigned threadCount) {
+    Image dst;
+    dst.width = std::max(1, src.width / 2);
+    dst.height = std::max(1, src.height / 2);
+    dst.channels = src.channels;
+    dst.type = src.type;
+    dst.format = src.format;
+    if (src.empty() || src.channels < 1) return dst;
+
+    const int c = src.channels;
+    std::vector<float> in = toLinearFloat(src, srgb);
+    const Kernel kx = buildKernel(src.width, dst.width, filter);
+    const Kernel ky = buildKernel(src.height, dst.height, filter);
+
+    // 先水平后垂直，可分离滤波
+    std::vector<float> tmp(size_t(dst.width) * src.height * c);
+    parallelRows(src.height, threadCount, [&](int y) {
+        const float* row = &in[size_t(y) * src.width * c];
+        float* out = &tmp[size_t(y) * dst.width * c];
+        for (int x = 0; x < dst.width; ++x) {
+            const int taps = kx.taps[x];
+            const float* w = &kx.weights[size_t(x) * taps];
+            for (int ch = 0; ch < c; ++ch) {
+                float acc = 0.0f;
+                for (int t = 0; t < taps; ++t) {
+                    int sx = std::min(src.width - 1, std::max(0, kx.first[x] + t));
+                    acc += w[t] * row[size_t(sx) * c + ch];
+                }
+                out[size_t(x) * c + ch] = acc;
+            }
+        }
+    });
+
+    std::vector<float> result(size_t(dst.width) * dst.height * c);
+    parallelRows(dst.height, threadCount, [&](int y) {
+        const int taps = ky.taps[y];
+        const float* w = &ky.weights[size_t(y) * taps];
+        float* out = &result[size_t(y) * dst.width * c];
+        std::fill(out, out + size_t(dst.width) * c, 0.0f);
+        for (int t = 0; t < taps; ++t) {
+            int sy = std::min(src.height - 1, std::max(0, ky.first[y] + t));
+            const float* row = &tmp[size_t(sy) * dst.width * c];
+            for (int i = 0; i < dst.width * c; ++i) out[i] += w[t] * row[i];
+        }
+    });
+
+    fromLinearFloat(result, dst, srgb && src.type == PixelType::UInt8);
+    return dst;
+}
+
+} // namespace
+
+int mipLevelCount(int width, int height) {
+    int levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        ++levels;
+    }
+    return levels;
+}
+
+Image downsampleImage(const Image& src, MipFilter filter, bool srgb) {
+    return downsample(src, filter, srgb, 1);
+}
+
+std::vector<Image> buildMipChain(const Image& base, MipFilter filter, bool srgb,
+                                 int maxLevels, unsigned threadCount) {
+    std::vector<Image> chain;
+    if (base.empty()) return chain;
+    int levels = mipLevelCount(base.width, base.height);
+    if (maxLevels > 0) levels = std::min(levels, maxLevels);
+    chain.reserve(levels);
+    chain.push_back(base);
+    // 每级都从上一级生成，Kaiser 滤波的支撑域在上一级上已经足够
+    for (int i = 1; i < levels; ++i) {
+        chain.push_back(downsample(chain.back(), filter, srgb, threadCount));
+    }
+    return chain;
+}
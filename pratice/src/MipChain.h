@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+#include "Image.h"
+
+// CPU 端 mip 链生成
+// sRGB 颜色先转换到线性空间再滤波，避免暗部在缩小时整体变暗；alpha 通道始终按线性处理。
+
+enum class MipFilter {
+    Box,     // 2x2 平均，最快
+    Kaiser   // Kaiser 窗 sinc，更锐利，离线烘焙推荐
+};
+
+// 生成 base 的下一级 mip（宽高各减半，最小为 1）
+Image downsampleImage(const Image& src, MipFilter filter = MipFilter::Box, bool srgb = true);
+
+// 返回包括 base 在内的整条 mip 链，maxLevels 为 0 时一直生成到 1x1
+// threadCount 为 0 时使用所有硬件线程，结果与线程数无关
+std::vector<Image> buildMipChain(const Image& base, MipFilter filter = MipFilter::Box,
+                                 bool srgb = true, int maxLevels = 0, unsigned threadCount = 0);
+
+int mipLevelCount(int width, int height);
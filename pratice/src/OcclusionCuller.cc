@@ -0,0 +1,488 @@
+#include "OcclusionCuller.h"
+#include "FullscreenPass.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#include "Shader.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+
+const char* kCopyFS =
+    "#version 330 core\n"
+    "uniform sampler2D depthTexture;\n"
+    "out float hiz;\n"
+    "void main() {\n"
+    "    hiz = texelFetch(depthTexture, ivec2(gl_FragCoord.xy), 0).r;\n"
+    "}\n";
+
+// 上一级的 2x2 取最大值；上一级尺寸为奇数时最后一列/行要多覆盖一个纹素，金字塔才是保守的。
+// 读取的级别通过 BASE_LEVEL 限定，texelFetch 的 lod 0 即上一级
+const char* kReduceFS =
+    "#version 330 core\n"
+    "uniform sampler2D pyramid;\n"
+    "uniform ivec2 sourceSize;\n"
+    "out float hiz;\n"
+    "float fetchDepth(ivec2 p) {\n"
+    "    return texelFetch(pyramid, min(p, sourceSize - 1), 0).r;\n"
+    "}\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy) * 2;\n"
+    "    float d = max(max(fetchDepth(p), fetchDepth(p + ivec2(1, 0))),\n"
+    "                  max(fetchDepth(p + ivec2(0, 1)), fetchDepth(p + ivec2(1, 1))));\n"
+    "    bool extraX = (sourceSize.x & 1) != 0 && p.x + 3 == sourceSize.x;\n"
+    "    bool extraY = (sourceSize.y & 1) != 0 && p.y + 3 == sourceSize.y;\n"
+    "    if (extraX) d = max(d, max(fetchDepth(p + ivec2(2, 0)), fetchDepth(p + ivec2(2, 1))));\n"
+    "    if (extraY) d = max(d, max(fetchDepth(p + ivec2(0, 2)), fetchDepth(p + ivec2(1, 2))));\n"
+    "    if (extraX && extraY) d = max(d, fetchDepth(p + ivec2(2, 2)));\n"
+    "    hiz = d;\n"
+    "}\n";
+
+// 每个片段测试一个物体，物体序号 = y * RESULT_WIDTH + x。
+// 有角点在相机后面或跨过近平面时投影不可靠，保守地判为可见；
+// 级别选择让屏幕矩形最多跨 2x2 个纹素
+const char* kTestFS =
+    "uniform samplerBuffer bounds;\n"
+    "uniform sampler2D pyramid;\n"
+    "uniform mat4 viewProjection;\n"
+    "uniform int objectCount;\n"
+    "uniform int levelCount;\n"
+    "uniform vec2 screenSize;\n"
+    "out float visible;\n"
+    "float fetchDepth(ivec2 p, int level) {\n"
+    "    ivec2 size = textureSize(pyramid, level);\n"
+    "    return texelFetch(pyramid, clamp(p, ivec2(0), size - 1), level).r;\n"
+    "}\n"
+    "void main() {\n"
+    "    int index = int(gl_FragCoord.y) * RESULT_WIDTH + int(gl_FragCoord.x);\n"
+    "    if (index >= objectCount) {\n"
+    "        visible = 1.0;\n"
+    "        return;\n"
+    "    }\n"
+    "    vec3 center = texelFetch(bounds, index * 2).xyz;\n"
+    "    vec3 extent = texelFetch(bounds, index * 2 + 1).xyz;\n"
+    "    vec3 minNdc = vec3(1e30);\n"
+    "    vec3 maxNdc = vec3(-1e30);\n"
+    "    for (int i = 0; i < 8; ++i) {\n"
+    "        vec3 corner = center + extent * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0,\n"
+    "                                             (i & 4) != 0 ? 1.0 : -1.0);\n"
+    "        vec4 clip = viewProjection * vec4(corner, 1.0);\n"
+    "        if (clip.w <= 0.0) {\n"
+    "            visible = 1.0;\n"
+    "            return;\n"
+    "        }\n"
+    "        vec3 ndc = clip.xyz / clip.w;\n"
+    "        minNdc = min(minNdc, ndc);\n"
+    "        maxNdc = max(maxNdc, ndc);\n"
+    "    }\n"
+    "    if (minNdc.z < -1.0) {\n"
+    "        visible = 1.0;\n"
+    "        return;\n"
+    "    }\n"
+    "    vec2 minPixel = clamp(minNdc.xy * 0.5 + 0.5, 0.0, 1.0) * screenSize;\n"
+    "    vec2 maxPixel = clamp(maxNdc.xy * 0.5 + 0.5, 0.0, 1.0) * screenSize;\n"
+    "    vec2 size = maxPixel - minPixel;\n"
+    "    int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, levelCount - 1);\n"
+    "    ivec2 lo = ivec2(minPixel) >> level;\n"
+    "    ivec2 hi = ivec2(maxPixel) >> level;\n"
+    "    float farthest = max(max(fetchDepth(lo, level), fetchDepth(ivec2(hi.x, lo.y), level)),\n"
+    "                         max(fetchDepth(ivec2(lo.x, hi.y), level), fetchDepth(hi, level)));\n"
+    "    float nearest = minNdc.z * 0.5 + 0.5;\n"
+    "    visible = nearest <= farthest ? 1.0 : 0.0;\n"
+    "}\n";
+
+const char* kBoxVS =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "uniform mat4 viewProjection;\n"
+    "uniform vec3 center;\n"
+    "uniform vec3 extent;\n"
+    "void main() {\n"
+    "    gl_Position = viewProjection * vec4(center + aPos * extent, 1.0);\n"
+    "}\n";
+
+const char* kBoxFS =
+    "#version 330 core\n"
+    "out vec4 FragColor;\n"
+    "void main() {\n"
+    "    FragColor = vec4(1.0);\n"
+    "}\n";
+
+} // namespace
+
+HiZCuller::HiZCuller() : m_viewProjection(1.0f) {}
+
+HiZCuller::~HiZCuller() {
+    release();
+    for (Readback& readback : m_readbacks) {
+        if (readback.fence) glDeleteSync(readback.fence);
+        GLStateCache::get().deleteBuffer(readback.buffer);
+    }
+    GLStateCache::get().deleteBuffer(m_boundsBuffer);
+    GLStateCache::get().deleteTexture(m_boundsTexture);
+    GLStateCache::get().deleteTexture(m_resultTexture);
+    GLStateCache::get().deleteFramebuffer(m_resultFbo);
+    GLStateCache::get().deleteVertexArray(m_emptyVao);
+}
+
+bool HiZCuller::init() {
+    if (m_ready) return true;
+    if (!GLCaps::get().versionAtLeast(3, 3)) {
+        std::cerr << "HiZCuller: requires OpenGL 3.3" << std::endl;
+        return false;
+    }
+    const std::string testSource = std::string("#version 330 core\n#define RESULT_WIDTH ") +
+                                   std::to_string(kResultWidth) + "\n" + kTestFS;
+    m_copyShader.reset(new Shader(kFullscreenVS, kCopyFS, true));
+    m_reduceShader.reset(new Shader(kFullscreenVS, kReduceFS, true));
+    m_testShader.reset(new Shader(kFullscreenVS, testSource, true));
+    if (!m_copyShader->isValid() || !m_reduceShader->isValid() || !m_testShader->isValid()) {
+        std::cerr << "HiZCuller: shader compilation failed" << std::endl;
+        m_copyShader.reset();
+        m_reduceShader.reset();
+        m_testShader.reset();
+        return false;
+    }
+    m_copyShader->use();
+    m_copyShader->setInt("depthTexture", 0);
+    m_reduceShader->use();
+    m_reduceShader->setInt("pyramid", 0);
+    m_testShader->use();
+    m_testShader->setInt("pyramid", 0);
+    m_testShader->setInt("bounds", 1);
+
+    glGenVertexArrays(1, &m_emptyVao);
+    glGenBuffers(1, &m_boundsBuffer);
+    glGenTextures(1, &m_boundsTexture);
+    GLStateCache::get().bindBuffer(GL_TEXTURE_BUFFER, m_boundsBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+    GLStateCache::get().bindTexture(GL_TEXTURE_BUFFER, m_boundsTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_boundsBuffer);
+    glGenFramebuffers(1, &m_resultFbo);
+    for (Readback& readback : m_readbacks) glGenBuffers(1, &readback.buffer);
+    m_ready = true;
+    return true;
+}
+
+void HiZCuller::release() {
+    GLStateCache::get().deleteTexture(m_depthTexture);
+    GLStateCache::get().deleteFramebuffer(m_depthFbo);
+    GLStateCache::get().deleteTexture(m_pyramid);
+    GLStateCache::get().deleteFramebuffer(m_pyramidFbo);
+    m_depthTexture = m_depthFbo = m_pyramid = m_pyramidFbo = 0;
+    m_width = m_height = m_levels = 0;
+    m_hasPyramid = false;
+}
+
+bool HiZCuller::resize(int width, int height) {
+    if (width == m_width && height == m_height && m_pyramid) return true;
+    release();
+    GLStateCache& cache = GLStateCache::get();
+
+    glGenTextures(1, &m_depthTexture);
+    cache.bindTexture(GL_TEXTURE_2D, m_depthTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0, GL_DEPTH_STENCIL,
+                 GL_UNSIGNED_INT_24_8, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glGenFramebuffers(1, &m_depthFbo);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_depthFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthTexture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    const bool depthComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    // 完整的 mip 链，各级尺寸按 GL 规则向下取整
+    m_levels = 1;
+    while ((width >> m_levels) > 0 || (height >> m_levels) > 0) ++m_levels;
+    glGenTextures(1, &m_pyramid);
+    cache.bindTexture(GL_TEXTURE_2D, m_pyramid);
+    for (int level = 0; level < m_levels; ++level) {
+        glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, std::max(1, width >> level), std::max(1, height >> level), 0,
+                     GL_RED, GL_FLOAT, nullptr);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glGenFramebuffers(1, &m_pyramidFbo);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_pyramidFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pyramid, 0);
+    const bool pyramidComplete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (!depthComplete || !pyramidComplete) {
+        std::cerr << "HiZCuller: incomplete framebuffer for " << width << "x" << height << std::endl;
+        release();
+        return false;
+    }
+    m_width = width;
+    m_height = height;
+    m_stats.levels = m_levels;
+    return true;
+}
+
+void HiZCuller::build(GLuint framebuffer, int width, int height, const glm::mat4& viewProjection) {
+    if (!m_ready || width <= 0 || height <= 0) return;
+    if (!resize(width, height)) {
+        GLStateCache::get().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        return;
+    }
+    GLStateCache& cache = GLStateCache::get();
+    PassStateScope scope;
+
+    cache.bindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    cache.bindFramebuffer(GL_DRAW_FRAMEBUFFER, m_depthFbo);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+
+    cache.bindVertexArray(m_emptyVao);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_pyramidFbo);
+    cache.bindSampler(0, 0);
+
+    // level 0：深度原样拷贝成 R32F
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pyramid, 0);
+    glViewport(0, 0, width, height);
+    m_copyShader->use();
+    cache.bindTextureUnit(0, GL_TEXTURE_2D, m_depthTexture);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // 逐级缩小。读写同一纹理的不同级别，用 BASE/MAX_LEVEL 把读取范围限定在上一级，避免反馈环
+    m_reduceShader->use();
+    const GLint sourceSizeLocation = glGetUniformLocation(m_reduceShader->ID(), "sourceSize");
+    cache.bindTextureUnit(0, GL_TEXTURE_2D, m_pyramid);
+    for (int level = 1; level < m_levels; ++level) {
+        const int sourceWidth = std::max(1, width >> (level - 1));
+        const int sourceHeight = std::max(1, height >> (level - 1));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_pyramid, level);
+        glViewport(0, 0, std::max(1, width >> level), std::max(1, height >> level));
+        glUniform2i(sourceSizeLocation, sourceWidth, sourceHeight);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+
+    cache.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    m_viewProjection = viewProjection;
+    m_hasPyramid = true;
+}
+
+void HiZCuller::test(const AABBSoA& bounds) {
+    if (!m_ready || !m_hasPyramid) return;
+    const size_t count = bounds.size();
+    if (count == 0) return;
+    GLStateCache& cache = GLStateCache::get();
+
+    // 包围盒上传到纹理缓冲，每帧重新分配避免等待上一帧仍在使用的数据
+    m_boundsData.resize(count * 8);
+    for (size_t i = 0; i < count; ++i) {
+        float* texels = &m_boundsData[i * 8];
+        texels[0] = bounds.centerX[i];
+        texels[1] = bounds.centerY[i];
+        texels[2] = bounds.centerZ[i];
+        texels[3] = 0.0f;
+        texels[4] = bounds.extentX[i];
+        texels[5] = bounds.extentY[i];
+        texels[6] = bounds.extentZ[i];
+        texels[7] = 0.0f;
+    }
+    cache.bindBuffer(GL_TEXTURE_BUFFER, m_boundsBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_boundsData.size() * sizeof(float), m_boundsData.data(), GL_STREAM_DRAW);
+
+    const int rows = static_cast<int>((count + kResultWidth - 1) / kResultWidth);
+    if (rows > m_resultRows) {
+        GLStateCache::get().deleteTexture(m_resultTexture);
+        glGenTextures(1, &m_resultTexture);
+        cache.bindTexture(GL_TEXTURE_2D, m_resultTexture);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, kResultWidth, rows, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        cache.bindFramebuffer(GL_FRAMEBUFFER, m_resultFbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_resultTexture, 0);
+        m_resultRows = rows;
+    }
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+    {
+        PassStateScope scope;
+        cache.bindFramebuffer(GL_FRAMEBUFFER, m_resultFbo);
+        glViewport(0, 0, kResultWidth, rows);
+        cache.bindVertexArray(m_emptyVao);
+        m_testShader->use();
+        glUniformMatrix4fv(glGetUniformLocation(m_testShader->ID(), "viewProjection"), 1, GL_FALSE,
+                           glm::value_ptr(m_viewProjection));
+        glUniform1i(glGetUniformLocation(m_testShader->ID(), "objectCount"), static_cast<GLint>(count));
+        glUniform1i(glGetUniformLocation(m_testShader->ID(), "levelCount"), m_levels);
+        glUniform2f(glGetUniformLocation(m_testShader->ID(), "screenSize"), static_cast<float>(m_width),
+                    static_cast<float>(m_height));
+        cache.bindSampler(0, 0);
+        cache.bindSampler(1, 0);
+        cache.bindTextureUnit(0, GL_TEXTURE_2D, m_pyramid);
+        cache.bindTextureUnit(1, GL_TEXTURE_BUFFER, m_boundsTexture);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    // 读回到 PBO，fence 就绪前不映射；槽位还没被取走说明落后太多，直接丢弃那次结果
+    Readback& readback = m_readbacks[m_nextSlot];
+    m_nextSlot = (m_nextSlot + 1) % kReadbackSlots;
+    if (readback.fence) glDeleteSync(readback.fence);
+    const size_t bytes = static_cast<size_t>(kResultWidth) * rows;
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+    GLint packAlignment = 4;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, kResultWidth, rows, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+    cache.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.count = count;
+    readback.frame = m_frame++;
+
+    cache.bindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+}
+
+bool HiZCuller::fetchResults() {
+    bool updated = false;
+    for (;;) {
+        // 按提交顺序取最早的一个，没完成就停下
+        Readback* oldest = nullptr;
+        for (Readback& readback : m_readbacks) {
+            if (readback.fence && (!oldest || readback.frame < oldest->frame)) oldest = &readback;
+        }
+        if (!oldest) break;
+        const GLenum status = glClientWaitSync(oldest->fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(oldest->fence);
+        oldest->fence = nullptr;
+
+        GLStateCache::get().bindBuffer(GL_PIXEL_PACK_BUFFER, oldest->buffer);
+        const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, oldest->count, GL_MAP_READ_BIT);
+        if (data) {
+            m_visibility.resize(oldest->count);
+            std::memcpy(m_visibility.data(), data, oldest->count);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            m_resultFrame = oldest->frame;
+            updated = true;
+        }
+        GLStateCache::get().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+    if (updated) {
+        m_stats.tested = m_visibility.size();
+        m_stats.occluded = static_cast<size_t>(std::count(m_visibility.begin(), m_visibility.end(), 0));
+    }
+    m_stats.latency = m_resultFrame >= 0 ? m_frame - m_resultFrame : 0;
+    return updated;
+}
+
+void HiZCuller::reset() {
+    for (Readback& readback : m_readbacks) {
+        if (readback.fence) glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+    }
+    m_visibility.clear();
+    m_resultFrame = -1;
+    m_hasPyramid = false;
+    m_stats = Stats();
+    m_stats.levels = m_levels;
+}
+
+OcclusionQueryCuller::OcclusionQueryCuller() : m_cameraPosition(0.0f) {}
+
+OcclusionQueryCuller::~OcclusionQueryCuller() {
+    if (!m_queries.empty()) glDeleteQueries(static_cast<GLsizei>(m_queries.size()), m_queries.data());
+    GLStateCache::get().deleteVertexArray(m_boxVao);
+    GLStateCache::get().deleteBuffer(m_boxVbo);
+    GLStateCache::get().deleteBuffer(m_boxEbo);
+}
+
+bool OcclusionQueryCuller::init() {
+    if (m_ready) return true;
+    if (!GLCaps::get().versionAtLeast(3, 3)) {
+        std::cerr << "OcclusionQueryCuller: requires OpenGL 3.3" << std::endl;
+        return false;
+    }
+    m_shader.reset(new Shader(kBoxVS, kBoxFS, true));
+    if (!m_shader->isValid()) {
+        std::cerr << "OcclusionQueryCuller: shader compilation failed" << std::endl;
+        m_shader.reset();
+        return false;
+    }
+    m_viewProjectionLocation = glGetUniformLocation(m_shader->ID(), "viewProjection");
+    m_centerLocation = glGetUniformLocation(m_shader->ID(), "center");
+    m_extentLocation = glGetUniformLocation(m_shader->ID(), "extent");
+
+    const float corners[] = {-1, -1, -1, 1, -1, -1, 1, 1, -1, -1, 1, -1,
+                             -1, -1, 1, 1, -1, 1, 1, 1, 1, -1, 1, 1};
+    const uint8_t indices[] = {0, 2, 1, 0, 3, 2, 4, 5, 6, 4, 6, 7, 0, 1, 5, 0, 5, 4,
+                               3, 6, 2, 3, 7, 6, 0, 4, 7, 0, 7, 3, 1, 2, 6, 1, 6, 5};
+    GLStateCache& cache = GLStateCache::get();
+    glGenVertexArrays(1, &m_boxVao);
+    glGenBuffers(1, &m_boxVbo);
+    glGenBuffers(1, &m_boxEbo);
+    cache.bindVertexArray(m_boxVao);
+    cache.bindBuffer(GL_ARRAY_BUFFER, m_boxVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    cache.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_boxEbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    cache.bindVertexArray(0);
+    m_ready = true;
+    return true;
+}
+
+void OcclusionQueryCuller::beginTests(const glm::mat4& viewProjection, const glm::vec3& cameraPosition,
+                                      size_t objectCount) {
+    if (!m_ready) return;
+    if (m_queries.size() < objectCount) {
+        const size_t old = m_queries.size();
+        m_queries.resize(objectCount);
+        glGenQueries(static_cast<GLsizei>(objectCount - old), &m_queries[old]);
+    }
+    m_issued.assign(objectCount, 0);
+    m_cameraPosition = cameraPosition;
+    m_shader->use();
+    glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    GLStateCache::get().bindVertexArray(m_boxVao);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    GLStateCache::get().depthMask(false);
+}
+
+void OcclusionQueryCuller::testBounds(size_t index, const glm::vec3& center, const glm::vec3& extent) {
+    if (!m_ready || index >= m_issued.size()) return;
+    // 相机（连同近平面附近的一小段）在包围盒内时不查询，条件渲染时直接绘制
+    const glm::vec3 d = glm::abs(m_cameraPosition - center);
+    const float margin = 0.5f;
+    if (d.x <= extent.x + margin && d.y <= extent.y + margin && d.z <= extent.z + margin) return;
+    glUniform3fv(m_centerLocation, 1, glm::value_ptr(center));
+    glUniform3fv(m_extentLocation, 1, glm::value_ptr(extent));
+    glBeginQuery(GL_ANY_SAMPLES_PASSED, m_queries[index]);
+    glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE, nullptr);
+    glEndQuery(GL_ANY_SAMPLES_PASSED);
+    m_issued[index] = 1;
+}
+
+void OcclusionQueryCuller::endTests() {
+    if (!m_ready) return;
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    GLStateCache::get().depthMask(true);
+}
+
+void OcclusionQueryCuller::beginConditional(size_t index) {
+    if (!m_ready || m_conditionalActive || index >= m_issued.size() || !m_issued[index]) return;
+    // NO_WAIT：结果还没出来时照常绘制，GPU 不会停下来等
+    glBeginConditionalRender(m_queries[index], GL_QUERY_NO_WAIT);
+    m_conditionalActive = true;
+}
+
+void OcclusionQueryCuller::endConditional() {
+    if (!m_conditionalActive) return;
+    glEndConditionalRender();
+    m_conditionalActive = false;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+
+class Shader;
+
+// Hi-Z 遮挡剔除
+// 每帧末尾把本帧深度拷贝出来，逐级取 2x2 最大值生成深度金字塔 (R32F，level 0 与帧缓冲同尺寸)；
+// 随后用片段 pass 在 GPU 上测试所有包围盒：包围盒投影到屏幕，选一个让它最多覆盖 2x2 纹素的级别，
+// 包围盒最近的深度比这些纹素里最远的深度还远就判为被遮挡。结果写入 R8 纹理，经 PBO 异步读回，
+// fence 就绪后才映射，不会阻塞管线。
+// 因此可见性有 1-2 帧延迟：被挡住的物体仍然每帧参与测试，露出来后晚一两帧出现。
+// 只需要 GL 3.3 (纹理缓冲 + texelFetch)，不依赖计算着色器。
+// 用法（每帧）：
+//   culler.fetchResults();                           // 取回已完成的结果
+//   ... 绘制 frustum 内且 culler.isVisible(i) 的物体 ...
+//   culler.build(framebuffer, w, h, projection * view);  // 本帧深度作为下一帧的遮挡体
+//   culler.test(bounds);
+class HiZCuller {
+public:
+    static const int kReadbackSlots = 3;
+    // 结果纹理每行的物体数
+    static const int kResultWidth = 256;
+
+    struct Stats {
+        size_t tested = 0;      // 最近一次读回的物体数
+        size_t occluded = 0;    // 其中被遮挡的
+        long latency = 0;       // 读回的结果落后几帧
+        int levels = 0;         // 金字塔级数
+    };
+
+    HiZCuller();
+    ~HiZCuller();
+    HiZCuller(const HiZCuller&) = delete;
+    HiZCuller& operator=(const HiZCuller&) = delete;
+
+    // 编译着色器、创建对象，需要 GL 上下文；失败时返回 false，调用方应改用 OcclusionQueryCuller 或不做遮挡剔除
+    bool init();
+    bool isReady() const { return m_ready; }
+
+    // 从 framebuffer（0 为默认帧缓冲）拷贝深度并生成金字塔。深度格式需要是 DEPTH24_STENCIL8，
+    // 这是 GLFW 默认帧缓冲和 Renderer 离屏目标的格式。viewProjection 是渲染这份深度时的矩阵
+    void build(GLuint framebuffer, int width, int height, const glm::mat4& viewProjection);
+    // 用最近一次 build 的金字塔测试包围盒，结果异步读回；包围盒序号即结果序号
+    void test(const AABBSoA& bounds);
+    // 非阻塞地取回已经完成的测试，有新结果时返回 true。每帧调用一次
+    bool fetchResults();
+
+    // 没有结果（还没读回或是新加的物体）时返回 true
+    bool isVisible(size_t index) const { return index >= m_visibility.size() || m_visibility[index] != 0; }
+    const std::vector<uint8_t>& visibility() const { return m_visibility; }
+    // 丢弃已有结果，例如场景或相机发生跳变后
+    void reset();
+
+    GLuint pyramidTexture() const { return m_pyramid; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Readback {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+        size_t count = 0;
+        long frame = 0;
+    };
+
+    bool resize(int width, int height);
+    void release();
+
+    bool m_ready = false;
+    int m_width = 0;
+    int m_height = 0;
+    int m_levels = 0;
+    glm::mat4 m_viewProjection;
+    bool m_hasPyramid = false;
+
+    std::unique_ptr<Shader> m_copyShader;
+    std::unique_ptr<Shader> m_reduceShader;
+    std::unique_ptr<Shader> m_testShader;
+    GLuint m_emptyVao = 0;
+    GLuint m_depthTexture = 0;   // 深度拷贝目标，DEPTH24_STENCIL8
+    GLuint m_depthFbo = 0;
+    GLuint m_pyramid = 0;
+    GLuint m_pyramidFbo = 0;
+
+    GLuint m_boundsBuffer = 0;   // 每个物体两个 RGBA32F 纹素：中心、半边长
+    GLuint m_boundsTexture = 0;
+    GLuint m_resultTexture = 0;
+    GLuint m_resultFbo = 0;
+    int m_resultRows = 0;
+    std::vector<float> m_boundsData;
+
+    Readback m_readbacks[kReadbackSlots];
+    int m_nextSlot = 0;
+    long m_frame = 0;
+    long m_resultFrame = -1;
+    std::vector<uint8_t> m_visibility;
+    Stats m_stats;
+};
+
+// 回退方案：遮挡查询 + 条件渲染
+// 先正常绘制大的遮挡体，再对每个物体用关闭颜色/深度写入的包围盒发起 GL_ANY_SAMPLES_PASSED 查询，
+// 然后在 glBeginConditionalRender 中绘制物体本身，由 GPU 根据查询结果决定是否执行，CPU 不读回。
+// 相机在包围盒内时包围盒会被近平面裁掉，这种物体不做查询，直接绘制
+class OcclusionQueryCuller {
+public:
+    OcclusionQueryCuller();
+    ~OcclusionQueryCuller();
+    OcclusionQueryCuller(const OcclusionQueryCuller&) = delete;
+    OcclusionQueryCuller& operator=(const OcclusionQueryCuller&) = delete;
+
+    bool init();
+    bool isReady() const { return m_ready; }
+
+    // 开始发起查询：切换到包围盒着色器并关闭颜色和深度写入
+    void beginTests(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, size_t objectCount);
+    void testBounds(size_t index, const glm::vec3& center, const glm::vec3& extent);
+    // 恢复颜色和深度写入
+    void endTests();
+
+    // 绘制 index 号物体之前/之后调用
+    void beginConditional(size_t index);
+    void endConditional();
+
+private:
+    bool m_ready = false;
+    std::unique_ptr<Shader> m_shader;
+    GLint m_viewProjectionLocation = -1;
+    GLint m_centerLocation = -1;
+    GLint m_extentLocation = -1;
+    GLuint m_boxVao = 0;
+    GLuint m_boxVbo = 0;
+    GLuint m_boxEbo = 0;
+    std::vector<GLuint> m_queries;
+    std::vector<uint8_t> m_issued;  // 本轮是否发起了查询
+    glm::vec3 m_cameraPosition;
+    bool m_conditionalActive = false;
+};
@@ -0,0 +1,360 @@
+#include "ProceduralTexture.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PROCEDURAL_SSE2 1
+#endif
+
+namespace {
+
+// 生成算法变化时递增，使旧的磁盘缓存失效
+const uint32_t kGeneratorVersion = 1;
+const float kTwoPi = 6.28318530718f;
+
+// FNV-1a，按字段累加，避免结构体填充字节参与哈希
+struct Hasher {
+    uint64_t h = 1469598103934665603ull;
+    Hasher& add(const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return *this;
+    }
+    Hasher& add(float v) { return add(&v, sizeof(v)); }
+    Hasher& add(int32_t v) { return add(&v, sizeof(v)); }
+    Hasher& add(uint32_t v) { return add(&v, sizeof(v)); }
+    Hasher& add(uint64_t v) { return add(&v, sizeof(v)); }
+    Hasher& add(const glm::vec3& v) { return add(v.x).add(v.y).add(v.z); }
+};
+
+inline uint32_t hashCell(int32_t x, int32_t y, uint32_t seed) {
+    uint32_t h = seed ^ (static_cast<uint32_t>(x) * 0x27d4eb2du) ^ (static_cast<uint32_t>(y) * 0x165667b1u);
+    h = (h ^ (h >> 15)) * 0x2c1b3c6du;
+    h = (h ^ (h >> 12)) * 0x297a2d39u;
+    return h ^ (h >> 15);
+}
+
+inline float fade(float t) { return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f); }
+inline float lerp(float a, float b, float t) { return a + t * (b - a); }
+
+inline float cellValue(uint32_t h) {
+    return static_cast<float>(h >> 8) * (1.0f / 16777216.0f) * 2.0f - 1.0f;
+}
+
+// 四个对角梯度 (±1, ±1)
+inline float gradient(uint32_t h, float x, float y) {
+    return ((h & 1u) ? -x : x) + ((h & 2u) ? -y : y);
+}
+
+inline uint32_t octaveSeed(uint32_t seed, int octave) {
+    return seed + static_cast<uint32_t>(octave) * 0x9e3779b9u;
+}
+
+#ifdef PROCEDURAL_SSE2
+// SSE2 没有 32 位乘法取低位，用两次 _mm_mul_epu32 拼出来
+inline __m128i mullo32(__m128i a, __m128i b) {
+    const __m128i even = _mm_mul_epu32(a, b);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+inline __m128i hashCell4(__m128i x, __m128i y, __m128i seed) {
+    __m128i h = _mm_xor_si128(seed, _mm_xor_si128(mullo32(x, _mm_set1_epi32(0x27d4eb2d)),
+                                                  mullo32(y, _mm_set1_epi32(0x165667b1))));
+    h = mullo32(_mm_xor_si128(h, _mm_srli_epi32(h, 15)), _mm_set1_epi32(0x2c1b3c6d));
+    h = mullo32(_mm_xor_si128(h, _mm_srli_epi32(h, 12)), _mm_set1_epi32(0x297a2d39));
+    return _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+}
+
+inline __m128 floor4(__m128 x) {
+    const __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, x), _mm_set1_ps(1.0f)));
+}
+
+inline __m128 fade4(__m128 t) {
+    const __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))),
+                                    _mm_set1_ps(10.0f));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+}
+
+inline __m128 lerp4(__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+inline __m128 cellValue4(__m128i h) {
+    const __m128 v = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+    return _mm_sub_ps(_mm_mul_ps(v, _mm_set1_ps(2.0f)), _mm_set1_ps(1.0f));
+}
+
+inline __m128 gradient4(__m128i h, __m128 x, __m128 y) {
+    const __m128 sx = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    const __m128 sy = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    return _mm_add_ps(_mm_xor_ps(x, sx), _mm_xor_ps(y, sy));
+}
+
+__m128 noise4(NoiseType type, __m128 x, __m128 y, uint32_t seed) {
+    const __m128 x0 = floor4(x), y0 = floor4(y);
+    const __m128i ix = _mm_cvttps_epi32(x0), iy = _mm_cvttps_epi32(y0);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i ix1 = _mm_add_epi32(ix, one), iy1 = _mm_add_epi32(iy, one);
+    const __m128i s = _mm_set1_epi32(static_cast<int>(seed));
+    const __m128i h00 = hashCell4(ix, iy, s), h10 = hashCell4(ix1, iy, s);
+    const __m128i h01 = hashCell4(ix, iy1, s), h11 = hashCell4(ix1, iy1, s);
+    const __m128 fx = _mm_sub_ps(x, x0), fy = _mm_sub_ps(y, y0);
+    const __m128 u = fade4(fx), v = fade4(fy);
+    __m128 a, b, c, d;
+    if (type == NoiseType::Value) {
+        a = cellValue4(h00); b = cellValue4(h10);
+        c = cellValue4(h01); d = cellValue4(h11);
+    } else {
+        const __m128 fx1 = _mm_sub_ps(fx, _mm_set1_ps(1.0f)), fy1 = _mm_sub_ps(fy, _mm_set1_ps(1.0f));
+        a = gradient4(h00, fx, fy);  b = gradient4(h10, fx1, fy);
+        c = gradient4(h01, fx, fy1); d = gradient4(h11, fx1, fy1);
+    }
+    return lerp4(lerp4(a, b, u), lerp4(c, d, u), v);
+}
+#endif
+
+float noise(NoiseType type, float x, float y, uint32_t seed) {
+    return type == NoiseType::Value ? valueNoise(x, y, seed) : perlinNoise(x, y, seed);
+}
+
+template <typename Fn>
+void parallelRows(int rows, unsigned threadCount, Fn fn) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(std::max(1, rows / 16)));
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int y = next++; y < rows; y = next++) fn(y);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+}
+
+inline unsigned char quantize(float v) {
+    return static_cast<unsigned char>(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+bool makeDirectory(const std::string& dir) {
+#ifdef _WIN32
+    return _mkdir(dir.c_str()) == 0;
+#else
+    return mkdir(dir.c_str(), 0755) == 0;
+#endif
+}
+
+const char kCacheMagic[4] = {'P', 'T', 'E', 'X'};
+
+bool readCache(const std::string& path, Image& out) {
+    std::vector<unsigned char> bytes;
+    if (!readFileBytes(path, bytes) || bytes.size() < 24 || std::memcmp(bytes.data(), kCacheMagic, 4) != 0) {
+        return false;
+    }
+    uint32_t header[5];
+    std::memcpy(header, bytes.data() + 4, sizeof(header));
+    Image image;
+    image.width = static_cast<int>(header[1]);
+    image.height = static_cast<int>(header[2]);
+    image.channels = static_cast<int>(header[3]);
+    image.type = static_cast<PixelType>(header[4]);
+    if (header[0] != kGeneratorVersion || image.width <= 0 || image.height <= 0 ||
+        image.channels < 1 || image.channels > 4) {
+        return false;
+    }
+    const size_t size = image.rowBytes() * image.height;
+    if (bytes.size() != 24 + size) return false;
+    image.pixels.assign(bytes.begin() + 24, bytes.end());
+    out = std::move(image);
+    return true;
+}
+
+bool writeCache(const std::string& path, const Image& image) {
+    // 先写临时文件再改名，并发进程不会读到写了一半的缓存
+    const std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary);
+        if (!file.is_open()) return false;
+        const uint32_t header[5] = {kGeneratorVersion, static_cast<uint32_t>(image.width),
+                                    static_cast<uint32_t>(image.height), static_cast<uint32_t>(image.channels),
+                                    static_cast<uint32_t>(image.type)};
+        file.write(kCacheMagic, 4);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(image.pixels.data()), static_cast<std::streamsize>(image.pixels.size()));
+        if (!file) return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+} // namespace
+
+uint64_t NoiseParams::hash() const {
+    Hasher h;
+    h.add(static_cast<int32_t>(type)).add(frequency).add(static_cast<int32_t>(octaves))
+     .add(lacunarity).add(gain).add(seed);
+    return h.h;
+}
+
+uint64_t WoodParams::hash() const {
+    Hasher h;
+    h.add(static_cast<int32_t>(width)).add(static_cast<int32_t>(height)).add(darkColor).add(lightColor)
+     .add(ringFrequency).add(grainStrength).add(grain.hash());
+    return h.h;
+}
+
+uint64_t BorderMaskParams::hash() const {
+    Hasher h;
+    h.add(static_cast<int32_t>(width)).add(static_cast<int32_t>(height)).add(static_cast<int32_t>(channels))
+     .add(border).add(borderValue).add(innerValue).add(noiseAmount).add(noise.hash());
+    return h.h;
+}
+
+float valueNoise(float x, float y, uint32_t seed) {
+    const float x0 = std::floor(x), y0 = std::floor(y);
+    const int32_t ix = static_cast<int32_t>(x0), iy = static_cast<int32_t>(y0);
+    const float u = fade(x - x0), v = fade(y - y0);
+    const float a = cellValue(hashCell(ix, iy, seed)), b = cellValue(hashCell(ix + 1, iy, seed));
+    const float c = cellValue(hashCell(ix, iy + 1, seed)), d = cellValue(hashCell(ix + 1, iy + 1, seed));
+    return lerp(lerp(a, b, u), lerp(c, d, u), v);
+}
+
+float perlinNoise(float x, float y, uint32_t seed) {
+    const float x0 = std::floor(x), y0 = std::floor(y);
+    const int32_t ix = static_cast<int32_t>(x0), iy = static_cast<int32_t>(y0);
+    const float fx = x - x0, fy = y - y0;
+    const float u = fade(fx), v = fade(fy);
+    const float a = gradient(hashCell(ix, iy, seed), fx, fy);
+    const float b = gradient(hashCell(ix + 1, iy, seed), fx - 1.0f, fy);
+    const float c = gradient(hashCell(ix, iy + 1, seed), fx, fy - 1.0f);
+    const float d = gradient(hashCell(ix + 1, iy + 1, seed), fx - 1.0f, fy - 1.0f);
+    return lerp(lerp(a, b, u), lerp(c, d, u), v);
+}
+
+float fbmNoise(float x, float y, const NoiseParams& params) {
+    float sum = 0.0f, amplitude = 1.0f, norm = 0.0f, frequency = params.frequency;
+    for (int octave = 0; octave < std::max(1, params.octaves); ++octave) {
+        sum += amplitude * noise(params.type, x * frequency, y * frequency, octaveSeed(params.seed, octave));
+        norm += amplitude;
+        amplitude *= params.gain;
+        frequency *= params.lacunarity;
+    }
+    return norm > 0.0f ? sum / norm : 0.0f;
+}
+
+void fbmNoiseRow(float x0, float dx, float y, int count, const NoiseParams& params, float* out) {
+    int i = 0;
+#ifdef PROCEDURAL_SSE2
+    const int octaves = std::max(1, params.octaves);
+    for (; i + 4 <= count; i += 4) {
+        const __m128 index = _mm_cvtepi32_ps(_mm_setr_epi32(i, i + 1, i + 2, i + 3));
+        const __m128 xs = _mm_add_ps(_mm_mul_ps(index, _mm_set1_ps(dx)), _mm_set1_ps(x0));
+        __m128 sum = _mm_setzero_ps();
+        float amplitude = 1.0f, norm = 0.0f, frequency = params.frequency;
+        for (int octave = 0; octave < octaves; ++octave) {
+            const __m128 n = noise4(params.type, _mm_mul_ps(xs, _mm_set1_ps(frequency)),
+                                    _mm_set1_ps(y * frequency), octaveSeed(params.seed, octave));
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(amplitude), n));
+            norm += amplitude;
+            amplitude *= params.gain;
+            frequency *= params.lacunarity;
+        }
+        _mm_storeu_ps(out + i, norm > 0.0f ? _mm_div_ps(sum, _mm_set1_ps(norm)) : _mm_setzero_ps());
+    }
+#endif
+    for (; i < count; ++i) out[i] = fbmNoise(static_cast<float>(i) * dx + x0, y, params);
+}
+
+Image generateImage(int width, int height, int channels, const ProceduralRowFunc& row, unsigned threadCount) {
+    Image image;
+    if (width <= 0 || height <= 0 || channels < 1 || channels > 4) return image;
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.resize(image.rowBytes() * height);
+    parallelRows(height, threadCount, [&](int y) {
+        std::vector<float> values(static_cast<size_t>(width) * channels, 0.0f);
+        row(y, values.data());
+        unsigned char* dst = image.pixels.data() + image.rowBytes() * y;
+        for (size_t i = 0; i < values.size(); ++i) dst[i] = quantize(values[i]);
+    });
+    return image;
+}
+
+Image generateNoiseImage(int width, int height, const NoiseParams& params, unsigned threadCount) {
+    const float invW = 1.0f / width, invH = 1.0f / height;
+    return generateImage(width, height, 1, [&](int y, float* row) {
+        fbmNoiseRow(0.5f * invW, invW, (y + 0.5f) * invH, width, params, row);
+        for (int x = 0; x < width; ++x) row[x] = row[x] * 0.5f + 0.5f;
+    }, threadCount);
+}
+
+Image generateWoodImage(const WoodParams& params, unsigned threadCount) {
+    const int width = params.width;
+    const float invW = 1.0f / width, invH = 1.0f / params.height;
+    return generateImage(width, params.height, 3, [&](int y, float* row) {
+        std::vector<float> grain(width);
+        fbmNoiseRow(0.5f * invW, invW, (y + 0.5f) * invH, width, params.grain, grain.data());
+        for (int x = 0; x < width; ++x) {
+            const float u = (x + 0.5f) * invW;
+            const float t = std::sin((u * params.ringFrequency + grain[x] * params.grainStrength) * kTwoPi) * 0.5f + 0.5f;
+            const glm::vec3 color = glm::mix(params.darkColor, params.lightColor, t);
+            row[x * 3 + 0] = color.x;
+            row[x * 3 + 1] = color.y;
+            row[x * 3 + 2] = color.z;
+        }
+    }, threadCount);
+}
+
+Image generateBorderMaskImage(const BorderMaskParams& params, unsigned threadCount) {
+    const int width = params.width, channels = params.channels;
+    const float invW = 1.0f / width, invH = 1.0f / params.height;
+    return generateImage(width, params.height, channels, [&](int y, float* row) {
+        std::vector<float> n(width);
+        const float v = (y + 0.5f) * invH;
+        fbmNoiseRow(0.5f * invW, invW, v, width, params.noise, n.data());
+        const bool rowBorder = v < params.border || v > 1.0f - params.border;
+        for (int x = 0; x < width; ++x) {
+            const float u = (x + 0.5f) * invW;
+            const bool isBorder = rowBorder || u < params.border || u > 1.0f - params.border;
+            const float value = isBorder ? params.borderValue : params.innerValue + n[x] * params.noiseAmount;
+            for (int c = 0; c < channels; ++c) row[x * channels + c] = value;
+        }
+    }, threadCount);
+}
+
+Image loadOrGenerate(const std::string& name, uint64_t paramsHash,
+                     const std::function<Image()>& generator, const std::string& cacheDir) {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%016llx.ptex", static_cast<unsigned long long>(paramsHash));
+    const std::string path = cacheDir + "/" + name + suffix;
+
+    Image image;
+    if (readCache(path, image)) return image;
+    image = generator();
+    if (image.empty()) return image;
+    makeDirectory(cacheDir);
+    if (!writeCache(path, image)) {
+        std::cerr << "Procedural cache: cannot write " << path << std::endl;
+    }
+    return image;
+}
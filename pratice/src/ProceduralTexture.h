@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <glm/glm.hpp>
+#include "Image.h"
+
+// 程序化纹理生成
+// 噪声按行批量求值（SSE2 一次 4 个像素，其余标量），图像按行分给多个线程并行生成；
+// 生成结果可以按 (生成器名, 参数哈希) 缓存到磁盘，参数不变时直接读文件。
+
+enum class NoiseType {
+    Value,   // 格点随机值插值，便宜，块状感较强
+    Perlin   // 梯度噪声，更平滑
+};
+
+struct NoiseParams {
+    NoiseType type = NoiseType::Perlin;
+    float frequency = 4.0f;   // 在 [0,1] 纹理坐标上的基础频率
+    int octaves = 5;          // fBm 叠加层数，1 即单层噪声
+    float lacunarity = 2.0f;  // 每层频率倍数
+    float gain = 0.5f;        // 每层振幅倍数
+    uint32_t seed = 1;
+
+    uint64_t hash() const;
+};
+
+// 单点求值，返回 [-1, 1]
+float valueNoise(float x, float y, uint32_t seed);
+float perlinNoise(float x, float y, uint32_t seed);
+// 按 params 叠加 fBm，坐标为纹理坐标 (会乘以 frequency)，返回 [-1, 1]
+float fbmNoise(float x, float y, const NoiseParams& params);
+// 一行 count 个采样：x = x0 + i * dx，结果与逐点调用 fbmNoise 一致
+void fbmNoiseRow(float x0, float dx, float y, int count, const NoiseParams& params, float* out);
+
+// 逐行生成：回调写出 width * channels 个 [0,1] 浮点值，最终量化为 8 位
+using ProceduralRowFunc = std::function<void(int y, float* row)>;
+Image generateImage(int width, int height, int channels, const ProceduralRowFunc& row, unsigned threadCount = 0);
+
+// 单通道 fBm 噪声图
+Image generateNoiseImage(int width, int height, const NoiseParams& params, unsigned threadCount = 0);
+
+// 木纹：噪声扰动的年轮条纹在深浅两色之间混合
+struct WoodParams {
+    int width = 256;
+    int height = 256;
+    glm::vec3 darkColor = glm::vec3(139.0f, 69.0f, 19.0f) / 255.0f;
+    glm::vec3 lightColor = glm::vec3(189.0f, 99.0f, 39.0f) / 255.0f;
+    float ringFrequency = 8.0f;    // 每个纹理宽度内的条纹数
+    float grainStrength = 1.5f;    // 噪声对条纹的扰动幅度
+    NoiseParams grain;
+
+    uint64_t hash() const;
+};
+Image generateWoodImage(const WoodParams& params, unsigned threadCount = 0);
+
+// 边框遮罩：边框高亮、内部暗并带噪声，用作木箱的镜面光贴图
+struct BorderMaskParams {
+    int width = 256;
+    int height = 256;
+    int channels = 3;              // 与漫反射贴图一致，方便放进同一个纹理数组
+    float border = 0.1f;           // 边框宽度，占纹理边长的比例
+    float borderValue = 1.0f;
+    float innerValue = 50.0f / 255.0f;
+    float noiseAmount = 0.1f;      // 内部噪声幅度
+    NoiseParams noise;
+
+    uint64_t hash() const;
+};
+Image generateBorderMaskImage(const BorderMaskParams& params, unsigned threadCount = 0);
+
+// 磁盘缓存：cacheDir/name-<hash>.ptex 存在时直接读取，否则调用 generator 并写入
+// 缓存目录不可写时只是跳过写入
+Image loadOrGenerate(const std::string& name, uint64_t paramsHash,
+                     const std::function<Image()>& generator,
+                     const std::string& cacheDir = "procedural_cache");
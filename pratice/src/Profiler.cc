@@ -0,0 +1,276 @@
+#include "Profiler.h"
+#include "GLCaps.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+Profiler::Stats computeStats(std::vector<double>& samples) {
+    Profiler::Stats s;
+    if (samples.empty()) return s;
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double v : samples) sum += v;
+    const size_t n = samples.size();
+    s.samples = static_cast<int>(n);
+    s.minMs = samples.front();
+    s.maxMs = samples.back();
+    s.avgMs = sum / n;
+    size_t p99 = static_cast<size_t>(std::ceil(0.99 * n));
+    s.p99Ms = samples[std::min(n, std::max<size_t>(p99, 1)) - 1];
+    return s;
+}
+
+void writeJsonString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+} // namespace
+
+Profiler& Profiler::get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : m_epoch(std::chrono::steady_clock::now()) {}
+
+int64_t Profiler::now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count();
+}
+
+void Profiler::setHistory(int frames) {
+    m_history = std::max(1, frames);
+    while (static_cast<int>(m_frames.size()) > m_history) m_frames.pop_front();
+}
+
+int Profiler::scopeId(const char* name) {
+    auto it = m_nameIds.find(name);
+    if (it != m_nameIds.end()) return it->second;
+    const int id = static_cast<int>(m_names.size());
+    m_names.push_back(name);
+    m_nameIds.emplace(m_names.back(), id);
+    return id;
+}
+
+void Profiler::beginFrame() {
+    if (!m_enabled || m_inFrame) return;
+    // 多线程渲染时 GL 线程可能换成渲染线程，以最近一次 beginFrame 的线程为准
+    m_thread = std::this_thread::get_id();
+    if (!m_initialized) {
+        m_initialized = true;
+        const GLCaps& caps = GLCaps::get();
+        m_gpuSupported = caps.versionAtLeast(3, 3) || caps.hasExtension("GL_ARB_timer_query");
+        if (m_gpuSupported) {
+            // 同一时刻读取两边的时间，之后 GPU 时间戳减去这个差值即落到 CPU 时间轴上
+            GLint64 gpuNow = 0;
+            glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+            m_gpuOffset = static_cast<int64_t>(gpuNow) - now();
+        }
+    }
+    m_gpuEnabled = m_gpuRequested && m_gpuSupported;
+
+    Slot& slot = m_slots[m_current];
+    if (slot.pending) resolve(slot);
+    slot.frame.index = m_frameIndex;
+    slot.frame.events.clear();
+    slot.gpu = m_gpuEnabled;
+    m_stack.clear();
+    m_inFrame = true;
+    m_frameEvent = beginScope("frame");
+}
+
+void Profiler::endFrame() {
+    if (!m_inFrame) return;
+    // 没有正常结束的作用域在帧末统一关闭
+    while (!m_stack.empty() && m_stack.back() != m_frameEvent) endScope(m_stack.back());
+    endScope(m_frameEvent);
+    m_slots[m_current].pending = true;
+    m_inFrame = false;
+    m_frameEvent = -1;
+    ++m_frameIndex;
+    m_current = (m_current + 1) % kFramesInFlight;
+}
+
+int Profiler::beginScope(const char* name) {
+    if (!m_enabled || !m_inFrame || std::this_thread::get_id() != m_thread) return -1;
+    Slot& slot = m_slots[m_current];
+    Event event;
+    event.scope = scopeId(name);
+    event.depth = static_cast<int>(m_stack.size());
+    const int index = static_cast<int>(slot.frame.events.size());
+    if (slot.gpu) {
+        const size_t needed = 2 * static_cast<size_t>(index + 1);
+        if (slot.queries.size() < needed) {
+            const size_t old = slot.queries.size();
+            slot.queries.resize(std::max<size_t>(std::max<size_t>(needed, old * 2), 32));
+            glGenQueries(static_cast<GLsizei>(slot.queries.size() - old), &slot.queries[old]);
+        }
+        glQueryCounter(slot.queries[2 * index], GL_TIMESTAMP);
+    }
+    event.cpuBegin = now();
+    slot.frame.events.push_back(event);
+    m_stack.push_back(index);
+    return index;
+}
+
+void Profiler::endScope(int event) {
+    if (event < 0 || !m_inFrame || std::this_thread::get_id() != m_thread) return;
+    Slot& slot = m_slots[m_current];
+    if (event >= static_cast<int>(slot.frame.events.size())) return;
+    slot.frame.events[event].cpuEnd = now();
+    if (slot.gpu) glQueryCounter(slot.queries[2 * event + 1], GL_TIMESTAMP);
+    auto it = std::find(m_stack.begin(), m_stack.end(), event);
+    if (it != m_stack.end()) m_stack.erase(it);
+}
+
+void Profiler::resolve(Slot& slot) {
+    Frame& frame = slot.frame;
+    if (slot.gpu && !frame.events.empty()) {
+        // 根作用域的结束时间戳最后提交，它可用说明整帧的查询都已完成；否则放弃这帧的 GPU 数据而不是等待
+        GLint available = 0;
+        glGetQueryObjectiv(slot.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available) {
+            for (size_t i = 0; i < frame.events.size(); ++i) {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(slot.queries[2 * i], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(slot.queries[2 * i + 1], GL_QUERY_RESULT, &end);
+                frame.events[i].gpuBegin = static_cast<int64_t>(begin) - m_gpuOffset;
+                frame.events[i].gpuEnd = static_cast<int64_t>(end) - m_gpuOffset;
+            }
+        }
+    }
+    slot.pending = false;
+    m_frames.push_back(std::move(frame));
+    frame = Frame();
+    while (static_cast<int>(m_frames.size()) > m_history) m_frames.pop_front();
+}
+
+std::vector<Profiler::ScopeStats> Profiler::report() const {
+    const size_t scopeCount = m_names.size();
+    std::vector<int> order;
+    std::vector<int> depth(scopeCount, -1);
+    std::vector<std::vector<double> > cpuSamples(scopeCount), gpuSamples(scopeCount);
+    std::vector<double> cpuFrame(scopeCount), gpuFrame(scopeCount);
+    std::vector<char> seen(scopeCount), gpuSeen(scopeCount);
+
+    for (const Frame& frame : m_frames) {
+        std::fill(cpuFrame.begin(), cpuFrame.end(), 0.0);
+        std::fill(gpuFrame.begin(), gpuFrame.end(), 0.0);
+        std::fill(seen.begin(), seen.end(), 0);
+        std::fill(gpuSeen.begin(), gpuSeen.end(), 0);
+        for (const Event& e : frame.events) {
+            if (depth[e.scope] < 0) {
+                depth[e.scope] = e.depth;
+                order.push_back(e.scope);
+            }
+            seen[e.scope] = 1;
+            cpuFrame[e.scope] += (e.cpuEnd - e.cpuBegin) * 1e-6;
+            if (e.gpuBegin >= 0) {
+                gpuSeen[e.scope] = 1;
+                gpuFrame[e.scope] += (e.gpuEnd - e.gpuBegin) * 1e-6;
+            }
+        }
+        for (size_t i = 0; i < scopeCount; ++i) {
+            if (seen[i]) cpuSamples[i].push_back(cpuFrame[i]);
+            if (gpuSeen[i]) gpuSamples[i].push_back(gpuFrame[i]);
+        }
+    }
+
+    std::vector<ScopeStats> result;
+    for (int id : order) {
+        ScopeStats s;
+        s.name = m_names[id];
+        s.depth = depth[id];
+        s.cpu = computeStats(cpuSamples[id]);
+        s.gpu = computeStats(gpuSamples[id]);
+        result.push_back(s);
+    }
+    return result;
+}
+
+void Profiler::print(std::ostream& out) const {
+    const std::vector<ScopeStats> stats = report();
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << "Profiler (" << m_frames.size() << " frames, ms)\n";
+    out << std::left << std::setw(24) << "scope" << std::right
+        << std::setw(9) << "cpu avg" << std::setw(9) << "min" << std::setw(9) << "max" << std::setw(9) << "p99"
+        << std::setw(9) << "gpu avg" << std::setw(9) << "min" << std::setw(9) << "max" << std::setw(9) << "p99"
+        << "\n";
+    out << std::fixed << std::setprecision(3);
+    for (const ScopeStats& s : stats) {
+        out << std::left << std::setw(24) << (std::string(2 * s.depth, ' ') + s.name) << std::right
+            << std::setw(9) << s.cpu.avgMs << std::setw(9) << s.cpu.minMs
+            << std::setw(9) << s.cpu.maxMs << std::setw(9) << s.cpu.p99Ms;
+        if (s.gpu.samples > 0) {
+            out << std::setw(9) << s.gpu.avgMs << std::setw(9) << s.gpu.minMs
+                << std::setw(9) << s.gpu.maxMs << std::setw(9) << s.gpu.p99Ms;
+        } else {
+            out << std::setw(9) << "-";
+        }
+        out << "\n";
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream file(path.c_str());
+    if (!file) {
+        std::cerr << "Profiler: cannot write " << path << std::endl;
+        return false;
+    }
+    // Chrome trace 的时间单位是微秒
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    for (const Frame& frame : m_frames) {
+        for (const Event& e : frame.events) {
+            file << ",\n{\"name\":";
+            writeJsonString(file, m_names[e.scope]);
+            file << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << e.cpuBegin * 1e-3
+                 << ",\"dur\":" << (e.cpuEnd - e.cpuBegin) * 1e-3 << ",\"args\":{\"frame\":" << frame.index << "}}";
+            if (e.gpuBegin >= 0) {
+                file << ",\n{\"name\":";
+                writeJsonString(file, m_names[e.scope]);
+                file << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":" << e.gpuBegin * 1e-3
+                     << ",\"dur\":" << (e.gpuEnd - e.gpuBegin) * 1e-3 << ",\"args\":{\"frame\":" << frame.index << "}}";
+            }
+        }
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+void Profiler::reset() {
+    m_frames.clear();
+    for (Slot& slot : m_slots) {
+        slot.pending = false;
+        slot.frame = Frame();
+    }
+}
+
+void Profiler::releaseGpuResources() {
+    for (Slot& slot : m_slots) {
+        // 还没读取的帧只保留 CPU 数据
+        if (slot.pending) {
+            slot.gpu = false;
+            resolve(slot);
+        }
+        if (!slot.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(slot.queries.size()), slot.queries.data());
+            slot.queries.clear();
+        }
+    }
+    m_inFrame = false;
+    m_initialized = false;
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+
+// CPU/GPU 帧分析器
+// CPU 时间用 steady_clock；GPU 时间在作用域开始和结束各插入一个 GL_TIMESTAMP 查询 (glQueryCounter)。
+// GL_TIME_ELAPSED 查询同一时刻只能有一个处于活动状态，作用域一嵌套就无法使用，时间戳对没有这个限制。
+// 查询池按 kFramesInFlight 帧轮转，结果在复用该帧的查询前才读取，GPU 还没完成时直接丢弃这一帧的 GPU 数据，
+// 因此不会让 CPU 等待 GPU。
+// 只记录 GL 线程（调用 beginFrame 的线程）上的作用域，其他线程的 PROFILE_SCOPE 不产生记录。
+class Profiler {
+public:
+    static const int kFramesInFlight = 3;
+
+    struct Stats {
+        double minMs = 0.0;
+        double avgMs = 0.0;
+        double maxMs = 0.0;
+        double p99Ms = 0.0;
+        int samples = 0;    // 出现过该作用域的帧数
+    };
+
+    struct ScopeStats {
+        std::string name;
+        int depth = 0;      // 第一次出现时的嵌套深度，frame 为 0
+        Stats cpu;
+        Stats gpu;          // 没有 GPU 数据时 samples 为 0
+    };
+
+    static Profiler& get();
+
+    void setEnabled(bool enabled) { m_enabled = enabled; }
+    bool isEnabled() const { return m_enabled; }
+    // GPU 计时需要 GL 3.3 或 ARB_timer_query，不支持时自动关闭
+    void setGpuTiming(bool enabled) { m_gpuRequested = enabled; }
+    bool gpuTiming() const { return m_gpuEnabled; }
+    // 统计和导出使用最近 frames 帧，默认 120
+    void setHistory(int frames);
+
+    // Renderer::run 在每帧渲染前后调用，帧本身作为名为 "frame" 的根作用域
+    void beginFrame();
+    void endFrame();
+
+    // 由 ProfileScope 调用，返回事件序号，未记录时返回 -1
+    int beginScope(const char* name);
+    void endScope(int event);
+
+    // 每个作用域一帧内多次出现时累加，统计的是每帧总耗时；按第一次出现的顺序排列
+    std::vector<ScopeStats> report() const;
+    void print(std::ostream& out) const;
+    // 导出最近的帧为 Chrome trace (chrome://tracing / Perfetto)，CPU 和 GPU 分别在两个轨道
+    bool writeChromeTrace(const std::string& path) const;
+
+    void reset();
+    // 删除查询对象，必须在 GL 上下文销毁前调用
+    void releaseGpuResources();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+private:
+    Profiler();
+
+    struct Event {
+        int scope = 0;
+        int depth = 0;
+        int64_t cpuBegin = 0;   // 相对 m_epoch 的纳秒
+        int64_t cpuEnd = 0;
+        int64_t gpuBegin = -1;  // 已换算到 CPU 时间轴的纳秒，-1 表示没有数据
+        int64_t gpuEnd = -1;
+    };
+    struct Frame {
+        long index = 0;
+        std::vector<Event> events;
+    };
+    struct Slot {
+        Frame frame;
+        std::vector<GLuint> queries;   // 每个事件两个查询：开始、结束
+        bool gpu = false;              // 这一帧是否插入了时间戳查询
+        bool pending = false;
+    };
+
+    int64_t now() const;
+    int scopeId(const char* name);
+    void resolve(Slot& slot);
+
+    bool m_enabled = true;
+    bool m_gpuRequested = true;
+    bool m_gpuSupported = false;
+    bool m_gpuEnabled = false;
+    // 其他线程的 PROFILE_SCOPE 也会读取这两个字段以判断是否记录，用原子变量。
+    // beginFrame 先写 m_thread 再置 m_inFrame
+    std::atomic<bool> m_inFrame{false};
+    bool m_initialized = false;
+    int m_history = 120;
+    long m_frameIndex = 0;
+    int m_current = 0;
+    int m_frameEvent = -1;
+    int64_t m_gpuOffset = 0;      // GPU 时间戳 - CPU 时间，用于把两条时间轴对齐
+    std::atomic<std::thread::id> m_thread{std::thread::id()};
+    std::chrono::steady_clock::time_point m_epoch;
+
+    Slot m_slots[kFramesInFlight];
+    std::vector<int> m_stack;     // 当前打开的事件
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, int> m_nameIds;
+    std::deque<Frame> m_frames;   // 已完成的帧，最多 m_history 个
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) : m_event(Profiler::get().beginScope(name)) {}
+    ~ProfileScope() { Profiler::get().endScope(m_event); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    int m_event;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// 用法：{ PROFILE_SCOPE("lights"); ... }，作用域结束时自动结束计时
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
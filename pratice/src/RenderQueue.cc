@@ -0,0 +1,188 @@
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "mesh.h"
+#include <algorithm>
+#include <iostream>
+#include <glm/gtc/type_ptr.hpp>
+
+RenderQueue::RenderQueue() {
+    for (int i = 0; i < kMaxPasses; ++i) m_depthOrder[i] = DepthOrder::FrontToBack;
+}
+
+template <typename T>
+uint16_t RenderQueue::denseId(std::unordered_map<const T*, uint16_t>& ids, const T* object) {
+    if (!object) return 0;
+    auto it = ids.find(object);
+    if (it != ids.end()) return it->second;
+    // 0 留给“没有”，序号从 1 开始
+    const uint16_t id = static_cast<uint16_t>(ids.size() + 1);
+    ids.emplace(object, id);
+    return id;
+}
+
+uint16_t RenderQueue::addMaterial(const RenderMaterial& material) {
+    MaterialState state;
+    state.desc = material;
+    if (material.shader) {
+        state.program = denseId(m_programIds, static_cast<const Shader*>(material.shader));
+        const GLuint program = material.shader->ID();
+        if (material.modelUniform && material.modelUniform[0]) {
+            state.modelLocation = glGetUniformLocation(program, material.modelUniform);
+        }
+        if (material.colorUniform && material.colorUniform[0]) {
+            state.colorLocation = glGetUniformLocation(program, material.colorUniform);
+        }
+    } else {
+        std::cerr << "RenderQueue: material without a shader" << std::endl;
+    }
+    m_materials.push_back(state);
+    return static_cast<uint16_t>(m_materials.size() - 1);
+}
+
+void RenderQueue::setProgramSetup(Shader* shader, std::function<void(Shader&)> setup) {
+    denseId(m_programIds, static_cast<const Shader*>(shader));
+    m_programSetup[shader] = setup;
+}
+
+void RenderQueue::setDepthOrder(uint8_t pass, DepthOrder order) {
+    if (pass < kMaxPasses) m_depthOrder[pass] = order;
+}
+
+void RenderQueue::setDepthRange(float nearDepth, float farDepth) {
+    m_nearDepth = nearDepth;
+    m_farDepth = std::max(farDepth, nearDepth + 1e-4f);
+}
+
+uint32_t RenderQueue::quantizeDepth(float depth, int bits) const {
+    float t = (depth - m_nearDepth) / (m_farDepth - m_nearDepth);
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    const uint32_t maxValue = (1u << bits) - 1;
+    return static_cast<uint32_t>(t * maxValue + 0.5f);
+}
+
+uint64_t RenderQueue::makeKey(const DrawCommand& command) {
+    const uint64_t pass = command.pass & 0xF;
+    const uint64_t program = m_materials[command.material].program & 0x3FF;
+    const uint64_t material = command.material & 0xFFF;
+    const uint64_t texture = denseId(m_textureIds, command.texture) & 0xFFF;
+    const uint64_t mesh = denseId(m_meshIds, command.mesh) & 0xFFF;
+    if (m_depthOrder[pass] == DepthOrder::BackToFront) {
+        const uint64_t depth = (~quantizeDepth(command.depth, 24)) & 0xFFFFFF;
+        return (pass << 60) | (depth << 36) | (program << 26) | (material << 14) | (texture << 2);
+    }
+    const uint64_t depth = quantizeDepth(command.depth, 14);
+    return (pass << 60) | (program << 50) | (material << 38) | (texture << 26) | (mesh << 14) | depth;
+}
+
+void RenderQueue::submit(const DrawCommand& command) {
+    if (command.material >= m_materials.size() || !command.mesh || !m_materials[command.material].desc.shader) {
+        std::cerr << "RenderQueue: invalid draw command" << std::endl;
+        return;
+    }
+    SortItem item;
+    item.key = makeKey(command);
+    item.index = static_cast<uint32_t>(m_commands.size());
+    m_commands.push_back(command);
+    m_items.push_back(item);
+    m_sorted = false;
+}
+
+void RenderQueue::clear() {
+    m_commands.clear();
+    m_items.clear();
+    m_sorted = false;
+}
+
+// LSD 基数排序，每趟 8 位；所有键在某个字节上都相同时跳过该趟（高位的 pass/程序经常如此）。
+// 稳定排序，键相同的命令保持提交顺序
+void RenderQueue::sort() {
+    const size_t n = m_items.size();
+    m_scratch.resize(n);
+    SortItem* src = m_items.data();
+    SortItem* dst = m_scratch.data();
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {0};
+        for (size_t i = 0; i < n; ++i) ++counts[(src[i].key >> shift) & 0xFF];
+        if (n == 0 || counts[(src[0].key >> shift) & 0xFF] == n) continue;
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            const size_t c = counts[b];
+            counts[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; ++i) dst[counts[(src[i].key >> shift) & 0xFF]++] = src[i];
+        std::swap(src, dst);
+    }
+    if (src != m_items.data()) std::copy(src, src + n, m_items.data());
+    m_sorted = true;
+}
+
+void RenderQueue::execute() {
+    m_stats = Stats();
+    if (!m_sorted) sort();
+
+    const Shader* currentShader = nullptr;
+    const Mesh* currentMesh = nullptr;
+    int currentMaterial = -1;
+    std::vector<const Texture*> boundTextures;
+    // 程序对象自己保存 uniform：逐帧设置每个程序只做一次，材质只在该程序上次用的不是它时重新应用
+    std::vector<char> programReady(m_programIds.size() + 1, 0);
+    std::vector<int> programMaterial(m_programIds.size() + 1, -1);
+
+    for (const SortItem& item : m_items) {
+        const DrawCommand& command = m_commands[item.index];
+        const MaterialState& material = m_materials[command.material];
+        Shader* shader = material.desc.shader;
+
+        if (shader != currentShader) {
+            shader->use();
+            currentShader = shader;
+            ++m_stats.programChanges;
+            if (!programReady[material.program]) {
+                programReady[material.program] = 1;
+                auto it = m_programSetup.find(shader);
+                if (it != m_programSetup.end() && it->second) it->second(*shader);
+            }
+        }
+        if (static_cast<int>(command.material) != currentMaterial) {
+            currentMaterial = command.material;
+            if (programMaterial[material.program] != currentMaterial) {
+                programMaterial[material.program] = currentMaterial;
+                ++m_stats.materialChanges;
+                if (material.desc.apply) material.desc.apply(*shader);
+            }
+            for (const auto& binding : material.desc.textures) {
+                if (binding.first >= boundTextures.size()) boundTextures.resize(binding.first + 1, nullptr);
+                if (boundTextures[binding.first] != binding.second) {
+                    binding.second->bind(binding.first);
+                    boundTextures[binding.first] = binding.second;
+                    ++m_stats.textureBinds;
+                }
+            }
+        }
+        if (command.texture) {
+            const GLuint unit = material.desc.drawTextureUnit;
+            if (unit >= boundTextures.size()) boundTextures.resize(unit + 1, nullptr);
+            if (boundTextures[unit] != command.texture) {
+                command.texture->bind(unit);
+                boundTextures[unit] = command.texture;
+                ++m_stats.textureBinds;
+            }
+        }
+        if (command.mesh != currentMesh) {
+            command.mesh->bind();
+            currentMesh = command.mesh;
+            ++m_stats.meshBinds;
+        }
+
+        if (material.modelLocation >= 0) {
+            glUniformMatrix4fv(material.modelLocation, 1, GL_FALSE, glm::value_ptr(command.model));
+        }
+        if (material.colorLocation >= 0) {
+            glUniform3fv(material.colorLocation, 1, glm::value_ptr(command.color));
+        }
+        command.mesh->drawBound(command.mode);
+        ++m_stats.draws;
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+class Shader;
+class Mesh;
+class Texture;
+
+// 渲染命令队列
+// 绘制调用先以 (64 位排序键, 命令) 的形式提交，每帧基数排序后按键顺序执行。
+// 执行时记录当前的程序、材质、纹理和 VAO，与上一条命令相同的绑定直接跳过，
+// 状态切换次数从“绘制次数”降到“不同状态的个数”。
+//
+// 不透明 pass 的键（高位优先）：
+//   pass:4 | program:10 | material:12 | texture:12 | mesh:12 | depth:14（由近到远）
+// 半透明 pass（DepthOrder::BackToFront）把深度提到 pass 之后，保证由远到近的混合顺序：
+//   pass:4 | ~depth:24 | program:10 | material:12 | texture:12
+// 程序/纹理/网格在键里是队列分配的紧凑序号，超出位宽时会回绕，只影响排序质量，
+// 执行时比较的始终是真实对象，不会因此漏掉绑定。
+struct RenderMaterial {
+    Shader* shader = nullptr;
+    // 材质切换时调用一次，设置材质相关的 uniform
+    std::function<void(Shader&)> apply;
+    // 材质固定使用的纹理：(纹理单元, 纹理)
+    std::vector<std::pair<GLuint, const Texture*> > textures;
+    // 每条命令的模型矩阵、颜色写入的 uniform，名字为空表示不设置
+    const char* modelUniform = "model";
+    const char* colorUniform = "";
+    // DrawCommand::texture 绑定的纹理单元
+    GLuint drawTextureUnit = 0;
+};
+
+struct DrawCommand {
+    uint8_t pass = 0;
+    uint16_t material = 0;             // RenderQueue::addMaterial 的返回值
+    const Mesh* mesh = nullptr;
+    const Texture* texture = nullptr;  // 可选，逐物体的纹理
+    float depth = 0.0f;                // 到相机的距离
+    GLenum mode = GL_TRIANGLES;
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::vec3 color = glm::vec3(1.0f);
+};
+
+class RenderQueue {
+public:
+    static const int kMaxPasses = 16;
+
+    enum class DepthOrder { FrontToBack, BackToFront };
+
+    struct Stats {
+        size_t draws = 0;
+        size_t programChanges = 0;
+        size_t materialChanges = 0;
+        size_t textureBinds = 0;
+        size_t meshBinds = 0;
+    };
+
+    RenderQueue();
+
+    // 材质在队列生命周期内保持不变，返回值写入 DrawCommand::material
+    uint16_t addMaterial(const RenderMaterial& material);
+    // 程序在每次 execute 中第一次被使用时调用，设置 view/projection/灯光等逐帧 uniform
+    void setProgramSetup(Shader* shader, std::function<void(Shader&)> setup);
+    void setDepthOrder(uint8_t pass, DepthOrder order);
+    // 深度量化的范围，默认与相机的近远平面一致
+    void setDepthRange(float nearDepth, float farDepth);
+
+    void submit(const DrawCommand& command);
+    size_t size() const { return m_commands.size(); }
+    void clear();
+
+    // 排序并执行；不会清空队列，同一批命令可以重复执行
+    void execute();
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct SortItem {
+        uint64_t key;
+        uint32_t index;
+    };
+    struct MaterialState {
+        RenderMaterial desc;
+        uint16_t program = 0;
+        GLint modelLocation = -1;
+        GLint colorLocation = -1;
+    };
+
+    uint64_t makeKey(const DrawCommand& command);
+    uint32_t quantizeDepth(float depth, int bits) const;
+    void sort();
+    template <typename T>
+    static uint16_t denseId(std::unordered_map<const T*, uint16_t>& ids, const T* object);
+
+    std::vector<MaterialState> m_materials;
+    std::unordered_map<const Shader*, uint16_t> m_programIds;
+    std::unordered_map<const Texture*, uint16_t> m_textureIds;
+    std::unordered_map<const Mesh*, uint16_t> m_meshIds;
+    std::unordered_map<const Shader*, std::function<void(Shader&)> > m_programSetup;
+    DepthOrder m_depthOrder[kMaxPasses];
+    float m_nearDepth = 0.1f;
+    float m_farDepth = 100.0f;
+
+    std::vector<DrawCommand> m_commands;
+    std::vector<SortItem> m_items;
+    std::vector<SortItem> m_scratch;
+    bool m_sorted = false;
+    Stats m_stats;
+};
@@ -0,0 +1,158 @@
+#include "RenderTargetPool.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+struct FormatInfo {
+    GLenum internalFormat;
+    GLenum format;
+    GLenum type;
+    size_t bytes;
+    GLenum attachment;
+};
+
+const FormatInfo kFormats[] = {
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, GL_COLOR_ATTACHMENT0},
+    {GL_SRGB8_ALPHA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, GL_COLOR_ATTACHMENT0},
+    {GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, GL_COLOR_ATTACHMENT0},
+    {GL_RGBA32F, GL_RGBA, GL_FLOAT, 16, GL_COLOR_ATTACHMENT0},
+    {GL_R11F_G11F_B10F, GL_RGB, GL_FLOAT, 4, GL_COLOR_ATTACHMENT0},
+    {GL_RG16F, GL_RG, GL_HALF_FLOAT, 4, GL_COLOR_ATTACHMENT0},
+    {GL_R16F, GL_RED, GL_HALF_FLOAT, 2, GL_COLOR_ATTACHMENT0},
+    {GL_R32F, GL_RED, GL_FLOAT, 4, GL_COLOR_ATTACHMENT0},
+    {GL_R8, GL_RED, GL_UNSIGNED_BYTE, 1, GL_COLOR_ATTACHMENT0},
+    {GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, 4, GL_DEPTH_STENCIL_ATTACHMENT},
+    {GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, 4, GL_DEPTH_ATTACHMENT},
+};
+
+const FormatInfo* findFormat(GLenum internalFormat) {
+    for (const FormatInfo& info : kFormats) {
+        if (info.internalFormat == internalFormat) return &info;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+RenderTargetPool::~RenderTargetPool() {
+    for (std::unique_ptr<Entry>& entry : m_entries) destroy(*entry);
+}
+
+size_t RenderTargetPool::bytesPerPixel(GLenum format) {
+    const FormatInfo* info = findFormat(format);
+    return info ? info->bytes : 0;
+}
+
+RenderTarget* RenderTargetPool::acquire(int width, int height, GLenum format) {
+    for (std::unique_ptr<Entry>& entry : m_entries) {
+        const RenderTarget& target = entry->target;
+        if (entry->inUse || target.width != width || target.height != height || target.format != format) continue;
+        entry->inUse = true;
+        entry->lastUsed = m_frame;
+        ++m_stats.inUse;
+        ++m_stats.reused;
+        return &entry->target;
+    }
+
+    const FormatInfo* info = findFormat(format);
+    if (!info || width <= 0 || height <= 0) {
+        std::cerr << "RenderTargetPool: unsupported target " << width << "x" << height << " format 0x" << std::hex
+                  << format << std::dec << std::endl;
+        return nullptr;
+    }
+    std::unique_ptr<Entry> entry(new Entry());
+    RenderTarget& target = entry->target;
+    target.width = width;
+    target.height = height;
+    target.format = format;
+    GLStateCache& cache = GLStateCache::get();
+    const GLenum filter = info->attachment == GL_COLOR_ATTACHMENT0 ? GL_LINEAR : GL_NEAREST;
+    glGenTextures(1, &target.texture);
+    cache.bindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, info->format, info->type, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    // 调用方可能正绑着自己的帧缓冲（绘制和读取可以不同），建完分别恢复
+    const GLuint previousDraw = cache.drawFramebuffer();
+    const GLuint previousRead = cache.readFramebuffer();
+    glGenFramebuffers(1, &target.framebuffer);
+    cache.bindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, info->attachment, GL_TEXTURE_2D, target.texture, 0);
+    if (info->attachment != GL_COLOR_ATTACHMENT0) {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    cache.bindFramebuffer(GL_DRAW_FRAMEBUFFER, previousDraw);
+    cache.bindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "RenderTargetPool: framebuffer incomplete: 0x" << std::hex << status << std::dec << std::endl;
+        cache.deleteFramebuffer(target.framebuffer);
+        cache.deleteTexture(target.texture);
+        return nullptr;
+    }
+
+    entry->inUse = true;
+    entry->lastUsed = m_frame;
+    m_stats.bytes += info->bytes * width * height;
+    ++m_stats.targets;
+    ++m_stats.inUse;
+    ++m_stats.created;
+    m_entries.push_back(std::move(entry));
+    return &m_entries.back()->target;
+}
+
+void RenderTargetPool::release(RenderTarget* target) {
+    if (!target) return;
+    for (std::unique_ptr<Entry>& entry : m_entries) {
+        if (&entry->target != target) continue;
+        if (entry->inUse) {
+            entry->inUse = false;
+            entry->lastUsed = m_frame;
+            --m_stats.inUse;
+        }
+        return;
+    }
+}
+
+void RenderTargetPool::endFrame() {
+    ++m_frame;
+    for (size_t i = 0; i < m_entries.size();) {
+        Entry& entry = *m_entries[i];
+        if (!entry.inUse && m_frame - entry.lastUsed > static_cast<uint64_t>(kMaxIdleFrames)) {
+            destroy(entry);
+            m_entries[i] = std::move(m_entries.back());
+            m_entries.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void RenderTargetPool::trim() {
+    for (size_t i = 0; i < m_entries.size();) {
+        if (!m_entries[i]->inUse) {
+            destroy(*m_entries[i]);
+            m_entries[i] = std::move(m_entries.back());
+            m_entries.pop_back();
+        } else {
+            ++i;
+        }
+    }
+}
+
+void RenderTargetPool::destroy(Entry& entry) {
+    RenderTarget& target = entry.target;
+    if (target.texture) {
+        m_stats.bytes -= bytesPerPixel(target.format) * target.width * target.height;
+        --m_stats.targets;
+    }
+    GLStateCache::get().deleteFramebuffer(target.framebuffer);
+    GLStateCache::get().deleteTexture(target.texture);
+    target = RenderTarget();
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+
+// 池中的一个渲染目标：单层纹理和以它为附件的 FBO。
+// 颜色格式挂在 COLOR_ATTACHMENT0，线性过滤；深度格式挂在深度（模板）附件，最近点过滤。边缘都是截断
+struct RenderTarget {
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+    int width = 0;
+    int height = 0;
+    GLenum format = GL_NONE;
+};
+
+// 临时渲染目标池
+// 后处理每帧要用一批中间纹理（泛光的各级降采样、亮度直方图等），pass 结束就不再需要。
+// acquire 按尺寸和格式找空闲的目标复用，找不到才创建；release 之后同一帧里后面的 pass
+// 就可以拿到同一张纹理，ping-pong 用的目标不必各自常驻显存。
+// endFrame 释放连续 kMaxIdleFrames 帧没被用到的目标，分辨率变化后旧尺寸的目标会自然淘汰
+class RenderTargetPool {
+public:
+    static const int kMaxIdleFrames = 4;
+
+    struct Stats {
+        size_t targets = 0;    // 池中的目标数
+        size_t inUse = 0;
+        size_t bytes = 0;      // 按格式估算的显存
+        size_t created = 0;    // 累计创建次数
+        size_t reused = 0;     // 累计复用次数
+    };
+
+    RenderTargetPool() = default;
+    ~RenderTargetPool();
+    RenderTargetPool(const RenderTargetPool&) = delete;
+    RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+    // 内容未定义，需要时自己清空。不支持的格式或 FBO 不完整时返回 nullptr
+    RenderTarget* acquire(int width, int height, GLenum format);
+    void release(RenderTarget* target);
+    // 每帧调用一次，淘汰长期空闲的目标
+    void endFrame();
+    // 释放所有空闲目标
+    void trim();
+
+    const Stats& stats() const { return m_stats; }
+    // 每像素字节数，不支持的格式返回 0
+    static size_t bytesPerPixel(GLenum format);
+
+private:
+    struct Entry {
+        RenderTarget target;
+        bool inUse = false;
+        uint64_t lastUsed = 0;
+    };
+
+    void destroy(Entry& entry);
+
+    std::vector<std::unique_ptr<Entry> > m_entries;
+    uint64_t m_frame = 0;
+    Stats m_stats;
+};
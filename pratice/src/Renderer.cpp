@@ -1,24 +1,48 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "Renderer.h"
+#include "TextureBudget.h"
+#include "Profiler.h"
+#include "GLStateCache.h"
+#include "ColorSpace.h"
+#include "Image.h"
+#include "HdrPipeline.h"
+#include "FrameCapture.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
 #include <iostream>
+#include <mutex>
+#include <thread>
+
+#ifdef OPENGL_UTILS_HAS_EGL
+// 只用 surfaceless 平台，避免 eglplatform.h 引入 X11 头文件
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 struct GLFWwindow;
 
-Renderer::Renderer(int width, int height, const char* title) {
+Renderer::Renderer(int width, int height, const char* title, bool srgb)
+    : m_srgb(srgb), m_width(width), m_height(height) {
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW" << std::endl;
         m_window = nullptr;
         return;
     }
+    m_glfwInitialized = true;
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, srgb ? GLFW_TRUE : GLFW_FALSE);
     m_window = glfwCreateWindow(width, height, title, nullptr, nullptr);
     if (!m_window) {
         std::cerr << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
+        m_glfwInitialized = false;
         return;
     }
     glfwMakeContextCurrent(m_window);
@@ -28,25 +52,314 @@ Renderer::Renderer(int width, int height, const char* title) {
         m_window = nullptr;
         return;
     }
+    GLStateCache::get().invalidate();
+    if (m_srgb) GLStateCache::get().enable(GL_FRAMEBUFFER_SRGB);
+}
+
+std::unique_ptr<Renderer> Renderer::createHeadless(int width, int height, bool srgb) {
+    std::unique_ptr<Renderer> renderer(new Renderer());
+    renderer->m_headless = true;
+    renderer->m_srgb = srgb;
+    renderer->m_width = width;
+    renderer->m_height = height;
+    if (!renderer->createEGLContext() && !renderer->createHiddenWindow()) {
+        std::cerr << "Failed to create a headless GL context" << std::endl;
+        return nullptr;
+    }
+    GLStateCache::get().invalidate();
+    if (!renderer->createRenderTarget()) return nullptr;
+    if (srgb) GLStateCache::get().enable(GL_FRAMEBUFFER_SRGB);
+    return renderer;
+}
+
+bool Renderer::createEGLContext() {
+#ifdef OPENGL_UTILS_HAS_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+    if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) return false;
+
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!extensions || !std::strstr(extensions, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL: surfaceless desktop GL contexts are not supported" << std::endl;
+        eglTerminate(display);
+        return false;
+    }
+    const EGLint configAttribs[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint count = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &count) || count == 0) {
+        eglTerminate(display);
+        return false;
+    }
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+        EGL_CONTEXT_MINOR_VERSION_KHR, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+    m_eglDisplay = display;
+    m_eglContext = context;
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        m_eglDisplay = nullptr;
+        m_eglContext = nullptr;
+        return false;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+// 回退：隐藏窗口，仍然需要显示服务器，但渲染同样走离屏 FBO
+bool Renderer::createHiddenWindow() {
+    if (!glfwInit()) return false;
+    m_glfwInitialized = true;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    m_window = glfwCreateWindow(m_width, m_height, "headless", nullptr, nullptr);
+    if (!m_window) return false;
+    glfwMakeContextCurrent(m_window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool Renderer::createRenderTarget() {
+    glGenRenderbuffers(1, &m_colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, m_srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, m_width, m_height);
+    glGenRenderbuffers(1, &m_depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &m_fbo);
+    GLStateCache::get().bindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+    const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Headless framebuffer incomplete: 0x" << std::hex << status << std::dec << std::endl;
+        return false;
+    }
+    glViewport(0, 0, m_width, m_height);
+    return true;
 }
 
 Renderer::~Renderer() {
+    if (m_window || m_eglContext) Profiler::get().releaseGpuResources();
+    if (m_fbo) {
+        GLStateCache::get().deleteFramebuffer(m_fbo);
+        glDeleteRenderbuffers(1, &m_colorBuffer);
+        glDeleteRenderbuffers(1, &m_depthBuffer);
+    }
+#ifdef OPENGL_UTILS_HAS_EGL
+    if (m_eglDisplay) {
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_eglContext) eglDestroyContext(m_eglDisplay, m_eglContext);
+        eglTerminate(m_eglDisplay);
+    }
+#endif
     if (m_window) {
         glfwDestroyWindow(m_window);
     }
-    glfwTerminate();
+    if (m_glfwInitialized) glfwTerminate();
+}
+
+GLuint Renderer::framebuffer() const {
+    return m_hdr && m_hdr->sceneFramebuffer() ? m_hdr->sceneFramebuffer() : m_fbo;
 }
 
-void Renderer::run(const std::function<void()>& renderFunc) {
-    while (m_window && !glfwWindowShouldClose(m_window)) {
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+void Renderer::framebufferSize(int& width, int& height) const {
+    width = m_width;
+    height = m_height;
+    if (!m_headless && m_window) glfwGetFramebufferSize(m_window, &width, &height);
+}
+
+void Renderer::renderFrame(const std::function<void()>& body, int width, int height) {
+    // 清屏色按 sRGB 给出，写入 sRGB 帧缓冲前转换到线性空间以保持原来的观感
+    static const glm::vec3 clearColor(0.2f, 0.3f, 0.3f);
+    const glm::vec3 clear = m_srgb ? srgbToLinear(clearColor) : clearColor;
+    Profiler::get().beginFrame();
+    if (m_hdr) {
+        // HDR 场景目标总是线性的，输出是否 sRGB 由色调映射处理
+        m_hdr->resize(width, height);
+        m_hdr->begin(srgbToLinear(clearColor));
+        body();
+        m_hdr->end(m_fbo, m_srgb);
+    } else {
+        if (m_headless) {
+            GLStateCache::get().bindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+            glViewport(0, 0, m_width, m_height);
+        }
+        glClearColor(clear.x, clear.y, clear.z, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        renderFunc();
-        glfwSwapBuffers(m_window);
-        glfwPollEvents();
+        body();
+    }
+    if (m_capture) m_capture->capture(m_fbo);
+    Profiler::get().endFrame();
+    if (!m_headless) glfwSwapBuffers(m_window);
+    ++m_frame;
+    TextureBudget::get().update();
+}
+
+void Renderer::run(const std::function<void()>& renderFunc, int frameCount) {
+    if (m_headless && frameCount <= 0) {
+        std::cerr << "Renderer: headless run() needs a frame count" << std::endl;
+        return;
     }
+    for (int frame = 0; frameCount <= 0 || frame < frameCount; ++frame) {
+        if (!m_headless && (!m_window || glfwWindowShouldClose(m_window))) break;
+        int width = 0, height = 0;
+        framebufferSize(width, height);
+        renderFrame(renderFunc, width, height);
+        if (m_window) glfwPollEvents();
+    }
+    // 无窗口模式没有 SwapBuffers 做隐式同步，返回前等 GPU 完成，计时和读回才可靠
+    if (m_headless) glFinish();
+}
+
+void Renderer::runThreaded(const std::function<void(RenderCommandList&)>& update, int frameCount,
+                           int maxFramesInFlight) {
+    if (m_headless && frameCount <= 0) {
+        std::cerr << "Renderer: headless runThreaded() needs a frame count" << std::endl;
+        return;
+    }
+    if (!m_window && !m_eglContext) return;
+    const int latency = std::min(std::max(maxFramesInFlight, 1), 2);
+    // 列表比允许领先的帧数多一个：渲染线程执行一个，主线程最多录制 latency 个
+    const int listCount = latency + 1;
+    std::vector<RenderCommandList> lists(listCount);
+    std::vector<GLsync> fences(listCount, nullptr);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    long published = 0;   // 主线程录制完成的帧数
+    long consumed = 0;    // 渲染线程执行完、列表可以复用的帧数
+    bool stop = false;
+
+    // GLFW 和 EGL 都要求上下文同一时刻只在一个线程上 current
+    releaseCurrent();
+    std::thread renderThread([&]() {
+        makeCurrent();
+        for (long next = 0;; ++next) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [&]() { return published > next || stop; });
+                if (published <= next) break;
+            }
+            const int slot = static_cast<int>(next % listCount);
+            // 复用槽位前等它上一次提交的 GPU 工作完成，GPU 上最多排队 listCount 帧
+            if (fences[slot]) {
+                glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+                glDeleteSync(fences[slot]);
+                fences[slot] = nullptr;
+            }
+            renderFrame([&]() { lists[slot].execute(); }, lists[slot].framebufferWidth(),
+                        lists[slot].framebufferHeight());
+            fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++consumed;
+            }
+            cv.notify_all();
+        }
+        for (GLsync fence : fences) {
+            if (fence) glDeleteSync(fence);
+        }
+        if (m_headless) glFinish();
+        releaseCurrent();
+    });
+
+    for (long frame = 0; frameCount <= 0 || frame < frameCount; ++frame) {
+        if (m_window) {
+            glfwPollEvents();
+            if (glfwWindowShouldClose(m_window)) break;
+        }
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [&]() { return frame - consumed < listCount; });
+        }
+        RenderCommandList& list = lists[frame % listCount];
+        list.clear();
+        list.setFrame(frame);
+        int width = 0, height = 0;
+        framebufferSize(width, height);
+        list.setFramebufferSize(width, height);
+        update(list);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++published;
+        }
+        cv.notify_all();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    cv.notify_all();
+    renderThread.join();
+    makeCurrent();
+}
+
+void Renderer::makeCurrent() {
+#ifdef OPENGL_UTILS_HAS_EGL
+    if (m_eglContext) {
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, m_eglContext);
+        return;
+    }
+#endif
+    if (m_window) glfwMakeContextCurrent(m_window);
+}
+
+void Renderer::releaseCurrent() {
+#ifdef OPENGL_UTILS_HAS_EGL
+    if (m_eglContext) {
+        eglMakeCurrent(m_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        return;
+    }
+#endif
+    if (m_window) glfwMakeContextCurrent(nullptr);
 }
 
 GLFWwindow* Renderer::window() const {
-    return m_window;
-} 
\ No newline at end of file
+    return m_headless ? nullptr : m_window;
+}
+
+double Renderer::time() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+bool Renderer::readPixels(Image& out) const {
+    int width = 0, height = 0;
+    framebufferSize(width, height);
+    if (width <= 0 || height <= 0) return false;
+    out = Image();
+    out.width = width;
+    out.height = height;
+    out.channels = 4;
+    out.pixels.resize(static_cast<size_t>(width) * height * 4);
+    GLStateCache::get().bindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, out.pixels.data());
+    return true;
+}
@@ -2,18 +2,116 @@
 #define RENDERER_H
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <memory>
+#include <vector>
 #include <GLFW/glfw3.h>
 
+struct Image;
+class HdrPipeline;
+class FrameCapture;
+
+// 一帧的 GL 命令列表：多线程模式下主线程录制，渲染线程按录制顺序执行。
+// 命令应按值捕获本帧需要的数据，主线程随后会继续修改自己的状态
+class RenderCommandList {
+public:
+    void add(std::function<void()> command) { m_commands.push_back(std::move(command)); }
+    void execute() const {
+        for (const auto& command : m_commands) command();
+    }
+    void clear() { m_commands.clear(); }
+    size_t size() const { return m_commands.size(); }
+    // 录制的是第几帧
+    long frame() const { return m_frame; }
+    void setFrame(long frame) { m_frame = frame; }
+    // 录制时的帧缓冲尺寸，由主线程查询（GLFW 的窗口函数只能在主线程调用）
+    int framebufferWidth() const { return m_framebufferWidth; }
+    int framebufferHeight() const { return m_framebufferHeight; }
+    void setFramebufferSize(int width, int height) {
+        m_framebufferWidth = width;
+        m_framebufferHeight = height;
+    }
+
+private:
+    std::vector<std::function<void()> > m_commands;
+    long m_frame = 0;
+    int m_framebufferWidth = 0;
+    int m_framebufferHeight = 0;
+};
+
 class Renderer {
 public:
-    Renderer(int width, int height, const char* title);
+    // srgb 为 true 时请求 sRGB 默认帧缓冲并开启 GL_FRAMEBUFFER_SRGB，着色器输出线性颜色即可
+    Renderer(int width, int height, const char* title, bool srgb = true);
     ~Renderer();
-    void run(const std::function<void()>& renderFunc);
+    Renderer(const Renderer&) = delete;
+    Renderer& operator=(const Renderer&) = delete;
 
+    // 无窗口渲染：优先使用 EGL surfaceless 上下文（Mesa llvmpipe 即可，不需要显示器和 GPU），
+    // 没有 EGL 时退化为隐藏的 GLFW 窗口。画面渲染到 width x height 的离屏 FBO。
+    // 创建失败时返回 nullptr
+    static std::unique_ptr<Renderer> createHeadless(int width, int height, bool srgb = true);
+
+    // frameCount 为 0 时一直运行到窗口关闭；无窗口模式必须给出帧数
+    void run(const std::function<void()>& renderFunc, int frameCount = 0);
+
+    // 多线程模式：GL 上下文交给渲染线程。主线程处理输入和模拟，调用 update 录制下一帧的命令列表，
+    // 同时渲染线程执行上一帧的列表并交换缓冲，两者重叠执行。
+    // maxFramesInFlight (1-2) 限制主线程最多领先渲染线程几帧；渲染线程每帧插入 fence，
+    // 同样限制 GPU 上排队的帧数。运行期间主线程不能调用任何 GL 函数，GL 资源需在调用前创建好
+    void runThreaded(const std::function<void(RenderCommandList&)>& update, int frameCount = 0,
+                     int maxFramesInFlight = 1);
+
+    // 无窗口 (EGL) 模式下为 nullptr
     GLFWwindow* window() const;
+    bool isSRGB() const { return m_srgb; }
+    bool isHeadless() const { return m_headless; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    // 当前渲染目标：设置了 HDR 管线时是它的场景目标，否则窗口模式为默认帧缓冲 0
+    GLuint framebuffer() const;
+    // 设置后每帧先渲染到 hdr 的 RGBA16F 场景目标，body 结束后色调映射到输出帧缓冲。
+    // hdr 需已 init，生命周期由调用方管理；传 nullptr 恢复直接渲染
+    void setHdr(HdrPipeline* hdr) { m_hdr = hdr; }
+    // 设置后每帧在交换缓冲前把输出帧缓冲交给 capture 异步读回，capture 需已 start
+    void setCapture(FrameCapture* capture) { m_capture = capture; }
+    // 已提交的帧数，多线程模式下由渲染线程递增
+    long frameIndex() const { return m_frame.load(); }
+    // 创建以来经过的秒数，两种模式都可用（替代 glfwGetTime）
+    double time() const;
+    // 读回渲染目标的 RGBA8 像素，行序自下而上，与 GL 和 Image 的 flip 约定一致
+    bool readPixels(Image& out) const;
+
 private:
-    GLFWwindow* m_window;
+    Renderer() = default;
+    bool createEGLContext();
+    bool createHiddenWindow();
+    bool createRenderTarget();
+    void makeCurrent();
+    void releaseCurrent();
+    // 当前帧缓冲尺寸，窗口模式下查询 GLFW，只能在主线程调用
+    void framebufferSize(int& width, int& height) const;
+    // 清屏、执行 body、交换缓冲，run 和 runThreaded 的渲染线程共用。width/height 为主线程查询的帧缓冲尺寸
+    void renderFrame(const std::function<void()>& body, int width, int height);
+
+    GLFWwindow* m_window = nullptr;
+    bool m_srgb = true;
+    bool m_headless = false;
+    bool m_glfwInitialized = false;
+    int m_width = 0;
+    int m_height = 0;
+    GLuint m_fbo = 0;
+    GLuint m_colorBuffer = 0;
+    GLuint m_depthBuffer = 0;
+    HdrPipeline* m_hdr = nullptr;
+    FrameCapture* m_capture = nullptr;
+    std::atomic<long> m_frame{0};
+    std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+    // EGL 句柄，头文件不引入 EGL
+    void* m_eglDisplay = nullptr;
+    void* m_eglContext = nullptr;
 };
 
-#endif // RENDERER_H 
\ No newline at end of file
+#endif // RENDERER_H
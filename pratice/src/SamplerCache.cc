@@ -0,0 +1,78 @@
+#include "SamplerCache.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY     0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+SamplerDesc SamplerDesc::trilinear(GLenum wrap, float anisotropy) {
+    SamplerDesc desc;
+    desc.wrapS = desc.wrapT = wrap;
+    desc.maxAnisotropy = anisotropy;
+    return desc;
+}
+
+SamplerDesc SamplerDesc::linearClamp() {
+    SamplerDesc desc;
+    desc.wrapS = desc.wrapT = GL_CLAMP_TO_EDGE;
+    desc.minFilter = GL_LINEAR;
+    return desc;
+}
+
+SamplerDesc SamplerDesc::nearestClamp() {
+    SamplerDesc desc;
+    desc.wrapS = desc.wrapT = GL_CLAMP_TO_EDGE;
+    desc.minFilter = GL_NEAREST;
+    desc.magFilter = GL_NEAREST;
+    return desc;
+}
+
+size_t SamplerCache::DescHash::operator()(const SamplerDesc& d) const {
+    uint32_t aniso;
+    std::memcpy(&aniso, &d.maxAnisotropy, sizeof(aniso));
+    size_t h = 0;
+    const uint32_t fields[] = {d.wrapS, d.wrapT, d.minFilter, d.magFilter, aniso, d.compareMode, d.compareFunc};
+    for (uint32_t f : fields) h ^= std::hash<uint32_t>()(f) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+}
+
+SamplerCache& SamplerCache::get() {
+    static SamplerCache cache;
+    return cache;
+}
+
+GLuint SamplerCache::sampler(const SamplerDesc& desc) {
+    auto it = m_samplers.find(desc);
+    if (it != m_samplers.end()) return it->second;
+
+    GLuint id = 0;
+    glGenSamplers(1, &id);
+    glSamplerParameteri(id, GL_TEXTURE_WRAP_S, desc.wrapS);
+    glSamplerParameteri(id, GL_TEXTURE_WRAP_T, desc.wrapT);
+    glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, desc.minFilter);
+    glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, desc.magFilter);
+    glSamplerParameteri(id, GL_TEXTURE_COMPARE_MODE, desc.compareMode);
+    glSamplerParameteri(id, GL_TEXTURE_COMPARE_FUNC, desc.compareFunc);
+    if (desc.maxAnisotropy > 1.0f) {
+        const GLCaps& caps = GLCaps::get();
+        if (caps.versionAtLeast(4, 6) || caps.hasExtension("GL_EXT_texture_filter_anisotropic") ||
+            caps.hasExtension("GL_ARB_texture_filter_anisotropic")) {
+            GLfloat maxSupported = 1.0f;
+            glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxSupported);
+            glSamplerParameterf(id, GL_TEXTURE_MAX_ANISOTROPY, std::min(desc.maxAnisotropy, maxSupported));
+        }
+    }
+    m_samplers.emplace(desc, id);
+    return id;
+}
+
+void SamplerCache::clear() {
+    for (auto& entry : m_samplers) GLStateCache::get().deleteSampler(entry.second);
+    m_samplers.clear();
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+#include <glad/glad.h>
+
+// 采样器描述：过滤、环绕、各向异性、深度比较
+struct SamplerDesc {
+    GLenum wrapS = GL_REPEAT;
+    GLenum wrapT = GL_REPEAT;
+    GLenum minFilter = GL_LINEAR_MIPMAP_LINEAR;  // 三线性，真正用到 mip
+    GLenum magFilter = GL_LINEAR;
+    float maxAnisotropy = 1.0f;                  // 大于 1 时启用各向异性过滤（若支持）
+    GLenum compareMode = GL_NONE;                // 阴影贴图使用 GL_COMPARE_REF_TO_TEXTURE
+    GLenum compareFunc = GL_LEQUAL;
+
+    static SamplerDesc trilinear(GLenum wrap = GL_REPEAT, float anisotropy = 1.0f);
+    static SamplerDesc linearClamp();             // 无 mip，夹取边缘（后处理/渲染目标）
+    static SamplerDesc nearestClamp();
+
+    bool operator==(const SamplerDesc& o) const {
+        return wrapS == o.wrapS && wrapT == o.wrapT && minFilter == o.minFilter &&
+               magFilter == o.magFilter && maxAnisotropy == o.maxAnisotropy &&
+               compareMode == o.compareMode && compareFunc == o.compareFunc;
+    }
+};
+
+// 采样器对象缓存：相同描述只创建一个 GL sampler，纹理之间共享
+// 采样状态与纹理对象分离后，驱动不必在每次绑定时重新校验纹理参数
+class SamplerCache {
+public:
+    static SamplerCache& get();
+
+    GLuint sampler(const SamplerDesc& desc);
+    size_t size() const { return m_samplers.size(); }
+    void clear();
+
+    SamplerCache(const SamplerCache&) = delete;
+    SamplerCache& operator=(const SamplerCache&) = delete;
+
+private:
+    SamplerCache() = default;
+
+    struct DescHash {
+        size_t operator()(const SamplerDesc& d) const;
+    };
+    std::unordered_map<SamplerDesc, GLuint, DescHash> m_samplers;
+};
@@ -1,6 +1,7 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "Shader.h"
+#include "GLStateCache.h"
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <fstream>
@@ -49,6 +50,7 @@ Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath) {
         glGetProgramInfoLog(programID, 512, nullptr, infoLog);
         std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
+    compiled = success == GL_TRUE;
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
 }
@@ -92,14 +94,14 @@ Shader::Shader(const std::string& vertexSource, const std::string& fragmentSourc
         glGetProgramInfoLog(programID, 512, nullptr, infoLog);
         std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
     }
+    compiled = success == GL_TRUE;
     
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
-    compiled = true;
 }
 
 Shader::~Shader() {
-    glDeleteProgram(programID);
+    GLStateCache::get().deleteProgram(programID);
 }
 
 Shader::Shader(Shader&& other) noexcept : programID(other.programID), compiled(other.compiled) {
@@ -109,7 +111,7 @@ Shader::Shader(Shader&& other) noexcept : programID(other.programID), compiled(o
 
 Shader& Shader::operator=(Shader&& other) noexcept {
     if (this != &other) {
-        glDeleteProgram(programID);
+        GLStateCache::get().deleteProgram(programID);
         programID = other.programID;
         compiled = other.compiled;
         other.programID = 0;
@@ -119,7 +121,7 @@ Shader& Shader::operator=(Shader&& other) noexcept {
 }
 
 void Shader::use() const {
-    glUseProgram(programID);
+    GLStateCache::get().useProgram(programID);
 }
 
 void Shader::setInt(const std::string& name, int value) {
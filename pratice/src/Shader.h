@@ -21,6 +21,7 @@ public:
 
     // 基本操作
     void use() const;
+    // 程序链接成功（着色器编译失败时链接也会失败）
     bool isValid() const { return programID != 0 && compiled; }
     GLuint ID() const { return programID; }
 
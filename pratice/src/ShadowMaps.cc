@@ -0,0 +1,513 @@
+#include "ShadowMaps.h"
+#include "Frustum.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#include "Shader.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+
+// 聚光和点光源阴影的近平面
+const float kNearPlane = 0.05f;
+// 级联分段中对数分布的比重，其余为均匀分布
+const float kSplitLambda = 0.75f;
+// 每个图块在 PCF 核外多画的纹素，点光源相邻两面的接缝处采样不会越界
+const float kBorderTexels = 2.0f;
+
+const char* kDepthVS =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 aPos;\n"
+    "uniform mat4 lightViewProjection;\n"
+    "uniform mat4 model;\n"
+    "void main() {\n"
+    "    gl_Position = lightViewProjection * model * vec4(aPos, 1.0);\n"
+    "}\n";
+
+const char* kDepthFS =
+    "#version 330 core\n"
+    "void main() {\n"
+    "}\n";
+
+// 深度偏移按世界单位给出，换算到各自的深度范围：正交投影是线性的，
+// 透视投影的深度对距离的导数约为 near / w^2
+const char* kShadowGLSL =
+    "uniform sampler2DArrayShadow cascadeShadowMap;\n"
+    "uniform mat4 cascadeMatrices[SHADOW_CASCADES];\n"
+    "uniform sampler2DShadow shadowAtlas;\n"
+    "uniform samplerBuffer shadowViews;\n"
+    "uniform vec2 shadowTexelSizes;\n"
+    "const float kShadowBias = 0.03;\n"
+    "float directionalShadow(vec3 worldPos) {\n"
+    "    float texel = shadowTexelSizes.x;\n"
+    "    for (int i = 0; i < SHADOW_CASCADES; ++i) {\n"
+    "        vec3 p = (cascadeMatrices[i] * vec4(worldPos, 1.0)).xyz * 0.5 + 0.5;\n"
+    "        // 留出 PCF 核的边距，落在边上的点交给下一级\n"
+    "        if (any(lessThan(p.xy, vec2(texel * 2.0))) || any(greaterThan(p.xy, vec2(1.0 - texel * 2.0))))\n"
+    "            continue;\n"
+    "        float depth = p.z - kShadowBias * abs(cascadeMatrices[i][2][2]) * 0.5;\n"
+    "        float sum = 0.0;\n"
+    "        for (int y = -1; y <= 1; ++y)\n"
+    "            for (int x = -1; x <= 1; ++x)\n"
+    "                sum += texture(cascadeShadowMap, vec4(p.xy + vec2(x, y) * texel, float(i), depth));\n"
+    "        return sum / 9.0;\n"
+    "    }\n"
+    "    return 1.0;\n"
+    "}\n"
+    "float atlasShadow(int view, vec3 worldPos) {\n"
+    "    mat4 m = mat4(texelFetch(shadowViews, view * 5), texelFetch(shadowViews, view * 5 + 1),\n"
+    "                  texelFetch(shadowViews, view * 5 + 2), texelFetch(shadowViews, view * 5 + 3));\n"
+    "    vec4 rect = texelFetch(shadowViews, view * 5 + 4);\n"
+    "    vec4 clip = m * vec4(worldPos, 1.0);\n"
+    "    if (clip.w <= 0.0) return 1.0;\n"
+    "    vec3 p = clip.xyz / clip.w * 0.5 + 0.5;\n"
+    "    if (p.z >= 1.0) return 1.0;\n"
+    "    float texel = shadowTexelSizes.y;\n"
+    "    vec2 lo = rect.xy + vec2(texel * 0.5);\n"
+    "    vec2 hi = rect.xy + rect.zw - vec2(texel * 0.5);\n"
+    "    vec2 uv = rect.xy + clamp(p.xy, 0.0, 1.0) * rect.zw;\n"
+    "    float depth = p.z - kShadowBias * SHADOW_NEAR / (clip.w * clip.w);\n"
+    "    float sum = 0.0;\n"
+    "    for (int y = -1; y <= 1; ++y)\n"
+    "        for (int x = -1; x <= 1; ++x)\n"
+    "            sum += texture(shadowAtlas, vec3(clamp(uv + vec2(x, y) * texel, lo, hi), depth));\n"
+    "    return sum / 9.0;\n"
+    "}\n"
+    "float spotShadow(int view, vec3 worldPos) {\n"
+    "    return view < 0 ? 1.0 : atlasShadow(view, worldPos);\n"
+    "}\n"
+    "float pointShadow(int firstView, vec3 worldPos, vec3 lightPos) {\n"
+    "    if (firstView < 0) return 1.0;\n"
+    "    vec3 d = worldPos - lightPos;\n"
+    "    vec3 a = abs(d);\n"
+    "    int face;\n"
+    "    if (a.x >= a.y && a.x >= a.z) face = d.x > 0.0 ? 0 : 1;\n"
+    "    else if (a.y >= a.z) face = d.y > 0.0 ? 2 : 3;\n"
+    "    else face = d.z > 0.0 ? 4 : 5;\n"
+    "    return atlasShadow(firstView + face, worldPos);\n"
+    "}\n";
+
+// 立方体六个面的朝向，顺序和着色器里选面的顺序一致
+const glm::vec3 kFaceAxes[6] = {glm::vec3(1.0f, 0.0f, 0.0f),  glm::vec3(-1.0f, 0.0f, 0.0f),
+                                glm::vec3(0.0f, 1.0f, 0.0f),  glm::vec3(0.0f, -1.0f, 0.0f),
+                                glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec3(0.0f, 0.0f, -1.0f)};
+const glm::vec3 kFaceUps[6] = {glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f),
+                               glm::vec3(0.0f, 0.0f, 1.0f),  glm::vec3(0.0f, 0.0f, -1.0f),
+                               glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)};
+
+glm::vec3 upFor(const glm::vec3& direction) {
+    return std::fabs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+GLuint createDepthTexture(GLenum target, int size, int layers) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    GLStateCache::get().bindTexture(target, texture);
+    if (target == GL_TEXTURE_2D_ARRAY) {
+        glTexImage3D(target, 0, GL_DEPTH_COMPONENT32F, size, size, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT,
+                     nullptr);
+    } else {
+        glTexImage2D(target, 0, GL_DEPTH_COMPONENT32F, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    }
+    // 比较采样：线性过滤时硬件对 2x2 个比较结果做双线性插值
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(target, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    return texture;
+}
+
+GLuint createDepthFramebuffer() {
+    GLuint framebuffer = 0;
+    glGenFramebuffers(1, &framebuffer);
+    GLStateCache::get().bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    return framebuffer;
+}
+
+// 阴影 pass 打开深度测试和多边形偏移、关闭混合和剔除（背面也投射阴影），
+// 结束后按进入时的状态恢复开关、深度函数和写入、多边形偏移、视口和帧缓冲
+class ShadowPassScope {
+public:
+    ShadowPassScope() {
+        GLStateCache& cache = GLStateCache::get();
+        glGetIntegerv(GL_VIEWPORT, m_viewport);
+        m_drawFramebuffer = cache.drawFramebuffer();
+        m_readFramebuffer = cache.readFramebuffer();
+        for (int i = 0; i < kCount; ++i) m_enabled[i] = glIsEnabled(kCapabilities[i]) == GL_TRUE;
+        glGetIntegerv(GL_DEPTH_FUNC, &m_depthFunc);
+        GLboolean depthMask = GL_TRUE;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+        m_depthMask = depthMask == GL_TRUE;
+        glGetFloatv(GL_POLYGON_OFFSET_FACTOR, &m_offsetFactor);
+        glGetFloatv(GL_POLYGON_OFFSET_UNITS, &m_offsetUnits);
+        cache.enable(GL_DEPTH_TEST);
+        cache.disable(GL_BLEND);
+        cache.disable(GL_CULL_FACE);
+        cache.enable(GL_SCISSOR_TEST);
+        cache.enable(GL_POLYGON_OFFSET_FILL);
+        cache.depthFunc(GL_LESS);
+        cache.depthMask(true);
+        glPolygonOffset(2.0f, 4.0f);
+    }
+    ~ShadowPassScope() {
+        GLStateCache& cache = GLStateCache::get();
+        for (int i = 0; i < kCount; ++i) cache.setEnabled(kCapabilities[i], m_enabled[i]);
+        cache.depthFunc(static_cast<GLenum>(m_depthFunc));
+        cache.depthMask(m_depthMask);
+        glPolygonOffset(m_offsetFactor, m_offsetUnits);
+        cache.bindFramebuffer(GL_DRAW_FRAMEBUFFER, m_drawFramebuffer);
+        cache.bindFramebuffer(GL_READ_FRAMEBUFFER, m_readFramebuffer);
+        glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
+    }
+
+private:
+    static const int kCount = 6;
+    static const GLenum kCapabilities[kCount];
+    GLint m_viewport[4];
+    GLuint m_drawFramebuffer = 0;
+    GLuint m_readFramebuffer = 0;
+    GLint m_depthFunc = GL_LESS;
+    bool m_depthMask = true;
+    GLfloat m_offsetFactor = 0.0f;
+    GLfloat m_offsetUnits = 0.0f;
+    bool m_enabled[kCount];
+};
+const GLenum ShadowPassScope::kCapabilities[ShadowPassScope::kCount] = {
+    GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST, GL_POLYGON_OFFSET_FILL, GL_DEPTH_CLAMP};
+
+} // namespace
+
+ShadowMaps::ShadowMaps() {
+    for (int i = 0; i < kCascades; ++i) m_cascadeMatrices[i] = glm::mat4(1.0f);
+}
+
+ShadowMaps::~ShadowMaps() {
+    GLStateCache& cache = GLStateCache::get();
+    cache.deleteFramebuffer(m_cascadeFbo);
+    cache.deleteFramebuffer(m_atlasFbo);
+    cache.deleteTexture(m_cascadeTexture);
+    cache.deleteTexture(m_atlasTexture);
+    cache.deleteTexture(m_viewTexture);
+    cache.deleteBuffer(m_viewBuffer);
+}
+
+bool ShadowMaps::init(int cascadeSize, int atlasSize, int tileSize) {
+    if (m_ready) return true;
+    if (!GLCaps::get().versionAtLeast(3, 3)) {
+        std::cerr << "ShadowMaps: requires OpenGL 3.3" << std::endl;
+        return false;
+    }
+    if (cascadeSize <= 0 || tileSize <= 0 || atlasSize < tileSize || atlasSize % tileSize != 0) {
+        std::cerr << "ShadowMaps: atlas size " << atlasSize << " is not a multiple of tile size " << tileSize
+                  << std::endl;
+        return false;
+    }
+    m_depthShader.reset(new Shader(kDepthVS, kDepthFS, true));
+    if (!m_depthShader->isValid()) {
+        std::cerr << "ShadowMaps: shader compilation failed" << std::endl;
+        m_depthShader.reset();
+        return false;
+    }
+    m_modelLocation = glGetUniformLocation(m_depthShader->ID(), "model");
+    m_viewProjectionLocation = glGetUniformLocation(m_depthShader->ID(), "lightViewProjection");
+
+    m_cascadeSize = cascadeSize;
+    m_atlasSize = atlasSize;
+    m_tileSize = tileSize;
+    m_tilesPerRow = atlasSize / tileSize;
+    const int tileCount = m_tilesPerRow * m_tilesPerRow;
+
+    m_cascadeTexture = createDepthTexture(GL_TEXTURE_2D_ARRAY, cascadeSize, kCascades);
+    m_cascadeFbo = createDepthFramebuffer();
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_cascadeTexture, 0, 0);
+    m_atlasTexture = createDepthTexture(GL_TEXTURE_2D, atlasSize, 1);
+    m_atlasFbo = createDepthFramebuffer();
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_atlasTexture, 0);
+    const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    GLStateCache::get().bindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cerr << "ShadowMaps: shadow framebuffer incomplete" << std::endl;
+        return false;
+    }
+
+    // 图块矩阵：每个图块固定 5 个 vec4，大小在初始化时就确定
+    m_tileUsed.assign(tileCount, 0);
+    m_viewData.assign(static_cast<size_t>(tileCount) * 5, glm::vec4(0.0f));
+    glGenBuffers(1, &m_viewBuffer);
+    glGenTextures(1, &m_viewTexture);
+    GLStateCache::get().bindBuffer(GL_TEXTURE_BUFFER, m_viewBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, m_viewData.size() * sizeof(glm::vec4), m_viewData.data(), GL_DYNAMIC_DRAW);
+    GLStateCache::get().bindTexture(GL_TEXTURE_BUFFER, m_viewTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_viewBuffer);
+    m_viewDataDirty = false;
+
+    m_ready = true;
+    return true;
+}
+
+std::string ShadowMaps::shaderSource() {
+    return "#define SHADOW_CASCADES " + std::to_string(kCascades) + "\n#define SHADOW_NEAR " +
+           std::to_string(kNearPlane) + "\n" + kShadowGLSL;
+}
+
+int ShadowMaps::allocateTiles(int count) {
+    int run = 0;
+    for (int tile = 0; tile < static_cast<int>(m_tileUsed.size()); ++tile) {
+        run = m_tileUsed[tile] ? 0 : run + 1;
+        if (run == count) {
+            const int first = tile - count + 1;
+            std::fill(m_tileUsed.begin() + first, m_tileUsed.begin() + tile + 1, 1);
+            return first;
+        }
+    }
+    return -1;
+}
+
+int ShadowMaps::addCaster(const Caster& caster) {
+    size_t id = 0;
+    while (id < m_casters.size() && m_casters[id].active) ++id;
+    if (id == m_casters.size()) m_casters.push_back(caster);
+    else m_casters[id] = caster;
+    Caster& added = m_casters[id];
+    added.active = true;
+    added.firstTile = allocateTiles(added.point ? 6 : 1);
+    if (added.firstTile < 0) {
+        std::cerr << "ShadowMaps: atlas full, light " << id << " casts no shadow" << std::endl;
+    }
+    return static_cast<int>(id);
+}
+
+int ShadowMaps::addSpotLight(const SpotLight& light, bool isStatic, int interval) {
+    Caster caster;
+    caster.isStatic = isStatic;
+    caster.interval = std::max(1, interval);
+    caster.position = light.position;
+    caster.direction = glm::normalize(light.direction);
+    caster.radius = light.radius;
+    caster.outerCos = light.outerCos;
+    return addCaster(caster);
+}
+
+int ShadowMaps::addPointLight(const PointLight& light, bool isStatic, int interval) {
+    Caster caster;
+    caster.point = true;
+    caster.isStatic = isStatic;
+    caster.interval = std::max(1, interval);
+    caster.position = light.position;
+    caster.radius = light.radius;
+    return addCaster(caster);
+}
+
+void ShadowMaps::setCaster(int id, const glm::vec3& position, const glm::vec3& direction, float radius,
+                           float outerCos) {
+    if (id < 0 || id >= static_cast<int>(m_casters.size()) || !m_casters[id].active) return;
+    Caster& caster = m_casters[id];
+    if (caster.position == position && caster.direction == direction && caster.radius == radius &&
+        caster.outerCos == outerCos) {
+        return;
+    }
+    caster.position = position;
+    caster.direction = direction;
+    caster.radius = radius;
+    caster.outerCos = outerCos;
+    caster.dirty = true;
+}
+
+void ShadowMaps::setSpotLight(int id, const SpotLight& light) {
+    setCaster(id, light.position, glm::normalize(light.direction), light.radius, light.outerCos);
+}
+
+void ShadowMaps::setPointLight(int id, const PointLight& light) {
+    setCaster(id, light.position, glm::vec3(0.0f), light.radius, 0.0f);
+}
+
+void ShadowMaps::removeLight(int id) {
+    if (id < 0 || id >= static_cast<int>(m_casters.size()) || !m_casters[id].active) return;
+    Caster& caster = m_casters[id];
+    if (caster.firstTile >= 0) {
+        const int count = caster.point ? 6 : 1;
+        std::fill(m_tileUsed.begin() + caster.firstTile, m_tileUsed.begin() + caster.firstTile + count, 0);
+    }
+    caster = Caster();
+}
+
+void ShadowMaps::invalidate() {
+    for (Caster& caster : m_casters) caster.dirty = true;
+}
+
+int ShadowMaps::shadowIndex(int id) const {
+    if (id < 0 || id >= static_cast<int>(m_casters.size())) return -1;
+    const Caster& caster = m_casters[id];
+    // 还没画过的图块内容未定义
+    return caster.active && caster.lastUpdate > 0 ? caster.firstTile : -1;
+}
+
+void ShadowMaps::setModel(const glm::mat4& model) {
+    glUniformMatrix4fv(m_modelLocation, 1, GL_FALSE, glm::value_ptr(model));
+}
+
+void ShadowMaps::update(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+                        const DirectionalLight& sun, const DrawCasters& drawCasters) {
+    if (!m_ready) return;
+    ++m_frame;
+    m_stats = Stats();
+
+    ShadowPassScope scope;
+    m_depthShader->use();
+    renderCascades(view, projection, zNear, zFar, sun, drawCasters);
+
+    // 需要重画的光源：参数变了，或者非静态光源到了重画间隔。视锥外的光源暂不处理，
+    // 保持待重画状态，进入视野时再画
+    const Frustum frustum = Frustum::fromMatrix(projection * view);
+    m_pending.clear();
+    size_t withTiles = 0;
+    for (size_t i = 0; i < m_casters.size(); ++i) {
+        Caster& caster = m_casters[i];
+        if (!caster.active) continue;
+        ++m_stats.lights;
+        if (caster.firstTile < 0) caster.firstTile = allocateTiles(caster.point ? 6 : 1);
+        if (caster.firstTile < 0) continue;
+        ++withTiles;
+        const bool expired = !caster.isStatic && m_frame - caster.lastUpdate >= static_cast<uint64_t>(caster.interval);
+        if (!caster.dirty && !expired) continue;
+        if (!frustum.intersectsSphere(caster.position, caster.radius)) continue;
+        m_pending.push_back(i);
+    }
+
+    // 最久没更新的先画（从没画过的 lastUpdate 为 0，排在最前）。预算不够时推迟，
+    // 但每帧至少画一个，预算小于 6 时点光源也不会一直轮不到
+    std::sort(m_pending.begin(), m_pending.end(), [this](size_t a, size_t b) {
+        return m_casters[a].lastUpdate < m_casters[b].lastUpdate;
+    });
+    int budget = m_tileBudget;
+    for (size_t index : m_pending) {
+        Caster& caster = m_casters[index];
+        const int cost = caster.point ? 6 : 1;
+        if (cost > budget && m_stats.lightsUpdated > 0) {
+            ++m_stats.lightsDeferred;
+            continue;
+        }
+        renderCaster(caster, drawCasters);
+        budget -= cost;
+        m_stats.tilesRendered += cost;
+        ++m_stats.lightsUpdated;
+    }
+    m_stats.lightsCached = withTiles - m_stats.lightsUpdated - m_stats.lightsDeferred;
+    m_stats.tilesUsed = static_cast<size_t>(std::count(m_tileUsed.begin(), m_tileUsed.end(), 1));
+
+    if (m_viewDataDirty) {
+        GLStateCache::get().bindBuffer(GL_TEXTURE_BUFFER, m_viewBuffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, 0, m_viewData.size() * sizeof(glm::vec4), m_viewData.data());
+        m_viewDataDirty = false;
+    }
+}
+
+void ShadowMaps::renderCascades(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+                                const DirectionalLight& sun, const DrawCasters& drawCasters) {
+    GLStateCache& cache = GLStateCache::get();
+    cache.bindFramebuffer(GL_FRAMEBUFFER, m_cascadeFbo);
+    cache.enable(GL_DEPTH_CLAMP);
+    glViewport(0, 0, m_cascadeSize, m_cascadeSize);
+    glScissor(0, 0, m_cascadeSize, m_cascadeSize);
+
+    // 观察空间里距离 d 处视锥截面的半宽为 d/P[0][0]、半高为 d/P[1][1]，k2 是截面半对角线与 d 之比的平方
+    const float farDistance = std::min(zFar, m_shadowDistance);
+    const float k2 = 1.0f / (projection[0][0] * projection[0][0]) + 1.0f / (projection[1][1] * projection[1][1]);
+    const glm::mat4 inverseView = glm::inverse(view);
+    const glm::vec3 direction = glm::normalize(sun.direction);
+    const glm::vec3 up = upFor(direction);
+    const float texels = m_cascadeSize * 0.5f;
+    float splitNear = zNear;
+    for (int i = 0; i < kCascades; ++i) {
+        const float t = static_cast<float>(i + 1) / kCascades;
+        const float splitFar = kSplitLambda * zNear * std::pow(farDistance / zNear, t) +
+                               (1.0f - kSplitLambda) * (zNear + (farDistance - zNear) * t);
+
+        // 视锥段的包围球：球心在视线上，到近端和远端四个角等距，球心超出远端时取远端。
+        // 半径只取决于投影，向上取整到 1/16 后不受浮点误差影响
+        const float c = std::min(0.5f * (splitNear + splitFar) * (1.0f + k2), splitFar);
+        const float nearCorner = (c - splitNear) * (c - splitNear) + k2 * splitNear * splitNear;
+        const float farCorner = (splitFar - c) * (splitFar - c) + k2 * splitFar * splitFar;
+        const float radius = std::ceil(std::sqrt(std::max(nearCorner, farCorner)) * 16.0f) / 16.0f;
+        const glm::vec3 center = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -c, 1.0f));
+
+        // 光源方向固定时视图矩阵的旋转不变，只要把平移对齐到纹素，
+        // 相机移动时每个世界位置总是落在同一个纹素网格上
+        const glm::mat4 lightView = glm::lookAt(center - direction * radius, center, up);
+        glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
+        const glm::vec4 origin = lightProjection * lightView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        lightProjection[3][0] += (std::round(origin.x * texels) - origin.x * texels) / texels;
+        lightProjection[3][1] += (std::round(origin.y * texels) - origin.y * texels) / texels;
+        m_cascadeMatrices[i] = lightProjection * lightView;
+
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_cascadeTexture, 0, i);
+        glClear(GL_DEPTH_BUFFER_BIT);
+        glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(m_cascadeMatrices[i]));
+        drawCasters(m_cascadeMatrices[i]);
+        splitNear = splitFar;
+    }
+    cache.disable(GL_DEPTH_CLAMP);
+}
+
+void ShadowMaps::renderCaster(Caster& caster, const DrawCasters& drawCasters) {
+    GLStateCache::get().bindFramebuffer(GL_FRAMEBUFFER, m_atlasFbo);
+    // 视场角向外扩 kBorderTexels 个纹素，PCF 在图块边缘采到的仍是有效深度
+    const float border = 1.0f + 2.0f * kBorderTexels / m_tileSize;
+    const float far = std::max(caster.radius, kNearPlane * 2.0f);
+    if (caster.point) {
+        const glm::mat4 faceProjection =
+            glm::perspective(2.0f * std::atan(border), 1.0f, kNearPlane, far);
+        for (int face = 0; face < 6; ++face) {
+            const glm::mat4 faceView =
+                glm::lookAt(caster.position, caster.position + kFaceAxes[face], kFaceUps[face]);
+            renderTile(caster.firstTile + face, faceProjection * faceView, drawCasters);
+        }
+    } else {
+        const float halfAngle = std::min(std::acos(glm::clamp(caster.outerCos, 0.0f, 1.0f)), glm::radians(85.0f));
+        const glm::mat4 spotProjection =
+            glm::perspective(2.0f * std::atan(std::tan(halfAngle) * border), 1.0f, kNearPlane, far);
+        const glm::mat4 spotView =
+            glm::lookAt(caster.position, caster.position + caster.direction, upFor(caster.direction));
+        renderTile(caster.firstTile, spotProjection * spotView, drawCasters);
+    }
+    caster.dirty = false;
+    caster.lastUpdate = m_frame;
+}
+
+void ShadowMaps::renderTile(int tile, const glm::mat4& viewProjection, const DrawCasters& drawCasters) {
+    const int x = (tile % m_tilesPerRow) * m_tileSize;
+    const int y = (tile / m_tilesPerRow) * m_tileSize;
+    glViewport(x, y, m_tileSize, m_tileSize);
+    glScissor(x, y, m_tileSize, m_tileSize);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE, glm::value_ptr(viewProjection));
+    drawCasters(viewProjection);
+
+    glm::vec4* view = &m_viewData[static_cast<size_t>(tile) * 5];
+    for (int column = 0; column < 4; ++column) view[column] = viewProjection[column];
+    const float scale = static_cast<float>(m_tileSize) / m_atlasSize;
+    view[4] = glm::vec4(x / static_cast<float>(m_atlasSize), y / static_cast<float>(m_atlasSize), scale, scale);
+    m_viewDataDirty = true;
+}
+
+void ShadowMaps::bind(Shader& shader, GLuint firstUnit) const {
+    if (!m_ready) return;
+    GLStateCache& cache = GLStateCache::get();
+    for (GLuint i = 0; i < 3; ++i) cache.bindSampler(firstUnit + i, 0);
+    cache.bindTextureUnit(firstUnit, GL_TEXTURE_2D_ARRAY, m_cascadeTexture);
+    cache.bindTextureUnit(firstUnit + 1, GL_TEXTURE_2D, m_atlasTexture);
+    cache.bindTextureUnit(firstUnit + 2, GL_TEXTURE_BUFFER, m_viewTexture);
+    shader.setInt("cascadeShadowMap", static_cast<int>(firstUnit));
+    shader.setInt("shadowAtlas", static_cast<int>(firstUnit + 1));
+    shader.setInt("shadowViews", static_cast<int>(firstUnit + 2));
+    glUniformMatrix4fv(glGetUniformLocation(shader.ID(), "cascadeMatrices"), kCascades, GL_FALSE,
+                       glm::value_ptr(m_cascadeMatrices[0]));
+    glUniform2f(glGetUniformLocation(shader.ID(), "shadowTexelSizes"), 1.0f / m_cascadeSize, 1.0f / m_atlasSize);
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include "Lights.h"
+
+class Shader;
+
+// 阴影贴图
+// 平行光用 4 级级联阴影 (CSM)：视锥按对数/均匀混合分段，每段取包围球做正交投影，
+// 球半径只和投影有关，投影原点再对齐到阴影贴图的纹素，相机移动和旋转时阴影边缘不闪烁。
+// 聚光和点光源共用一张深度图集：聚光占一块，点光源的立方体六个面各占一块，
+// 着色器按主轴选面。所有阴影用比较采样器做 3x3 PCF，每个样本本身是 2x2 双线性比较。
+// 级联每帧重画；图集里的阴影按光源缓存，静态光源只在参数变化或 invalidate() 后重画，
+// 其它光源最多每 interval 帧重画一次，每帧重画的图块数不超过预算，超出的推迟到之后的帧。
+// 用法：
+//   Shader shader(vs, "#version 330 core\n" + ShadowMaps::shaderSource() + fs, true);
+//   int id = shadows.addPointLight(light);               // 之后光源移动时 setPointLight(id, light)
+//   shadows.update(view, projection, near, far, sun, [&](const glm::mat4& lightViewProjection) {
+//       for (...) { shadows.setModel(model); mesh.draw(); }
+//   });
+//   shader.use(); shadows.bind(shader, 1);
+//   glUniform1i(..., shadows.shadowIndex(id));
+// 片段着色器中（worldPos 沿法线稍微偏移可以减少自阴影）：
+//   directionalShadow(worldPos) / spotShadow(index, worldPos) / pointShadow(index, worldPos, lightPos)
+class ShadowMaps {
+public:
+    static const int kCascades = 4;
+
+    struct Stats {
+        size_t lights = 0;          // 注册的光源数
+        size_t tilesUsed = 0;       // 图集已分配的图块
+        size_t tilesRendered = 0;   // 本帧重画的图块，不含级联
+        size_t lightsUpdated = 0;
+        size_t lightsCached = 0;    // 复用缓存、本帧没有重画的
+        size_t lightsDeferred = 0;  // 需要重画但超出预算，推迟到之后的帧
+    };
+
+    // 画阴影投射物：对每个物体调用 setModel 后绘制，网格需要 Mesh::getLayout() 的顶点布局。
+    // 可以用 lightViewProjection 剔除，但级联开了深度截断，光源近平面前的物体仍然要画
+    typedef std::function<void(const glm::mat4& lightViewProjection)> DrawCasters;
+
+    ShadowMaps();
+    ~ShadowMaps();
+    ShadowMaps(const ShadowMaps&) = delete;
+    ShadowMaps& operator=(const ShadowMaps&) = delete;
+
+    // 创建级联纹理数组和图集，需要 GL 3.3 上下文；atlasSize 需要是 tileSize 的整数倍
+    bool init(int cascadeSize = 2048, int atlasSize = 4096, int tileSize = 512);
+    bool isReady() const { return m_ready; }
+
+    // 注册投射阴影的光源，返回编号；图集满时光源没有阴影，shadowIndex 为 -1
+    int addSpotLight(const SpotLight& light, bool isStatic = true, int interval = 1);
+    int addPointLight(const PointLight& light, bool isStatic = true, int interval = 1);
+    // 更新光源参数，位置、方向、半径或锥角变化时标记重画
+    void setSpotLight(int id, const SpotLight& light);
+    void setPointLight(int id, const PointLight& light);
+    void removeLight(int id);
+    // 静态几何变化后调用，所有光源重画
+    void invalidate();
+    // 着色器里 spotShadow/pointShadow 的第一个参数
+    int shadowIndex(int id) const;
+
+    // 每帧最多重画的图块数，点光源一次占 6 块
+    void setTileBudget(int tiles) { m_tileBudget = tiles; }
+    // 级联覆盖的最远视距，和相机远平面取较小值
+    void setShadowDistance(float distance) { m_shadowDistance = distance; }
+
+    // 画级联和需要更新的图块，结束后恢复帧缓冲和视口。projection 需要是对称的透视投影
+    void update(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+                const DirectionalLight& sun, const DrawCasters& drawCasters);
+    // 设置下一个投射物的模型矩阵，只在 DrawCasters 里调用
+    void setModel(const glm::mat4& model);
+
+    // 把级联、图集和图块矩阵绑定到 firstUnit 起的三个纹理单元并设置 uniform，shader 需要是当前程序
+    void bind(Shader& shader, GLuint firstUnit = 0) const;
+
+    // 片段着色器用的声明和函数，拼在 #version 之后
+    static std::string shaderSource();
+
+    GLuint cascadeTexture() const { return m_cascadeTexture; }
+    GLuint atlasTexture() const { return m_atlasTexture; }
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Caster {
+        bool active = false;
+        bool point = false;
+        bool isStatic = true;
+        int interval = 1;
+        glm::vec3 position;
+        glm::vec3 direction;
+        float radius = 0.0f;
+        float outerCos = 0.0f;
+        int firstTile = -1;
+        bool dirty = true;
+        uint64_t lastUpdate = 0;  // 0 表示还没画过
+    };
+
+    int addCaster(const Caster& caster);
+    void setCaster(int id, const glm::vec3& position, const glm::vec3& direction, float radius, float outerCos);
+    int allocateTiles(int count);
+    void renderCascades(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar,
+                        const DirectionalLight& sun, const DrawCasters& drawCasters);
+    void renderCaster(Caster& caster, const DrawCasters& drawCasters);
+    void renderTile(int tile, const glm::mat4& viewProjection, const DrawCasters& drawCasters);
+
+    bool m_ready = false;
+    int m_cascadeSize = 0;
+    int m_atlasSize = 0;
+    int m_tileSize = 0;
+    int m_tilesPerRow = 0;
+    int m_tileBudget = 8;
+    float m_shadowDistance = 60.0f;
+    uint64_t m_frame = 0;
+
+    std::unique_ptr<Shader> m_depthShader;
+    GLint m_modelLocation = -1;
+    GLint m_viewProjectionLocation = -1;
+
+    GLuint m_cascadeFbo = 0;
+    GLuint m_cascadeTexture = 0;   // DEPTH_COMPONENT32F 纹理数组，每级一层
+    GLuint m_atlasFbo = 0;
+    GLuint m_atlasTexture = 0;     // DEPTH_COMPONENT32F
+    GLuint m_viewBuffer = 0;       // 每个图块 5 个 vec4：光源视图投影矩阵 + 图集中的 uv 矩形
+    GLuint m_viewTexture = 0;
+
+    glm::mat4 m_cascadeMatrices[kCascades];
+    std::vector<Caster> m_casters;
+    std::vector<uint8_t> m_tileUsed;
+    std::vector<glm::vec4> m_viewData;
+    std::vector<size_t> m_pending;
+    bool m_viewDataDirty = true;
+    Stats m_stats;
+};
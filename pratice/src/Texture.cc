@@ -1,30 +1,325 @@
 #include "./Texture.h"
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include "Image.h"
+#include "MipChain.h"
+#include "TextureContainer.h"
+#include "GLCaps.h"
+#include "TextureBudget.h"
+#include "GLStateCache.h"
+#include <algorithm>
 #include <iostream>
+#include <vector>
+
+int Texture::channelsForFormat(GLenum format) {
+    switch (format) {
+        case GL_RED:  return 1;
+        case GL_RG:   return 2;
+        case GL_RGB:  return 3;
+        case GL_RGBA: return 4;
+        default:      return 0;
+    }
+}
+
+GLenum Texture::internalFormatFor(const Image& image, TextureRole role) {
+    static const GLenum internal8[]  = {GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+    static const GLenum internalS[]  = {GL_R8, GL_RG8, GL_SRGB8, GL_SRGB8_ALPHA8};
+    static const GLenum internal16[] = {GL_R16, GL_RG16, GL_RGB16, GL_RGBA16};
+    static const GLenum internalF[]  = {GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F};  // HDR 用半精度存储即可
+    const int c = std::min(4, std::max(1, image.channels)) - 1;
+    if (image.type == PixelType::UInt16) return internal16[c];
+    if (image.type == PixelType::Float32) return internalF[c];
+    return role == TextureRole::Color ? internalS[c] : internal8[c];
+}
+
+int Texture::levelCountFor(int width, int height, int requested) {
+    const int full = mipLevelCount(width, height);
+    return requested > 0 ? std::min(requested, full) : full;
+}
+
+void Texture::allocateStorage(GLenum target, GLenum internalFormat, int levels, int width, int height) {
+#ifdef GL_VERSION_4_2
+    const GLCaps& caps = GLCaps::get();
+    if (caps.versionAtLeast(4, 2) || caps.hasExtension("GL_ARB_texture_storage")) {
+        glTexStorage2D(target, levels, internalFormat, width, height);
+        return;
+    }
+#endif
+    // 回退：逐级分配并限制 MAX_LEVEL，效果等同于不可变存储的完整性保证
+    const bool compressed = compressedBlockBytes(internalFormat) != 0;
+    for (int level = 0; level < levels; ++level) {
+        if (compressed) {
+            const GLsizei size = static_cast<GLsizei>(compressedLevelSize(internalFormat, width, height));
+            std::vector<unsigned char> zeros(size);
+            glCompressedTexImage2D(target, level, internalFormat, width, height, 0, size, zeros.data());
+        } else {
+            // 不上传数据时只需要给出与内部格式兼容的 format/type 组合
+            const bool depth = internalFormat == GL_DEPTH_COMPONENT16 || internalFormat == GL_DEPTH_COMPONENT24 ||
+                               internalFormat == GL_DEPTH_COMPONENT32F;
+            glTexImage2D(target, level, internalFormat, width, height, 0,
+                         depth ? GL_DEPTH_COMPONENT : GL_RED, depth ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr);
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
 
 Texture::Texture(const std::string& path, GLenum format, bool flip) {
-    glGenTextures(1, &m_id);
-    glBindTexture(GL_TEXTURE_2D, m_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    if (flip) stbi_set_flip_vertically_on_load(true);
-    int width, height, nrChannels;
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-    if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+    TextureParams params;
+    params.format = format;
+    params.flip = flip;
+    load(path, params);
+}
+
+Texture::Texture(const std::string& path, const TextureParams& params) {
+    load(path, params);
+}
+
+void Texture::load(const std::string& path, const TextureParams& params) {
+    create(params);
+    setSource(path, params);
+    std::string error;
+    if (!loadSource(0, &error)) std::cerr << "Failed to load texture: " << path << " (" << error << ")" << std::endl;
+}
+
+void Texture::setSource(const std::string& path, const TextureParams& params) {
+    m_sourcePath = path;
+    m_params = params;
+}
+
+// 从来源文件解码并上传到当前纹理对象
+bool Texture::loadSource(int dropLevels, std::string* error) {
+    std::vector<unsigned char> bytes;
+    if (!readFileBytes(m_sourcePath, bytes)) {
+        if (error) *error = "cannot open file";
+        return false;
+    }
+    if (detectContainerFormat(bytes.data(), bytes.size()) != ContainerFormat::None) {
+        CompressedImage compressed;
+        if (!parseCompressedImage(bytes.data(), bytes.size(), compressed, error) ||
+            !orientCompressedImage(compressed, m_params.flip, error)) {
+            return false;
+        }
+        upload(compressed, m_params.mipLevels, dropLevels);
     } else {
-        std::cerr << "Failed to load texture: " << path << std::endl;
+        Image image;
+        if (!decodeImage(bytes.data(), bytes.size(), image, m_params.flip, channelsForFormat(m_params.format), error)) {
+            return false;
+        }
+        upload(image, m_params.mipLevels, dropLevels);
+    }
+    if (!isValid() && error) *error = "upload failed";
+    return isValid();
+}
+
+bool Texture::reload(int dropLevels) {
+    if (!isReloadable()) return false;
+    dropLevels = std::max(0, dropLevels);
+    if (dropLevels == m_droppedLevels) return true;
+    return replaceStorage([this, dropLevels]() {
+        std::string error;
+        if (loadSource(dropLevels, &error)) return true;
+        std::cerr << "Failed to reload texture: " << m_sourcePath << " (" << error << ")" << std::endl;
+        return false;
+    });
+}
+
+bool Texture::reload(const Image& image, int droppedLevels, int fullWidth, int fullHeight) {
+    if (m_handle != 0 || image.empty()) return false;
+    return replaceStorage([&]() {
+        const int requested = m_params.mipLevels > 0 ? std::max(1, m_params.mipLevels - droppedLevels) : 0;
+        upload(image, requested);
+        m_droppedLevels = droppedLevels;
+        m_fullWidth = fullWidth;
+        m_fullHeight = fullHeight;
+        return isValid();
+    });
+}
+
+bool Texture::reload(const CompressedImage& image, int dropLevels) {
+    if (m_handle != 0 || image.empty()) return false;
+    return replaceStorage([&]() {
+        upload(image, m_params.mipLevels, dropLevels);
+        return isValid();
+    });
+}
+
+// 在新的纹理对象上执行上传，成功后替换旧对象，失败时保持原状
+bool Texture::replaceStorage(const std::function<bool()>& uploadFn) {
+    const GLuint oldId = m_id;
+    const int oldWidth = m_width, oldHeight = m_height, oldLevels = m_levels, oldDropped = m_droppedLevels;
+    const int oldFullWidth = m_fullWidth, oldFullHeight = m_fullHeight;
+    const GLenum oldFormat = m_internalFormat;
+    const bool oldCompressed = m_compressed;
+    m_width = m_height = 0;
+    glGenTextures(1, &m_id);
+    if (!uploadFn()) {
+        GLStateCache::get().deleteTexture(m_id);
+        m_id = oldId;
+        m_width = oldWidth;
+        m_height = oldHeight;
+        m_levels = oldLevels;
+        m_droppedLevels = oldDropped;
+        m_fullWidth = oldFullWidth;
+        m_fullHeight = oldFullHeight;
+        m_internalFormat = oldFormat;
+        m_compressed = oldCompressed;
+        return false;
+    }
+    GLStateCache::get().deleteTexture(oldId);
+    return true;
+}
+
+Texture::Texture(const Image& image, const TextureParams& params) {
+    create(params);
+    if (!image.empty()) upload(image, params.mipLevels);
+}
+
+Texture::Texture(const CompressedImage& image, const TextureParams& params) {
+    create(params);
+    if (!image.empty()) upload(image, params.mipLevels);
+}
+
+void Texture::create(const TextureParams& params) {
+    m_params = params;
+    glGenTextures(1, &m_id);
+    setSampler(params.sampler);
+    TextureBudget::get().add(this);
+}
+
+void Texture::setSampler(const SamplerDesc& desc) {
+    if (m_handle != 0) {
+        std::cerr << "Texture: sampler is frozen once a bindless handle exists" << std::endl;
+        return;
+    }
+    m_sampler = SamplerCache::get().sampler(desc);
+}
+
+GLuint64 Texture::bindlessHandle() const {
+#ifdef GL_ARB_bindless_texture
+    if (m_handle == 0 && m_id != 0 && GLCaps::get().supportsBindlessTextures()) {
+        m_handle = glGetTextureSamplerHandleARB(m_id, m_sampler);
+    }
+#endif
+    return m_handle;
+}
+
+size_t Texture::estimateBytes(GLenum internalFormat, int width, int height, int levels) {
+    size_t texel = 4;
+    switch (internalFormat) {
+        case GL_R8:
+            texel = 1; break;
+        case GL_RG8: case GL_R16: case GL_R16F: case GL_DEPTH_COMPONENT16:
+            texel = 2; break;
+        // RGB 格式驱动通常按 4 字节 (8 位) 或 8 字节 (16 位) 对齐存储
+        case GL_RGB16: case GL_RGBA16: case GL_RGB16F: case GL_RGBA16F: case GL_RG32F:
+            texel = 8; break;
+        case GL_RGB32F: case GL_RGBA32F:
+            texel = 16; break;
+        default:
+            break;
+    }
+    const bool compressed = compressedBlockBytes(internalFormat) != 0;
+    size_t bytes = 0;
+    for (int level = 0; level < levels; ++level) {
+        bytes += compressed ? compressedLevelSize(internalFormat, width, height)
+                            : static_cast<size_t>(width) * height * texel;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
     }
-    stbi_image_free(data);
+    return bytes;
 }
+
+void Texture::upload(const Image& source, int requestedLevels, int dropLevels) {
+    static const GLenum dataFormats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+    if (source.channels < 1 || source.channels > 4) return;
+    const int c = source.channels - 1;
+
+    // 降级时在 CPU 端逐级缩小，只上传剩余的 mip
+    Image reduced;
+    int dropped = 0;
+    for (; dropped < dropLevels && (source.width >> dropped > 1 || source.height >> dropped > 1); ++dropped) {
+        reduced = downsampleImage(dropped == 0 ? source : reduced, MipFilter::Box, m_params.role == TextureRole::Color);
+    }
+    const Image& image = dropped > 0 ? reduced : source;
+    if (requestedLevels > 0) requestedLevels = std::max(1, requestedLevels - dropped);
+
+    // sRGB 纹理的 glGenerateMipmap 在线性空间滤波，采样结果与 CPU 端 MipChain 一致
+    const GLenum internalFormat = internalFormatFor(image, m_params.role);
+    GLenum type = GL_UNSIGNED_BYTE;
+    if (image.type == PixelType::UInt16) type = GL_UNSIGNED_SHORT;
+    else if (image.type == PixelType::Float32) type = GL_FLOAT;
+
+    const int levels = levelCountFor(image.width, image.height, requestedLevels);
+    GLStateCache::get().bindTexture(GL_TEXTURE_2D, m_id);
+    allocateStorage(GL_TEXTURE_2D, internalFormat, levels, image.width, image.height);
+
+    // RGB8 等行字节数不是 4 的倍数时默认对齐会错位
+    const bool unaligned = image.rowBytes() % 4 != 0;
+    if (unaligned) glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height,
+                    dataFormats[c], type, image.pixels.data());
+    if (unaligned) glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (levels > 1) glGenerateMipmap(GL_TEXTURE_2D);
+
+    m_width = image.width;
+    m_height = image.height;
+    m_levels = levels;
+    m_internalFormat = internalFormat;
+    m_compressed = false;
+    m_droppedLevels = dropped;
+    m_fullWidth = source.width;
+    m_fullHeight = source.height;
+}
+
+void Texture::upload(const CompressedImage& image, int requestedLevels, int dropLevels) {
+    if (!GLCaps::get().supportsCompressedFormat(image.internalFormat)) {
+        std::cerr << "Compressed texture format 0x" << std::hex << image.internalFormat << std::dec
+                  << " is not supported by this GL context" << std::endl;
+        return;
+    }
+    if (image.originTop == m_params.flip) {
+        // 行序和 flip 的约定相反（如 "rd" 的 KTX2 配 flip=true），翻转一份再上传
+        CompressedImage oriented = image;
+        std::string error;
+        if (!flipCompressedImage(oriented, &error)) {
+            std::cerr << "Compressed texture orientation does not match TextureParams::flip (" << error << ")"
+                      << std::endl;
+            return;
+        }
+        upload(oriented, requestedLevels, dropLevels);
+        return;
+    }
+    // 只使用文件里提供的 mip 级别，降级时直接跳过前几级
+    int levels = static_cast<int>(image.levels.size());
+    if (requestedLevels > 0) levels = std::min(levels, requestedLevels);
+    const int dropped = std::min(std::max(0, dropLevels), levels - 1);
+    levels -= dropped;
+    const CompressedImage::Level& base = image.levels[dropped];
+
+    GLStateCache::get().bindTexture(GL_TEXTURE_2D, m_id);
+    allocateStorage(GL_TEXTURE_2D, image.internalFormat, levels, base.width, base.height);
+    for (int i = 0; i < levels; ++i) {
+        const CompressedImage::Level& level = image.levels[i + dropped];
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, level.width, level.height, image.internalFormat,
+                                  static_cast<GLsizei>(level.size), image.levelData(i + dropped));
+    }
+    m_width = base.width;
+    m_height = base.height;
+    m_levels = levels;
+    m_internalFormat = image.internalFormat;
+    m_compressed = true;
+    m_droppedLevels = dropped;
+    m_fullWidth = image.width;
+    m_fullHeight = image.height;
+}
+
 Texture::~Texture() {
-    glDeleteTextures(1, &m_id);
+    TextureBudget::get().remove(this);
+    GLStateCache::get().deleteTexture(m_id);
 }
 void Texture::bind(GLuint unit) const {
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(GL_TEXTURE_2D, m_id);
-} 
\ No newline at end of file
+    TextureBudget::get().touch(this);
+    GLStateCache::get().bindTextureUnit(unit, GL_TEXTURE_2D, m_id);
+    GLStateCache::get().bindSampler(unit, m_sampler);
+}
@@ -1,13 +1,107 @@
 #pragma once
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <glad/glad.h>
+#include "SamplerCache.h"
 
+struct Image;
+struct CompressedImage;
+
+// 纹理用途：颜色类贴图（漫反射/反照率、自发光）按 sRGB 存储，采样时由硬件解码到线性空间；
+// 数据类贴图（法线、粗糙度、镜面遮罩等）本身就是线性值，按原样存储
+enum class TextureRole {
+    Color,
+    Data
+};
+
+// 纹理创建参数
+struct TextureParams {
+    GLenum format = GL_RGB;  // 解码后的通道数 (GL_RED/GL_RG/GL_RGB/GL_RGBA)
+    bool flip = true;        // 翻转在解码层逐行完成，不修改 stb 全局状态
+    int mipLevels = 0;       // 0 表示完整 mip 链，1 表示不生成 mip
+    SamplerDesc sampler;     // 默认三线性 + GL_REPEAT
+    TextureRole role = TextureRole::Color;  // 8 位 RGB/RGBA 的颜色贴图使用 GL_SRGB8(_ALPHA8)
+};
+
+// 2D 纹理
+// 存储通过 glTexStorage2D 一次性分配 (不可变)，采样状态放在共享的 sampler 对象里，
+// 不支持 ARB_texture_storage 的上下文退化为逐级 glTexImage2D + GL_TEXTURE_MAX_LEVEL。
 class Texture {
 public:
+    // .ktx2/.dds 文件按魔数识别，直接上传压缩 mip 链，此时忽略 format；
+    // 文件行序（KTXorientation）与 flip 不一致时上传前翻转，只支持 BC1-BC5，其他格式报错
     Texture(const std::string& path, GLenum format = GL_RGB, bool flip = true);
+    Texture(const std::string& path, const TextureParams& params);
+    // 从已解码的图像上传，解码可以在工作线程完成，上传必须在 GL 线程
+    explicit Texture(const Image& image, const TextureParams& params = TextureParams());
+    // 上传预压缩的 mip 链 (BC1-7 / ETC2)，不做 CPU 解码和运行时 mip 生成
+    explicit Texture(const CompressedImage& image, const TextureParams& params = TextureParams());
     ~Texture();
+    // GL 纹理对象不可拷贝，共享请使用 TextureCache 返回的句柄
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
     void bind(GLuint unit = 0) const;
+    void setSampler(const SamplerDesc& desc);
     GLuint id() const { return m_id; }
+    GLuint sampler() const { return m_sampler; }
+    bool isValid() const { return m_width > 0 && m_height > 0; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int levels() const { return m_levels; }
+    GLenum internalFormat() const { return m_internalFormat; }
+    bool isCompressed() const { return m_compressed; }
+
+    // 显存占用估算：内部格式 × 尺寸 × mip 级数
+    size_t memoryBytes() const { return estimateBytes(m_internalFormat, m_width, m_height, m_levels); }
+    static size_t estimateBytes(GLenum internalFormat, int width, int height, int levels);
+
+    // 来源文件：从路径创建的纹理自动记录，降级后可以从磁盘重新加载
+    void setSource(const std::string& path, const TextureParams& params);
+    const std::string& sourcePath() const { return m_sourcePath; }
+    bool isReloadable() const { return !m_sourcePath.empty() && m_handle == 0; }
+    // 相对完整分辨率丢弃的 mip 级数，以及完整分辨率尺寸
+    int droppedLevels() const { return m_droppedLevels; }
+    int fullWidth() const { return m_fullWidth; }
+    int fullHeight() const { return m_fullHeight; }
+    // 以丢弃最高 dropLevels 级的分辨率重建纹理，0 表示恢复完整分辨率
+    // 不可变存储无法缩小，因此会创建新的纹理对象，id() 随之改变
+    bool reload(int dropLevels);
+    // 用工作线程上已解码（并已缩小 droppedLevels 级）的图像重建，流式加载使用
+    bool reload(const Image& image, int droppedLevels, int fullWidth, int fullHeight);
+    bool reload(const CompressedImage& image, int dropLevels);
+    // 纹理+采样器的 bindless 句柄，首次调用时创建，不支持时返回 0
+    // 句柄创建后纹理和采样状态被冻结，之后不能再 setSampler
+    GLuint64 bindlessHandle() const;
+
+    static int channelsForFormat(GLenum format);
+    // 按像素类型、通道数和用途选择内部格式，sRGB 只用于 8 位 3/4 通道
+    static GLenum internalFormatFor(const Image& image, TextureRole role);
+    // 按参数计算实际 mip 级数
+    static int levelCountFor(int width, int height, int requested);
+    // 分配不可变存储（或等价的回退实现），要求纹理已绑定到 target
+    static void allocateStorage(GLenum target, GLenum internalFormat, int levels, int width, int height);
+
 private:
-    GLuint m_id;
-}; 
\ No newline at end of file
+    void load(const std::string& path, const TextureParams& params);
+    void create(const TextureParams& params);
+    bool loadSource(int dropLevels, std::string* error);
+    bool replaceStorage(const std::function<bool()>& uploadFn);
+    void upload(const Image& image, int requestedLevels, int dropLevels = 0);
+    void upload(const CompressedImage& image, int requestedLevels, int dropLevels = 0);
+
+    GLuint m_id = 0;
+    GLuint m_sampler = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_levels = 0;
+    GLenum m_internalFormat = 0;
+    bool m_compressed = false;
+    int m_droppedLevels = 0;
+    int m_fullWidth = 0;
+    int m_fullHeight = 0;
+    std::string m_sourcePath;
+    TextureParams m_params;
+    mutable GLuint64 m_handle = 0;
+};
@@ -0,0 +1,110 @@
+#include "TextureArray.h"
+#include "GLCaps.h"
+#include "GLStateCache.h"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+const GLenum kDataFormats[] = {GL_RED, GL_RG, GL_RGB, GL_RGBA};
+
+GLenum pixelTypeFor(const Image& image) {
+    if (image.type == PixelType::UInt16) return GL_UNSIGNED_SHORT;
+    if (image.type == PixelType::Float32) return GL_FLOAT;
+    return GL_UNSIGNED_BYTE;
+}
+
+} // namespace
+
+TextureArray::TextureArray(GLenum internalFormat, int width, int height, int layers,
+                           int mipLevels, const SamplerDesc& sampler)
+    : m_width(width), m_height(height), m_layers(layers),
+      m_levels(Texture::levelCountFor(width, height, mipLevels)),
+      m_internalFormat(internalFormat) {
+    glGenTextures(1, &m_id);
+    GLStateCache::get().bindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    m_sampler = SamplerCache::get().sampler(sampler);
+#ifdef GL_VERSION_4_2
+    const GLCaps& caps = GLCaps::get();
+    if (caps.versionAtLeast(4, 2) || caps.hasExtension("GL_ARB_texture_storage")) {
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, m_levels, internalFormat, width, height, layers);
+        return;
+    }
+#endif
+    int w = width, h = height;
+    for (int level = 0; level < m_levels; ++level) {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, w, h, layers, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_levels - 1);
+}
+
+TextureArray::~TextureArray() {
+    GLStateCache::get().deleteTexture(m_id);
+}
+
+bool TextureArray::uploadLayer(int layer, const Image& image) {
+    if (layer < 0 || layer >= m_layers || image.width != m_width || image.height != m_height ||
+        image.channels < 1 || image.channels > 4) {
+        std::cerr << "TextureArray: layer " << layer << " does not match array dimensions" << std::endl;
+        return false;
+    }
+    GLStateCache::get().bindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    const bool unaligned = image.rowBytes() % 4 != 0;
+    if (unaligned) glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, m_width, m_height, 1,
+                    kDataFormats[image.channels - 1], pixelTypeFor(image), image.pixels.data());
+    if (unaligned) glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    return true;
+}
+
+void TextureArray::generateMipmaps() {
+    if (m_levels <= 1) return;
+    GLStateCache::get().bindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+}
+
+void TextureArray::bind(GLuint unit) const {
+    GLStateCache::get().bindTextureUnit(unit, GL_TEXTURE_2D_ARRAY, m_id);
+    GLStateCache::get().bindSampler(unit, m_sampler);
+}
+
+TextureArrayBuilder::TextureArrayBuilder(const TextureParams& params)
+    : m_params(params) {}
+
+int TextureArrayBuilder::addLayer(const Image& image) {
+    if (image.empty()) return -1;
+    if (!m_images.empty()) {
+        const Image& first = m_images.front();
+        if (image.width != first.width || image.height != first.height ||
+            image.channels != first.channels || image.type != first.type) {
+            std::cerr << "TextureArrayBuilder: layer is " << image.width << "x" << image.height
+                      << " but array is " << first.width << "x" << first.height
+                      << "; use TextureAtlasBuilder for mixed sizes" << std::endl;
+            return -1;
+        }
+    }
+    m_images.push_back(image);
+    return static_cast<int>(m_images.size()) - 1;
+}
+
+int TextureArrayBuilder::addLayer(const std::string& path) {
+    Image image;
+    std::string error;
+    if (!loadImage(path, image, m_params.flip, Texture::channelsForFormat(m_params.format), &error)) {
+        std::cerr << "Failed to load texture: " << path << " (" << error << ")" << std::endl;
+        return -1;
+    }
+    return addLayer(image);
+}
+
+std::unique_ptr<TextureArray> TextureArrayBuilder::build() const {
+    if (m_images.empty()) return nullptr;
+    const Image& first = m_images.front();
+    std::unique_ptr<TextureArray> array(new TextureArray(Texture::internalFormatFor(first, m_params.role), first.width, first.height,
+                                                         layerCount(), m_params.mipLevels, m_params.sampler));
+    for (int layer = 0; layer < layerCount(); ++layer) array->uploadLayer(layer, m_images[layer]);
+    array->generateMipmaps();
+    return array;
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "Image.h"
+#include "Texture.h"
+
+// GL_TEXTURE_2D_ARRAY 封装
+// 同尺寸的多张贴图放进一个纹理对象的不同层，着色器用 sampler2DArray + 层号采样，
+// 多个材质可以在一次绑定下批量绘制，不再逐对象 glActiveTexture/glBindTexture。
+class TextureArray {
+public:
+    TextureArray(GLenum internalFormat, int width, int height, int layers,
+                 int mipLevels = 0, const SamplerDesc& sampler = SamplerDesc());
+    ~TextureArray();
+    TextureArray(const TextureArray&) = delete;
+    TextureArray& operator=(const TextureArray&) = delete;
+
+    // 图像尺寸必须与数组一致，通道数决定上传时的数据格式
+    bool uploadLayer(int layer, const Image& image);
+    void generateMipmaps();
+
+    void bind(GLuint unit = 0) const;
+    GLuint id() const { return m_id; }
+    GLuint sampler() const { return m_sampler; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int layers() const { return m_layers; }
+    int levels() const { return m_levels; }
+    GLenum internalFormat() const { return m_internalFormat; }
+
+private:
+    GLuint m_id = 0;
+    GLuint m_sampler = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_layers = 0;
+    int m_levels = 0;
+    GLenum m_internalFormat = 0;
+};
+
+// 收集同尺寸图像并一次性打包成 TextureArray
+class TextureArrayBuilder {
+public:
+    explicit TextureArrayBuilder(const TextureParams& params = TextureParams());
+
+    // 返回层号，尺寸或像素类型与第一张不一致时返回 -1
+    int addLayer(const Image& image);
+    int addLayer(const std::string& path);
+    int layerCount() const { return static_cast<int>(m_images.size()); }
+
+    // 没有任何层时返回空指针
+    std::unique_ptr<TextureArray> build() const;
+
+private:
+    TextureParams m_params;
+    std::vector<Image> m_images;
+};
@@ -0,0 +1,238 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+SkylinePacker::SkylinePacker(int width, int height) {
+    reset(width, height);
+}
+
+void SkylinePacker::reset(int width, int height) {
+    m_width = width;
+    m_height = height;
+    m_usedArea = 0;
+    m_skyline.clear();
+    Node root = {0, 0, width};
+    m_skyline.push_back(root);
+}
+
+// 以第 index 段为左端放置时矩形底边的高度，放不下返回 -1
+int SkylinePacker::fitAt(size_t index, int width, int height) const {
+    const int x = m_skyline[index].x;
+    if (x + width > m_width) return -1;
+    int y = 0;
+    int remaining = width;
+    for (size_t i = index; remaining > 0; ++i) {
+        if (i >= m_skyline.size()) return -1;
+        y = std::max(y, m_skyline[i].y);
+        if (y + height > m_height) return -1;
+        remaining -= m_skyline[i].width;
+    }
+    return y;
+}
+
+bool SkylinePacker::pack(int width, int height, int& outX, int& outY) {
+    if (width <= 0 || height <= 0) return false;
+    int bestTop = INT_MAX, bestWidth = INT_MAX;
+    size_t bestIndex = m_skyline.size();
+    for (size_t i = 0; i < m_skyline.size(); ++i) {
+        const int y = fitAt(i, width, height);
+        if (y < 0) continue;
+        // 顶边最低优先，相同时选更窄的段以减少浪费
+        if (y + height < bestTop || (y + height == bestTop && m_skyline[i].width < bestWidth)) {
+            bestTop = y + height;
+            bestWidth = m_skyline[i].width;
+            bestIndex = i;
+        }
+    }
+    if (bestIndex == m_skyline.size()) return false;
+
+    outX = m_skyline[bestIndex].x;
+    outY = bestTop - height;
+    addLevel(bestIndex, outX, outY, width, height);
+    m_usedArea += static_cast<long long>(width) * height;
+    return true;
+}
+
+void SkylinePacker::addLevel(size_t index, int x, int y, int width, int height) {
+    Node node = {x, y + height, width};
+    m_skyline.insert(m_skyline.begin() + index, node);
+
+    // 裁掉被新段覆盖的部分
+    for (size_t i = index + 1; i < m_skyline.size();) {
+        Node& prev = m_skyline[i - 1];
+        Node& cur = m_skyline[i];
+        if (cur.x >= prev.x + prev.width) break;
+        const int shrink = prev.x + prev.width - cur.x;
+        cur.x += shrink;
+        cur.width -= shrink;
+        if (cur.width > 0) break;
+        m_skyline.erase(m_skyline.begin() + i);
+    }
+    // 合并相邻同高的段
+    for (size_t i = 0; i + 1 < m_skyline.size();) {
+        if (m_skyline[i].y == m_skyline[i + 1].y) {
+            m_skyline[i].width += m_skyline[i + 1].width;
+            m_skyline.erase(m_skyline.begin() + i + 1);
+        } else {
+            ++i;
+        }
+    }
+}
+
+float SkylinePacker::occupancy() const {
+    const long long total = static_cast<long long>(m_width) * m_height;
+    return total > 0 ? static_cast<float>(m_usedArea) / static_cast<float>(total) : 0.0f;
+}
+
+glm::vec2 TextureAtlas::remap(int id, const glm::vec2& uv) const {
+    const glm::vec4& r = m_regions[id].uvRect;
+    return glm::vec2(uv.x * r.z + r.x, uv.y * r.w + r.y);
+}
+
+void TextureAtlas::remapUVs(int id, std::vector<glm::vec2>& uvs) const {
+    for (size_t i = 0; i < uvs.size(); ++i) uvs[i] = remap(id, uvs[i]);
+}
+
+namespace {
+
+// 统一转换为 RGBA8，灰度图复制到 RGB
+Image toRGBA8(const Image& src) {
+    Image out;
+    out.width = src.width;
+    out.height = src.height;
+    out.channels = 4;
+    out.pixels.resize(static_cast<size_t>(src.width) * src.height * 4);
+    const size_t count = static_cast<size_t>(src.width) * src.height;
+    const unsigned char* s = src.pixels.data();
+    unsigned char* d = out.pixels.data();
+    for (size_t i = 0; i < count; ++i, s += src.channels, d += 4) {
+        switch (src.channels) {
+        case 1: d[0] = d[1] = d[2] = s[0]; d[3] = 255; break;
+        case 2: d[0] = d[1] = d[2] = s[0]; d[3] = s[1]; break;
+        case 3: d[0] = s[0]; d[1] = s[1]; d[2] = s[2]; d[3] = 255; break;
+        default: std::memcpy(d, s, 4); break;
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+TextureAtlasBuilder::TextureAtlasBuilder(int maxSize, int padding)
+    : m_maxSize(maxSize), m_padding(std::max(0, padding)) {}
+
+int TextureAtlasBuilder::add(const Image& image) {
+    if (image.empty() || image.channels < 1 || image.channels > 4) return -1;
+    if (image.type != PixelType::UInt8) {
+        std::cerr << "TextureAtlasBuilder: only 8-bit images can be packed" << std::endl;
+        return -1;
+    }
+    if (image.width + 2 * m_padding > m_maxSize || image.height + 2 * m_padding > m_maxSize) {
+        std::cerr << "TextureAtlasBuilder: " << image.width << "x" << image.height
+                  << " image exceeds atlas size " << m_maxSize << std::endl;
+        return -1;
+    }
+    m_images.push_back(image.channels == 4 ? image : toRGBA8(image));
+    return static_cast<int>(m_images.size()) - 1;
+}
+
+int TextureAtlasBuilder::add(const std::string& path, bool flip) {
+    Image image;
+    std::string error;
+    if (!loadImage(path, image, flip, 4, &error)) {
+        std::cerr << "Failed to load texture: " << path << " (" << error << ")" << std::endl;
+        return -1;
+    }
+    return add(image);
+}
+
+bool TextureAtlasBuilder::packAll(int width, int height, std::vector<AtlasRegion>& regions) const {
+    // 按高度降序（再按宽度）放置，skyline 对这种顺序最友好
+    std::vector<int> order(m_images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        if (m_images[a].height != m_images[b].height) return m_images[a].height > m_images[b].height;
+        return m_images[a].width > m_images[b].width;
+    });
+
+    SkylinePacker packer(width, height);
+    regions.assign(m_images.size(), AtlasRegion());
+    for (size_t i = 0; i < order.size(); ++i) {
+        const Image& image = m_images[order[i]];
+        int x = 0, y = 0;
+        if (!packer.pack(image.width + 2 * m_padding, image.height + 2 * m_padding, x, y)) return false;
+        AtlasRegion& r = regions[order[i]];
+        r.x = x + m_padding;
+        r.y = y + m_padding;
+        r.width = image.width;
+        r.height = image.height;
+    }
+    return true;
+}
+
+bool TextureAtlasBuilder::compose(Image& atlas, std::vector<AtlasRegion>& regions) const {
+    if (m_images.empty()) return false;
+
+    // 从能容纳总面积的最小 2 的幂开始逐级放大
+    long long area = 0;
+    for (size_t i = 0; i < m_images.size(); ++i) {
+        area += static_cast<long long>(m_images[i].width + 2 * m_padding) * (m_images[i].height + 2 * m_padding);
+    }
+    int width = 64, height = 64;
+    while (width < m_maxSize && static_cast<long long>(width) * height < area) {
+        if (width == height) width *= 2; else height *= 2;
+    }
+    width = std::min(width, m_maxSize);
+    // 放不下时交替加宽、加高，比直接翻倍成正方形省一半空间
+    while (!packAll(width, height, regions)) {
+        if (width >= m_maxSize && height >= m_maxSize) {
+            std::cerr << "TextureAtlasBuilder: " << m_images.size() << " images do not fit in "
+                      << m_maxSize << "x" << m_maxSize << std::endl;
+            return false;
+        }
+        if (height < width || width >= m_maxSize) height = std::min(height * 2, m_maxSize);
+        else width = std::min(width * 2, m_maxSize);
+    }
+
+    atlas = Image();
+    atlas.width = width;
+    atlas.height = height;
+    atlas.channels = 4;
+    atlas.pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+    const float invW = 1.0f / static_cast<float>(width);
+    const float invH = 1.0f / static_cast<float>(height);
+    for (size_t i = 0; i < m_images.size(); ++i) {
+        const Image& src = m_images[i];
+        AtlasRegion& r = regions[i];
+        // 写入子图并把边缘像素外扩到 padding 区域
+        for (int y = -m_padding; y < src.height + m_padding; ++y) {
+            const int sy = std::min(std::max(y, 0), src.height - 1);
+            const unsigned char* srcRow = src.pixels.data() + static_cast<size_t>(sy) * src.width * 4;
+            unsigned char* dstRow = atlas.pixels.data() + (static_cast<size_t>(r.y + y) * width + r.x) * 4;
+            for (int x = -m_padding; x < src.width + m_padding; ++x) {
+                const int sx = std::min(std::max(x, 0), src.width - 1);
+                std::memcpy(dstRow + x * 4, srcRow + sx * 4, 4);
+            }
+        }
+        r.uvRect = glm::vec4(r.x * invW, r.y * invH, r.width * invW, r.height * invH);
+    }
+    return true;
+}
+
+std::unique_ptr<TextureAtlas> TextureAtlasBuilder::build(TextureParams params) const {
+    Image atlas;
+    std::vector<AtlasRegion> regions;
+    if (!compose(atlas, regions)) return nullptr;
+
+    if (params.mipLevels == 0) {
+        int levels = 1;
+        for (int p = m_padding; p > 1; p /= 2) ++levels;
+        params.mipLevels = levels;
+    }
+    params.format = GL_RGBA;
+    std::unique_ptr<Texture> texture(new Texture(atlas, params));
+    return std::unique_ptr<TextureAtlas>(new TextureAtlas(std::move(texture), std::move(regions)));
+}
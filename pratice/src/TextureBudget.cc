@@ -0,0 +1,112 @@
+#include "TextureBudget.h"
+#include "Texture.h"
+#include <algorithm>
+
+TextureBudget& TextureBudget::get() {
+    static TextureBudget budget;
+    return budget;
+}
+
+void TextureBudget::add(Texture* texture) {
+    m_lastUsed[texture] = m_frame;
+}
+
+void TextureBudget::remove(Texture* texture) {
+    m_lastUsed.erase(texture);
+    m_restoreRequests.erase(std::remove(m_restoreRequests.begin(), m_restoreRequests.end(), texture),
+                            m_restoreRequests.end());
+}
+
+void TextureBudget::touch(const Texture* texture) {
+    auto it = m_lastUsed.find(texture);
+    if (it == m_lastUsed.end() || it->second == m_frame) return;
+    it->second = m_frame;
+    // 不能从磁盘重新加载的纹理（流式纹理、内存图像）恢复不了，排队只会白白挤掉别的纹理；
+    // 流式纹理的细化由 TextureStreamer 负责
+    if (texture->droppedLevels() > 0 && texture->isReloadable()) {
+        // 登记时是非 const 指针，这里只是找回原来的指针
+        Texture* mutableTexture = const_cast<Texture*>(texture);
+        if (std::find(m_restoreRequests.begin(), m_restoreRequests.end(), mutableTexture) == m_restoreRequests.end()) {
+            m_restoreRequests.push_back(mutableTexture);
+        }
+    }
+}
+
+size_t TextureBudget::usedBytes() const {
+    size_t bytes = 0;
+    for (auto it = m_lastUsed.begin(); it != m_lastUsed.end(); ++it) bytes += it->first->memoryBytes();
+    return bytes;
+}
+
+TextureBudget::Stats TextureBudget::stats() const {
+    Stats s;
+    s.textures = m_lastUsed.size();
+    for (auto it = m_lastUsed.begin(); it != m_lastUsed.end(); ++it) {
+        if (it->first->droppedLevels() > 0) ++s.degraded;
+    }
+    s.evictions = m_evictions;
+    s.reloads = m_reloads;
+    return s;
+}
+
+size_t TextureBudget::degrade(Texture* texture, size_t excess) {
+    const size_t before = texture->memoryBytes();
+    // 每丢一级约释放 3/4，一次算出需要丢几级，避免反复解码
+    int drop = texture->droppedLevels();
+    int w = texture->width(), h = texture->height();
+    size_t bytes = before;
+    while (bytes > 0 && before - bytes < excess && std::min(w, h) / 2 >= m_minDimension) {
+        w /= 2;
+        h /= 2;
+        bytes /= 4;
+        ++drop;
+    }
+    if (drop == texture->droppedLevels() || !texture->reload(drop)) return 0;
+    ++m_evictions;
+    const size_t after = texture->memoryBytes();
+    return before > after ? before - after : 0;
+}
+
+void TextureBudget::evictTo(size_t target) {
+    size_t used = usedBytes();
+    if (used <= target) return;
+
+    std::vector<std::pair<uint64_t, Texture*> > candidates;
+    for (auto it = m_lastUsed.begin(); it != m_lastUsed.end(); ++it) {
+        Texture* texture = const_cast<Texture*>(it->first);
+        if (it->second + kGraceFrames <= m_frame && texture->isReloadable() &&
+            std::min(texture->width(), texture->height()) / 2 >= m_minDimension) {
+            candidates.push_back(std::make_pair(it->second, texture));
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (size_t i = 0; i < candidates.size() && used > target; ++i) {
+        used -= std::min(used, degrade(candidates[i].second, used - target));
+    }
+}
+
+void TextureBudget::update() {
+    ++m_frame;
+    if (m_cap != 0) evictTo(m_cap);
+
+    // 最近请求的优先恢复
+    int reloads = 0;
+    while (!m_restoreRequests.empty() && reloads < m_maxReloadsPerFrame) {
+        Texture* texture = m_restoreRequests.back();
+        m_restoreRequests.pop_back();
+        // 只在确实能恢复时才为它腾空间
+        if (texture->droppedLevels() == 0 || !texture->isReloadable()) continue;
+        const size_t growth = Texture::estimateBytes(texture->internalFormat(), texture->fullWidth(),
+                                                     texture->fullHeight(), texture->levels() + texture->droppedLevels()) -
+                              texture->memoryBytes();
+        if (m_cap != 0) {
+            const size_t room = m_cap > growth ? m_cap - growth : 0;
+            evictTo(room);
+            if (usedBytes() > room) continue;  // 腾不出空间，保持降级
+        }
+        if (texture->reload(0)) {
+            ++m_reloads;
+            ++reloads;
+        }
+    }
+}
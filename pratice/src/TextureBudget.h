@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+class Texture;
+
+// 全局纹理显存预算
+// 所有 Texture 创建时自动登记，bind() 时刷新最近使用帧。超出上限时按 LRU 把长期未绑定、
+// 可重新加载的纹理降到更低的 mip（重建为更小的纹理对象）；降级纹理再次被绑定后，
+// 下一次 update() 会在预算允许时从磁盘恢复完整分辨率。
+// 只能在 GL 线程上使用。
+class TextureBudget {
+public:
+    struct Stats {
+        size_t textures = 0;    // 登记的纹理数
+        size_t degraded = 0;    // 当前处于降级状态的纹理数
+        size_t evictions = 0;   // 累计降级次数
+        size_t reloads = 0;     // 累计恢复次数
+    };
+
+    static TextureBudget& get();
+
+    // 上限（字节），0 表示不限
+    void setCap(size_t bytes) { m_cap = bytes; }
+    size_t cap() const { return m_cap; }
+    // 降级时保留的最小边长
+    void setMinDimension(int pixels) { m_minDimension = pixels; }
+    // 每帧最多恢复的纹理数，恢复需要同步解码，限制它可以避免卡顿
+    void setMaxReloadsPerFrame(int count) { m_maxReloadsPerFrame = count; }
+
+    // 所有登记纹理的估算占用
+    size_t usedBytes() const;
+    Stats stats() const;
+
+    // 每帧调用一次：先按 LRU 降级到预算以内，再处理恢复请求
+    void update();
+
+    // 由 Texture 调用
+    void add(Texture* texture);
+    void remove(Texture* texture);
+    void touch(const Texture* texture);
+
+private:
+    static const int kGraceFrames = 2;  // 最近这么多帧绑定过的纹理不会被降级
+
+    TextureBudget() = default;
+    // 让 texture 降级以腾出至少 excess 字节，返回实际释放的字节数
+    size_t degrade(Texture* texture, size_t excess);
+    // 按 LRU 降级空闲纹理直到占用不超过 target
+    void evictTo(size_t target);
+
+    std::unordered_map<const Texture*, uint64_t> m_lastUsed;
+    std::vector<Texture*> m_restoreRequests;
+    size_t m_cap = 0;
+    int m_minDimension = 64;
+    int m_maxReloadsPerFrame = 2;
+    uint64_t m_frame = 0;
+    size_t m_evictions = 0;
+    size_t m_reloads = 0;
+};
@@ -0,0 +1,174 @@
+#include "TextureCache.h"
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+std::string TextureCache::canonicalPath(const std::string& path) {
+#ifndef _WIN32
+    char resolved[PATH_MAX];
+    if (realpath(path.c_str(), resolved)) return resolved;
+#endif
+    return path;
+}
+
+// FNV-1a 64 位哈希，只用于去重，不需要抗碰撞
+uint64_t TextureCache::hashBytes(const std::vector<unsigned char>& bytes) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char b : bytes) {
+        h ^= b;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+void TextureCache::decode(const std::vector<unsigned char>& bytes, GLenum format, bool flip, Decoded& out) {
+    if (detectContainerFormat(bytes.data(), bytes.size()) != ContainerFormat::None) {
+        out.compressed = parseCompressedImage(bytes.data(), bytes.size(), out.compressedImage) &&
+                         orientCompressedImage(out.compressedImage, flip);
+    } else {
+        decodeImage(bytes.data(), bytes.size(), out.image, flip, Texture::channelsForFormat(format));
+    }
+}
+
+TextureCache::Handle TextureCache::insert(const Key& key, bool hashed, uint64_t hash, const Decoded& decoded) {
+    ++m_stats.misses;
+    TextureParams params;
+    params.format = key.format;
+    params.flip = key.flip;
+    params.role = key.role;
+    Handle texture = decoded.compressed ? std::make_shared<Texture>(decoded.compressedImage, params)
+                                        : std::make_shared<Texture>(decoded.image, params);
+    if (!texture->isValid()) {
+        // 失败的结果不缓存，文件修复或出现后下次 get 会重新加载
+        std::cerr << "Failed to load texture: " << key.path << std::endl;
+        return texture;
+    }
+    // 记录来源，TextureBudget 降级后可以从磁盘恢复
+    texture->setSource(key.path, params);
+    m_textures.emplace(key, texture);
+    if (hashed) m_byContent[ContentKey{hash, key.format, key.flip, key.role}] = texture;
+    return texture;
+}
+
+TextureCache::Handle TextureCache::get(const std::string& path, GLenum format, bool flip, TextureRole role) {
+    Key key{canonicalPath(path), format, flip, role};
+    auto it = m_textures.find(key);
+    if (it != m_textures.end()) {
+        ++m_stats.hits;
+        return it->second;
+    }
+
+    // 文件只读一次：先哈希查重，未命中再从同一块内存解码
+    std::vector<unsigned char> bytes;
+    bool hashed = readFileBytes(key.path, bytes);
+    uint64_t hash = hashed ? hashBytes(bytes) : 0;
+    if (hashed) {
+        auto cit = m_byContent.find(ContentKey{hash, format, flip, role});
+        if (cit != m_byContent.end()) {
+            if (Handle shared = cit->second.lock()) {
+                ++m_stats.contentHits;
+                m_textures.emplace(key, shared);
+                return shared;
+            }
+        }
+    }
+
+    Decoded decoded;
+    if (hashed) decode(bytes, format, flip, decoded);
+    return insert(key, hashed, hash, decoded);
+}
+
+void TextureCache::preload(const std::vector<std::string>& paths, GLenum format, bool flip, TextureRole role) {
+    std::vector<std::string> pending;
+    for (const auto& path : paths) {
+        Key key{canonicalPath(path), format, flip, role};
+        if (m_textures.find(key) == m_textures.end() &&
+            std::find(pending.begin(), pending.end(), key.path) == pending.end()) {
+            pending.push_back(key.path);
+        }
+    }
+    if (pending.empty()) return;
+
+    struct Pending {
+        bool read = false;
+        uint64_t hash = 0;
+        Decoded decoded;
+    };
+    std::vector<Pending> results(pending.size());
+    unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(pending.size()));
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        std::vector<unsigned char> bytes;
+        for (size_t i = next++; i < pending.size(); i = next++) {
+            Pending& r = results[i];
+            r.read = readFileBytes(pending[i], bytes);
+            if (!r.read) continue;
+            r.hash = hashBytes(bytes);
+            decode(bytes, format, flip, r.decoded);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+
+    // GL 上传只能在当前线程进行
+    for (size_t i = 0; i < pending.size(); ++i) {
+        Key key{pending[i], format, flip, role};
+        const Pending& r = results[i];
+        if (r.read) {
+            auto cit = m_byContent.find(ContentKey{r.hash, format, flip, role});
+            if (cit != m_byContent.end()) {
+                if (Handle shared = cit->second.lock()) {
+                    ++m_stats.contentHits;
+                    m_textures.emplace(key, shared);
+                    continue;
+                }
+            }
+        }
+        insert(key, r.read, r.hash, r.decoded);
+    }
+}
+
+size_t TextureCache::evictUnused() {
+    // 同一纹理可能被多个路径键引用，先统计缓存内部持有的引用数
+    std::unordered_map<const Texture*, long> internalRefs;
+    for (const auto& entry : m_textures) ++internalRefs[entry.second.get()];
+
+    size_t released = 0;
+    for (auto it = m_textures.begin(); it != m_textures.end();) {
+        long internal = internalRefs[it->second.get()];
+        if (it->second.use_count() == internal) {
+            // 最后一个引用该纹理的键被删除时才算真正释放
+            if (--internalRefs[it->second.get()] == 0) ++released;
+            it = m_textures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = m_byContent.begin(); it != m_byContent.end();) {
+        if (it->second.expired()) it = m_byContent.erase(it);
+        else ++it;
+    }
+    m_stats.evictions += released;
+    return released;
+}
+
+void TextureCache::clear() {
+    m_textures.clear();
+    m_byContent.clear();
+}
+
+long TextureCache::refCount(const std::string& path, GLenum format, bool flip, TextureRole role) const {
+    auto it = m_textures.find(Key{canonicalPath(path), format, flip, role});
+    if (it == m_textures.end()) return 0;
+    long internal = 0;
+    for (const auto& entry : m_textures) {
+        if (entry.second == it->second) ++internal;
+    }
+    return it->second.use_count() - internal;
+}
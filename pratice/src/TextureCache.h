@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include "Texture.h"
+#include "Image.h"
+#include "TextureContainer.h"
+
+// 纹理缓存
+// 以 (规范化路径, 格式, 是否翻转, 用途) 为键，同一份纹理只加载/上传一次；
+// 另外按文件内容哈希建立索引，不同路径下内容相同的文件也会复用同一个 GL 纹理。
+// 返回的 shared_ptr 即引用计数句柄，evictUnused() 释放只被缓存自身持有的条目。
+class TextureCache {
+public:
+    using Handle = std::shared_ptr<Texture>;
+
+    struct Stats {
+        size_t hits = 0;          // 路径命中
+        size_t contentHits = 0;   // 路径未命中但内容哈希命中
+        size_t misses = 0;        // 实际加载次数
+        size_t evictions = 0;
+    };
+
+    TextureCache() = default;
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // role 决定是否按 sRGB 存储，同一文件作为颜色和数据使用时是两个不同的纹理
+    Handle get(const std::string& path, GLenum format = GL_RGB, bool flip = true,
+               TextureRole role = TextureRole::Color);
+    // 批量预加载：未命中的文件在工作线程上并行解码，随后在当前 (GL) 线程上传
+    void preload(const std::vector<std::string>& paths, GLenum format = GL_RGB, bool flip = true,
+                 TextureRole role = TextureRole::Color);
+
+    // 释放所有没有外部引用的纹理，返回释放的纹理数量
+    size_t evictUnused();
+    void clear();
+
+    size_t size() const { return m_textures.size(); }
+    // 外部持有的句柄数量（不含缓存自身）
+    long refCount(const std::string& path, GLenum format = GL_RGB, bool flip = true,
+                  TextureRole role = TextureRole::Color) const;
+    const Stats& stats() const { return m_stats; }
+
+private:
+    struct Key {
+        std::string path;
+        GLenum format;
+        bool flip;
+        TextureRole role;
+        bool operator==(const Key& o) const {
+            return format == o.format && flip == o.flip && role == o.role && path == o.path;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            size_t h = std::hash<std::string>()(k.path);
+            h ^= std::hash<unsigned>()(k.format) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h ^ (k.flip ? 0x51ed27u : 0u) ^ (k.role == TextureRole::Color ? 0x2f0b3au : 0u);
+        }
+    };
+    struct ContentKey {
+        uint64_t hash;
+        GLenum format;
+        bool flip;
+        TextureRole role;
+        bool operator==(const ContentKey& o) const {
+            return hash == o.hash && format == o.format && flip == o.flip && role == o.role;
+        }
+    };
+    struct ContentKeyHash {
+        size_t operator()(const ContentKey& k) const {
+            return static_cast<size_t>(k.hash ^ (uint64_t(k.format) << 1) ^ (k.flip ? 1u : 0u) ^
+                                       (uint64_t(k.role == TextureRole::Color) << 40));
+        }
+    };
+
+    static std::string canonicalPath(const std::string& path);
+    // 解码结果：普通图像或预压缩的 KTX2/DDS mip 链
+    struct Decoded {
+        bool compressed = false;
+        Image image;
+        CompressedImage compressedImage;
+    };
+
+    static uint64_t hashBytes(const std::vector<unsigned char>& bytes);
+    static void decode(const std::vector<unsigned char>& bytes, GLenum format, bool flip, Decoded& out);
+    Handle insert(const Key& key, bool hashed, uint64_t hash, const Decoded& decoded);
+
+    std::unordered_map<Key, Handle, KeyHash> m_textures;
+    std::unordered_map<ContentKey, std::weak_ptr<Texture>, ContentKeyHash> m_byContent;
+    Stats m_stats;
+};
@@ -0,0 +1,544 @@
+#include "TextureContainer.h"
+#include "Image.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+const unsigned char kKTX2Identifier[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+uint32_t readU32(const unsigned char* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint64_t readU64(const unsigned char* p) {
+    return uint64_t(readU32(p)) | (uint64_t(readU32(p + 4)) << 32);
+}
+
+uint32_t fourCC(const char* s) {
+    return uint32_t(uint8_t(s[0])) | (uint32_t(uint8_t(s[1])) << 8) |
+           (uint32_t(uint8_t(s[2])) << 16) | (uint32_t(uint8_t(s[3])) << 24);
+}
+
+bool fail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return false;
+}
+
+// VkFormat 与 GL 内部格式对照表
+struct FormatPair {
+    uint32_t vk;
+    GLenum gl;
+};
+const FormatPair kFormatTable[] = {
+    {131, GL_COMPRESSED_RGB_S3TC_DXT1_EXT},          // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+    {132, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT},         // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+    {133, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT},         // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+    {134, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT},   // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+    {135, GL_COMPRESSED_RGBA_S3TC_DXT3_EXT},         // VK_FORMAT_BC2_UNORM_BLOCK
+    {136, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT},   // VK_FORMAT_BC2_SRGB_BLOCK
+    {137, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT},         // VK_FORMAT_BC3_UNORM_BLOCK
+    {138, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT},   // VK_FORMAT_BC3_SRGB_BLOCK
+    {139, GL_COMPRESSED_RED_RGTC1},                  // VK_FORMAT_BC4_UNORM_BLOCK
+    {140, GL_COMPRESSED_SIGNED_RED_RGTC1},           // VK_FORMAT_BC4_SNORM_BLOCK
+    {141, GL_COMPRESSED_RG_RGTC2},                   // VK_FORMAT_BC5_UNORM_BLOCK
+    {142, GL_COMPRESSED_SIGNED_RG_RGTC2},            // VK_FORMAT_BC5_SNORM_BLOCK
+    {143, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT},    // VK_FORMAT_BC6H_UFLOAT_BLOCK
+    {144, GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT},      // VK_FORMAT_BC6H_SFLOAT_BLOCK
+    {145, GL_COMPRESSED_RGBA_BPTC_UNORM},            // VK_FORMAT_BC7_UNORM_BLOCK
+    {146, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM},      // VK_FORMAT_BC7_SRGB_BLOCK
+    {147, GL_COMPRESSED_RGB8_ETC2},                  // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+    {148, GL_COMPRESSED_SRGB8_ETC2},                 // VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+    {149, GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2},
+    {150, GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2},
+    {151, GL_COMPRESSED_RGBA8_ETC2_EAC},
+    {152, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC},
+};
+
+// DDS DX10 扩展头中的 DXGI_FORMAT
+GLenum glFormatFromDXGI(uint32_t dxgi) {
+    switch (dxgi) {
+        case 71: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;        // BC1_UNORM
+        case 72: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;  // BC1_UNORM_SRGB
+        case 74: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;        // BC2_UNORM
+        case 75: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;  // BC2_UNORM_SRGB
+        case 77: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;        // BC3_UNORM
+        case 78: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;  // BC3_UNORM_SRGB
+        case 80: return GL_COMPRESSED_RED_RGTC1;                 // BC4_UNORM
+        case 81: return GL_COMPRESSED_SIGNED_RED_RGTC1;          // BC4_SNORM
+        case 83: return GL_COMPRESSED_RG_RGTC2;                  // BC5_UNORM
+        case 84: return GL_COMPRESSED_SIGNED_RG_RGTC2;           // BC5_SNORM
+        case 95: return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;   // BC6H_UF16
+        case 96: return GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT;     // BC6H_SF16
+        case 98: return GL_COMPRESSED_RGBA_BPTC_UNORM;           // BC7_UNORM
+        case 99: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;     // BC7_UNORM_SRGB
+        default: return 0;
+    }
+}
+
+// 校验每级 mip 的尺寸并把数据拷进 out.data
+bool appendLevel(CompressedImage& out, const unsigned char* src, size_t available,
+                 int width, int height, std::string* error) {
+    size_t size = compressedLevelSize(out.internalFormat, width, height);
+    if (size == 0 || size > available) return fail(error, "mip level data truncated");
+    CompressedImage::Level level{width, height, out.data.size(), size};
+    out.data.insert(out.data.end(), src, src + size);
+    out.levels.push_back(level);
+    return true;
+}
+
+void writeU32(std::vector<unsigned char>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+}
+
+void writeU64(std::vector<unsigned char>& out, uint64_t v) {
+    writeU32(out, static_cast<uint32_t>(v));
+    writeU32(out, static_cast<uint32_t>(v >> 32));
+}
+
+void patchU32(std::vector<unsigned char>& out, size_t at, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out[at + i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+void patchU64(std::vector<unsigned char>& out, size_t at, uint64_t v) {
+    patchU32(out, at, static_cast<uint32_t>(v));
+    patchU32(out, at + 4, static_cast<uint32_t>(v >> 32));
+}
+
+void padTo(std::vector<unsigned char>& out, size_t alignment) {
+    while (out.size() % alignment) out.push_back(0);
+}
+
+// Khronos Data Format 基本描述块，块压缩格式每个样本覆盖整个 4x4 块
+void appendDFD(std::vector<unsigned char>& out, GLenum internalFormat) {
+    struct Sample {
+        uint32_t bitOffset, bitLength, channel;
+    };
+    const uint32_t KHR_DF_CHANNEL_ALPHA = 15;
+    uint32_t model = 0;
+    std::vector<Sample> samples;
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+            model = 128; samples = {{0, 64, 0}}; break;                                    // BC1A, 不透明
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            model = 128; samples = {{0, 64, 1}}; break;                                    // BC1A, 带 1 位 alpha
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+            model = 129; samples = {{0, 64, KHR_DF_CHANNEL_ALPHA}, {64, 64, 0}}; break;    // BC2
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            model = 130; samples = {{0, 64, KHR_DF_CHANNEL_ALPHA}, {64, 64, 0}}; break;    // BC3
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+            model = 131; samples = {{0, 64, 0}}; break;                                    // BC4
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_SIGNED_RG_RGTC2:
+            model = 132; samples = {{0, 64, 0}, {64, 64, 1}}; break;                       // BC5
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+            model = 133; samples = {{0, 128, 0}}; break;                                   // BC6H
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+            model = 134; samples = {{0, 128, 0}}; break;                                   // BC7
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+            model = 161; samples = {{0, 64, KHR_DF_CHANNEL_ALPHA}, {64, 64, 2}}; break;    // ETC2 + EAC alpha
+        default:
+            model = 161; samples = {{0, 64, 2}}; break;                                    // ETC2 RGB
+    }
+
+    const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+    writeU32(out, 4 + blockSize);                 // dfdTotalSize
+    writeU32(out, 0);                             // vendorId = KHR, descriptorType = basic
+    writeU32(out, 2u | (blockSize << 16));        // versionNumber = 2
+    const uint32_t primaries = 1;                 // BT.709
+    const uint32_t transfer = isSRGBCompressedFormat(internalFormat) ? 2u : 1u;
+    writeU32(out, model | (primaries << 8) | (transfer << 16));
+    writeU32(out, 3u | (3u << 8));                // 4x4x1x1 块 (存储值为尺寸 - 1)
+    writeU32(out, static_cast<uint32_t>(compressedBlockBytes(internalFormat)));
+    writeU32(out, 0);
+    for (const Sample& sample : samples) {
+        writeU32(out, sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+        writeU32(out, 0);                         // samplePosition
+        writeU32(out, 0);                         // sampleLower
+        writeU32(out, 0xFFFFFFFFu);               // sampleUpper
+    }
+}
+
+void appendKeyValue(std::vector<unsigned char>& out, const std::string& key, const std::string& value) {
+    const uint32_t length = static_cast<uint32_t>(key.size() + 1 + value.size() + 1);
+    writeU32(out, length);
+    out.insert(out.end(), key.begin(), key.end());
+    out.push_back(0);
+    out.insert(out.end(), value.begin(), value.end());
+    out.push_back(0);
+    padTo(out, 4);
+}
+
+// 以下在 4x4 块内上下翻转前 rows 行（这一级不足 4 行时只有前几行有效）
+
+// BC1 颜色块：两个端点 4 字节，之后每行一个字节的 2 位索引
+void flipBC1Block(unsigned char* block, int rows) {
+    std::reverse(block + 4, block + 4 + rows);
+}
+
+// BC2 显式 alpha：每行 16 位
+void flipBC2AlphaBlock(unsigned char* block, int rows) {
+    for (int r = 0; r < rows / 2; ++r) std::swap_ranges(block + 2 * r, block + 2 * r + 2, block + 2 * (rows - 1 - r));
+}
+
+// BC4 块（BC3 的 alpha、BC5 的每个通道）：两个端点之后是 48 位小端索引，每行 12 位
+void flipBC4Block(unsigned char* block, int rows) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) bits |= uint64_t(block[2 + i]) << (8 * i);
+    uint64_t flipped = bits;
+    for (int r = 0; r < rows; ++r) {
+        const int to = 12 * (rows - 1 - r);
+        flipped = (flipped & ~(uint64_t(0xFFF) << to)) | (((bits >> (12 * r)) & 0xFFF) << to);
+    }
+    for (int i = 0; i < 6; ++i) block[2 + i] = static_cast<unsigned char>(flipped >> (8 * i));
+}
+
+} // namespace
+
+int compressedBlockBytes(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+            return 8;
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_SIGNED_RG_RGTC2:
+        case GL_COMPRESSED_RGBA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        case GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT:
+        case GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT:
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+bool isSRGBCompressedFormat(GLenum internalFormat) {
+    switch (internalFormat) {
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM:
+        case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+            return true;
+        default:
+            return false;
+    }
+}
+
+size_t compressedLevelSize(GLenum internalFormat, int width, int height) {
+    size_t blockBytes = static_cast<size_t>(compressedBlockBytes(internalFormat));
+    size_t blocksX = static_cast<size_t>(std::max(1, (width + 3) / 4));
+    size_t blocksY = static_cast<size_t>(std::max(1, (height + 3) / 4));
+    return blocksX * blocksY * blockBytes;
+}
+
+GLenum glFormatFromVkFormat(uint32_t vkFormat) {
+    for (const FormatPair& pair : kFormatTable) {
+        if (pair.vk == vkFormat) return pair.gl;
+    }
+    return 0;
+}
+
+uint32_t vkFormatFromGLFormat(GLenum internalFormat) {
+    for (const FormatPair& pair : kFormatTable) {
+        if (pair.gl == internalFormat) return pair.vk;
+    }
+    return 0;
+}
+
+ContainerFormat detectContainerFormat(const unsigned char* data, size_t size) {
+    if (size >= sizeof(kKTX2Identifier) && std::memcmp(data, kKTX2Identifier, sizeof(kKTX2Identifier)) == 0)
+        return ContainerFormat::KTX2;
+    if (size >= 4 && std::memcmp(data, "DDS ", 4) == 0)
+        return ContainerFormat::DDS;
+    return ContainerFormat::None;
+}
+
+bool parseKTX2(const unsigned char* data, size_t size, CompressedImage& out, std::string* error) {
+    out = CompressedImage();
+    // 标识符 12 字节 + 头部 9 个 uint32 + 索引 (4 个 uint32 + 2 个 uint64)
+    const size_t headerSize = 12 + 9 * 4 + 4 * 4 + 2 * 8;
+    if (size < headerSize || detectContainerFormat(data, size) != ContainerFormat::KTX2)
+        return fail(error, "not a KTX2 file");
+
+    const unsigned char* h = data + 12;
+    uint32_t vkFormat        = readU32(h + 0);
+    uint32_t pixelWidth      = readU32(h + 8);
+    uint32_t pixelHeight     = readU32(h + 12);
+    uint32_t pixelDepth      = readU32(h + 16);
+    uint32_t layerCount      = readU32(h + 20);
+    uint32_t faceCount       = readU32(h + 24);
+    uint32_t levelCount      = readU32(h + 28);
+    uint32_t supercompession = readU32(h + 32);
+    uint32_t kvdOffset       = readU32(h + 44);
+    uint32_t kvdLength       = readU32(h + 48);
+
+    if (supercompession != 0) return fail(error, "supercompressed KTX2 (BasisLZ/Zstd) is not supported");
+    if (pixelDepth > 1 || layerCount > 1 || faceCount != 1) return fail(error, "only 2D KTX2 textures are supported");
+    if (pixelWidth == 0 || pixelHeight == 0) return fail(error, "invalid KTX2 dimensions");
+
+    out.internalFormat = glFormatFromVkFormat(vkFormat);
+    if (out.internalFormat == 0) return fail(error, "unsupported KTX2 vkFormat (block-compressed formats only)");
+    out.blockBytes = compressedBlockBytes(out.internalFormat);
+    out.width = static_cast<int>(pixelWidth);
+    out.height = static_cast<int>(pixelHeight);
+
+    // KTXorientation 键：默认 "rd" (第一行在上)，"ru" 表示已按 OpenGL 约定从底部开始
+    if (kvdLength > 0 && size_t(kvdOffset) + kvdLength <= size) {
+        const unsigned char* p = data + kvdOffset;
+        const unsigned char* end = p + kvdLength;
+        while (p + 4 <= end) {
+            uint32_t entryLength = readU32(p);
+            const char* entry = reinterpret_cast<const char*>(p + 4);
+            if (p + 4 + entryLength > end) break;
+            std::string key(entry, strnlen(entry, entryLength));
+            if (key == "KTXorientation" && entryLength > key.size() + 2) {
+                out.originTop = entry[key.size() + 2] != 'u';
+            }
+            p += 4 + ((entryLength + 3) & ~3u);
+        }
+    }
+
+    if (levelCount == 0) levelCount = 1;
+    const unsigned char* levelIndex = data + headerSize;
+    if (size < headerSize + size_t(levelCount) * 24) return fail(error, "KTX2 level index truncated");
+
+    int width = out.width, height = out.height;
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        uint64_t offset = readU64(levelIndex + i * 24);
+        uint64_t length = readU64(levelIndex + i * 24 + 8);
+        if (offset > size || length > size - offset) return fail(error, "KTX2 level out of range");
+        if (!appendLevel(out, data + offset, static_cast<size_t>(length), width, height, error)) return false;
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    return true;
+}
+
+bool parseDDS(const unsigned char* data, size_t size, CompressedImage& out, std::string* error) {
+    out = CompressedImage();
+    // 魔数 4 字节 + DDS_HEADER 124 字节
+    if (size < 128 || detectContainerFormat(data, size) != ContainerFormat::DDS)
+        return fail(error, "not a DDS file");
+
+    const unsigned char* h = data + 4;
+    if (readU32(h) != 124) return fail(error, "invalid DDS header size");
+    const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    const uint32_t DDPF_FOURCC = 0x4;
+    uint32_t flags       = readU32(h + 4);
+    uint32_t height      = readU32(h + 8);
+    uint32_t width       = readU32(h + 12);
+    uint32_t mipCount    = readU32(h + 24);
+    const unsigned char* pf = h + 72;  // DDS_PIXELFORMAT
+    uint32_t pfFlags     = readU32(pf + 4);
+    uint32_t pfFourCC    = readU32(pf + 8);
+
+    if (!(pfFlags & DDPF_FOURCC)) return fail(error, "uncompressed DDS is not supported");
+
+    size_t dataOffset = 128;
+    if (pfFourCC == fourCC("DXT1")) out.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    else if (pfFourCC == fourCC("DXT3")) out.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+    else if (pfFourCC == fourCC("DXT5")) out.internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    else if (pfFourCC == fourCC("ATI1") || pfFourCC == fourCC("BC4U")) out.internalFormat = GL_COMPRESSED_RED_RGTC1;
+    else if (pfFourCC == fourCC("BC4S")) out.internalFormat = GL_COMPRESSED_SIGNED_RED_RGTC1;
+    else if (pfFourCC == fourCC("ATI2") || pfFourCC == fourCC("BC5U")) out.internalFormat = GL_COMPRESSED_RG_RGTC2;
+    else if (pfFourCC == fourCC("BC5S")) out.internalFormat = GL_COMPRESSED_SIGNED_RG_RGTC2;
+    else if (pfFourCC == fourCC("DX10")) {
+        if (size < 148) return fail(error, "DDS DX10 header truncated");
+        const unsigned char* dx10 = data + 128;
+        uint32_t dxgiFormat = readU32(dx10);
+        uint32_t dimension = readU32(dx10 + 4);
+        uint32_t miscFlag = readU32(dx10 + 8);
+        if (dimension != 3 || (miscFlag & 0x4)) return fail(error, "only 2D DDS textures are supported");
+        out.internalFormat = glFormatFromDXGI(dxgiFormat);
+        dataOffset = 148;
+    }
+    if (out.internalFormat == 0) return fail(error, "unsupported DDS pixel format");
+
+    out.blockBytes = compressedBlockBytes(out.internalFormat);
+    out.width = static_cast<int>(width);
+    out.height = static_cast<int>(height);
+    if (out.width == 0 || out.height == 0) return fail(error, "invalid DDS dimensions");
+
+    uint32_t levels = (flags & DDSD_MIPMAPCOUNT) ? std::max(1u, mipCount) : 1u;
+    size_t offset = dataOffset;
+    int w = out.width, hgt = out.height;
+    for (uint32_t i = 0; i < levels; ++i) {
+        if (!appendLevel(out, data + offset, size - offset, w, hgt, error)) return false;
+        offset += out.levels.back().size;
+        w = std::max(1, w / 2);
+        hgt = std::max(1, hgt / 2);
+    }
+    return true;
+}
+
+bool parseCompressedImage(const unsigned char* data, size_t size, CompressedImage& out, std::string* error) {
+    switch (detectContainerFormat(data, size)) {
+        case ContainerFormat::KTX2: return parseKTX2(data, size, out, error);
+        case ContainerFormat::DDS:  return parseDDS(data, size, out, error);
+        default:                    return fail(error, "unknown texture container");
+    }
+}
+
+bool loadCompressedImage(const std::string& path, CompressedImage& out, std::string* error) {
+    std::vector<unsigned char> bytes;
+    if (!readFileBytes(path, bytes)) return fail(error, "cannot open file");
+    return parseCompressedImage(bytes.data(), bytes.size(), out, error);
+}
+
+bool encodeKTX2(const CompressedImage& image, std::vector<unsigned char>& out,
+                const std::string& writer, std::string* error) {
+    out.clear();
+    const uint32_t vkFormat = vkFormatFromGLFormat(image.internalFormat);
+    if (vkFormat == 0 || image.empty()) return fail(error, "nothing to write or format has no VkFormat");
+    const uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+
+    out.insert(out.end(), kKTX2Identifier, kKTX2Identifier + sizeof(kKTX2Identifier));
+    writeU32(out, vkFormat);
+    writeU32(out, 1);                                        // typeSize
+    writeU32(out, static_cast<uint32_t>(image.width));
+    writeU32(out, static_cast<uint32_t>(image.height));
+    writeU32(out, 0);                                        // pixelDepth
+    writeU32(out, 0);                                        // layerCount
+    writeU32(out, 1);                                        // faceCount
+    writeU32(out, levelCount);
+    writeU32(out, 0);                                        // supercompressionScheme
+    const size_t indexAt = out.size();
+    for (int i = 0; i < 4; ++i) writeU32(out, 0);            // dfd / kvd 偏移与长度，稍后回填
+    writeU64(out, 0);                                        // sgdByteOffset
+    writeU64(out, 0);                                        // sgdByteLength
+    const size_t levelIndexAt = out.size();
+    for (uint32_t i = 0; i < levelCount * 3; ++i) writeU64(out, 0);
+
+    const size_t dfdOffset = out.size();
+    appendDFD(out, image.internalFormat);
+    const size_t kvdOffset = out.size();
+    // 键按字节序排列
+    appendKeyValue(out, "KTXorientation", image.originTop ? "rd" : "ru");
+    if (!writer.empty()) appendKeyValue(out, "KTXwriter", writer);
+    const size_t kvdLength = out.size() - kvdOffset;
+    patchU32(out, indexAt + 0, static_cast<uint32_t>(dfdOffset));
+    patchU32(out, indexAt + 4, static_cast<uint32_t>(kvdOffset - dfdOffset));
+    patchU32(out, indexAt + 8, static_cast<uint32_t>(kvdOffset));
+    patchU32(out, indexAt + 12, static_cast<uint32_t>(kvdLength));
+
+    // 规范要求从最小的 mip 开始存放，每级按块大小对齐
+    const size_t alignment = static_cast<size_t>(std::max(4, image.blockBytes ? image.blockBytes
+                                                                : compressedBlockBytes(image.internalFormat)));
+    for (uint32_t i = levelCount; i-- > 0;) {
+        padTo(out, alignment);
+        const CompressedImage::Level& level = image.levels[i];
+        const size_t at = levelIndexAt + size_t(i) * 24;
+        patchU64(out, at, out.size());
+        patchU64(out, at + 8, level.size);
+        patchU64(out, at + 16, level.size);
+        const unsigned char* src = image.levelData(i);
+        out.insert(out.end(), src, src + level.size);
+    }
+    return true;
+}
+
+bool writeKTX2(const std::string& path, const CompressedImage& image,
+               const std::string& writer, std::string* error) {
+    std::vector<unsigned char> bytes;
+    if (!encodeKTX2(image, bytes, writer, error)) return false;
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) return fail(error, "cannot open output file");
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file.good() || fail(error, "write failed");
+}
+
+bool flipCompressedImage(CompressedImage& image, std::string* error) {
+    // BC6H/BC7/ETC2 的分区和子块布局依赖模式，不能简单按行重排
+    enum class Layout { BC1, BC2, BC3, BC4, BC5 } layout;
+    switch (image.internalFormat) {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_S3TC_DXT1_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT:
+            layout = Layout::BC1;
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT:
+            layout = Layout::BC2;
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        case GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT:
+            layout = Layout::BC3;
+            break;
+        case GL_COMPRESSED_RED_RGTC1:
+        case GL_COMPRESSED_SIGNED_RED_RGTC1:
+            layout = Layout::BC4;
+            break;
+        case GL_COMPRESSED_RG_RGTC2:
+        case GL_COMPRESSED_SIGNED_RG_RGTC2:
+            layout = Layout::BC5;
+            break;
+        default:
+            return fail(error, "vertical flip is only supported for BC1-BC5; bake the file with the orientation "
+                               "the loader expects");
+    }
+    // 高度不是 4 的倍数时翻转后有效行落在块的下半部分，无法按块对齐
+    for (const CompressedImage::Level& level : image.levels) {
+        if (level.height > 4 && level.height % 4 != 0) {
+            return fail(error, "vertical flip needs mip heights that are multiples of 4");
+        }
+    }
+
+    const size_t blockBytes = static_cast<size_t>(image.blockBytes);
+    for (const CompressedImage::Level& level : image.levels) {
+        const int blocksX = std::max(1, (level.width + 3) / 4);
+        const int blocksY = std::max(1, (level.height + 3) / 4);
+        const int rows = std::min(4, level.height);
+        const size_t rowBytes = blocksX * blockBytes;
+        unsigned char* data = image.data.data() + level.offset;
+        for (int y = 0; y < blocksY / 2; ++y) {
+            std::swap_ranges(data + y * rowBytes, data + (y + 1) * rowBytes, data + (blocksY - 1 - y) * rowBytes);
+        }
+        for (size_t i = 0; i < level.size / blockBytes; ++i) {
+            unsigned char* block = data + i * blockBytes;
+            switch (layout) {
+                case Layout::BC1: flipBC1Block(block, rows); break;
+                case Layout::BC2: flipBC2AlphaBlock(block, rows); flipBC1Block(block + 8, rows); break;
+                case Layout::BC3: flipBC4Block(block, rows); flipBC1Block(block + 8, rows); break;
+                case Layout::BC4: flipBC4Block(block, rows); break;
+                case Layout::BC5: flipBC4Block(block, rows); flipBC4Block(block + 8, rows); break;
+            }
+        }
+    }
+    image.originTop = !image.originTop;
+    return true;
+}
+
+bool orientCompressedImage(CompressedImage& image, bool flip, std::string* error) {
+    if (image.originTop != flip) return true;
+    return flipCompressedImage(image, error);
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+
+// GPU 压缩纹理容器 (KTX2 / DDS) 解析
+// 只负责把文件拆成每级 mip 的压缩数据块，上传由 Texture 通过 glCompressedTexImage2D 完成，
+// 不做任何 CPU 解码，也不在运行时生成 mip。
+
+// 部分 GLAD 配置不会生成扩展常量，这里按规范值补齐
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT        0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT       0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT       0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT       0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT       0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT 0x8C4E
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM          0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM    0x8E8D
+#define GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT    0x8E8E
+#define GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT  0x8E8F
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2                      0x9274
+#define GL_COMPRESSED_SRGB8_ETC2                     0x9275
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2  0x9276
+#define GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9277
+#define GL_COMPRESSED_RGBA8_ETC2_EAC                 0x9278
+#define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC          0x9279
+#endif
+
+enum class ContainerFormat {
+    None,
+    KTX2,
+    DDS
+};
+
+struct CompressedImage {
+    struct Level {
+        int width;
+        int height;
+        size_t offset;   // 在 data 中的偏移
+        size_t size;
+    };
+
+    GLenum internalFormat = 0;
+    int width = 0;
+    int height = 0;
+    int blockBytes = 0;     // 每个 4x4 块的字节数 (8 或 16)
+    bool originTop = true;  // 数据第一行是否为图像顶部 (DDS 和默认 KTX2 都是)
+    std::vector<Level> levels;
+    std::vector<unsigned char> data;
+
+    bool empty() const { return levels.empty(); }
+    const unsigned char* levelData(size_t level) const { return data.data() + levels[level].offset; }
+    size_t totalBytes() const { return data.size(); }
+};
+
+ContainerFormat detectContainerFormat(const unsigned char* data, size_t size);
+
+bool parseKTX2(const unsigned char* data, size_t size, CompressedImage& out, std::string* error = nullptr);
+bool parseDDS(const unsigned char* data, size_t size, CompressedImage& out, std::string* error = nullptr);
+// 根据魔数自动选择 KTX2 或 DDS
+bool parseCompressedImage(const unsigned char* data, size_t size, CompressedImage& out, std::string* error = nullptr);
+bool loadCompressedImage(const std::string& path, CompressedImage& out, std::string* error = nullptr);
+
+// 写出无超压缩的 2D KTX2 文件，originTop 为 false 时写入 KTXorientation = "ru"
+bool encodeKTX2(const CompressedImage& image, std::vector<unsigned char>& out,
+                const std::string& writer = "", std::string* error = nullptr);
+bool writeKTX2(const std::string& path, const CompressedImage& image,
+               const std::string& writer = "", std::string* error = nullptr);
+
+// 上下翻转所有 mip 级：交换块行并翻转块内的行，originTop 取反。
+// 只支持 BC1-BC5，且高度超过 4 的级别必须是 4 的倍数，否则返回 false 并保持不变
+bool flipCompressedImage(CompressedImage& image, std::string* error = nullptr);
+// 让行序符合 TextureParams::flip 的约定：flip 为 true 时第一行是图像底部（与 stb 路径一致），
+// 需要时调用 flipCompressedImage
+bool orientCompressedImage(CompressedImage& image, bool flip, std::string* error = nullptr);
+
+// 压缩格式的块大小，非块压缩格式返回 0
+int compressedBlockBytes(GLenum internalFormat);
+bool isSRGBCompressedFormat(GLenum internalFormat);
+// 一级 mip 的数据大小
+size_t compressedLevelSize(GLenum internalFormat, int width, int height);
+
+// KTX2 使用的 VkFormat 与 GL 内部格式互相转换
+GLenum glFormatFromVkFormat(uint32_t vkFormat);
+uint32_t vkFormatFromGLFormat(GLenum internalFormat);
@@ -0,0 +1,288 @@
+#include "TextureStreamer.h"
+#include "MipChain.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+TextureStreamer::TextureStreamer(unsigned threadCount) : m_inFlight(0) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threadCount; ++i) {
+        m_workers.push_back(std::thread(&TextureStreamer::workerLoop, this));
+    }
+}
+
+TextureStreamer::~TextureStreamer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (size_t i = 0; i < m_workers.size(); ++i) m_workers[i].join();
+}
+
+TextureStreamer::Handle TextureStreamer::load(const std::string& path, const TextureParams& params) {
+    // 1x1 中灰占位，解码完成前也可以正常绑定
+    Image placeholder;
+    placeholder.width = placeholder.height = 1;
+    placeholder.channels = std::max(1, Texture::channelsForFormat(params.format));
+    placeholder.pixels.assign(placeholder.channels, 128);
+
+    Record record;
+    record.texture = std::make_shared<Texture>(placeholder, params);
+    record.path = path;
+    record.params = params;
+    record.lastRequested = m_frame;
+    const size_t index = m_records.size();
+    m_index[record.texture.get()] = index;
+    m_records.push_back(record);
+
+    Job job = {index, path, params, -1, m_coarseSize, nullptr};
+    m_records[index].pending = true;
+    ++m_inFlight;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_initialJobs.push_back(job);
+    }
+    m_cv.notify_one();
+    return m_records[index].texture;
+}
+
+TextureStreamer::Record* TextureStreamer::find(const Handle& texture) {
+    auto it = m_index.find(texture.get());
+    return it != m_index.end() ? &m_records[it->second] : nullptr;
+}
+
+void TextureStreamer::request(const Handle& texture, int mipLevel) {
+    Record* record = find(texture);
+    if (!record) return;
+    mipLevel = std::max(0, mipLevel);
+    record->requestedDrop = record->requestedDrop < 0 ? mipLevel : std::min(record->requestedDrop, mipLevel);
+}
+
+void TextureStreamer::requestForView(const Handle& texture, float distance, float worldUnitsPerUV,
+                                     float fovY, int viewportHeight) {
+    Record* record = find(texture);
+    if (!record || !record->initialized) return;
+    const int size = std::max(record->fullWidth, record->fullHeight);
+    request(texture, static_cast<int>(std::floor(mipForView(size, distance, worldUnitsPerUV, fovY, viewportHeight))));
+}
+
+// fovY 为弧度
+float TextureStreamer::mipForView(int textureSize, float distance, float worldUnitsPerUV,
+                                  float fovY, int viewportHeight) {
+    if (distance <= 0.0f || worldUnitsPerUV <= 0.0f || viewportHeight <= 0) return 0.0f;
+    const float pixelsPerUnit = viewportHeight / (2.0f * distance * std::tan(fovY * 0.5f));
+    const float texelsPerUnit = textureSize / worldUnitsPerUV;
+    const float texelsPerPixel = texelsPerUnit / pixelsPerUnit;
+    return texelsPerPixel > 1.0f ? std::log2(texelsPerPixel) : 0.0f;
+}
+
+void TextureStreamer::schedule(size_t index, int drop) {
+    Record& record = m_records[index];
+    Job job = {index, record.path, record.params, drop, m_coarseSize, record.source};
+    record.pending = true;
+    ++m_inFlight;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_refineJobs.push_back(job);
+    }
+    m_cv.notify_one();
+}
+
+void TextureStreamer::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_stop || !m_initialJobs.empty() || !m_refineJobs.empty(); });
+            if (m_stop) return;
+            std::deque<Job>& queue = m_initialJobs.empty() ? m_refineJobs : m_initialJobs;
+            job = queue.front();
+            queue.pop_front();
+        }
+        Result result;
+        decode(job, result);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_results.push_back(std::move(result));
+        }
+    }
+}
+
+bool TextureStreamer::loadSource(const Job& job, Source& source) {
+    std::vector<unsigned char> bytes;
+    std::string error;
+    if (!readFileBytes(job.path, bytes)) {
+        std::cerr << "Failed to stream texture: " << job.path << " (cannot open file)" << std::endl;
+        return false;
+    }
+
+    if (detectContainerFormat(bytes.data(), bytes.size()) != ContainerFormat::None) {
+        // 压缩容器自带 mip 链，上传时直接跳过不需要的级别。行序在这里调整一次，细化时不再拷贝
+        if (!parseCompressedImage(bytes.data(), bytes.size(), source.compressedImage, &error) ||
+            !orientCompressedImage(source.compressedImage, job.params.flip, &error)) {
+            std::cerr << "Failed to stream texture: " << job.path << " (" << error << ")" << std::endl;
+            return false;
+        }
+        const CompressedImage& image = source.compressedImage;
+        const int levels = static_cast<int>(image.levels.size());
+        int coarse = 0;
+        while (coarse + 1 < levels &&
+               std::max(image.levels[coarse].width, image.levels[coarse].height) > job.coarseSize) {
+            ++coarse;
+        }
+        source.compressed = true;
+        source.coarseDrop = coarse;
+        source.fullWidth = image.width;
+        source.fullHeight = image.height;
+        return true;
+    }
+
+    Image full;
+    if (!decodeImage(bytes.data(), bytes.size(), full, job.params.flip,
+                     Texture::channelsForFormat(job.params.format), &error)) {
+        std::cerr << "Failed to stream texture: " << job.path << " (" << error << ")" << std::endl;
+        return false;
+    }
+    const int maxDrop = mipLevelCount(full.width, full.height) - 1;
+    int coarse = 0;
+    while (coarse < maxDrop && std::max(full.width >> coarse, full.height >> coarse) > job.coarseSize) ++coarse;
+    source.coarseDrop = coarse;
+    source.fullWidth = full.width;
+    source.fullHeight = full.height;
+    // 逐级缩小到粗级别，细化时直接取对应的一级
+    const bool srgb = job.params.role == TextureRole::Color;
+    source.levels.resize(coarse + 1);
+    source.levels[0] = std::move(full);
+    for (int i = 1; i <= coarse; ++i) source.levels[i] = downsampleImage(source.levels[i - 1], MipFilter::Box, srgb);
+    return true;
+}
+
+void TextureStreamer::decode(const Job& job, Result& result) {
+    result.record = job.record;
+    result.source = job.source;
+    if (!result.source) {
+        std::shared_ptr<Source> source = std::make_shared<Source>();
+        if (!loadSource(job, *source)) return;
+        result.source = source;
+    }
+    const Source& source = *result.source;
+    if (source.compressed) {
+        const int levels = static_cast<int>(source.compressedImage.levels.size());
+        result.drop = job.drop < 0 ? source.coarseDrop : std::min(job.drop, levels - 1);
+        for (int i = result.drop; i < levels; ++i) result.bytes += source.compressedImage.levels[i].size;
+    } else {
+        const int levels = static_cast<int>(source.levels.size());
+        result.drop = job.drop < 0 ? source.coarseDrop : std::min(job.drop, levels - 1);
+        // 上传的数据量，mip 由 GPU 生成
+        result.bytes = source.levels[result.drop].pixels.size();
+    }
+    result.ok = true;
+}
+
+void TextureStreamer::apply(Result& result) {
+    Record& record = m_records[result.record];
+    record.pending = false;
+    if (!record.texture) return;  // 已释放
+    const bool initial = !record.initialized;
+    record.initialized = true;
+    if (!result.ok) return;
+
+    const Source& source = *result.source;
+    const bool ok = source.compressed ? record.texture->reload(source.compressedImage, result.drop)
+                                      : record.texture->reload(source.levels[result.drop], result.drop,
+                                                               source.fullWidth, source.fullHeight);
+    if (!ok) return;
+    record.currentDrop = record.texture->droppedLevels();
+    record.coarseDrop = source.coarseDrop;
+    record.fullWidth = source.fullWidth;
+    record.fullHeight = source.fullHeight;
+    if (initial) record.targetDrop = record.coarseDrop;
+    // 完整驻留后不再需要源数据
+    if (record.currentDrop > 0) record.source = result.source;
+    else record.source.reset();
+}
+
+void TextureStreamer::update() {
+    ++m_frame;
+    m_uploadsThisFrame = 0;
+    m_bytesThisFrame = 0;
+
+    size_t resident = 0;
+    for (size_t i = 0; i < m_records.size(); ++i) {
+        Record& record = m_records[i];
+        if (!record.texture) continue;
+        // 只剩流送器自己持有时释放
+        if (record.texture.use_count() == 1 && !record.pending) {
+            m_index.erase(record.texture.get());
+            record.texture.reset();
+            continue;
+        }
+        resident += record.texture->memoryBytes();
+    }
+
+    for (size_t i = 0; i < m_records.size(); ++i) {
+        Record& record = m_records[i];
+        if (!record.texture || !record.initialized) continue;
+        if (record.requestedDrop >= 0) {
+            record.targetDrop = std::min(record.requestedDrop, record.coarseDrop);
+            record.lastRequested = m_frame;
+        } else if (m_frame - record.lastRequested > static_cast<uint64_t>(m_evictDelay)) {
+            record.targetDrop = record.coarseDrop;
+            // 已经退回粗级别，源数据留着只占内存，再细化时重新读文件
+            if (!record.pending && record.currentDrop == record.coarseDrop) record.source.reset();
+        }
+        record.requestedDrop = -1;
+        if (record.pending || record.targetDrop == record.currentDrop) continue;
+
+        int drop = record.targetDrop;
+        if (drop < record.currentDrop && m_residentBudget != 0) {
+            // 放不下时退而求其次，选预算内最细的级别
+            const Texture& texture = *record.texture;
+            for (; drop < record.currentDrop; ++drop) {
+                const int w = std::max(1, record.fullWidth >> drop), h = std::max(1, record.fullHeight >> drop);
+                const size_t bytes = Texture::estimateBytes(texture.internalFormat(), w, h,
+                                                            Texture::levelCountFor(w, h, 0));
+                if (resident + bytes <= m_residentBudget + texture.memoryBytes()) {
+                    resident += bytes - std::min(bytes, texture.memoryBytes());
+                    break;
+                }
+            }
+            if (drop == record.currentDrop) continue;
+        }
+        schedule(i, drop);
+    }
+
+    // 在预算内上传解码结果，至少上传一个以保证进度
+    for (;;) {
+        Result result;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_results.empty()) break;
+            if (m_uploadsThisFrame > 0 && m_bytesThisFrame + m_results.front().bytes > m_uploadBudget) break;
+            result = std::move(m_results.front());
+            m_results.pop_front();
+        }
+        --m_inFlight;
+        m_bytesThisFrame += result.bytes;
+        ++m_uploadsThisFrame;
+        apply(result);
+    }
+}
+
+TextureStreamer::Stats TextureStreamer::stats() const {
+    Stats s;
+    for (size_t i = 0; i < m_records.size(); ++i) {
+        if (!m_records[i].texture) continue;
+        ++s.textures;
+        s.residentBytes += m_records[i].texture->memoryBytes();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        s.readyUploads = m_results.size();
+    }
+    s.pendingJobs = m_inFlight.load() - s.readyUploads;
+    s.uploadsThisFrame = m_uploadsThisFrame;
+    s.bytesUploadedThisFrame = m_bytesThisFrame;
+    return s;
+}
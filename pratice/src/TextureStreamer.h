@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Image.h"
+#include "Texture.h"
+#include "TextureContainer.h"
+
+// 按屏幕空间需求流式加载 mip
+// load() 立即返回一个 1x1 占位纹理，工作线程解码后先上传最粗的几级（最大边不超过 coarseSize），
+// 之后只有当渲染时的纹素密度需要时才加载更细的级别；长时间不再需要的纹理退回粗级别释放显存。
+// 需求可以在 CPU 上按距离/UV 密度估算 (requestForView)，也可以由反馈 pass 直接给出 mip 级 (request)。
+// 解码和缩小在工作线程完成，GL 上传在 update() 中按每帧字节预算进行。
+// 文件只在初始加载时解码一次，完整分辨率到粗级别的各级保留在内存里供后续细化直接取用，
+// 纹理完整驻留或长时间没有请求后释放；之后再细化才会重新读文件。
+class TextureStreamer {
+public:
+    using Handle = std::shared_ptr<Texture>;
+
+    struct Stats {
+        size_t textures = 0;
+        size_t residentBytes = 0;
+        size_t pendingJobs = 0;       // 排队或正在解码
+        size_t readyUploads = 0;      // 已解码、等待上传
+        size_t uploadsThisFrame = 0;
+        size_t bytesUploadedThisFrame = 0;
+    };
+
+    explicit TextureStreamer(unsigned threadCount = 2);
+    ~TextureStreamer();
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // 每帧上传的字节上限，至少会上传一个
+    void setUploadBudget(size_t bytesPerFrame) { m_uploadBudget = bytesPerFrame; }
+    // 流式纹理总占用上限，0 表示不限；超出时细化请求会停在能放下的最细级别
+    void setResidentBudget(size_t bytes) { m_residentBudget = bytes; }
+    // 初始加载的最大边长，对之后 load 的纹理生效
+    void setCoarseSize(int pixels) { m_coarseSize = pixels; }
+    // 多少帧没有请求后退回粗级别
+    void setEvictDelay(int frames) { m_evictDelay = frames; }
+
+    Handle load(const std::string& path, const TextureParams& params = TextureParams());
+
+    // 本帧需要 mipLevel（相对完整分辨率）及更粗的级别，同一帧多次请求取最细的
+    void request(const Handle& texture, int mipLevel);
+    // 按物体距离估算：worldUnitsPerUV 为 UV 从 0 到 1 在世界空间跨越的长度
+    void requestForView(const Handle& texture, float distance, float worldUnitsPerUV,
+                        float fovY, int viewportHeight);
+    // 屏幕上每个像素对应的纹素数取 log2，即需要的 mip 级
+    static float mipForView(int textureSize, float distance, float worldUnitsPerUV, float fovY, int viewportHeight);
+
+    // GL 线程每帧调用：根据请求调度解码任务，并在预算内上传已解码的结果
+    void update();
+    Stats stats() const;
+
+private:
+    // 解码后的源数据，创建后只读，在工作线程和 GL 线程之间共享
+    struct Source {
+        bool compressed = false;
+        CompressedImage compressedImage;  // 自带完整 mip 链
+        std::vector<Image> levels;        // levels[i] 为缩小 i 级的图像，只生成到粗级别
+        int coarseDrop = 0;
+        int fullWidth = 0;
+        int fullHeight = 0;
+    };
+
+    struct Record {
+        Handle texture;
+        std::string path;
+        TextureParams params;
+        bool initialized = false;
+        bool pending = false;
+        int currentDrop = 0;
+        int coarseDrop = 0;
+        int fullWidth = 0;
+        int fullHeight = 0;
+        int requestedDrop = -1;       // 本帧请求，-1 表示没有
+        int targetDrop = 0;
+        uint64_t lastRequested = 0;
+        std::shared_ptr<const Source> source;   // 细化用的缓存，可能为空
+    };
+    struct Job {
+        size_t record;
+        std::string path;
+        TextureParams params;
+        int drop;                     // -1 表示初始加载，由解码结果决定粗级别
+        int coarseSize;               // 入队时的 m_coarseSize，工作线程不读成员
+        std::shared_ptr<const Source> source;   // 为空时从文件解码
+    };
+    struct Result {
+        size_t record;
+        bool ok = false;
+        int drop = 0;
+        std::shared_ptr<const Source> source;
+        size_t bytes = 0;
+    };
+
+    void workerLoop();
+    static bool loadSource(const Job& job, Source& source);
+    static void decode(const Job& job, Result& result);
+    void schedule(size_t index, int drop);
+    void apply(Result& result);
+    Record* find(const Handle& texture);
+
+    std::vector<Record> m_records;
+    std::unordered_map<const Texture*, size_t> m_index;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_initialJobs;    // 初始加载优先于细化
+    std::deque<Job> m_refineJobs;
+    std::deque<Result> m_results;
+    std::vector<std::thread> m_workers;
+    bool m_stop = false;
+    std::atomic<size_t> m_inFlight;
+
+    size_t m_uploadBudget = 4u << 20;
+    size_t m_residentBudget = 0;
+    int m_coarseSize = 64;
+    int m_evictDelay = 120;
+    uint64_t m_frame = 0;
+    size_t m_uploadsThisFrame = 0;
+    size_t m_bytesThisFrame = 0;
+};
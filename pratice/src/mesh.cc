@@ -1,4 +1,5 @@
 #include "mesh.h"
+#include "GLStateCache.h"
 #include <vector>
 #include <cstddef>
 #include <memory>
@@ -9,9 +10,9 @@ VertexLayout::VertexLayout(std::initializer_list<VertexAttributeDesc> attrs, GLs
 
 // VertexArray 实现
 VertexArray::VertexArray() { glGenVertexArrays(1, &ID); }
-VertexArray::~VertexArray() { glDeleteVertexArrays(1, &ID); }
-void VertexArray::bind() const { glBindVertexArray(ID); }
-void VertexArray::unbind() const { glBindVertexArray(0); }
+VertexArray::~VertexArray() { GLStateCache::get().deleteVertexArray(ID); }
+void VertexArray::bind() const { GLStateCache::get().bindVertexArray(ID); }
+void VertexArray::unbind() const { GLStateCache::get().bindVertexArray(0); }
 void VertexArray::setLayout(const VertexLayout& layout) {
     for (const auto& attr : layout.attributes) {
         glEnableVertexAttribArray(attr.index);
@@ -22,22 +23,22 @@ void VertexArray::setLayout(const VertexLayout& layout) {
 // VertexBuffer 实现
 VertexBuffer::VertexBuffer(const void* data, GLsizeiptr size) {
     glGenBuffers(1, &ID);
-    glBindBuffer(GL_ARRAY_BUFFER, ID);
+    GLStateCache::get().bindBuffer(GL_ARRAY_BUFFER, ID);
     glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
-VertexBuffer::~VertexBuffer() { glDeleteBuffers(1, &ID); }
-void VertexBuffer::bind() const { glBindBuffer(GL_ARRAY_BUFFER, ID); }
-void VertexBuffer::unbind() const { glBindBuffer(GL_ARRAY_BUFFER, 0); }
+VertexBuffer::~VertexBuffer() { GLStateCache::get().deleteBuffer(ID); }
+void VertexBuffer::bind() const { GLStateCache::get().bindBuffer(GL_ARRAY_BUFFER, ID); }
+void VertexBuffer::unbind() const { GLStateCache::get().bindBuffer(GL_ARRAY_BUFFER, 0); }
 
 // ElementBuffer 实现
 ElementBuffer::ElementBuffer(const void* data, GLsizeiptr size) {
     glGenBuffers(1, &ID);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
+    GLStateCache::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
-ElementBuffer::~ElementBuffer() { glDeleteBuffers(1, &ID); }
-void ElementBuffer::bind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID); }
-void ElementBuffer::unbind() const { glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
+ElementBuffer::~ElementBuffer() { GLStateCache::get().deleteBuffer(ID); }
+void ElementBuffer::bind() const { GLStateCache::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, ID); }
+void ElementBuffer::unbind() const { GLStateCache::get().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); }
 
 // Mesh 实现
 Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
@@ -60,6 +61,11 @@ void Mesh::drawLines() const {
     vao.bind();
     glDrawElements(GL_LINES, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
 }
+// 调用前 VAO 必须已经绑定
+void Mesh::drawBound(GLenum mode) const {
+    glDrawElements(mode, static_cast<GLsizei>(indexCount), GL_UNSIGNED_INT, 0);
+}
+
 VertexLayout Mesh::getLayout() {
     return VertexLayout{
         {
@@ -40,6 +40,7 @@ public:
     void bind() const;
     void unbind() const;
     void setLayout(const VertexLayout& layout);
+    GLuint id() const { return ID; }
 private:
     GLuint ID;
 };
@@ -72,6 +73,10 @@ public:
     Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
     void draw() const;
     void drawLines() const;  // 新增线框绘制方法
+    // 拆开的绑定和绘制：RenderQueue 对连续相同网格只绑定一次 VAO
+    void bind() const { vao.bind(); }
+    void drawBound(GLenum mode = GL_TRIANGLES) const;
+    GLuint vertexArray() const { return vao.id(); }
     static VertexLayout getLayout();
 private:
     VertexArray vao;
@@ -0,0 +1,150 @@
+#include "FrameCapture.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// FrameCapture 编码器的测试：用按规范写的参考解码器解 QOI，逐像素比较
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+// 参考 QOI 解码器，索引表为 RGBA、初始全 0，与 qoiformat.org 的实现一致。输出 RGBA，行序自上而下
+bool decodeQOI(const std::vector<unsigned char>& data, int& width, int& height, std::vector<unsigned char>& out) {
+    if (data.size() < 22 || data[0] != 'q' || data[1] != 'o' || data[2] != 'i' || data[3] != 'f') return false;
+    width = (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+    height = (data[8] << 24) | (data[9] << 16) | (data[10] << 8) | data[11];
+    const size_t pixels = static_cast<size_t>(width) * height;
+    out.clear();
+    unsigned char index[64][4] = {};
+    unsigned char px[4] = {0, 0, 0, 255};
+    size_t p = 14;
+    int run = 0;
+    while (out.size() < pixels * 4) {
+        if (run > 0) {
+            --run;
+        } else {
+            if (p >= data.size() - 8) return false;
+            const int b = data[p++];
+            if (b == 0xfe) {
+                px[0] = data[p++];
+                px[1] = data[p++];
+                px[2] = data[p++];
+            } else if (b == 0xff) {
+                px[0] = data[p++];
+                px[1] = data[p++];
+                px[2] = data[p++];
+                px[3] = data[p++];
+            } else if ((b >> 6) == 0) {
+                for (int c = 0; c < 4; ++c) px[c] = index[b][c];
+            } else if ((b >> 6) == 1) {
+                px[0] = static_cast<unsigned char>(px[0] + ((b >> 4) & 3) - 2);
+                px[1] = static_cast<unsigned char>(px[1] + ((b >> 2) & 3) - 2);
+                px[2] = static_cast<unsigned char>(px[2] + (b & 3) - 2);
+            } else if ((b >> 6) == 2) {
+                const int b2 = data[p++];
+                const int dg = (b & 63) - 32;
+                px[0] = static_cast<unsigned char>(px[0] + dg - 8 + (b2 >> 4));
+                px[1] = static_cast<unsigned char>(px[1] + dg);
+                px[2] = static_cast<unsigned char>(px[2] + dg - 8 + (b2 & 15));
+            } else {
+                run = b & 63;
+            }
+            const int hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+            for (int c = 0; c < 4; ++c) index[hash][c] = px[c];
+        }
+        out.insert(out.end(), px, px + 4);
+    }
+    return true;
+}
+
+// rgba 为自下而上，和 glReadPixels 一致
+bool roundTrip(const std::vector<unsigned char>& rgba, int width, int height) {
+    std::vector<unsigned char> encoded, decoded;
+    FrameCapture::encodeQOI(rgba.data(), width, height, encoded);
+    int w = 0, h = 0;
+    if (!decodeQOI(encoded, w, h, decoded) || w != width || h != height) return false;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const unsigned char* expected = &rgba[(static_cast<size_t>(height - 1 - y) * width + x) * 4];
+            const unsigned char* actual = &decoded[(static_cast<size_t>(y) * width + x) * 4];
+            if (expected[0] != actual[0] || expected[1] != actual[1] || expected[2] != actual[2] || actual[3] != 255) {
+                std::printf("  pixel (%d, %d): expected %d %d %d, got %d %d %d %d\n", x, y, expected[0], expected[1],
+                            expected[2], actual[0], actual[1], actual[2], actual[3]);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void testQOIFirstPixelNotBlack() {
+    // 第一个像素不是黑色（且和黑色不在同一个索引槽位）时，之后的黑色像素不能命中空的索引槽位
+    const unsigned char colors[5][4] = {
+        {100, 100, 100, 255}, {0, 0, 0, 255}, {200, 10, 10, 255}, {50, 50, 50, 255}, {200, 10, 10, 255}};
+    std::vector<unsigned char> rgba(colors[0], colors[0] + sizeof(colors));
+    check(roundTrip(rgba, 5, 1), "QOI round trip starting with a non-black pixel");
+}
+
+void testQOIRandom() {
+    const int width = 37, height = 23;
+    std::vector<unsigned char> rgba(static_cast<size_t>(width) * height * 4);
+    std::srand(1);
+    for (int i = 0; i < width * height; ++i) {
+        // 混合平坦区、小差值和随机颜色，覆盖所有操作码；alpha 随机，编码时应被丢弃
+        const int mode = i % 7;
+        for (int c = 0; c < 3; ++c) {
+            rgba[i * 4 + c] = static_cast<unsigned char>(mode < 3 ? (i / 50) * 3 + c : std::rand() % 256);
+        }
+        rgba[i * 4 + 3] = static_cast<unsigned char>(std::rand() % 256);
+    }
+    check(roundTrip(rgba, width, height), "QOI round trip of mixed content");
+}
+
+// 2x2 纯色图，Y4M 帧为 "FRAME\n" + 4 个 Y + 1 个 Cb + 1 个 Cr
+void y4mSolid(unsigned char r, unsigned char g, unsigned char b, int& y, int& cb, int& cr) {
+    std::vector<unsigned char> rgba;
+    for (int i = 0; i < 4; ++i) {
+        rgba.push_back(r);
+        rgba.push_back(g);
+        rgba.push_back(b);
+        rgba.push_back(255);
+    }
+    std::vector<unsigned char> encoded;
+    FrameCapture::encodeY4M(rgba.data(), 2, 2, encoded);
+    y = cb = cr = -1;
+    if (encoded.size() != 6 + 4 + 2) return;
+    y = encoded[6];
+    cb = encoded[10];
+    cr = encoded[11];
+}
+
+void testY4MSaturatedColors() {
+    int y, cb, cr;
+    // 纯蓝的 Cb、纯红的 Cr 舍入后超过 255，不能回绕成 0
+    y4mSolid(0, 0, 255, y, cb, cr);
+    check(y == 29 && cb == 255 && cr == 107, "Y4M pure blue");
+    y4mSolid(255, 0, 0, y, cb, cr);
+    check(y == 76 && cb == 85 && cr == 255, "Y4M pure red");
+    y4mSolid(255, 255, 255, y, cb, cr);
+    check(y == 255 && cb == 128 && cr == 128, "Y4M white");
+    y4mSolid(0, 0, 0, y, cb, cr);
+    check(y == 0 && cb == 128 && cr == 128, "Y4M black");
+}
+
+} // namespace
+
+int main() {
+    testQOIFirstPixelNotBlack();
+    testQOIRandom();
+    testY4MSaturatedColors();
+    if (failures == 0) std::printf("frame_capture_test: all passed\n");
+    return failures == 0 ? 0 : 1;
+}
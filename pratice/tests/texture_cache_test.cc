@@ -0,0 +1,83 @@
+#include "Renderer.h"
+#include "TextureCache.h"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// TextureCache 的行为测试：同一键共享一个 GL 纹理，内容相同的文件复用纹理，
+// 最后一个句柄释放后 evictUnused() 删除条目和 GL 纹理。需要 GL 上下文，创建不了时跳过
+
+namespace {
+
+const int kSkipped = 77;
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+bool copyFile(const std::string& from, const std::string& to) {
+    std::vector<unsigned char> bytes;
+    if (!readFileBytes(from, bytes)) return false;
+    std::ofstream out(to.c_str(), std::ios::binary);
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(out);
+}
+
+void testSharedHandles(const std::string& path, const std::string& copy) {
+    TextureCache cache;
+    GLuint id = 0;
+    {
+        TextureCache::Handle a = cache.get(path);
+        TextureCache::Handle b = cache.get(path);
+        check(a && a->isValid(), "texture loads");
+        check(a == b && a->id() == b->id(), "same key shares one GL texture");
+        check(cache.size() == 1 && cache.stats().misses == 1 && cache.stats().hits == 1, "second get is a hit");
+        check(cache.refCount(path) == 2, "refCount counts both handles");
+
+        // 内容相同、路径不同：复用同一个纹理，但是单独的键
+        TextureCache::Handle c = cache.get(copy);
+        check(c == a && cache.stats().contentHits == 1 && cache.size() == 2, "identical file reuses the texture");
+
+        check(cache.evictUnused() == 0 && cache.size() == 2, "held entries survive eviction");
+        id = a->id();
+        b.reset();
+        check(cache.refCount(path) == 2, "refCount includes handles obtained through other keys");
+    }
+    check(glIsTexture(id) == GL_TRUE, "texture stays alive in the cache after handles drop");
+    check(cache.refCount(path) == 0, "no external handles left");
+    check(cache.evictUnused() == 1, "one texture released");
+    check(cache.size() == 0 && cache.stats().evictions == 1, "both keys evicted");
+    check(glIsTexture(id) == GL_FALSE, "GL texture deleted on eviction");
+
+    // 驱逐后再次请求会重新加载
+    TextureCache::Handle again = cache.get(path);
+    check(again && again->isValid() && cache.stats().misses == 2, "evicted entry reloads");
+}
+
+} // namespace
+
+int main() {
+    std::unique_ptr<Renderer> renderer = Renderer::createHeadless(64, 64, false);
+    if (!renderer) {
+        std::printf("texture_cache_test: skipped, no GL context\n");
+        return kSkipped;
+    }
+
+    const std::string path = std::string(TEST_TEXTURE_DIR) + "container.jpg";
+    const std::string copy = "texture_cache_test_copy.jpg";
+    if (!copyFile(path, copy)) {
+        std::printf("FAIL: cannot copy %s\n", path.c_str());
+        return 1;
+    }
+    testSharedHandles(path, copy);
+    std::remove(copy.c_str());
+
+    if (failures == 0) std::printf("texture_cache_test: all passed\n");
+    return failures == 0 ? 0 : 1;
+}
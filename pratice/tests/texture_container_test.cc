@@ -0,0 +1,129 @@
+#include "TextureContainer.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// KTX2 行序 (KTXorientation) 与 TextureParams::flip 的对齐：解析 "ru"/"rd" 文件并按需翻转压缩块
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+// width x height 的单级压缩图像，数据按字节序号填充，每个块内容都不相同
+CompressedImage makeImage(GLenum format, int width, int height) {
+    CompressedImage image;
+    image.internalFormat = format;
+    image.width = width;
+    image.height = height;
+    image.blockBytes = compressedBlockBytes(format);
+    const size_t size = compressedLevelSize(format, width, height);
+    CompressedImage::Level level{width, height, 0, size};
+    image.levels.push_back(level);
+    image.data.resize(size);
+    for (size_t i = 0; i < size; ++i) image.data[i] = static_cast<unsigned char>(i * 7 + 1);
+    return image;
+}
+
+// BC4 块内 (x, y) 的 3 位索引
+int bc4Index(const unsigned char* block, int x, int y) {
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) bits |= uint64_t(block[2 + i]) << (8 * i);
+    return static_cast<int>((bits >> (3 * (y * 4 + x))) & 7);
+}
+
+// BC1 块内 (x, y) 的 2 位索引
+int bc1Index(const unsigned char* block, int x, int y) {
+    return (block[4 + y] >> (2 * x)) & 3;
+}
+
+bool roundTripKTX2(const CompressedImage& image, CompressedImage& parsed) {
+    std::vector<unsigned char> bytes;
+    return encodeKTX2(image, bytes) && parseKTX2(bytes.data(), bytes.size(), parsed);
+}
+
+void testRuFileMatchesFlip() {
+    // texbake 默认输出 "ru"：第一行是图像底部，和 stb 路径 flip=true 的上传顺序一致
+    CompressedImage image = makeImage(GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 8, 8);
+    image.originTop = false;
+    CompressedImage parsed;
+    check(roundTripKTX2(image, parsed), "encode/parse ru KTX2");
+    check(!parsed.originTop, "ru KTX2 parses as bottom-up");
+    const std::vector<unsigned char> original = parsed.data;
+    check(orientCompressedImage(parsed, true), "orient ru for flip=true");
+    check(parsed.data == original && !parsed.originTop, "ru with flip=true is uploaded unchanged");
+
+    // flip=false 要求第一行在上，需要翻转
+    check(orientCompressedImage(parsed, false), "orient ru for flip=false");
+    check(parsed.originTop, "ru with flip=false becomes top-down");
+    const size_t rowBytes = 2 * 8;   // 两个 BC1 块
+    for (int by = 0; by < 2; ++by) {
+        for (int bx = 0; bx < 2; ++bx) {
+            const unsigned char* before = &original[by * rowBytes + bx * 8];
+            const unsigned char* after = &parsed.data[(1 - by) * rowBytes + bx * 8];
+            bool same = std::memcmp(before, after, 4) == 0;
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) same = same && bc1Index(before, x, y) == bc1Index(after, x, 3 - y);
+            }
+            check(same, "BC1 block rows and in-block rows are mirrored");
+        }
+    }
+}
+
+void testRdFileIsFlippedForFlip() {
+    CompressedImage image = makeImage(GL_COMPRESSED_RED_RGTC1, 4, 4);
+    CompressedImage parsed;
+    check(roundTripKTX2(image, parsed), "encode/parse rd KTX2");
+    check(parsed.originTop, "rd KTX2 parses as top-down");
+    const std::vector<unsigned char> original = parsed.data;
+    check(orientCompressedImage(parsed, true), "orient rd for flip=true");
+    bool mirrored = !parsed.originTop && parsed.data[0] == original[0] && parsed.data[1] == original[1];
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 4; ++x) {
+            mirrored = mirrored && bc4Index(&original[0], x, y) == bc4Index(&parsed.data[0], x, 3 - y);
+        }
+    }
+    check(mirrored, "BC4 indices are mirrored within the block");
+}
+
+void testShortLevel() {
+    // 只有 2 行的 mip 级：只交换有效的两行，填充行保持不动
+    CompressedImage image = makeImage(GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4, 2);
+    const std::vector<unsigned char> original = image.data;
+    check(flipCompressedImage(image), "flip 4x2 BC3");
+    bool ok = true;
+    for (int x = 0; x < 4; ++x) {
+        ok = ok && bc4Index(&image.data[0], x, 0) == bc4Index(&original[0], x, 1);
+        ok = ok && bc4Index(&image.data[0], x, 1) == bc4Index(&original[0], x, 0);
+        ok = ok && bc4Index(&image.data[0], x, 2) == bc4Index(&original[0], x, 2);
+        ok = ok && bc1Index(&image.data[8], x, 0) == bc1Index(&original[8], x, 1);
+        ok = ok && bc1Index(&image.data[8], x, 3) == bc1Index(&original[8], x, 3);
+    }
+    check(ok, "BC3 flip of a 2-row level only swaps the valid rows");
+}
+
+void testUnsupportedFormatIsRejected() {
+    CompressedImage image = makeImage(GL_COMPRESSED_RGBA_BPTC_UNORM, 4, 4);
+    const std::vector<unsigned char> original = image.data;
+    std::string error;
+    check(!orientCompressedImage(image, true, &error), "BC7 top-down data cannot be flipped");
+    check(image.data == original && image.originTop && !error.empty(), "rejected flip leaves the image unchanged");
+    check(orientCompressedImage(image, false), "BC7 already in the requested order is accepted");
+}
+
+} // namespace
+
+int main() {
+    testRuFileMatchesFlip();
+    testRdFileIsFlippedForFlip();
+    testShortLevel();
+    testUnsupportedFormatIsRejected();
+    if (failures == 0) std::printf("texture_container_test: all passed\n");
+    return failures == 0 ? 0 : 1;
+}
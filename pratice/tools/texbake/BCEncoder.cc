@@ -0,0 +1,386 @@
+#include "BCEncoder.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TEXBAKE_SSE2 1
+#endif
+
+namespace {
+
+// 16 个像素按通道分开存放 (SoA)，便于 SIMD
+struct BlockPixels {
+    float c[4][16];
+};
+
+struct Palette {
+    float c[4][16];
+    int size;
+};
+
+// 为每个像素选出误差最小的调色板项，返回总误差
+// 平局时取下标较小者，SIMD 与标量路径结果一致
+float selectIndices(const BlockPixels& px, const Palette& pal, uint8_t indices[16]) {
+    float total = 0.0f;
+#ifdef TEXBAKE_SSE2
+    if (pal.size % 4 == 0) {
+        for (int i = 0; i < 16; ++i) {
+            const __m128 pr = _mm_set1_ps(px.c[0][i]);
+            const __m128 pg = _mm_set1_ps(px.c[1][i]);
+            const __m128 pb = _mm_set1_ps(px.c[2][i]);
+            const __m128 pa = _mm_set1_ps(px.c[3][i]);
+            __m128 best = _mm_set1_ps(1e30f);
+            __m128 bestIndex = _mm_setzero_ps();
+            __m128 index = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+            const __m128 step = _mm_set1_ps(4.0f);
+            for (int j = 0; j < pal.size; j += 4) {
+                __m128 dr = _mm_sub_ps(_mm_loadu_ps(&pal.c[0][j]), pr);
+                __m128 dg = _mm_sub_ps(_mm_loadu_ps(&pal.c[1][j]), pg);
+                __m128 db = _mm_sub_ps(_mm_loadu_ps(&pal.c[2][j]), pb);
+                __m128 da = _mm_sub_ps(_mm_loadu_ps(&pal.c[3][j]), pa);
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)),
+                                      _mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(da, da)));
+                __m128 less = _mm_cmplt_ps(d, best);
+                best = _mm_min_ps(d, best);
+                bestIndex = _mm_or_ps(_mm_and_ps(less, index), _mm_andnot_ps(less, bestIndex));
+                index = _mm_add_ps(index, step);
+            }
+            float e[4], k[4];
+            _mm_storeu_ps(e, best);
+            _mm_storeu_ps(k, bestIndex);
+            int lane = 0;
+            for (int l = 1; l < 4; ++l) {
+                if (e[l] < e[lane] || (e[l] == e[lane] && k[l] < k[lane])) lane = l;
+            }
+            indices[i] = static_cast<uint8_t>(k[lane]);
+            total += e[lane];
+        }
+        return total;
+    }
+#endif
+    for (int i = 0; i < 16; ++i) {
+        float best = 1e30f;
+        int bestIndex = 0;
+        for (int j = 0; j < pal.size; ++j) {
+            float dr = pal.c[0][j] - px.c[0][i];
+            float dg = pal.c[1][j] - px.c[1][i];
+            float db = pal.c[2][j] - px.c[2][i];
+            float da = pal.c[3][j] - px.c[3][i];
+            float d = (dr * dr + dg * dg) + (db * db + da * da);
+            if (d < best) {
+                best = d;
+                bestIndex = j;
+            }
+        }
+        indices[i] = static_cast<uint8_t>(bestIndex);
+        total += best;
+    }
+    return total;
+}
+
+BlockPixels loadPixels(const uint8_t rgba[64], int channels) {
+    BlockPixels px;
+    for (int i = 0; i < 16; ++i) {
+        for (int c = 0; c < 4; ++c) px.c[c][i] = c < channels ? float(rgba[i * 4 + c]) : 0.0f;
+    }
+    return px;
+}
+
+// 用幂迭代求协方差矩阵的主轴，返回 false 表示块内颜色完全一致
+bool principalAxis(const BlockPixels& px, int channels, float mean[4], float axis[4]) {
+    for (int c = 0; c < 4; ++c) {
+        mean[c] = 0.0f;
+        for (int i = 0; i < 16; ++i) mean[c] += px.c[c][i];
+        mean[c] /= 16.0f;
+    }
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; ++i) {
+        float d[4];
+        for (int c = 0; c < 4; ++c) d[c] = px.c[c][i] - mean[c];
+        for (int a = 0; a < channels; ++a)
+            for (int b = 0; b < channels; ++b) cov[a][b] += d[a] * d[b];
+    }
+    // 以包围盒对角线作为初值，收敛快且不依赖随机数
+    float v[4] = {0, 0, 0, 0};
+    for (int c = 0; c < channels; ++c) {
+        float lo = 255.0f, hi = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+            lo = std::min(lo, px.c[c][i]);
+            hi = std::max(hi, px.c[c][i]);
+        }
+        v[c] = hi - lo;
+    }
+    for (int iter = 0; iter < 8; ++iter) {
+        float n[4] = {0, 0, 0, 0};
+        for (int a = 0; a < channels; ++a)
+            for (int b = 0; b < channels; ++b) n[a] += cov[a][b] * v[b];
+        float len = 0.0f;
+        for (int c = 0; c < channels; ++c) len = std::max(len, std::fabs(n[c]));
+        if (len < 1e-6f) break;
+        for (int c = 0; c < channels; ++c) v[c] = n[c] / len;
+    }
+    float len = 0.0f;
+    for (int c = 0; c < channels; ++c) len += v[c] * v[c];
+    if (len < 1e-12f) return false;
+    len = std::sqrt(len);
+    for (int c = 0; c < 4; ++c) axis[c] = c < channels ? v[c] / len : 0.0f;
+    return true;
+}
+
+void axisEndpoints(const BlockPixels& px, int channels, const float mean[4], const float axis[4],
+                   float lo[4], float hi[4]) {
+    float tMin = 1e30f, tMax = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < channels; ++c) t += (px.c[c][i] - mean[c]) * axis[c];
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+    }
+    for (int c = 0; c < 4; ++c) {
+        lo[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * tMin));
+        hi[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * tMax));
+    }
+}
+
+// 给定每个像素的插值权重 t (端点1 的比例)，最小二乘求两个端点
+bool leastSquaresEndpoints(const BlockPixels& px, const float t[16], float e0[4], float e1[4]) {
+    float a = 0, b = 0, c = 0;
+    float x0[4] = {0, 0, 0, 0}, x1[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 16; ++i) {
+        float w1 = t[i], w0 = 1.0f - t[i];
+        a += w0 * w0;
+        b += w0 * w1;
+        c += w1 * w1;
+        for (int ch = 0; ch < 4; ++ch) {
+            x0[ch] += w0 * px.c[ch][i];
+            x1[ch] += w1 * px.c[ch][i];
+        }
+    }
+    float det = a * c - b * b;
+    if (std::fabs(det) < 1e-6f) return false;
+    for (int ch = 0; ch < 4; ++ch) {
+        e0[ch] = std::min(255.0f, std::max(0.0f, (c * x0[ch] - b * x1[ch]) / det));
+        e1[ch] = std::min(255.0f, std::max(0.0f, (a * x1[ch] - b * x0[ch]) / det));
+    }
+    return true;
+}
+
+// ---------------- BC1 ----------------
+
+uint16_t packRGB565(const float c[4]) {
+    int r = static_cast<int>(c[0] * 31.0f / 255.0f + 0.5f);
+    int g = static_cast<int>(c[1] * 63.0f / 255.0f + 0.5f);
+    int b = static_cast<int>(c[2] * 31.0f / 255.0f + 0.5f);
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void unpackRGB565(uint16_t v, float c[4]) {
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    c[0] = float((r << 3) | (r >> 2));
+    c[1] = float((g << 2) | (g >> 4));
+    c[2] = float((b << 3) | (b >> 2));
+    c[3] = 0.0f;
+}
+
+struct BC1Candidate {
+    uint16_t c0, c1;
+    uint8_t indices[16];
+    float error;
+};
+
+BC1Candidate evaluateBC1(const BlockPixels& px, uint16_t c0, uint16_t c1) {
+    BC1Candidate cand;
+    // 四色模式要求 c0 > c1
+    if (c0 < c1) std::swap(c0, c1);
+    cand.c0 = c0;
+    cand.c1 = c1;
+    float p0[4], p1[4];
+    unpackRGB565(c0, p0);
+    unpackRGB565(c1, p1);
+    Palette pal;
+    pal.size = 4;
+    for (int ch = 0; ch < 4; ++ch) {
+        pal.c[ch][0] = p0[ch];
+        pal.c[ch][1] = p1[ch];
+        pal.c[ch][2] = (2.0f * p0[ch] + p1[ch]) / 3.0f;
+        pal.c[ch][3] = (p0[ch] + 2.0f * p1[ch]) / 3.0f;
+    }
+    if (c0 == c1) {
+        // 端点相同退化为三色模式，索引 0 即端点颜色
+        for (int ch = 0; ch < 4; ++ch) pal.c[ch][2] = pal.c[ch][3] = p0[ch];
+    }
+    cand.error = selectIndices(px, pal, cand.indices);
+    if (c0 == c1) std::fill(cand.indices, cand.indices + 16, uint8_t(0));
+    return cand;
+}
+
+// ---------------- BC7 (模式 6) ----------------
+
+const int kBC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+struct BC7Candidate {
+    int q0[4], q1[4];  // 7 位端点
+    int p0, p1;        // p 位
+    uint8_t indices[16];
+    float error;
+};
+
+int quantize7(float v, int pbit) {
+    int q = static_cast<int>(std::floor((v - pbit) / 2.0f + 0.5f));
+    return std::min(127, std::max(0, q));
+}
+
+BC7Candidate evaluateBC7(const BlockPixels& px, const float e0[4], const float e1[4], int p0, int p1) {
+    BC7Candidate cand;
+    cand.p0 = p0;
+    cand.p1 = p1;
+    int full0[4], full1[4];
+    for (int ch = 0; ch < 4; ++ch) {
+        cand.q0[ch] = quantize7(e0[ch], p0);
+        cand.q1[ch] = quantize7(e1[ch], p1);
+        full0[ch] = (cand.q0[ch] << 1) | p0;
+        full1[ch] = (cand.q1[ch] << 1) | p1;
+    }
+    Palette pal;
+    pal.size = 16;
+    for (int k = 0; k < 16; ++k) {
+        const int w = kBC7Weights4[k];
+        for (int ch = 0; ch < 4; ++ch)
+            pal.c[ch][k] = float(((64 - w) * full0[ch] + w * full1[ch] + 32) >> 6);
+    }
+    cand.error = selectIndices(px, pal, cand.indices);
+    return cand;
+}
+
+BC7Candidate bestBC7(const BlockPixels& px, const float e0[4], const float e1[4]) {
+    BC7Candidate best = evaluateBC7(px, e0, e1, 0, 0);
+    for (int combo = 1; combo < 4; ++combo) {
+        BC7Candidate cand = evaluateBC7(px, e0, e1, combo & 1, combo >> 1);
+        if (cand.error < best.error) best = cand;
+    }
+    return best;
+}
+
+struct BitWriter {
+    uint8_t* out;
+    int pos = 0;
+    explicit BitWriter(uint8_t* o) : out(o) {}
+    void put(uint32_t value, int bits) {
+        for (int i = 0; i < bits; ++i, ++pos) {
+            if ((value >> i) & 1u) out[pos >> 3] |= static_cast<uint8_t>(1u << (pos & 7));
+        }
+    }
+};
+
+template <typename Fn>
+void parallelFor(int count, unsigned threadCount, Fn fn) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min<unsigned>(threadCount, static_cast<unsigned>(std::max(1, count)));
+    std::atomic<int> next(0);
+    auto worker = [&]() {
+        for (int i = next++; i < count; i = next++) fn(i);
+    };
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < threadCount; ++t) threads.emplace_back(worker);
+    worker();
+    for (auto& t : threads) t.join();
+}
+
+} // namespace
+
+void encodeBC1Block(const uint8_t rgba[64], uint8_t out[8]) {
+    BlockPixels px = loadPixels(rgba, 3);
+    float mean[4], axis[4], lo[4], hi[4];
+    BC1Candidate best;
+    if (!principalAxis(px, 3, mean, axis)) {
+        best = evaluateBC1(px, packRGB565(mean), packRGB565(mean));
+    } else {
+        axisEndpoints(px, 3, mean, axis, lo, hi);
+        best = evaluateBC1(px, packRGB565(hi), packRGB565(lo));
+        // 根据选出的索引做一次最小二乘细化
+        static const float kWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+        float t[16], e0[4], e1[4];
+        for (int i = 0; i < 16; ++i) t[i] = kWeights[best.indices[i]];
+        if (best.c0 != best.c1 && leastSquaresEndpoints(px, t, e0, e1)) {
+            BC1Candidate refined = evaluateBC1(px, packRGB565(e0), packRGB565(e1));
+            if (refined.error < best.error) best = refined;
+        }
+    }
+    out[0] = static_cast<uint8_t>(best.c0 & 0xFF);
+    out[1] = static_cast<uint8_t>(best.c0 >> 8);
+    out[2] = static_cast<uint8_t>(best.c1 & 0xFF);
+    out[3] = static_cast<uint8_t>(best.c1 >> 8);
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i) bits |= uint32_t(best.indices[i]) << (2 * i);
+    for (int i = 0; i < 4; ++i) out[4 + i] = static_cast<uint8_t>(bits >> (8 * i));
+}
+
+void encodeBC7Block(const uint8_t rgba[64], uint8_t out[16]) {
+    BlockPixels px = loadPixels(rgba, 4);
+    float mean[4], axis[4], lo[4], hi[4];
+    BC7Candidate best;
+    if (!principalAxis(px, 4, mean, axis)) {
+        best = bestBC7(px, mean, mean);
+    } else {
+        axisEndpoints(px, 4, mean, axis, lo, hi);
+        best = bestBC7(px, lo, hi);
+        float t[16], e0[4], e1[4];
+        for (int i = 0; i < 16; ++i) t[i] = kBC7Weights4[best.indices[i]] / 64.0f;
+        if (leastSquaresEndpoints(px, t, e0, e1)) {
+            BC7Candidate refined = bestBC7(px, e0, e1);
+            if (refined.error < best.error) best = refined;
+        }
+    }
+
+    // 锚点 (像素 0) 的索引最高位隐含为 0，必要时交换端点并翻转索引
+    if (best.indices[0] >= 8) {
+        for (int ch = 0; ch < 4; ++ch) std::swap(best.q0[ch], best.q1[ch]);
+        std::swap(best.p0, best.p1);
+        for (int i = 0; i < 16; ++i) best.indices[i] = static_cast<uint8_t>(15 - best.indices[i]);
+    }
+
+    std::memset(out, 0, 16);
+    BitWriter w(out);
+    w.put(1u << 6, 7);  // 模式 6
+    for (int ch = 0; ch < 4; ++ch) {
+        w.put(static_cast<uint32_t>(best.q0[ch]), 7);
+        w.put(static_cast<uint32_t>(best.q1[ch]), 7);
+    }
+    w.put(static_cast<uint32_t>(best.p0), 1);
+    w.put(static_cast<uint32_t>(best.p1), 1);
+    w.put(best.indices[0], 3);
+    for (int i = 1; i < 16; ++i) w.put(best.indices[i], 4);
+}
+
+int bcBlockBytes(BCFormat format) {
+    return format == BCFormat::BC1 ? 8 : 16;
+}
+
+std::vector<unsigned char> compressImage(const Image& rgba, BCFormat format, unsigned threadCount) {
+    const int blocksX = std::max(1, (rgba.width + 3) / 4);
+    const int blocksY = std::max(1, (rgba.height + 3) / 4);
+    const int blockBytes = bcBlockBytes(format);
+    std::vector<unsigned char> out(size_t(blocksX) * blocksY * blockBytes);
+    if (rgba.empty() || rgba.channels != 4 || rgba.type != PixelType::UInt8) return out;
+
+    // 按块行分发给工作线程，每块写入固定位置，结果与调度顺序无关
+    parallelFor(blocksY, threadCount, [&](int by) {
+        uint8_t block[64];
+        for (int bx = 0; bx < blocksX; ++bx) {
+            for (int y = 0; y < 4; ++y) {
+                const int sy = std::min(rgba.height - 1, by * 4 + y);
+                for (int x = 0; x < 4; ++x) {
+                    const int sx = std::min(rgba.width - 1, bx * 4 + x);
+                    std::memcpy(&block[(y * 4 + x) * 4], &rgba.pixels[(size_t(sy) * rgba.width + sx) * 4], 4);
+                }
+            }
+            unsigned char* dst = &out[(size_t(by) * blocksX + bx) * blockBytes];
+            if (format == BCFormat::BC1) encodeBC1Block(block, dst);
+            else encodeBC7Block(block, dst);
+        }
+    });
+    return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Image.h"
+
+// BC1 / BC7 块压缩编码器
+// BC1: 主轴拟合 + 一次最小二乘细化，只编码不透明的 4 色模式
+// BC7: 只使用模式 6 (单子集, RGBA 7 位端点 + p 位, 4 位索引)，质量与速度比较均衡
+// 调色板匹配在 SSE2 可用时按 4 路并行计算，与标量路径结果逐位一致；
+// 每个块独立编码，所以输出与线程数无关，完全确定。
+
+enum class BCFormat {
+    BC1,
+    BC7
+};
+
+// rgba: 16 个像素的 RGBA8，行优先
+void encodeBC1Block(const uint8_t rgba[64], uint8_t out[8]);
+void encodeBC7Block(const uint8_t rgba[64], uint8_t out[16]);
+
+int bcBlockBytes(BCFormat format);
+
+// 压缩一张 RGBA8 图像（非 4 的倍数时边缘像素夹取），threadCount 为 0 时使用所有硬件线程
+std::vector<unsigned char> compressImage(const Image& rgba, BCFormat format, unsigned threadCount = 0);
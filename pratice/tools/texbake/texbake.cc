@@ -0,0 +1,193 @@
+// texbake: 离线纹理烘焙工具
+// 读取 demo 使用的 JPG/PNG，生成伽马正确的 mip 链，编码为 BC1/BC7 并写出 KTX2，
+// 运行时由 Texture 直接上传压缩数据，不再在启动时解码和生成 mip。
+//
+// 用法: texbake [选项] <输入文件>...
+//   -o <路径>           输出文件 (只有一个输入时) 或输出目录，默认与输入同名的 .ktx2
+//   --format bc1|bc7    默认 bc7
+//   --filter box|kaiser 默认 kaiser
+//   --linear            输入是线性数据 (法线/镜面贴图)，不做 sRGB 转换
+//   --no-flip           保持图像行顺序 (默认翻转为 OpenGL 的自下而上)
+//   --threads <n>       工作线程数，默认使用全部硬件线程
+//   --bench <n>         重复编码 n 次并报告 MP/s
+
+#include "BCEncoder.h"
+#include "Image.h"
+#include "MipChain.h"
+#include "TextureContainer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string output;
+    BCFormat format = BCFormat::BC7;
+    MipFilter filter = MipFilter::Kaiser;
+    bool srgb = true;
+    bool flip = true;
+    unsigned threads = 0;
+    int benchRuns = 0;
+};
+
+void printUsage() {
+    std::cout << "usage: texbake [-o <file|dir>] [--format bc1|bc7] [--filter box|kaiser]\n"
+                 "               [--linear] [--no-flip] [--threads n] [--bench n] <input>..." << std::endl;
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        if (arg == "-o") {
+            const char* v = next();
+            if (!v) return false;
+            opt.output = v;
+        } else if (arg == "--format") {
+            const char* v = next();
+            if (!v) return false;
+            if (std::strcmp(v, "bc1") == 0) opt.format = BCFormat::BC1;
+            else if (std::strcmp(v, "bc7") == 0) opt.format = BCFormat::BC7;
+            else return false;
+        } else if (arg == "--filter") {
+            const char* v = next();
+            if (!v) return false;
+            if (std::strcmp(v, "box") == 0) opt.filter = MipFilter::Box;
+            else if (std::strcmp(v, "kaiser") == 0) opt.filter = MipFilter::Kaiser;
+            else return false;
+        } else if (arg == "--linear") {
+            opt.srgb = false;
+        } else if (arg == "--no-flip") {
+            opt.flip = false;
+        } else if (arg == "--threads") {
+            const char* v = next();
+            if (!v) return false;
+            opt.threads = static_cast<unsigned>(std::atoi(v));
+        } else if (arg == "--bench") {
+            const char* v = next();
+            if (!v) return false;
+            opt.benchRuns = std::max(1, std::atoi(v));
+        } else if (arg == "-h" || arg == "--help") {
+            return false;
+        } else {
+            opt.inputs.push_back(arg);
+        }
+    }
+    return !opt.inputs.empty();
+}
+
+bool isDirectory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+std::string outputPathFor(const Options& opt, const std::string& input) {
+    std::string base = input;
+    size_t dot = base.find_last_of('.');
+    size_t slash = base.find_last_of("/\\");
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) base.erase(dot);
+    if (opt.output.empty()) return base + ".ktx2";
+    if (isDirectory(opt.output)) {
+        std::string name = slash == std::string::npos ? base : base.substr(slash + 1);
+        return opt.output + "/" + name + ".ktx2";
+    }
+    return opt.output;
+}
+
+GLenum glFormatFor(const Options& opt) {
+    if (opt.format == BCFormat::BC1)
+        return opt.srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    return opt.srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool bake(const Options& opt, const std::string& input) {
+    typedef std::chrono::steady_clock Clock;
+    Image source;
+    std::string error;
+    Clock::time_point t0 = Clock::now();
+    if (!loadImage(input, source, opt.flip, 4, &error)) {
+        std::cerr << input << ": " << error << std::endl;
+        return false;
+    }
+    if (source.type != PixelType::UInt8) {
+        std::cerr << input << ": only 8-bit inputs can be encoded to BC1/BC7" << std::endl;
+        return false;
+    }
+    const double decodeTime = secondsSince(t0);
+
+    Clock::time_point t1 = Clock::now();
+    std::vector<Image> mips = buildMipChain(source, opt.filter, opt.srgb, 0, opt.threads);
+    const double mipTime = secondsSince(t1);
+
+    double texels = 0.0;
+    for (const Image& level : mips) texels += double(level.width) * level.height;
+
+    CompressedImage out;
+    out.internalFormat = glFormatFor(opt);
+    out.width = source.width;
+    out.height = source.height;
+    out.blockBytes = bcBlockBytes(opt.format);
+    out.originTop = !opt.flip;
+
+    const int runs = std::max(1, opt.benchRuns);
+    double encodeTime = 0.0;
+    for (int run = 0; run < runs; ++run) {
+        out.levels.clear();
+        out.data.clear();
+        Clock::time_point t2 = Clock::now();
+        for (const Image& level : mips) {
+            std::vector<unsigned char> blocks = compressImage(level, opt.format, opt.threads);
+            out.levels.push_back(CompressedImage::Level{level.width, level.height, out.data.size(), blocks.size()});
+            out.data.insert(out.data.end(), blocks.begin(), blocks.end());
+        }
+        encodeTime += secondsSince(t2);
+    }
+    encodeTime /= runs;
+
+    const std::string path = outputPathFor(opt, input);
+    if (!writeKTX2(path, out, "texbake", &error)) {
+        std::cerr << path << ": " << error << std::endl;
+        return false;
+    }
+
+    const double rawBytes = texels * 4.0;
+    std::cout << input << " -> " << path << "\n"
+              << "  " << source.width << "x" << source.height << ", " << mips.size() << " mips, "
+              << std::fixed << std::setprecision(1) << rawBytes / 1024.0 << " KiB RGBA8 -> "
+              << out.totalBytes() / 1024.0 << " KiB (" << rawBytes / out.totalBytes() << "x)\n"
+              << std::setprecision(2)
+              << "  decode " << decodeTime * 1000.0 << " ms, mips " << mipTime * 1000.0 << " ms, encode "
+              << encodeTime * 1000.0 << " ms (" << texels / 1e6 / encodeTime << " MP/s";
+    if (opt.benchRuns > 0) std::cout << ", avg of " << runs << " runs";
+    std::cout << ")" << std::endl;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        printUsage();
+        return 1;
+    }
+    if (opt.inputs.size() > 1 && !opt.output.empty() && !isDirectory(opt.output)) {
+        std::cerr << "-o must be a directory when baking multiple inputs" << std::endl;
+        return 1;
+    }
+    bool ok = true;
+    for (const std::string& input : opt.inputs) ok = bake(opt, input) && ok;
+    return ok ? 0 : 1;
+}